@@ -2073,3 +2073,73 @@ lp_build_sample_offset(struct lp_build_context *bld,
 
    *out_offset = offset;
 }
+
+
+/**
+ * Compute the offset of a pixel in a texture laid out in Y-major tiles.
+ *
+ * Tiles are 4KB, 128 bytes wide and 32 rows high, made of eight 16 byte
+ * wide columns stored one after the other.  Tiles of a row of tiles are
+ * consecutive, so like the linear offset this is the sum of an x and a y
+ * term, with a row of tiles being y_stride * 32 bytes.
+ *
+ * Only formats with 1x1 pixel blocks of at most 16 bytes can be tiled.
+ */
+void
+lp_build_sample_offset_tiled(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef z,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef z_stride,
+                             LLVMValueRef *out_offset,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMValueRef x_bytes;
+   LLVMValueRef offset;
+   LLVMValueRef tmp;
+
+   assert(format_desc->block.width == 1 && format_desc->block.height == 1);
+
+   /* x: bytes [3:0] within the column, [6:4] the column, the rest the tile */
+   x_bytes = lp_build_mul_imm(bld, x, format_desc->block.bits/8);
+   offset = LLVMBuildAnd(builder, x_bytes,
+                         lp_build_const_int_vec(gallivm, bld->type, 0xf), "");
+   tmp = LLVMBuildShl(builder, x_bytes,
+                      lp_build_const_int_vec(gallivm, bld->type, 5), "");
+   tmp = LLVMBuildAnd(builder, tmp,
+                      lp_build_const_int_vec(gallivm, bld->type, 0xe00), "");
+   offset = LLVMBuildOr(builder, offset, tmp, "");
+   tmp = LLVMBuildLShr(builder, x_bytes,
+                       lp_build_const_int_vec(gallivm, bld->type, 7), "");
+   tmp = LLVMBuildShl(builder, tmp,
+                      lp_build_const_int_vec(gallivm, bld->type, 12), "");
+   offset = LLVMBuildOr(builder, offset, tmp, "");
+
+   if (y && y_stride) {
+      /* y: rows [4:0] within the column, the rest the row of tiles */
+      tmp = LLVMBuildShl(builder, y,
+                         lp_build_const_int_vec(gallivm, bld->type, 4), "");
+      tmp = LLVMBuildAnd(builder, tmp,
+                         lp_build_const_int_vec(gallivm, bld->type, 0x1f0), "");
+      offset = LLVMBuildOr(builder, offset, tmp, "");
+      tmp = LLVMBuildLShr(builder, y,
+                          lp_build_const_int_vec(gallivm, bld->type, 5), "");
+      tmp = lp_build_mul(bld, tmp,
+                         LLVMBuildShl(builder, y_stride,
+                                      lp_build_const_int_vec(gallivm, bld->type, 5), ""));
+      offset = lp_build_add(bld, offset, tmp);
+   }
+
+   if (z && z_stride) {
+      offset = lp_build_add(bld, offset, lp_build_mul(bld, z, z_stride));
+   }
+
+   *out_offset = offset;
+   *out_i = bld->zero;
+   *out_j = bld->zero;
+}
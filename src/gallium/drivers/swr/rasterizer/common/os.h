@@ -194,6 +194,7 @@ unsigned int _mm_popcnt_u32(unsigned int v)
 #define InterlockedExchangeAdd(Addend, Value) __sync_fetch_and_add(Addend, Value)
 #define InterlockedDecrement(Append) __sync_sub_and_fetch(Append, 1)
 #define InterlockedIncrement(Append) __sync_add_and_fetch(Append, 1)
+#define InterlockedExchangePointer(Target, Value) __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST)
 #define _ReadWriteBarrier() asm volatile("" ::: "memory")
 #define __stdcall
 
@@ -215,6 +216,9 @@ typedef MEGABYTE    GIGABYTE[1024];
 #if KNOB_SIMD_WIDTH == 8
 #define OSALIGNSIMD(RWORD) OSALIGN(RWORD, 32)
 #endif
+#if ENABLE_AVX512_SIMD16
+#define OSALIGNSIMD16(RWORD) OSALIGN(RWORD, 64)
+#endif
 
 #include "common/swr_assert.h"
 
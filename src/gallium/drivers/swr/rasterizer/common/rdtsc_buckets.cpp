@@ -30,7 +30,7 @@
 #include "rdtsc_buckets.h"
 #include <inttypes.h>
 
-THREAD UINT tlsThreadId = 0;
+THREAD BUCKET_THREAD* tlsBucketThread = nullptr;
 
 void BucketManager::RegisterThread(const std::string& name)
 {
@@ -39,14 +39,12 @@ void BucketManager::RegisterThread(const std::string& name)
     newThread.root.children.reserve(mBuckets.size());
     newThread.root.id = 0;
     newThread.root.pParent = nullptr;
-    newThread.pCurrent = &newThread.root;
 
     mThreadMutex.lock();
 
     // assign unique thread id for this thread
     size_t id = mThreads.size();
     newThread.id = (UINT)id;
-    tlsThreadId = (UINT)id;
 
     // open threadviz file if enabled
     if (mThreadViz)
@@ -56,8 +54,10 @@ void BucketManager::RegisterThread(const std::string& name)
         newThread.vizFile = fopen(ss.str().c_str(), "wb");
     }
 
-    // store new thread
+    // store new thread, pointing it at its own root rather than the copy's
     mThreads.push_back(newThread);
+    mThreads.back().pCurrent = &mThreads.back().root;
+    tlsBucketThread = &mThreads.back();
 
     mThreadMutex.unlock();
 }
@@ -165,6 +165,76 @@ void BucketManager::DumpThreadViz()
     fclose(f);
 }
 
+// chrome://tracing category of a bucket, from its name prefix
+static const char* GetTraceCategory(const std::string& name)
+{
+    static const char* categories[] = { "API", "FE", "BE", "Worker", "JIT" };
+    for (const char* category : categories)
+    {
+        if (name.compare(0, strlen(category), category) == 0)
+        {
+            return category;
+        }
+    }
+
+    // per format load/store tile buckets
+    return "Tile";
+}
+
+void BucketManager::PrintChromeTrace(const std::string& filename)
+{
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == nullptr)
+    {
+        return;
+    }
+
+    // rdtsc ticks per microsecond over the capture
+    double us = std::chrono::duration<double, std::micro>(mCaptureEndTime - mCaptureStartTime).count();
+    double ticksPerUs = us > 0.0 ? (double)(mCaptureEndTsc - mCaptureStartTsc) / us : 1.0;
+    uint32_t pid = GetCurrentProcessId();
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    mThreadMutex.lock();
+    bool first = true;
+    for (const BUCKET_THREAD& thread : mThreads)
+    {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,"
+            "\"args\":{\"name\":\"%s %u\"}}",
+            first ? "" : ",\n", pid, thread.id, thread.name.c_str(), thread.id);
+        first = false;
+
+        for (const BUCKET_SPAN& span : thread.spans)
+        {
+            // still open when capture stopped
+            if (span.end == 0)
+            {
+                continue;
+            }
+
+            const std::string& name = mBuckets[span.id].name;
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"draw\":%" PRIu64 "}}",
+                name.c_str(), GetTraceCategory(name), pid, thread.id,
+                (double)(span.start - mCaptureStartTsc) / ticksPerUs,
+                (double)(span.end - span.start) / ticksPerUs,
+                span.drawId);
+        }
+
+        if (thread.spans.size() >= BUCKET_MAX_TRACE_SPANS)
+        {
+            fprintf(f, ",\n{\"name\":\"spans dropped\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%u,"
+                "\"ts\":%.3f}",
+                pid, thread.id, (double)(thread.spans.back().start - mCaptureStartTsc) / ticksPerUs);
+        }
+    }
+    mThreadMutex.unlock();
+
+    fprintf(f, "\n],\"displayTimeUnit\":\"ns\"}\n");
+    fclose(f);
+}
+
 void BucketManager::PrintReport(const std::string& filename)
 {
     if (mThreadViz)
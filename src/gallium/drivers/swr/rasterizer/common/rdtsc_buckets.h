@@ -30,14 +30,20 @@
 #pragma once
 
 #include "os.h"
+#include <chrono>
+#include <deque>
 #include <vector>
 #include <mutex>
 #include <sstream>
 
 #include "rdtsc_buckets_shared.h"
 
-// unique thread id stored in thread local storage
-extern THREAD UINT tlsThreadId;
+// the calling thread's data, null until the thread registers with a manager
+struct BUCKET_THREAD;
+extern THREAD BUCKET_THREAD* tlsBucketThread;
+
+// most spans recorded per thread for trace export in one capture
+#define BUCKET_MAX_TRACE_SPANS (1 << 20)
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief BucketManager encapsulates a single instance of the buckets
@@ -59,20 +65,24 @@ public:
         }
     }
 
-    // removes all registered thread data
-    void ClearThreads()
-    {
-        mThreadMutex.lock();
-        mThreads.clear();
-        mThreadMutex.unlock();
-    }
-
     // removes all registered buckets
     void ClearBuckets()
     {
         mBuckets.clear();
     }
 
+    // whether buckets may be started, cheap enough to check on every bucket
+    INLINE bool IsCapturing() const
+    {
+        return mCapturing;
+    }
+
+    // whether buckets may be started or stopped
+    INLINE bool IsActive() const
+    {
+        return mCapturing || mDraining;
+    }
+
     /// Registers a new thread with the manager.
     /// @param name - name of thread, used for labels in reports and threadviz
     void RegisterThread(const std::string& name);
@@ -89,31 +99,56 @@ public:
     // print report
     void PrintReport(const std::string& filename);
 
+    // write the spans recorded since StartCapture in Chrome trace event
+    // format, viewable in chrome://tracing
+    void PrintChromeTrace(const std::string& filename);
+
     // start capturing
-    INLINE void StartCapture()
+    // @param trace - also record every span for PrintChromeTrace
+    INLINE void StartCapture(bool trace = false)
     {
+        mThreadMutex.lock();
+        for (BUCKET_THREAD& t : mThreads)
+        {
+            t.spans.clear();
+            t.openSpans.clear();
+        }
+        mThreadMutex.unlock();
+
+        mTrace = trace && !mThreadViz;
+        mCaptureStartTsc = __rdtsc();
+        mCaptureStartTime = std::chrono::steady_clock::now();
         mCapturing = true;
     }
 
     // stop capturing
     INLINE void StopCapture()
     {
+        mDraining = true;
         mCapturing = false;
 
         // wait for all threads to pop back to root bucket
+        std::lock_guard<std::mutex> lock(mThreadMutex);
         bool stillCapturing = true;
         while (stillCapturing)
         {
+            // re-read what the other threads are popping
+            _ReadWriteBarrier();
+
             stillCapturing = false;
             for (const BUCKET_THREAD& t : mThreads)
             {
                 if (t.pCurrent != &t.root)
                 {
                     stillCapturing = true;
-                    continue;
+                    break;
                 }
             }
         }
+
+        mCaptureEndTsc = __rdtsc();
+        mCaptureEndTime = std::chrono::steady_clock::now();
+        mDraining = false;
     }
 
     // start a bucket
@@ -122,9 +157,10 @@ public:
     {
         if (!mCapturing) return;
 
-        SWR_ASSERT(tlsThreadId < mThreads.size());
+        BUCKET_THREAD* pThread = GetThread();
+        if (pThread == nullptr) return;
 
-        BUCKET_THREAD& bt = mThreads[tlsThreadId];
+        BUCKET_THREAD& bt = *pThread;
 
         // if threadviz is enabled, only need to dump start info to threads viz file
         if (mThreadViz)
@@ -149,16 +185,32 @@ public:
 
             // update thread's currently executing bucket
             bt.pCurrent = &child;
+
+            if (mTrace)
+            {
+                uint32_t span = 0xffffffff;
+                if (bt.spans.size() < BUCKET_MAX_TRACE_SPANS)
+                {
+                    span = (uint32_t)bt.spans.size();
+                    bt.spans.push_back({ id, child.start, 0, 0 });
+                }
+                bt.openSpans.push_back(span);
+            }
         }
 
         bt.level++;
     }
 
     // stop the currently executing bucket
-    INLINE void StopBucket(UINT id)
+    // @param drawId - draw the bucket worked on, only used for trace export
+    INLINE void StopBucket(UINT id, uint64_t drawId = 0)
     {
-        SWR_ASSERT(tlsThreadId < mThreads.size());
-        BUCKET_THREAD &bt = mThreads[tlsThreadId];
+        if (!IsActive()) return;
+
+        BUCKET_THREAD* pThread = GetThread();
+        if (pThread == nullptr) return;
+
+        BUCKET_THREAD &bt = *pThread;
 
         if (bt.level == 0) return;
 
@@ -176,9 +228,21 @@ public:
             if (bt.pCurrent->start == 0) return;
             SWR_ASSERT(bt.pCurrent->id == id, "Mismatched buckets detected");
 
-            bt.pCurrent->elapsed += (__rdtsc() - bt.pCurrent->start);
+            uint64_t end = __rdtsc();
+            bt.pCurrent->elapsed += (end - bt.pCurrent->start);
             bt.pCurrent->count++;
 
+            if (!bt.openSpans.empty())
+            {
+                uint32_t span = bt.openSpans.back();
+                bt.openSpans.pop_back();
+                if (span != 0xffffffff)
+                {
+                    bt.spans[span].end = end;
+                    bt.spans[span].drawId = drawId;
+                }
+            }
+
             // pop to parent
             bt.pCurrent = bt.pCurrent->pParent;
         }
@@ -190,9 +254,10 @@ public:
     {
         if (!mCapturing) return;
 
-        SWR_ASSERT(tlsThreadId < mThreads.size());
+        BUCKET_THREAD* pThread = GetThread();
+        if (pThread == nullptr) return;
 
-        BUCKET_THREAD& bt = mThreads[tlsThreadId];
+        BUCKET_THREAD& bt = *pThread;
 
         // don't record events for threadviz
         if (!mThreadViz)
@@ -209,11 +274,20 @@ public:
     }
 
 private:
+    // the calling thread's data, or null if it isn't registered.  Set once
+    // by RegisterThread, elements of the deque stay put while other threads
+    // register, so no lock is needed.
+    INLINE BUCKET_THREAD* GetThread()
+    {
+        return tlsBucketThread;
+    }
+
     void PrintBucket(FILE* f, UINT level, UINT64 threadCycles, UINT64 parentCycles, const BUCKET& bucket);
     void PrintThread(FILE* f, const BUCKET_THREAD& thread);
 
-    // list of active threads that have registered with this manager
-    std::vector<BUCKET_THREAD> mThreads;
+    // list of active threads that have registered with this manager,
+    // a deque so registering a thread doesn't move the others
+    std::deque<BUCKET_THREAD> mThreads;
 
     // list of buckets registered with this manager
     std::vector<BUCKET_DESC> mBuckets;
@@ -221,6 +295,19 @@ private:
     // is capturing currently enabled
     volatile bool mCapturing{ false };
 
+    // is StopCapture waiting for threads to stop their buckets
+    volatile bool mDraining{ false };
+
+    // record spans for trace export
+    bool mTrace{ false };
+
+    // capture interval, used to convert rdtsc to microseconds
+    uint64_t mCaptureStartTsc{ 0 };
+    uint64_t mCaptureEndTsc{ 0 };
+    std::chrono::steady_clock::time_point mCaptureStartTime;
+    std::chrono::steady_clock::time_point mCaptureEndTime;
+
+    // guards mThreads, which threads append to while others walk it
     std::mutex mThreadMutex;
 
     // enable threadviz
@@ -43,6 +43,15 @@ struct BUCKET
     std::vector<BUCKET> children;
 };
 
+// a single start/stop of a bucket, recorded for trace export
+struct BUCKET_SPAN
+{
+    uint32_t id;
+    uint64_t start;
+    uint64_t end;
+    uint64_t drawId;
+};
+
 struct BUCKET_DESC
 {
     // name of bucket, used in reports
@@ -78,6 +87,10 @@ struct BUCKET_THREAD
     // threadviz file object
     FILE* vizFile{ nullptr };
 
+    // spans recorded for trace export, and the indices of the open ones
+    std::vector<BUCKET_SPAN> spans;
+    std::vector<uint32_t> openSpans;
+
     BUCKET_THREAD() {}
     BUCKET_THREAD(const BUCKET_THREAD& that)
     {
@@ -86,6 +99,8 @@ struct BUCKET_THREAD
         root = that.root;
         pCurrent = &root;
         vizFile = that.vizFile;
+        spans = that.spans;
+        openSpans = that.openSpans;
     }
 };
 
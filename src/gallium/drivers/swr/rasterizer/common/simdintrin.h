@@ -393,6 +393,70 @@ void _simdvec_transpose(simdvector &v)
 #error Unsupported vector width
 #endif
 
+#if ENABLE_AVX512_SIMD16
+// 16 wide AVX512 companions to the simd types, for internal use by code that
+// can process two simd tiles worth of data at once.
+typedef __m512 simd16scalar;
+typedef __m512d simd16scalard;
+typedef __m512i simd16scalari;
+typedef __mmask16 simd16mask;
+
+OSALIGNSIMD16(union) simd16vector
+{
+	simd16scalar	v[4];
+	struct
+	{
+		simd16scalar x, y, z, w;
+	};
+
+	simd16scalar& operator[] (const int i) { return v[i]; }
+	const simd16scalar& operator[] (const int i) const { return v[i]; }
+};
+
+#define _simd16_load_ps _mm512_load_ps
+#define _simd16_loadu_ps _mm512_loadu_ps
+#define _simd16_store_ps _mm512_store_ps
+#define _simd16_storeu_ps _mm512_storeu_ps
+#define _simd16_setzero_ps _mm512_setzero_ps
+#define _simd16_set1_ps _mm512_set1_ps
+#define _simd16_broadcast_ss(p) _mm512_set1_ps(*(p))
+#define _simd16_mul_ps _mm512_mul_ps
+#define _simd16_add_ps _mm512_add_ps
+#define _simd16_sub_ps _mm512_sub_ps
+#define _simd16_div_ps _mm512_div_ps
+#define _simd16_min_ps _mm512_min_ps
+#define _simd16_max_ps _mm512_max_ps
+#define _simd16_fmadd_ps _mm512_fmadd_ps
+#define _simd16_and_ps _mm512_and_ps
+#define _simd16_or_ps _mm512_or_ps
+#define _simd16_andnot_ps _mm512_andnot_ps
+#define _simd16_cmp_ps_mask(a, b, imm) _mm512_cmp_ps_mask(a, b, imm)
+#define _simd16_blend_ps(mask, a, b) _mm512_mask_blend_ps(mask, a, b)
+#define _simd16_cvtps_epi32 _mm512_cvtps_epi32
+#define _simd16_cvttps_epi32 _mm512_cvttps_epi32
+#define _simd16_cvtepi32_ps _mm512_cvtepi32_ps
+#define _simd16_castps_si _mm512_castps_si512
+#define _simd16_castsi_ps _mm512_castsi512_ps
+
+#define _simd16_load_si _mm512_load_si512
+#define _simd16_store_si _mm512_store_si512
+#define _simd16_setzero_si _mm512_setzero_si512
+#define _simd16_set1_epi32 _mm512_set1_epi32
+#define _simd16_set1_epi8 _mm512_set1_epi8
+#define _simd16_add_epi32 _mm512_add_epi32
+#define _simd16_sub_epi32 _mm512_sub_epi32
+#define _simd16_mullo_epi32 _mm512_mullo_epi32
+#define _simd16_and_si _mm512_and_si512
+#define _simd16_or_si _mm512_or_si512
+#define _simd16_cmpeq_epi32_mask _mm512_cmpeq_epi32_mask
+#define _simd16_cmpgt_epi32_mask _mm512_cmpgt_epi32_mask
+
+// combine two simd registers into the lo/hi halves of a simd16 register
+#define _simd16_combine_ps(lo, hi) _mm512_insertf32x8(_mm512_castps256_ps512(lo), hi, 1)
+#define _simd16_extract_ps(a, imm) _mm512_extractf32x8_ps(a, imm)
+
+#endif//ENABLE_AVX512_SIMD16
+
 // Populates a simdvector from a vector. So p = xyzw becomes xxxx yyyy zzzz wwww.
 INLINE
 void _simdvec_load_ps(simdvector& r, const float *p)
@@ -43,6 +43,10 @@
 #include "common/simdintrin.h"
 #include "common/os.h"
 
+void InitDrawContext(DRAW_CONTEXT& dc);
+void DestroyDrawContext(DRAW_CONTEXT& dc);
+void InitStateBlocks(SWR_CONTEXT *pContext);
+void DestroyStateBlocks(SWR_CONTEXT *pContext);
 void SetupDefaultState(SWR_CONTEXT *pContext);
 
 //////////////////////////////////////////////////////////////////////////
@@ -61,11 +65,14 @@ HANDLE SwrCreateContext(
     pContext->driverType = pCreateInfo->driver;
     pContext->privateStateSize = pCreateInfo->privateStateSize;
 
-    pContext->dcRing = (DRAW_CONTEXT*)_aligned_malloc(sizeof(DRAW_CONTEXT)*KNOB_MAX_DRAWS_IN_FLIGHT, 64);
-    memset(pContext->dcRing, 0, sizeof(DRAW_CONTEXT)*KNOB_MAX_DRAWS_IN_FLIGHT);
+    // the next draw context and state must not be the previous ones, as in SwrSetMaxDrawsInFlight
+    pContext->maxDrawsInFlight = pCreateInfo->maxDrawsInFlight ? std::max(2u, pCreateInfo->maxDrawsInFlight) : KNOB_MAX_DRAWS_IN_FLIGHT;
 
-    pContext->dsRing = (DRAW_STATE*)_aligned_malloc(sizeof(DRAW_STATE)*KNOB_MAX_DRAWS_IN_FLIGHT, 64);
-    memset(pContext->dsRing, 0, sizeof(DRAW_STATE)*KNOB_MAX_DRAWS_IN_FLIGHT);
+    pContext->dcRing = (DRAW_CONTEXT*)_aligned_malloc(sizeof(DRAW_CONTEXT)*pContext->maxDrawsInFlight, 64);
+    memset(pContext->dcRing, 0, sizeof(DRAW_CONTEXT)*pContext->maxDrawsInFlight);
+
+    pContext->dsRing = (DRAW_STATE*)_aligned_malloc(sizeof(DRAW_STATE)*pContext->maxDrawsInFlight, 64);
+    memset(pContext->dsRing, 0, sizeof(DRAW_STATE)*pContext->maxDrawsInFlight);
 
     pContext->numSubContexts = pCreateInfo->maxSubContexts;
     if (pContext->numSubContexts > 1)
@@ -74,43 +81,19 @@ HANDLE SwrCreateContext(
         memset(pContext->subCtxSave, 0, sizeof(DRAW_STATE) * pContext->numSubContexts);
     }
 
-    for (uint32_t dc = 0; dc < KNOB_MAX_DRAWS_IN_FLIGHT; ++dc)
+    for (uint32_t dc = 0; dc < pContext->maxDrawsInFlight; ++dc)
     {
-        pContext->dcRing[dc].pArena = new Arena();
-        pContext->dcRing[dc].inUse = false;
-        pContext->dcRing[dc].pTileMgr = new MacroTileMgr(*(pContext->dcRing[dc].pArena));
-        pContext->dcRing[dc].pDispatch = new DispatchQueue(); /// @todo Could lazily allocate this if Dispatch seen.
+        InitDrawContext(pContext->dcRing[dc]);
 
         pContext->dsRing[dc].pArena = new Arena();
     }
 
-    if (!KNOB_SINGLE_THREADED)
-    {
-        memset(&pContext->WaitLock, 0, sizeof(pContext->WaitLock));
-        memset(&pContext->FifosNotEmpty, 0, sizeof(pContext->FifosNotEmpty));
-        new (&pContext->WaitLock) std::mutex();
-        new (&pContext->FifosNotEmpty) std::condition_variable();
-
-        CreateThreadPool(pContext, &pContext->threadPool);
-    }
-
-    // Calling createThreadPool() above can set SINGLE_THREADED
-    if (KNOB_SINGLE_THREADED)
-    {
-        pContext->NumWorkerThreads = 1;
-    }
-
-    // Allocate scratch space for workers.
-    ///@note We could lazily allocate this but its rather small amount of memory.
-    for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
-    {
-        ///@todo Use numa API for allocations using numa information from thread data (if exists).
-        pContext->pScratch[i] = (uint8_t*)_aligned_malloc((32 * 1024), KNOB_SIMD_WIDTH * 4);
-    }
-
     pContext->nextDrawId = 1;
+    pContext->hiZGeneration = 1;
     pContext->DrawEnqueued = 1;
 
+    InitStateBlocks(pContext);
+
     // State setup AFTER context is fully initialized
     SetupDefaultState(pContext);
 
@@ -125,21 +108,56 @@ HANDLE SwrCreateContext(
     pContext->pfnStoreTile = pCreateInfo->pfnStoreTile;
     pContext->pfnClearTile = pCreateInfo->pfnClearTile;
 
+    // Work on a shared pool if there is one with room, or on our own worker threads. Workers
+    // only start looking at the context once it is attached, and have nothing to do until the
+    // first draw is queued.
+    THREAD_POOL *pSharedPool = (THREAD_POOL*)pCreateInfo->hWorkerPool;
+    if (pSharedPool == nullptr || !AttachThreadPool(pSharedPool, pContext, pCreateInfo->workerPoolWeight))
+    {
+        THREAD_POOL *pPool = new THREAD_POOL();
+        if (!KNOB_SINGLE_THREADED)
+        {
+            CreateThreadPool(pPool);
+        }
+        AttachThreadPool(pPool, pContext, 1);
+        pContext->ownsThreadPool = true;
+    }
+
+    // Calling createThreadPool() above can set SINGLE_THREADED
+    if (KNOB_SINGLE_THREADED)
+    {
+        pContext->NumWorkerThreads = 1;
+    }
+
+    // Allocate scratch space for workers.
+    ///@note We could lazily allocate this but its rather small amount of memory.
+    for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
+    {
+        ///@todo Use numa API for allocations using numa information from thread data (if exists).
+        pContext->pScratch[i] = (uint8_t*)_aligned_malloc((32 * 1024), KNOB_SIMD_WIDTH * 4);
+    }
+
     return (HANDLE)pContext;
 }
 
 void SwrDestroyContext(HANDLE hContext)
 {
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
-    DestroyThreadPool(pContext, &pContext->threadPool);
+    if (pContext->ownsThreadPool)
+    {
+        DestroyThreadPool(pContext->pThreadPool);
+        delete pContext->pThreadPool;
+    }
+    else
+    {
+        DetachThreadPool(pContext->pThreadPool, pContext);
+    }
 
     // free the fifos
-    for (uint32_t i = 0; i < KNOB_MAX_DRAWS_IN_FLIGHT; ++i)
+    for (uint32_t i = 0; i < pContext->maxDrawsInFlight; ++i)
     {
-        delete pContext->dcRing[i].pArena;
+        DestroyDrawContext(pContext->dcRing[i]);
         delete pContext->dsRing[i].pArena;
-        delete(pContext->dcRing[i].pTileMgr);
-        delete(pContext->dcRing[i].pDispatch);
     }
 
     // Free scratch space.
@@ -148,6 +166,8 @@ void SwrDestroyContext(HANDLE hContext)
         _aligned_free(pContext->pScratch[i]);
     }
 
+    DestroyStateBlocks(pContext);
+
     _aligned_free(pContext->dcRing);
     _aligned_free(pContext->dsRing);
     _aligned_free(pContext->subCtxSave);
@@ -158,14 +178,205 @@ void SwrDestroyContext(HANDLE hContext)
     _aligned_free((SWR_CONTEXT*)hContext);
 }
 
-void CopyState(DRAW_STATE& dst, const DRAW_STATE& src)
+HANDLE SwrCreateWorkerPool()
+{
+    RDTSC_INIT(0);
+
+    THREAD_POOL *pPool = new THREAD_POOL();
+    if (!KNOB_SINGLE_THREADED)
+    {
+        CreateThreadPool(pPool);
+    }
+
+    return (HANDLE)pPool;
+}
+
+void SwrDestroyWorkerPool(HANDLE hWorkerPool)
+{
+    THREAD_POOL *pPool = (THREAD_POOL*)hWorkerPool;
+
+    DestroyThreadPool(pPool);
+    delete pPool;
+}
+
+void SwrSetWorkerPoolWeight(HANDLE hContext, uint32_t weight)
 {
+    SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+
+    SetThreadPoolWeight(pContext->pThreadPool, pContext, weight);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Takes a state block from the free list of the context or
+///        allocates a new one. The block is returned with one reference.
+template <typename BLOCK>
+BLOCK* AllocStateBlock(SWR_CONTEXT *pContext)
+{
+    STATE_BLOCK*& pFree = pContext->pFreeStateBlocks[BLOCK::TYPE];
+    BLOCK* pBlock = static_cast<BLOCK*>(pFree);
+    if (pBlock != nullptr)
+    {
+        pFree = pBlock->pNextFree;
+    }
+    else
+    {
+        pBlock = (BLOCK*)_aligned_malloc(sizeof(BLOCK), 64);
+    }
+
+    pBlock->refCount = 1;
+    return pBlock;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Drops a reference to a state block. Unused blocks go back to
+///        the free list; draws using them are done, as the last reference
+///        is only dropped when their draw state is recycled.
+template <typename BLOCK>
+void ReleaseStateBlock(SWR_CONTEXT *pContext, BLOCK* pBlock)
+{
+    SWR_ASSERT(pBlock->refCount > 0);
+    if (--pBlock->refCount == 0)
+    {
+        pBlock->pNextFree = pContext->pFreeStateBlocks[BLOCK::TYPE];
+        pContext->pFreeStateBlocks[BLOCK::TYPE] = pBlock;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Makes a state block safe to change. A block shared with other
+///        draw states is replaced by a copy that only pBlock refers to.
+template <typename BLOCK>
+BLOCK* WriteStateBlock(SWR_CONTEXT *pContext, BLOCK*& pBlock)
+{
+    if (pBlock->refCount > 1)
+    {
+        BLOCK* pCopy = AllocStateBlock<BLOCK>(pContext);
+        *pCopy = *pBlock;
+        pCopy->refCount = 1;
+        pContext->ringStats.numStateBlockCopies++;
+
+        ReleaseStateBlock(pContext, pBlock);
+        pBlock = pCopy;
+    }
+
+    return pBlock;
+}
+
+void AddRefStateBlocks(const API_STATE& state)
+{
+    state.pVertexInput->refCount++;
+    state.pShaders->refCount++;
+    state.pFrontend->refCount++;
+    state.pRaster->refCount++;
+    state.pViewport->refCount++;
+    state.pOutput->refCount++;
+}
+
+void ReleaseStateBlocks(SWR_CONTEXT *pContext, const API_STATE& state)
+{
+    ReleaseStateBlock(pContext, state.pVertexInput);
+    ReleaseStateBlock(pContext, state.pShaders);
+    ReleaseStateBlock(pContext, state.pFrontend);
+    ReleaseStateBlock(pContext, state.pRaster);
+    ReleaseStateBlock(pContext, state.pViewport);
+    ReleaseStateBlock(pContext, state.pOutput);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Sets a zeroed state block to start out with.
+template <typename BLOCK>
+void InitStateBlock(SWR_CONTEXT *pContext, BLOCK*& pBlock)
+{
+    pBlock = AllocStateBlock<BLOCK>(pContext);
+    memset(pBlock, 0, sizeof(BLOCK));
+    pBlock->refCount = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Lets all draw states and subcontext save areas share one set of
+///        zeroed state blocks.
+void InitStateBlocks(SWR_CONTEXT *pContext)
+{
+    API_STATE& state = pContext->dsRing[0].state;
+    InitStateBlock(pContext, state.pVertexInput);
+    InitStateBlock(pContext, state.pShaders);
+    InitStateBlock(pContext, state.pFrontend);
+    InitStateBlock(pContext, state.pRaster);
+    InitStateBlock(pContext, state.pViewport);
+    InitStateBlock(pContext, state.pOutput);
+
+    for (uint32_t ds = 1; ds < pContext->maxDrawsInFlight; ++ds)
+    {
+        pContext->dsRing[ds].state = state;
+        AddRefStateBlocks(state);
+    }
+
+    if (pContext->subCtxSave)
+    {
+        for (uint32_t i = 0; i < pContext->numSubContexts; ++i)
+        {
+            pContext->subCtxSave[i].state = state;
+            AddRefStateBlocks(state);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Releases the state blocks of all draw states and frees them.
+void DestroyStateBlocks(SWR_CONTEXT *pContext)
+{
+    for (uint32_t ds = 0; ds < pContext->maxDrawsInFlight; ++ds)
+    {
+        ReleaseStateBlocks(pContext, pContext->dsRing[ds].state);
+    }
+
+    if (pContext->subCtxSave)
+    {
+        for (uint32_t i = 0; i < pContext->numSubContexts; ++i)
+        {
+            ReleaseStateBlocks(pContext, pContext->subCtxSave[i].state);
+        }
+    }
+
+    for (uint32_t type = 0; type < STATE_BLOCK_COUNT; ++type)
+    {
+        while (pContext->pFreeStateBlocks[type])
+        {
+            STATE_BLOCK* pBlock = pContext->pFreeStateBlocks[type];
+            pContext->pFreeStateBlocks[type] = pBlock->pNextFree;
+            _aligned_free(pBlock);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Copies draw state. dst shares the state blocks of src and gives
+///        up its own.
+void CopyState(SWR_CONTEXT *pContext, DRAW_STATE& dst, const DRAW_STATE& src)
+{
+    AddRefStateBlocks(src.state);
+    ReleaseStateBlocks(pContext, dst.state);
     memcpy(&dst.state, &src.state, sizeof(API_STATE));
 }
 
+void InitDrawContext(DRAW_CONTEXT& dc)
+{
+    dc.pArena = new Arena();
+    dc.inUse = false;
+    dc.pTileMgr = new MacroTileMgr(*(dc.pArena));
+    dc.pDispatch = new DispatchQueue(); /// @todo Could lazily allocate this if Dispatch seen.
+}
+
+void DestroyDrawContext(DRAW_CONTEXT& dc)
+{
+    delete dc.pArena;
+    delete(dc.pTileMgr);
+    delete(dc.pDispatch);
+}
+
 void WakeAllThreads(SWR_CONTEXT *pContext)
 {
-    pContext->FifosNotEmpty.notify_all();
+    pContext->pThreadPool->FifosNotEmpty.notify_all();
 }
 
 bool StillDrawing(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
@@ -202,6 +413,118 @@ bool StillDrawing(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
     return pDC->inUse;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if all workers have moved past every queued draw.
+bool DrawRingsDrained(SWR_CONTEXT *pContext)
+{
+    if (KNOB_SINGLE_THREADED || pContext->pPrevDrawContext == nullptr) { return true; }
+
+    // Workers move past draws in order, so the last draw queued is the last one retired.
+    DRAW_CONTEXT *pDC = pContext->pPrevDrawContext;
+    return pDC->threadsDoneFE == pContext->NumWorkerThreads &&
+        pDC->threadsDoneBE == pContext->NumWorkerThreads;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Replaces the DC and DS rings by ones of a different size, after
+///        waiting for all queued draws to retire. The most recent entries
+///        are kept in order, ending right before the ones the next draw
+///        context and state are taken from. This keeps the previous draw
+///        context and its state, which the next one copies or shares.
+void ResizeDrawRings(SWR_CONTEXT *pContext, uint32_t maxDrawsInFlight)
+{
+    SWR_ASSERT(pContext->pCurDrawContext == nullptr);
+    SWR_ASSERT(pContext->pPrevDrawContext != nullptr);
+
+    while (!DrawRingsDrained(pContext))
+    {
+        _mm_pause();
+    }
+
+    // A worker that just moved past the last draw may still be reading the old ring.
+    QuiesceThreadPool(pContext->pThreadPool, pContext);
+
+    uint32_t oldSize = pContext->maxDrawsInFlight;
+    DRAW_CONTEXT* pOldDCs = pContext->dcRing;
+    DRAW_STATE* pOldDSs = pContext->dsRing;
+    uint32_t oldDC = (uint32_t)(pContext->pPrevDrawContext - pOldDCs);
+    uint32_t oldDS = (uint32_t)(pContext->pPrevDrawContext->pState - pOldDSs);
+
+    uint32_t size = maxDrawsInFlight;
+    DRAW_CONTEXT* pNewDCs = (DRAW_CONTEXT*)_aligned_malloc(sizeof(DRAW_CONTEXT) * size, 64);
+    DRAW_STATE* pNewDSs = (DRAW_STATE*)_aligned_malloc(sizeof(DRAW_STATE) * size, 64);
+    uint32_t newDC = (uint32_t)((pContext->nextDrawId - 1) % size);
+    uint32_t newDS = (pContext->curStateId - 1) % size;
+
+    // Index of the entry i before the one at index 'from' in a ring of n entries
+    auto before = [](uint32_t from, uint32_t i, uint32_t n) { return (from + n - i) % n; };
+    uint32_t numKept = std::min(size, oldSize);
+
+    for (uint32_t i = 0; i < numKept; ++i)
+    {
+        DRAW_CONTEXT* pNewDC = &pNewDCs[before(newDC, i, size)];
+        memcpy(pNewDC, &pOldDCs[before(oldDC, i, oldSize)], sizeof(DRAW_CONTEXT));
+        memcpy(&pNewDSs[before(newDS, i, size)], &pOldDSs[before(oldDS, i, oldSize)], sizeof(DRAW_STATE));
+        pNewDC->pState = nullptr;   // retired, set again when reused
+    }
+
+    // New entries start out sharing the state blocks of the previous draw
+    for (uint32_t i = numKept; i < size; ++i)
+    {
+        DRAW_CONTEXT* pNewDC = &pNewDCs[before(newDC, i, size)];
+        memset(pNewDC, 0, sizeof(DRAW_CONTEXT));
+        InitDrawContext(*pNewDC);
+
+        DRAW_STATE* pNewDS = &pNewDSs[before(newDS, i, size)];
+        memset(pNewDS, 0, sizeof(DRAW_STATE));
+        pNewDS->pArena = new Arena();
+        pNewDS->state = pOldDSs[oldDS].state;
+        AddRefStateBlocks(pNewDS->state);
+    }
+
+    // Oldest entries that don't fit anymore
+    for (uint32_t i = numKept; i < oldSize; ++i)
+    {
+        DestroyDrawContext(pOldDCs[before(oldDC, i, oldSize)]);
+
+        DRAW_STATE* pOldDS = &pOldDSs[before(oldDS, i, oldSize)];
+        delete pOldDS->pArena;
+        ReleaseStateBlocks(pContext, pOldDS->state);
+    }
+
+    pNewDCs[newDC].pState = &pNewDSs[newDS];
+    pContext->pPrevDrawContext = &pNewDCs[newDC];
+
+    pContext->dcRing = pNewDCs;
+    pContext->dsRing = pNewDSs;
+    pContext->maxDrawsInFlight = size;
+
+    _aligned_free(pOldDCs);
+    _aligned_free(pOldDSs);
+
+    if (pContext->growDrawRings)
+    {
+        pContext->ringStats.numGrows++;
+    }
+    pContext->nextMaxDrawsInFlight = 0;
+    pContext->growDrawRings = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Applies a pending automatic growth of the rings if they are
+///        drained. Growth is asked for while the API thread waits on a full
+///        ring, which rarely drains by itself while the app keeps drawing.
+static void GrowDrawRingsIfIdle(SWR_CONTEXT *pContext)
+{
+    if (pContext->growDrawRings &&
+        pContext->pCurDrawContext == nullptr &&
+        pContext->pPrevDrawContext != nullptr &&
+        DrawRingsDrained(pContext))
+    {
+        ResizeDrawRings(pContext, pContext->nextMaxDrawsInFlight);
+    }
+}
+
 void QueueDraw(SWR_CONTEXT *pContext)
 {
     SWR_ASSERT(pContext->pCurDrawContext->inUse == false);
@@ -209,7 +532,7 @@ void QueueDraw(SWR_CONTEXT *pContext)
 
     _ReadWriteBarrier();
     {
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
+        std::unique_lock<std::mutex> lock(pContext->pThreadPool->WaitLock);
         pContext->DrawEnqueued++;
     }
 
@@ -219,10 +542,14 @@ void QueueDraw(SWR_CONTEXT *pContext)
         uint32_t mxcsr = _mm_getcsr();
         _mm_setcsr(mxcsr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
 
-        std::unordered_set<uint32_t> lockedTiles;
+        // no worker threads to hold the draw back, see SwrSetDeferredFunc
+        SWR_ASSERT(IsDeferredFuncsReady(GetApiState(pContext->pCurDrawContext)),
+            "Deferred functions must be compiled before a single threaded draw");
+
+        TileSet lockedTiles;
         uint64_t curDraw[2] = { pContext->pCurDrawContext->drawId, pContext->pCurDrawContext->drawId };
         WorkOnFifoFE(pContext, 0, curDraw[0], 0);
-        WorkOnFifoBE(pContext, 0, curDraw[1], lockedTiles);
+        WorkOnFifoBE(pContext, 0, curDraw[1], lockedTiles, 0);
 
         // restore csr
         _mm_setcsr(mxcsr);
@@ -247,7 +574,7 @@ void QueueDispatch(SWR_CONTEXT *pContext)
 
     _ReadWriteBarrier();
     {
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
+        std::unique_lock<std::mutex> lock(pContext->pThreadPool->WaitLock);
         pContext->DrawEnqueued++;
     }
 
@@ -281,19 +608,38 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
     // If current draw context is null then need to obtain a new draw context to use from ring.
     if (pContext->pCurDrawContext == nullptr)
     {
-        uint32_t dcIndex = pContext->nextDrawId % KNOB_MAX_DRAWS_IN_FLIGHT;
+        // Change the ring size if asked to. Growths wait until the ring drains without waiting for it.
+        if (pContext->nextMaxDrawsInFlight != 0 && (!pContext->growDrawRings || DrawRingsDrained(pContext)))
+        {
+            ResizeDrawRings(pContext, pContext->nextMaxDrawsInFlight);
+        }
+
+        uint32_t dcIndex = pContext->nextDrawId % pContext->maxDrawsInFlight;
 
         DRAW_CONTEXT* pCurDrawContext = &pContext->dcRing[dcIndex];
         pContext->pCurDrawContext = pCurDrawContext;
 
         // Need to wait until this draw context is available to use.
-        while (StillDrawing(pContext, pCurDrawContext))
+        if (StillDrawing(pContext, pCurDrawContext))
         {
-            _mm_pause();
+            uint64_t waitStart = __rdtsc();
+            while (StillDrawing(pContext, pCurDrawContext))
+            {
+                _mm_pause();
+            }
+            pContext->ringStats.numRingFullWaits++;
+            pContext->ringStats.ringFullWaitTicks += __rdtsc() - waitStart;
+
+            uint32_t limit = KNOB_MAX_DRAWS_IN_FLIGHT_LIMIT;
+            if (pContext->nextMaxDrawsInFlight == 0 && pContext->maxDrawsInFlight < limit)
+            {
+                pContext->nextMaxDrawsInFlight = std::min(pContext->maxDrawsInFlight * 2, limit);
+                pContext->growDrawRings = true;
+            }
         }
 
         // Assign next available entry in DS ring to this DC.
-        uint32_t dsIndex = pContext->curStateId % KNOB_MAX_DRAWS_IN_FLIGHT;
+        uint32_t dsIndex = pContext->curStateId % pContext->maxDrawsInFlight;
         pCurDrawContext->pState = &pContext->dsRing[dsIndex];
 
         Arena& stateArena = *(pCurDrawContext->pState->pArena);
@@ -308,7 +654,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
             // draw can receive the state.
             if (isSplitDraw == false)
             {
-                CopyState(*pCurDrawContext->pState, *pPrevDrawContext->pState);
+                CopyState(pContext, *pCurDrawContext->pState, *pPrevDrawContext->pState);
 
                 stateArena.Reset(true);    // Reset memory.
                 pCurDrawContext->pState->pPrivateState = nullptr;
@@ -329,6 +675,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
         }
 
         pCurDrawContext->dependency = 0;
+        pCurDrawContext->dependentFE = false;
         pCurDrawContext->pArena->Reset();
         pCurDrawContext->pContext = pContext;
         pCurDrawContext->isCompute = false; // Dispatch has to set this to true.
@@ -344,6 +691,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
 
         // Assign unique drawId for this DC
         pCurDrawContext->drawId = pContext->nextDrawId++;
+        pCurDrawContext->hiZGeneration = pContext->hiZGeneration;
     }
     else
     {
@@ -369,10 +717,12 @@ void SWR_API SwrSetActiveSubContext(
         // Save and restore draw state
         DRAW_CONTEXT* pDC = GetDrawContext(pContext);
         CopyState(
+            pContext,
             pContext->subCtxSave[pContext->curSubCtxId],
             *(pDC->pState));
 
         CopyState(
+            pContext,
             *(pDC->pState),
             pContext->subCtxSave[subContextIndex]);
 
@@ -388,12 +738,35 @@ API_STATE* GetDrawState(SWR_CONTEXT *pContext)
     return &pDC->pState->state;
 }
 
-void SetupDefaultState(SWR_CONTEXT *pContext)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns a state block of the current draw state for the API
+///        thread to change.
+/// @param pBlock - Block member of API_STATE.
+template <typename BLOCK>
+BLOCK* GetDrawStateBlock(SWR_CONTEXT *pContext, BLOCK* API_STATE::*pBlock)
 {
     API_STATE* pState = GetDrawState(pContext);
 
-    pState->rastState.cullMode = SWR_CULLMODE_NONE;
-    pState->rastState.frontWinding = SWR_FRONTWINDING_CCW;
+    return WriteStateBlock(pContext, pState->*pBlock);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns a state block of the current draw state for the API
+///        thread to compare against. Unlike GetDrawStateBlock this keeps
+///        the block shared, so setters can skip values that didn't change.
+/// @param pBlock - Block member of API_STATE.
+template <typename BLOCK>
+const BLOCK* PeekDrawStateBlock(SWR_CONTEXT *pContext, BLOCK* API_STATE::*pBlock)
+{
+    return GetDrawState(pContext)->*pBlock;
+}
+
+void SetupDefaultState(SWR_CONTEXT *pContext)
+{
+    RASTER_BLOCK* pRaster = GetDrawStateBlock(pContext, &API_STATE::pRaster);
+
+    pRaster->rastState.cullMode = SWR_CULLMODE_NONE;
+    pRaster->rastState.frontWinding = SWR_FRONTWINDING_CCW;
 }
 
 static INLINE SWR_CONTEXT* GetContext(HANDLE hContext)
@@ -432,7 +805,7 @@ void SwrWaitForIdle(HANDLE hContext)
 
     RDTSC_START(APIWaitForIdle);
     // Wait for all work to complete.
-    for (uint32_t dc = 0; dc < KNOB_MAX_DRAWS_IN_FLIGHT; ++dc)
+    for (uint32_t dc = 0; dc < pContext->maxDrawsInFlight; ++dc)
     {
         DRAW_CONTEXT *pDC = &pContext->dcRing[dc];
 
@@ -441,6 +814,8 @@ void SwrWaitForIdle(HANDLE hContext)
             _mm_pause();
         }
     }
+
+    GrowDrawRingsIfIdle(pContext);
     RDTSC_STOP(APIWaitForIdle, 1, 0);
 }
 
@@ -449,12 +824,12 @@ void SwrSetVertexBuffers(
     uint32_t numBuffers,
     const SWR_VERTEX_BUFFER_STATE* pVertexBuffers)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    VERTEX_INPUT_BLOCK* pVertexInput = GetDrawStateBlock(GetContext(hContext), &API_STATE::pVertexInput);
 
     for (uint32_t i = 0; i < numBuffers; ++i)
     {
         const SWR_VERTEX_BUFFER_STATE *pVB = &pVertexBuffers[i];
-        pState->vertexBuffers[pVB->index] = *pVB;
+        pVertexInput->vertexBuffers[pVB->index] = *pVB;
     }
 }
 
@@ -462,18 +837,29 @@ void SwrSetIndexBuffer(
     HANDLE hContext,
     const SWR_INDEX_BUFFER_STATE* pIndexBuffer)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    VERTEX_INPUT_BLOCK* pVertexInput = GetDrawStateBlock(GetContext(hContext), &API_STATE::pVertexInput);
 
-    pState->indexBuffer = *pIndexBuffer;
+    pVertexInput->indexBuffer = *pIndexBuffer;
 }
 
 void SwrSetFetchFunc(
     HANDLE hContext,
     PFN_FETCH_FUNC    pfnFetchFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    // drivers set the shaders for every draw, don't unshare the block for that
+    const SHADER_BLOCK* pCurShaders = PeekDrawStateBlock(pContext, &API_STATE::pShaders);
+    if (pCurShaders->pfnFetchFunc == pfnFetchFunc &&
+        !(pCurShaders->deferredFuncMask & (1 << SWR_DEFERRED_FETCH_FUNC)))
+    {
+        return;
+    }
+
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(pContext, &API_STATE::pShaders);
 
-    pState->pfnFetchFunc = pfnFetchFunc;
+    pShaders->pfnFetchFunc = pfnFetchFunc;
+    pShaders->deferredFuncMask &= ~(1 << SWR_DEFERRED_FETCH_FUNC);
 }
 
 void SwrSetSoFunc(
@@ -481,20 +867,52 @@ void SwrSetSoFunc(
     PFN_SO_FUNC    pfnSoFunc,
     uint32_t streamIndex)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    SWR_CONTEXT *pContext = GetContext(hContext);
 
     SWR_ASSERT(streamIndex < MAX_SO_STREAMS);
 
-    pState->pfnSoFunc[streamIndex] = pfnSoFunc;
+    const SHADER_BLOCK* pCurShaders = PeekDrawStateBlock(pContext, &API_STATE::pShaders);
+    if (pCurShaders->pfnSoFunc[streamIndex] == pfnSoFunc &&
+        !(pCurShaders->deferredFuncMask & (1 << (SWR_DEFERRED_SO_FUNC + streamIndex))))
+    {
+        return;
+    }
+
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(pContext, &API_STATE::pShaders);
+
+    pShaders->pfnSoFunc[streamIndex] = pfnSoFunc;
+    pShaders->deferredFuncMask &= ~(1 << (SWR_DEFERRED_SO_FUNC + streamIndex));
+}
+
+void SwrSetDeferredFunc(
+    HANDLE hContext,
+    SWR_DEFERRED_FUNC func,
+    void* volatile* ppFunc)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    SWR_ASSERT(func < SWR_NUM_DEFERRED_FUNCS);
+
+    const SHADER_BLOCK* pCurShaders = PeekDrawStateBlock(pContext, &API_STATE::pShaders);
+    if (pCurShaders->ppDeferredFuncs[func] == ppFunc &&
+        (pCurShaders->deferredFuncMask & (1 << func)))
+    {
+        return;
+    }
+
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(pContext, &API_STATE::pShaders);
+
+    pShaders->ppDeferredFuncs[func] = ppFunc;
+    pShaders->deferredFuncMask |= (1 << func);
 }
 
 void SwrSetSoState(
     HANDLE hContext,
     SWR_STREAMOUT_STATE* pSoState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    FRONTEND_BLOCK* pFrontend = GetDrawStateBlock(GetContext(hContext), &API_STATE::pFrontend);
 
-    pState->soState = *pSoState;
+    pFrontend->soState = *pSoState;
 }
 
 void SwrSetSoBuffers(
@@ -513,33 +931,41 @@ void SwrSetVertexFunc(
     HANDLE hContext,
     PFN_VERTEX_FUNC pfnVertexFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
 
-    pState->pfnVertexFunc = pfnVertexFunc;
+    pShaders->pfnVertexFunc = pfnVertexFunc;
 }
 
 void SwrSetFrontendState(
     HANDLE hContext,
     SWR_FRONTEND_STATE *pFEState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
-    pState->frontendState = *pFEState;
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    const FRONTEND_BLOCK* pCurFrontend = PeekDrawStateBlock(pContext, &API_STATE::pFrontend);
+    if (memcmp(&pCurFrontend->frontendState, pFEState, sizeof(*pFEState)) == 0)
+    {
+        return;
+    }
+
+    FRONTEND_BLOCK* pFrontend = GetDrawStateBlock(pContext, &API_STATE::pFrontend);
+    pFrontend->frontendState = *pFEState;
 }
 
 void SwrSetGsState(
     HANDLE hContext,
     SWR_GS_STATE *pGSState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
-    pState->gsState = *pGSState;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->gsState = *pGSState;
 }
 
 void SwrSetGsFunc(
     HANDLE hContext,
     PFN_GS_FUNC pfnGsFunc)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
-    pState->pfnGsFunc = pfnGsFunc;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->pfnGsFunc = pfnGsFunc;
 }
 
 void SwrSetCsFunc(
@@ -547,67 +973,81 @@ void SwrSetCsFunc(
     PFN_CS_FUNC pfnCsFunc,
     uint32_t totalThreadsInGroup)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
-    pState->pfnCsFunc = pfnCsFunc;
-    pState->totalThreadsInGroup = totalThreadsInGroup;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->pfnCsFunc = pfnCsFunc;
+    pShaders->totalThreadsInGroup = totalThreadsInGroup;
 }
 
 void SwrSetTsState(
     HANDLE hContext,
     SWR_TS_STATE *pState)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
-    pApiState->tsState = *pState;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->tsState = *pState;
 }
 
 void SwrSetHsFunc(
     HANDLE hContext,
     PFN_HS_FUNC pfnFunc)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
-    pApiState->pfnHsFunc = pfnFunc;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->pfnHsFunc = pfnFunc;
 }
 
 void SwrSetDsFunc(
     HANDLE hContext,
     PFN_DS_FUNC pfnFunc)
 {
-    API_STATE* pApiState = GetDrawState(GetContext(hContext));
-    pApiState->pfnDsFunc = pfnFunc;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->pfnDsFunc = pfnFunc;
 }
 
 void SwrSetDepthStencilState(
     HANDLE hContext,
     SWR_DEPTH_STENCIL_STATE *pDSState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    RASTER_BLOCK* pRaster = GetDrawStateBlock(GetContext(hContext), &API_STATE::pRaster);
 
-    pState->depthStencilState = *pDSState;
+    pRaster->depthStencilState = *pDSState;
 }
 
 void SwrSetBackendState(
     HANDLE hContext,
     SWR_BACKEND_STATE *pBEState)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    RASTER_BLOCK* pRaster = GetDrawStateBlock(GetContext(hContext), &API_STATE::pRaster);
 
-    pState->backendState = *pBEState;
+    pRaster->backendState = *pBEState;
 }
 
 void SwrSetPixelShaderState(
     HANDLE hContext,
     SWR_PS_STATE *pPSState)
 {
-    API_STATE *pState = GetDrawState(GetContext(hContext));
-    pState->psState = *pPSState;
+    SHADER_BLOCK* pShaders = GetDrawStateBlock(GetContext(hContext), &API_STATE::pShaders);
+    pShaders->psState = *pPSState;
+    pShaders->deferredFuncMask &= ~(1 << SWR_DEFERRED_PIXEL_SHADER);
 }
 
 void SwrSetBlendState(
     HANDLE hContext,
     SWR_BLEND_STATE *pBlendState)
 {
-    API_STATE *pState = GetDrawState(GetContext(hContext));
-    memcpy(&pState->blendState, pBlendState, sizeof(SWR_BLEND_STATE));
+    OUTPUT_BLOCK* pOutput = GetDrawStateBlock(GetContext(hContext), &API_STATE::pOutput);
+    memcpy(&pOutput->blendState, pBlendState, sizeof(SWR_BLEND_STATE));
+}
+
+void SwrSetRenderTargetFormats(
+    HANDLE hContext,
+    uint32_t numRenderTargets,
+    const SWR_FORMAT *pFormats)
+{
+    SWR_ASSERT(numRenderTargets <= SWR_NUM_RENDERTARGETS);
+    OUTPUT_BLOCK* pOutput = GetDrawStateBlock(GetContext(hContext), &API_STATE::pOutput);
+    for (uint32_t rt = 0; rt < numRenderTargets; ++rt)
+    {
+        pOutput->renderTargetFormat[rt] = pFormats[rt];
+    }
 }
 
 void SwrSetBlendFunc(
@@ -616,8 +1056,8 @@ void SwrSetBlendFunc(
     PFN_BLEND_JIT_FUNC pfnBlendFunc)
 {
     SWR_ASSERT(renderTarget < SWR_NUM_RENDERTARGETS);
-    API_STATE *pState = GetDrawState(GetContext(hContext));
-    pState->pfnBlendFunc[renderTarget] = pfnBlendFunc;
+    OUTPUT_BLOCK* pOutput = GetDrawStateBlock(GetContext(hContext), &API_STATE::pOutput);
+    pOutput->pfnBlendFunc[renderTarget] = pfnBlendFunc;
 }
 
 void SwrSetLinkage(
@@ -625,34 +1065,34 @@ void SwrSetLinkage(
     uint32_t mask,
     const uint8_t* pMap)
 {
-    API_STATE* pState = GetDrawState(GetContext(hContext));
+    FRONTEND_BLOCK* pFrontend = GetDrawStateBlock(GetContext(hContext), &API_STATE::pFrontend);
 
     static const uint8_t IDENTITY_MAP[] =
     {
          0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
         16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
     };
-    static_assert(sizeof(IDENTITY_MAP) == sizeof(pState->linkageMap),
+    static_assert(sizeof(IDENTITY_MAP) == sizeof(pFrontend->linkageMap),
         "Update for new value of MAX_ATTRIBUTES");
 
-    pState->linkageMask = mask;
-    pState->linkageCount = _mm_popcnt_u32(mask);
+    pFrontend->linkageMask = mask;
+    pFrontend->linkageCount = _mm_popcnt_u32(mask);
 
     if (!pMap)
     {
         pMap = IDENTITY_MAP;
     }
-    memcpy(pState->linkageMap, pMap, pState->linkageCount);
+    memcpy(pFrontend->linkageMap, pMap, pFrontend->linkageCount);
 }
 
 // update guardband multipliers for the viewport
-void updateGuardband(API_STATE *pState)
+void updateGuardband(VIEWPORT_BLOCK *pViewport)
 {
     // guardband center is viewport center
-    pState->gbState.left    = KNOB_GUARDBAND_WIDTH  / pState->vp[0].width;
-    pState->gbState.right   = KNOB_GUARDBAND_WIDTH  / pState->vp[0].width;
-    pState->gbState.top     = KNOB_GUARDBAND_HEIGHT / pState->vp[0].height;
-    pState->gbState.bottom  = KNOB_GUARDBAND_HEIGHT / pState->vp[0].height;
+    pViewport->gbState.left    = KNOB_GUARDBAND_WIDTH  / pViewport->vp[0].width;
+    pViewport->gbState.right   = KNOB_GUARDBAND_WIDTH  / pViewport->vp[0].width;
+    pViewport->gbState.top     = KNOB_GUARDBAND_HEIGHT / pViewport->vp[0].height;
+    pViewport->gbState.bottom  = KNOB_GUARDBAND_HEIGHT / pViewport->vp[0].height;
 }
 
 void SwrSetRastState(
@@ -660,9 +1100,9 @@ void SwrSetRastState(
     const SWR_RASTSTATE *pRastState)
 {
     SWR_CONTEXT *pContext = GetContext(hContext);
-    API_STATE* pState = GetDrawState(pContext);
+    RASTER_BLOCK* pRaster = GetDrawStateBlock(pContext, &API_STATE::pRaster);
 
-    memcpy(&pState->rastState, pRastState, sizeof(SWR_RASTSTATE));
+    memcpy(&pRaster->rastState, pRastState, sizeof(SWR_RASTSTATE));
 }
 
 void SwrSetViewports(
@@ -675,13 +1115,13 @@ void SwrSetViewports(
         "Invalid number of viewports.");
 
     SWR_CONTEXT *pContext = GetContext(hContext);
-    API_STATE* pState = GetDrawState(pContext);
+    VIEWPORT_BLOCK* pViewport = GetDrawStateBlock(pContext, &API_STATE::pViewport);
 
-    memcpy(&pState->vp[0], pViewports, sizeof(SWR_VIEWPORT) * numViewports);
+    memcpy(&pViewport->vp[0], pViewports, sizeof(SWR_VIEWPORT) * numViewports);
 
     if (pMatrices != nullptr)
     {
-        memcpy(&pState->vpMatrix[0], pMatrices, sizeof(SWR_VIEWPORT_MATRIX) * numViewports);
+        memcpy(&pViewport->vpMatrix[0], pMatrices, sizeof(SWR_VIEWPORT_MATRIX) * numViewports);
     }
     else
     {
@@ -690,32 +1130,32 @@ void SwrSetViewports(
         {
             if (pContext->driverType == DX)
             {
-                pState->vpMatrix[i].m00 = pState->vp[i].width / 2.0f;
-                pState->vpMatrix[i].m11 = -pState->vp[i].height / 2.0f;
-                pState->vpMatrix[i].m22 = pState->vp[i].maxZ - pState->vp[i].minZ;
-                pState->vpMatrix[i].m30 = pState->vp[i].x + pState->vpMatrix[i].m00;
-                pState->vpMatrix[i].m31 = pState->vp[i].y - pState->vpMatrix[i].m11;
-                pState->vpMatrix[i].m32 = pState->vp[i].minZ;
+                pViewport->vpMatrix[i].m00 = pViewport->vp[i].width / 2.0f;
+                pViewport->vpMatrix[i].m11 = -pViewport->vp[i].height / 2.0f;
+                pViewport->vpMatrix[i].m22 = pViewport->vp[i].maxZ - pViewport->vp[i].minZ;
+                pViewport->vpMatrix[i].m30 = pViewport->vp[i].x + pViewport->vpMatrix[i].m00;
+                pViewport->vpMatrix[i].m31 = pViewport->vp[i].y - pViewport->vpMatrix[i].m11;
+                pViewport->vpMatrix[i].m32 = pViewport->vp[i].minZ;
             }
             else
             {
                 // Standard, with the exception that Y is inverted.
-                pState->vpMatrix[i].m00 = (pState->vp[i].width - pState->vp[i].x) / 2.0f;
-                pState->vpMatrix[i].m11 = (pState->vp[i].y - pState->vp[i].height) / 2.0f;
-                pState->vpMatrix[i].m22 = (pState->vp[i].maxZ - pState->vp[i].minZ) / 2.0f;
-                pState->vpMatrix[i].m30 = pState->vp[i].x + pState->vpMatrix[i].m00;
-                pState->vpMatrix[i].m31 = pState->vp[i].height + pState->vpMatrix[i].m11;
-                pState->vpMatrix[i].m32 = pState->vp[i].minZ + pState->vpMatrix[i].m22;
+                pViewport->vpMatrix[i].m00 = (pViewport->vp[i].width - pViewport->vp[i].x) / 2.0f;
+                pViewport->vpMatrix[i].m11 = (pViewport->vp[i].y - pViewport->vp[i].height) / 2.0f;
+                pViewport->vpMatrix[i].m22 = (pViewport->vp[i].maxZ - pViewport->vp[i].minZ) / 2.0f;
+                pViewport->vpMatrix[i].m30 = pViewport->vp[i].x + pViewport->vpMatrix[i].m00;
+                pViewport->vpMatrix[i].m31 = pViewport->vp[i].height + pViewport->vpMatrix[i].m11;
+                pViewport->vpMatrix[i].m32 = pViewport->vp[i].minZ + pViewport->vpMatrix[i].m22;
 
                 // Now that the matrix is calculated, clip the view coords to screen size.
                 // OpenGL allows for -ve x,y in the viewport.
-                pState->vp[i].x = std::max(pState->vp[i].x, 0.0f);
-                pState->vp[i].y = std::max(pState->vp[i].y, 0.0f);
+                pViewport->vp[i].x = std::max(pViewport->vp[i].x, 0.0f);
+                pViewport->vp[i].y = std::max(pViewport->vp[i].y, 0.0f);
             }
         }
     }
 
-    updateGuardband(pState);
+    updateGuardband(pViewport);
 }
 
 void SwrSetScissorRects(
@@ -726,8 +1166,8 @@ void SwrSetScissorRects(
     SWR_ASSERT(numScissors <= KNOB_NUM_VIEWPORTS_SCISSORS,
         "Invalid number of scissor rects.");
 
-    API_STATE* pState = GetDrawState(GetContext(hContext));
-    memcpy(&pState->scissorRects[0], pScissors, numScissors * sizeof(BBOX));
+    VIEWPORT_BLOCK* pViewport = GetDrawStateBlock(GetContext(hContext), &API_STATE::pViewport);
+    memcpy(&pViewport->scissorRects[0], pScissors, numScissors * sizeof(BBOX));
 };
 
 void SetupMacroTileScissors(DRAW_CONTEXT *pDC)
@@ -736,20 +1176,20 @@ void SetupMacroTileScissors(DRAW_CONTEXT *pDC)
     uint32_t left, right, top, bottom;
 
     // Set up scissor dimensions based on scissor or viewport
-    if (pState->rastState.scissorEnable)
+    if (pState->pRaster->rastState.scissorEnable)
     {
         // scissor rect right/bottom edge are exclusive, core expects scissor dimensions to be inclusive, so subtract one pixel from right/bottom edges
-        left = pState->scissorRects[0].left;
-        right = pState->scissorRects[0].right;
-        top = pState->scissorRects[0].top;
-        bottom = pState->scissorRects[0].bottom;
+        left = pState->pViewport->scissorRects[0].left;
+        right = pState->pViewport->scissorRects[0].right;
+        top = pState->pViewport->scissorRects[0].top;
+        bottom = pState->pViewport->scissorRects[0].bottom;
     }
     else
     {
-        left = (int32_t)pState->vp[0].x;
-        right = (int32_t)pState->vp[0].x + (int32_t)pState->vp[0].width;
-        top = (int32_t)pState->vp[0].y;
-        bottom = (int32_t)pState->vp[0].y + (int32_t)pState->vp[0].height;
+        left = (int32_t)pState->pViewport->vp[0].x;
+        right = (int32_t)pState->pViewport->vp[0].x + (int32_t)pState->pViewport->vp[0].width;
+        top = (int32_t)pState->pViewport->vp[0].y;
+        bottom = (int32_t)pState->pViewport->vp[0].y + (int32_t)pState->pViewport->vp[0].height;
     }
 
     right = std::min<uint32_t>(right, KNOB_MAX_SCISSOR_X);
@@ -771,56 +1211,96 @@ void SetupMacroTileScissors(DRAW_CONTEXT *pDC)
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Selects the hottile format for each render target. Single sampled
+///        RGBA8/BGRA8 UNORM and RGBA16 FLOAT targets keep their hottiles in
+///        the surface format when KNOB_NATIVE_COLOR_HOT_TILES is set.
+void SetupColorHotTileFormats(DRAW_CONTEXT *pDC)
+{
+    API_STATE &state = pDC->pState->state;
+    const bool bNativeEnable = KNOB_NATIVE_COLOR_HOT_TILES &&
+                               (state.pRaster->rastState.sampleCount == SWR_MULTISAMPLE_1X) &&
+                               (state.pOutput->blendState.sampleCount == SWR_MULTISAMPLE_1X);
+
+    for (uint32_t rt = 0; rt < SWR_NUM_RENDERTARGETS; ++rt)
+    {
+        SWR_FORMAT hotTileFormat = KNOB_COLOR_HOT_TILE_FORMAT;
+        if (bNativeEnable)
+        {
+            switch (state.pOutput->renderTargetFormat[rt])
+            {
+            case R8G8B8A8_UNORM:
+            case B8G8R8A8_UNORM:
+            case R16G16B16A16_FLOAT:
+                hotTileFormat = state.pOutput->renderTargetFormat[rt];
+                break;
+            default:
+                break;
+            }
+        }
+        state.colorHotTileFormat[rt] = hotTileFormat;
+    }
+}
+
 void SetupPipeline(DRAW_CONTEXT *pDC)
 {
     DRAW_STATE* pState = pDC->pState;
-    const SWR_RASTSTATE &rastState = pState->state.rastState;
+    const SWR_RASTSTATE &rastState = pState->state.pRaster->rastState;
     BACKEND_FUNCS& backendFuncs = pState->backendFuncs;
     const uint32_t forcedSampleCount = (rastState.bForcedSampleCount) ? 1 : 0;
 
+    SetupColorHotTileFormats(pDC);
+
+    // only use the format aware output merger if a render target has a native hottile
+    uint32_t nativeHotTiles = 0;
+    for (uint32_t rt = 0; rt < pState->state.pShaders->psState.numRenderTargets; ++rt)
+    {
+        nativeHotTiles |= (pState->state.colorHotTileFormat[rt] != KNOB_COLOR_HOT_TILE_FORMAT) ? 1 : 0;
+    }
+
     // setup backend
-    if (pState->state.psState.pfnPixelShader == nullptr)
+    if (!HasPixelShader(pState->state))
     {
-        backendFuncs.pfnBackend = gBackendNullPs[pState->state.rastState.sampleCount];
+        backendFuncs.pfnBackend = gBackendNullPs[pState->state.pRaster->rastState.sampleCount];
         // always need to generate I & J per sample for Z interpolation
         backendFuncs.pfnCalcSampleBarycentrics = gSampleBarycentricTable[1];
     }
     else
     {
         const bool bMultisampleEnable = ((rastState.sampleCount > SWR_MULTISAMPLE_1X) || rastState.bForcedSampleCount) ? 1 : 0;
-        const uint32_t centroid = ((pState->state.psState.barycentricsMask & SWR_BARYCENTRIC_CENTROID_MASK) > 0) ? 1 : 0;
+        const uint32_t centroid = ((pState->state.pShaders->psState.barycentricsMask & SWR_BARYCENTRIC_CENTROID_MASK) > 0) ? 1 : 0;
 
         // currently only support 'normal' input coverage
-        SWR_ASSERT(pState->state.psState.inputCoverage == SWR_INPUT_COVERAGE_NORMAL ||
-                   pState->state.psState.inputCoverage == SWR_INPUT_COVERAGE_NONE);
+        SWR_ASSERT(pState->state.pShaders->psState.inputCoverage == SWR_INPUT_COVERAGE_NORMAL ||
+                   pState->state.pShaders->psState.inputCoverage == SWR_INPUT_COVERAGE_NONE);
      
-        SWR_BARYCENTRICS_MASK barycentricsMask = (SWR_BARYCENTRICS_MASK)pState->state.psState.barycentricsMask;
+        SWR_BARYCENTRICS_MASK barycentricsMask = (SWR_BARYCENTRICS_MASK)pState->state.pShaders->psState.barycentricsMask;
         
         // select backend function
-        switch(pState->state.psState.shadingRate)
+        switch(pState->state.pShaders->psState.shadingRate)
         {
         case SWR_SHADING_RATE_PIXEL:
             if(bMultisampleEnable)
             {
                 // always need to generate I & J per sample for Z interpolation
                 barycentricsMask = (SWR_BARYCENTRICS_MASK)(barycentricsMask | SWR_BARYCENTRIC_PER_SAMPLE_MASK);
-                backendFuncs.pfnBackend = gBackendPixelRateTable[rastState.sampleCount][rastState.samplePattern][pState->state.psState.inputCoverage][centroid][forcedSampleCount];
-                backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.psState.numRenderTargets][pState->state.blendState.sampleCount];
+                backendFuncs.pfnBackend = gBackendPixelRateTable[rastState.sampleCount][rastState.samplePattern][pState->state.pShaders->psState.inputCoverage][centroid][forcedSampleCount];
+                backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.pShaders->psState.numRenderTargets][pState->state.pOutput->blendState.sampleCount][nativeHotTiles];
             }
             else
             {
                 // always need to generate I & J per pixel for Z interpolation
                 barycentricsMask = (SWR_BARYCENTRICS_MASK)(barycentricsMask | SWR_BARYCENTRIC_PER_PIXEL_MASK);
-                backendFuncs.pfnBackend = gBackendSingleSample[pState->state.psState.inputCoverage][centroid];
-                backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.psState.numRenderTargets][SWR_MULTISAMPLE_1X];
+                backendFuncs.pfnBackend = gBackendSingleSample[pState->state.pShaders->psState.inputCoverage][centroid];
+                backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.pShaders->psState.numRenderTargets][SWR_MULTISAMPLE_1X][nativeHotTiles];
             }
             break;
         case SWR_SHADING_RATE_SAMPLE:
             SWR_ASSERT(rastState.samplePattern == SWR_MSAA_STANDARD_PATTERN);
             // always need to generate I & J per sample for Z interpolation
             barycentricsMask = (SWR_BARYCENTRICS_MASK)(barycentricsMask | SWR_BARYCENTRIC_PER_SAMPLE_MASK);
-            backendFuncs.pfnBackend = gBackendSampleRateTable[rastState.sampleCount][pState->state.psState.inputCoverage][centroid];
-            backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.psState.numRenderTargets][pState->state.blendState.sampleCount];
+            backendFuncs.pfnBackend = gBackendSampleRateTable[rastState.sampleCount][pState->state.pShaders->psState.inputCoverage][centroid];
+            backendFuncs.pfnOutputMerger = gBackendOutputMergerTable[pState->state.pShaders->psState.numRenderTargets][pState->state.pOutput->blendState.sampleCount][nativeHotTiles];
             break;
         case SWR_SHADING_RATE_COARSE:
         default:
@@ -861,71 +1341,125 @@ void SetupPipeline(DRAW_CONTEXT *pDC)
     };
 
     // disable clipper if viewport transform is disabled
-    if (pState->state.frontendState.vpTransformDisable)
+    if (pState->state.pFrontend->frontendState.vpTransformDisable)
     {
         pState->pfnProcessPrims = pfnBinner;
     }
 
-    if ((pState->state.psState.pfnPixelShader == nullptr) &&
-        (pState->state.depthStencilState.depthTestEnable == FALSE) &&
-        (pState->state.depthStencilState.depthWriteEnable == FALSE) &&
-        (pState->state.depthStencilState.stencilTestEnable == FALSE) &&
-        (pState->state.depthStencilState.stencilWriteEnable == FALSE) &&
-        (pState->state.linkageCount == 0))
+    bool bDisableLinkage = false;
+    if (!HasPixelShader(pState->state) &&
+        (pState->state.pRaster->depthStencilState.depthTestEnable == FALSE) &&
+        (pState->state.pRaster->depthStencilState.depthWriteEnable == FALSE) &&
+        (pState->state.pRaster->depthStencilState.stencilTestEnable == FALSE) &&
+        (pState->state.pRaster->depthStencilState.stencilWriteEnable == FALSE) &&
+        (pState->state.pFrontend->linkageCount == 0))
     {
         pState->pfnProcessPrims = nullptr;
-        pState->state.linkageMask = 0;
+        bDisableLinkage = true;
     }
 
-    if (pState->state.soState.rasterizerDisable == true)
+    if (pState->state.pFrontend->soState.rasterizerDisable == true)
     {
         pState->pfnProcessPrims = nullptr;
-        pState->state.linkageMask = 0;
+        bDisableLinkage = true;
+    }
+
+    if (bDisableLinkage && (pState->state.pFrontend->linkageMask != 0))
+    {
+        WriteStateBlock(pDC->pContext, pState->state.pFrontend)->linkageMask = 0;
     }
 
     // set up the frontend attrib mask
-    pState->state.feAttribMask = pState->state.linkageMask;
-    if (pState->state.soState.soEnable)
+    pState->state.feAttribMask = pState->state.pFrontend->linkageMask;
+    if (pState->state.pFrontend->soState.soEnable)
     {
         for (uint32_t i = 0; i < 4; ++i)
         {
-            pState->state.feAttribMask |= pState->state.soState.streamMasks[i];
+            pState->state.feAttribMask |= pState->state.pFrontend->soState.streamMasks[i];
         }
     }
 
     // complicated logic to test for cases where we don't need backing hottile memory for a draw
     // have to check for the special case where depth/stencil test is enabled but depthwrite is disabled.
-    pState->state.depthHottileEnable = ((!(pState->state.depthStencilState.depthTestEnable &&
-                                           !pState->state.depthStencilState.depthWriteEnable &&
-                                           pState->state.depthStencilState.depthTestFunc == ZFUNC_ALWAYS)) && 
-                                        (pState->state.depthStencilState.depthTestEnable || 
-                                         pState->state.depthStencilState.depthWriteEnable)) ? true : false;
-
-    pState->state.stencilHottileEnable = (((!(pState->state.depthStencilState.stencilTestEnable &&
-                                             !pState->state.depthStencilState.stencilWriteEnable &&
-                                              pState->state.depthStencilState.stencilTestFunc == ZFUNC_ALWAYS)) ||
+    pState->state.depthHottileEnable = ((!(pState->state.pRaster->depthStencilState.depthTestEnable &&
+                                           !pState->state.pRaster->depthStencilState.depthWriteEnable &&
+                                           pState->state.pRaster->depthStencilState.depthTestFunc == ZFUNC_ALWAYS)) && 
+                                        (pState->state.pRaster->depthStencilState.depthTestEnable || 
+                                         pState->state.pRaster->depthStencilState.depthWriteEnable)) ? true : false;
+
+    pState->state.stencilHottileEnable = (((!(pState->state.pRaster->depthStencilState.stencilTestEnable &&
+                                             !pState->state.pRaster->depthStencilState.stencilWriteEnable &&
+                                              pState->state.pRaster->depthStencilState.stencilTestFunc == ZFUNC_ALWAYS)) ||
                                           // for stencil we have to check the double sided state as well
-                                          (!(pState->state.depthStencilState.doubleSidedStencilTestEnable &&
-                                             !pState->state.depthStencilState.stencilWriteEnable &&
-                                              pState->state.depthStencilState.backfaceStencilTestFunc == ZFUNC_ALWAYS))) && 
-                                          (pState->state.depthStencilState.stencilTestEnable  ||
-                                           pState->state.depthStencilState.stencilWriteEnable)) ? true : false;
+                                          (!(pState->state.pRaster->depthStencilState.doubleSidedStencilTestEnable &&
+                                             !pState->state.pRaster->depthStencilState.stencilWriteEnable &&
+                                              pState->state.pRaster->depthStencilState.backfaceStencilTestFunc == ZFUNC_ALWAYS))) && 
+                                          (pState->state.pRaster->depthStencilState.stencilTestEnable  ||
+                                           pState->state.pRaster->depthStencilState.stencilWriteEnable)) ? true : false;
 
-    uint32_t numRTs = pState->state.psState.numRenderTargets;
+    uint32_t numRTs = pState->state.pShaders->psState.numRenderTargets;
     pState->state.colorHottileEnable = 0;
-    if(pState->state.psState.pfnPixelShader != nullptr)
+    if(HasPixelShader(pState->state))
     {
         for (uint32_t rt = 0; rt < numRTs; ++rt)
         {
             pState->state.colorHottileEnable |=  
-                (!pState->state.blendState.renderTarget[rt].writeDisableAlpha ||
-                 !pState->state.blendState.renderTarget[rt].writeDisableRed ||
-                 !pState->state.blendState.renderTarget[rt].writeDisableGreen ||
-                 !pState->state.blendState.renderTarget[rt].writeDisableBlue) ? (1 << rt) : 0;
+                (!pState->state.pOutput->blendState.renderTarget[rt].writeDisableAlpha ||
+                 !pState->state.pOutput->blendState.renderTarget[rt].writeDisableRed ||
+                 !pState->state.pOutput->blendState.renderTarget[rt].writeDisableGreen ||
+                 !pState->state.pOutput->blendState.renderTarget[rt].writeDisableBlue) ? (1 << rt) : 0;
         }
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Starts a new HiZ generation with an op that may raise depth.
+///        The binner of the ops after it won't trust the coarse depth
+///        published before it, see HIZ_TILE.
+/// @param exclusive - The op raises depth gradually in the BE, so the ops
+///        after it need a generation of their own too.
+void StartHiZGeneration(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, bool exclusive)
+{
+    // 0 marks invalid coarse depth
+    if (++pContext->hiZGeneration == 0)
+    {
+        ++pContext->hiZGeneration;
+    }
+    pDC->hiZGeneration = pContext->hiZGeneration;
+
+    if (exclusive && ++pContext->hiZGeneration == 0)
+    {
+        ++pContext->hiZGeneration;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if a draw may leave depth farther than it was.
+bool MayRaiseDepth(const API_STATE& state)
+{
+    const SWR_DEPTH_STENCIL_STATE& dsState = state.pRaster->depthStencilState;
+    if (!state.depthHottileEnable || !dsState.depthWriteEnable)
+    {
+        return false;
+    }
+
+    if (!HiZTracksDepthWrites(state))
+    {
+        return true;
+    }
+
+    switch (dsState.depthTestFunc)
+    {
+    case ZFUNC_NEVER:
+    case ZFUNC_LT:
+    case ZFUNC_EQ:
+    case ZFUNC_LE:
+        return !dsState.depthTestEnable || state.pShaders->psState.writesODepth;
+    default:
+        return true;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief InitDraw
 /// @param pDC - Draw context to initialize for this draw.
@@ -939,6 +1473,11 @@ void InitDraw(
         SetupMacroTileScissors(pDC);
         SetupPipeline(pDC);
     }
+
+    if (MayRaiseDepth(pDC->pState->state))
+    {
+        StartHiZGeneration(pDC->pContext, pDC, true);
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -954,7 +1493,7 @@ uint32_t MaxVertsPerDraw(
 
     uint32_t vertsPerDraw = totalVerts;
 
-    if (state.soState.soEnable)
+    if (state.pFrontend->soState.soEnable)
     {
         return totalVerts;
     }
@@ -998,7 +1537,7 @@ uint32_t MaxVertsPerDraw(
     case TOP_PATCHLIST_30:
     case TOP_PATCHLIST_31:
     case TOP_PATCHLIST_32:
-        if (pDC->pState->state.tsState.tsEnable)
+        if (pDC->pState->state.pShaders->tsState.tsEnable)
         {
             uint32_t vertsPerPrim = topology - TOP_PATCHLIST_BASE;
             vertsPerDraw = vertsPerPrim * KNOB_MAX_TESS_PRIMS_PER_DRAW;
@@ -1085,10 +1624,10 @@ void DrawInstanced(
     pState->forceFront = false;
 
     // disable culling for points/lines
-    uint32_t oldCullMode = pState->rastState.cullMode;
+    uint32_t oldCullMode = pState->pRaster->rastState.cullMode;
     if (topology == TOP_POINT_LIST)
     {
-        pState->rastState.cullMode = SWR_CULLMODE_NONE;
+        WriteStateBlock(pContext, pState->pRaster)->rastState.cullMode = SWR_CULLMODE_NONE;
         pState->forceFront = true;
     }
 
@@ -1105,9 +1644,9 @@ void DrawInstanced(
         pDC->FeWork.type = DRAW;
         pDC->FeWork.pfnWork = GetFEDrawFunc(
             false,  // IsIndexed
-            pState->tsState.tsEnable,
-            pState->gsState.gsEnable,
-            pState->soState.soEnable,
+            pState->pShaders->tsState.tsEnable,
+            pState->pShaders->gsState.gsEnable,
+            pState->pFrontend->soState.soEnable,
             pDC->pState->pfnProcessPrims != nullptr);
         pDC->FeWork.desc.draw.numVerts = numVertsForDraw;
         pDC->FeWork.desc.draw.startVertex = startVertex;
@@ -1125,7 +1664,10 @@ void DrawInstanced(
 
     // restore culling state
     pDC = GetDrawContext(pContext);
-    pDC->pState->state.rastState.cullMode = oldCullMode;
+    if (pDC->pState->state.pRaster->rastState.cullMode != oldCullMode)
+    {
+        WriteStateBlock(pContext, pDC->pState->state.pRaster)->rastState.cullMode = oldCullMode;
+    }
 
     RDTSC_STOP(APIDraw, numVertices * numInstances, 0);
 }
@@ -1199,7 +1741,7 @@ void DrawIndexedInstance(
     int32_t remainingIndices = numIndices;
 
     uint32_t indexSize = 0;
-    switch (pState->indexBuffer.format)
+    switch (pState->pVertexInput->indexBuffer.format)
     {
     case R32_UINT: indexSize = sizeof(uint32_t); break;
     case R16_UINT: indexSize = sizeof(uint16_t); break;
@@ -1209,17 +1751,17 @@ void DrawIndexedInstance(
     }
 
     int draw = 0;
-    uint8_t *pIB = (uint8_t*)pState->indexBuffer.pIndices;
+    uint8_t *pIB = (uint8_t*)pState->pVertexInput->indexBuffer.pIndices;
     pIB += (uint64_t)indexOffset * (uint64_t)indexSize;
 
     pState->topology = topology;
     pState->forceFront = false;
 
     // disable culling for points/lines
-    uint32_t oldCullMode = pState->rastState.cullMode;
+    uint32_t oldCullMode = pState->pRaster->rastState.cullMode;
     if (topology == TOP_POINT_LIST)
     {
-        pState->rastState.cullMode = SWR_CULLMODE_NONE;
+        WriteStateBlock(pContext, pState->pRaster)->rastState.cullMode = SWR_CULLMODE_NONE;
         pState->forceFront = true;
     }
 
@@ -1236,14 +1778,14 @@ void DrawIndexedInstance(
         pDC->FeWork.type = DRAW;
         pDC->FeWork.pfnWork = GetFEDrawFunc(
             true,   // IsIndexed
-            pState->tsState.tsEnable,
-            pState->gsState.gsEnable,
-            pState->soState.soEnable,
+            pState->pShaders->tsState.tsEnable,
+            pState->pShaders->gsState.gsEnable,
+            pState->pFrontend->soState.soEnable,
             pDC->pState->pfnProcessPrims != nullptr);
         pDC->FeWork.desc.draw.pDC = pDC;
         pDC->FeWork.desc.draw.numIndices = numIndicesForDraw;
         pDC->FeWork.desc.draw.pIB = (int*)pIB;
-        pDC->FeWork.desc.draw.type = pDC->pState->state.indexBuffer.format;
+        pDC->FeWork.desc.draw.type = pDC->pState->state.pVertexInput->indexBuffer.format;
 
         pDC->FeWork.desc.draw.numInstances = numInstances;
         pDC->FeWork.desc.draw.startInstance = startInstance;
@@ -1260,7 +1802,10 @@ void DrawIndexedInstance(
 
     // restore culling state
     pDC = GetDrawContext(pContext);
-    pDC->pState->state.rastState.cullMode = oldCullMode;
+    if (pDC->pState->state.pRaster->rastState.cullMode != oldCullMode)
+    {
+        WriteStateBlock(pContext, pDC->pState->state.pRaster)->rastState.cullMode = oldCullMode;
+    }
 
     RDTSC_STOP(APIDrawIndexed, numIndices * numInstances, 0);
 }
@@ -1305,6 +1850,98 @@ void SwrDrawIndexedInstanced(
     DrawIndexedInstance(hContext, topology, numIndices, indexOffset, baseVertex, numInstances, startInstance);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief DrawIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param isIndexed - Whether pArgs are SWR_DRAW_INDEXED_INDIRECT_ARGS.
+/// @param pArgs - Draw arguments, read by the FE.
+void DrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    bool isIndexed,
+    const void* pArgs)
+{
+    if (KNOB_TOSS_DRAW)
+    {
+        return;
+    }
+
+    RDTSC_START(APIDraw);
+
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    DRAW_CONTEXT* pDC = GetDrawContext(pContext);
+    API_STATE* pState = &pDC->pState->state;
+
+    pState->topology = topology;
+    pState->forceFront = false;
+
+    // disable culling for points/lines
+    uint32_t oldCullMode = pState->pRaster->rastState.cullMode;
+    if (topology == TOP_POINT_LIST)
+    {
+        WriteStateBlock(pContext, pState->pRaster)->rastState.cullMode = SWR_CULLMODE_NONE;
+        pState->forceFront = true;
+    }
+
+    // The vertex count isn't known until the FE runs, so the draw can't be
+    // split like DrawInstanced and DrawIndexedInstance do.
+    InitDraw(pDC, false);
+
+    pDC->FeWork.type = DRAW;
+    pDC->FeWork.pfnWork = isIndexed ? ProcessDrawIndexedIndirect : ProcessDrawIndirect;
+    pDC->FeWork.desc.draw.pDC = pDC;
+    pDC->FeWork.desc.draw.type = pState->pVertexInput->indexBuffer.format;
+    pDC->FeWork.desc.draw.pIndirectArgs = pArgs;
+    pDC->FeWork.desc.draw.pfnIndirectDraw = GetFEDrawFunc(
+        isIndexed,
+        pState->pShaders->tsState.tsEnable,
+        pState->pShaders->gsState.gsEnable,
+        pState->pFrontend->soState.soEnable,
+        pDC->pState->pfnProcessPrims != nullptr);
+
+    // args may be written by streamout of previous draws
+    pDC->dependentFE = true;
+
+    //enqueue DC
+    QueueDraw(pContext);
+
+    // restore culling state
+    pDC = GetDrawContext(pContext);
+    if (pDC->pState->state.pRaster->rastState.cullMode != oldCullMode)
+    {
+        WriteStateBlock(pContext, pDC->pState->state.pRaster)->rastState.cullMode = oldCullMode;
+    }
+
+    RDTSC_STOP(APIDraw, 0, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Draw arguments.
+void SwrDrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const SWR_DRAW_INDIRECT_ARGS* pArgs)
+{
+    DrawIndirect(hContext, topology, false, pArgs);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndexedIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Draw arguments.
+void SwrDrawIndexedIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const SWR_DRAW_INDEXED_INDIRECT_ARGS* pArgs)
+{
+    DrawIndirect(hContext, topology, true, pArgs);
+}
+
 // Attach surfaces to pipeline
 void SwrInvalidateTiles(
     HANDLE hContext,
@@ -1318,6 +1955,11 @@ void SwrInvalidateTiles(
     pDC->FeWork.pfnWork = ProcessInvalidateTiles;
     pDC->FeWork.desc.invalidateTiles.attachmentMask = attachmentMask;
 
+    if (attachmentMask & SWR_ATTACHMENT_DEPTH_BIT)
+    {
+        StartHiZGeneration(pContext, pDC, false);
+    }
+
     //enqueue
     QueueDraw(pContext);
 }
@@ -1380,6 +2022,12 @@ void SwrStoreTiles(
     pDC->FeWork.desc.storeTiles.attachment = attachment;
     pDC->FeWork.desc.storeTiles.postStoreTileState = postStoreTileState;
 
+    // the surface may be written behind our back once stored
+    if (attachment == SWR_ATTACHMENT_DEPTH)
+    {
+        StartHiZGeneration(pContext, pDC, false);
+    }
+
     //enqueue
     QueueDraw(pContext);
 
@@ -1400,6 +2048,7 @@ void SwrClearRenderTarget(
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
     SetupMacroTileScissors(pDC);
+    SetupColorHotTileFormats(pDC);
 
     CLEAR_FLAGS flags;
     flags.mask = clearMask;
@@ -1414,6 +2063,11 @@ void SwrClearRenderTarget(
     pDC->FeWork.desc.clear.clearRTColor[3] = clearColor[3];
     pDC->FeWork.desc.clear.clearStencil = stencil;
 
+    if (clearMask & SWR_CLEAR_DEPTH)
+    {
+        StartHiZGeneration(pContext, pDC, false);
+    }
+
     // enqueue draw
     QueueDraw(pContext);
 
@@ -1501,6 +2155,47 @@ void SwrEnableStats(
     pDC->pState->state.enableStats = enable;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Changes the number of draws that can be queued before the API
+///        thread blocks. Takes effect when the next draw context is
+///        started, which first waits for all queued draws to retire.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param maxDrawsInFlight - New size of the draw context ring.
+void SwrSetMaxDrawsInFlight(
+    HANDLE hContext,
+    uint32_t maxDrawsInFlight)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    // the next draw context and state must not be the previous ones
+    maxDrawsInFlight = std::max(maxDrawsInFlight, 2u);
+
+    pContext->nextMaxDrawsInFlight = (maxDrawsInFlight != pContext->maxDrawsInFlight) ? maxDrawsInFlight : 0;
+    pContext->growDrawRings = false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns counters for sizing the draw context ring.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SwrGetDrawRingStats(
+    HANDLE hContext,
+    SWR_DRAW_RING_STATS* pStats)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    *pStats = pContext->ringStats;
+    pStats->maxDrawsInFlight = pContext->maxDrawsInFlight;
+    pStats->numDraws = pContext->DrawEnqueued - 1;
+
+    THREAD_POOL *pPool = pContext->pThreadPool;
+    pStats->workerIdleTicks = 0;
+    for (uint32_t t = 0; t < pPool->numThreads; ++t)
+    {
+        pStats->workerIdleTicks += pPool->pThreadData[t].idleTicks;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Mark end of frame - used for performance profiling
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -1508,4 +2203,7 @@ void SWR_API SwrEndFrame(
     HANDLE hContext)
 {
     RDTSC_ENDFRAME();
+    Arena::EndFrame();
+
+    GrowDrawRingsIfIdle(GetContext(hContext));
 }
@@ -62,10 +62,11 @@ typedef void(SWR_API *PFN_LOAD_TILE)(HANDLE hPrivateContext, SWR_FORMAT dstForma
 /// @param renderTargetIndex - render target to store, can be color, depth or stencil
 /// @param x - destination x coordinate
 /// @param y - destination y coordinate
+/// @param numSamples - samples in the hot tile, resolved if the surface has fewer
 /// @param pSrcHotTile - pointer to the hot tile surface
 typedef void(SWR_API *PFN_STORE_TILE)(HANDLE hPrivateContext, SWR_FORMAT srcFormat,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
-    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, BYTE *pSrcHotTile);
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSamples, BYTE *pSrcHotTile);
 
 /// @brief Function signature for clearing from the hot tiles clear value
 /// @param hPrivateContext - handle to private data
@@ -95,6 +96,35 @@ struct SWR_CREATECONTEXT_INFO
     PFN_LOAD_TILE pfnLoadTile;
     PFN_STORE_TILE pfnStoreTile;
     PFN_CLEAR_TILE pfnClearTile;
+
+    // Worker pool shared with other contexts, from SwrCreateWorkerPool. If null, or the
+    // pool already has the maximum number of contexts, the context gets its own workers.
+    HANDLE hWorkerPool;
+
+    // Share of the shared pool's workers relative to its other contexts, see
+    // SwrSetWorkerPoolWeight.
+    uint32_t workerPoolWeight;
+
+    // Number of draws that can be queued before the API thread blocks, see
+    // SwrSetMaxDrawsInFlight. 0 uses KNOB_MAX_DRAWS_IN_FLIGHT.
+    uint32_t maxDrawsInFlight;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DRAW_RING_STATS
+/////////////////////////////////////////////////////////////////////////
+struct SWR_DRAW_RING_STATS
+{
+    uint32_t maxDrawsInFlight;      // Current size of the draw context ring
+    uint32_t numGrows;              // Times the ring was grown after filling up
+    uint64_t numDraws;              // Draw contexts queued, including syncs, clears, dispatches, etc.
+    uint64_t numRingFullWaits;      // Times the API thread waited for the oldest draw to retire
+    uint64_t ringFullWaitTicks;     // RDTSC ticks the API thread spent in those waits
+    uint64_t numStateBlockCopies;   // State blocks copied because a setter changed one queued draws share
+
+    // RDTSC ticks summed over the workers while no attached context had a queued draw.
+    // With a shared worker pool, this is for the whole pool.
+    uint64_t workerIdleTicks;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -120,6 +150,28 @@ HANDLE SWR_API SwrCreateContext(
 void SWR_API SwrDestroyContext(
     HANDLE hContext);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Create a pool of worker threads that several contexts can share,
+///        instead of each creating as many workers as there are HW threads.
+///        Contexts are attached with SWR_CREATECONTEXT_INFO::hWorkerPool.
+HANDLE SWR_API SwrCreateWorkerPool();
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Destroys a worker pool. All contexts using it must be destroyed first.
+/// @param hWorkerPool - Handle passed back from SwrCreateWorkerPool
+void SWR_API SwrDestroyWorkerPool(
+    HANDLE hWorkerPool);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Sets the share of its worker pool a context gets while other
+///        contexts of the pool have work too. A context with weight 2 is
+///        worked on twice as often as one with weight 1.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param weight - Relative weight, at least 1
+void SWR_API SwrSetWorkerPoolWeight(
+    HANDLE hContext,
+    uint32_t weight);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set currently active state context
 /// @param subContextIndex - value from 0 to
@@ -183,6 +235,34 @@ void SWR_API SwrSetSoFunc(
     PFN_SO_FUNC    pfnSoFunc,
     uint32_t streamIndex);
 
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DEFERRED_FUNC
+/// @brief Jitted functions that can be set while still being compiled.
+//////////////////////////////////////////////////////////////////////////
+enum SWR_DEFERRED_FUNC
+{
+    SWR_DEFERRED_FETCH_FUNC,
+    SWR_DEFERRED_PIXEL_SHADER,
+    SWR_DEFERRED_SO_FUNC,   // + streamIndex
+    SWR_NUM_DEFERRED_FUNCS = SWR_DEFERRED_SO_FUNC + MAX_SO_STREAMS
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Set a jitted function that may still be compiling.  Draws are
+///        queued as usual, but their frontend doesn't start until the
+///        compiler has written the function to *ppFunc.  Setting the
+///        function with SwrSetFetchFunc, SwrSetPixelShaderState or
+///        SwrSetSoFunc clears it again.  With KNOB_SINGLE_THREADED draws
+///        run as they are queued, so the function has to be compiled by then.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param func - Function to set.
+/// @param ppFunc - Location the function is written to once compiled.
+///                 Must stay valid until all draws using it are done.
+void SWR_API SwrSetDeferredFunc(
+    HANDLE hContext,
+    SWR_DEFERRED_FUNC func,
+    void* volatile* ppFunc);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set streamout state
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -299,6 +379,17 @@ void SWR_API SwrSetBlendState(
     HANDLE hContext,
     SWR_BLEND_STATE *pState);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Set render target surface formats. Used to select the color
+///        hottile format when KNOB_NATIVE_COLOR_HOT_TILES is enabled.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param numRenderTargets - number of formats in pFormats
+/// @param pFormats - Format of each bound render target.
+void SWR_API SwrSetRenderTargetFormats(
+    HANDLE hContext,
+    uint32_t numRenderTargets,
+    const SWR_FORMAT *pFormats);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set blend function
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -382,6 +473,56 @@ void SWR_API SwrDrawIndexedInstanced(
     int32_t baseVertex,
     uint32_t startInstance);
 
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DRAW_INDIRECT_ARGS
+/// @brief Arguments of SwrDrawIndirect, laid out as in the argument buffer.
+//////////////////////////////////////////////////////////////////////////
+struct SWR_DRAW_INDIRECT_ARGS
+{
+    uint32_t numVertices;
+    uint32_t numInstances;
+    uint32_t startVertex;
+    uint32_t startInstance;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DRAW_INDEXED_INDIRECT_ARGS
+/// @brief Arguments of SwrDrawIndexedIndirect, laid out as in the argument
+///        buffer.
+//////////////////////////////////////////////////////////////////////////
+struct SWR_DRAW_INDEXED_INDIRECT_ARGS
+{
+    uint32_t numIndices;
+    uint32_t numInstances;
+    uint32_t indexOffset;
+    int32_t  baseVertex;
+    uint32_t startInstance;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndirect
+///        The arguments are read by the frontend when the draw executes,
+///        after the frontend of all previous draws is done, so they can be
+///        written by earlier streamout.  The draw isn't split.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Draw arguments.  Must stay valid until the draw is done.
+void SWR_API SwrDrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const SWR_DRAW_INDIRECT_ARGS* pArgs);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndexedIndirect
+///        Indexed version of SwrDrawIndirect, using the bound index buffer.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Draw arguments.  Must stay valid until the draw is done.
+void SWR_API SwrDrawIndexedIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const SWR_DRAW_INDEXED_INDIRECT_ARGS* pArgs);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief SwrInvalidateTiles
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -492,6 +633,26 @@ void SWR_API SwrEnableStats(
     HANDLE hContext,
     bool enable);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Changes the number of draws that can be queued before the API
+///        thread blocks. Takes effect when the next draw context is
+///        started, which first waits for all queued draws to retire.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param maxDrawsInFlight - New size of the draw context ring.
+void SWR_API SwrSetMaxDrawsInFlight(
+    HANDLE hContext,
+    uint32_t maxDrawsInFlight);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns counters for sizing the draw context ring. Can be called
+///        at any time, the counters are only approximate while draws are
+///        queued.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SWR_API SwrGetDrawRingStats(
+    HANDLE hContext,
+    SWR_DRAW_RING_STATS* pStats);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Mark end of frame - used for performance profiling
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -35,132 +35,218 @@
 #include "arena.h"
 
 #include <cmath>
-
-Arena::Arena()
-    : m_pCurBlock(nullptr), m_size(0)
+#include <mutex>
+
+static const size_t ArenaBlockSize = 1024*1024;
+
+//////////////////////////////////////////////////////////////////////////
+/// ArenaBlockCache - Free arena blocks of all arenas of all contexts, by
+/// size in MB. Arenas take blocks from it as they grow and give them back
+/// on Reset, so a heavy draw followed by light ones doesn't malloc and
+/// free its blocks over and over. Holds up to KNOB_ARENA_BLOCK_CACHE_MB,
+/// blocks past that are freed.
+//////////////////////////////////////////////////////////////////////////
+class ArenaBlockCache
 {
-    m_pMutex = new std::mutex();
-}
+public:
+    static const uint32_t MAX_BLOCK_MB = 16;    // larger blocks aren't cached
 
-Arena::~Arena()
-{
-    Reset();        // Reset just in case to avoid leaking memory.
+    Arena::ArenaBlock* Get(size_t blockSize)
+    {
+        SWR_ASSERT((blockSize % ArenaBlockSize) == 0);
+        size_t sizeMB = blockSize / ArenaBlockSize;
 
-    if (m_pCurBlock)
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            if (sizeMB <= MAX_BLOCK_MB && mpFree[sizeMB] != nullptr)
+            {
+                Arena::ArenaBlock* pBlock = mpFree[sizeMB];
+                mpFree[sizeMB] = pBlock->pNext;
+                mCachedBytes -= blockSize;
+
+                pBlock->offset = 0;
+                pBlock->pNext = nullptr;
+                return pBlock;
+            }
+            mNumMallocs++;
+        }
+
+        void *pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
+        SWR_ASSERT(pMem != nullptr);
+
+        Arena::ArenaBlock* pBlock = new Arena::ArenaBlock();
+        pBlock->pMem = pMem;
+        pBlock->blockSize = blockSize;
+        return pBlock;
+    }
+
+    void Put(Arena::ArenaBlock* pBlock)
     {
-        _aligned_free(m_pCurBlock->pMem);
-        delete m_pCurBlock;
+        size_t sizeMB = pBlock->blockSize / ArenaBlockSize;
+
+        {
+            std::unique_lock<std::mutex> lock(mLock);
+            if (sizeMB <= MAX_BLOCK_MB &&
+                mCachedBytes + pBlock->blockSize <= (size_t)KNOB_ARENA_BLOCK_CACHE_MB * ArenaBlockSize)
+            {
+                pBlock->pNext = mpFree[sizeMB];
+                mpFree[sizeMB] = pBlock;
+                mCachedBytes += pBlock->blockSize;
+                return;
+            }
+        }
+
+        _aligned_free(pBlock->pMem);
+        delete pBlock;
     }
 
-    delete m_pMutex;
-}
+    void AddBytesAllocated(size_t size)
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        mBytesAllocated += size;
+    }
+
+    void EndFrame()
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        mFrameBytesAllocated = mBytesAllocated;
+        mFrameNumMallocs = mNumMallocs;
+        mBytesAllocated = 0;
+        mNumMallocs = 0;
+    }
+
+    void GetFrameStats(SWR_STATS& stats)
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        stats.ArenaBytesAllocated = mFrameBytesAllocated;
+        stats.ArenaBlockMallocs = mFrameNumMallocs;
+    }
+
+private:
+    std::mutex mLock;
+    Arena::ArenaBlock* mpFree[MAX_BLOCK_MB + 1] = {};
+    size_t mCachedBytes = 0;
 
-///@todo Remove this when all users have stopped using this.
-void Arena::Init()
+    // counts for the current and the last complete frame
+    uint64_t mBytesAllocated = 0;
+    uint64_t mNumMallocs = 0;
+    uint64_t mFrameBytesAllocated = 0;
+    uint64_t mFrameNumMallocs = 0;
+};
+
+// Never destroyed, arenas may outlive static destructors.
+static ArenaBlockCache& gArenaBlockCache = *new ArenaBlockCache();
+
+Arena::Arena()
+    : m_pCurBlock(nullptr), m_size(0)
 {
-    m_size = 0;
-    m_pCurBlock = nullptr;
+}
 
-    m_pMutex = new std::mutex();
+Arena::~Arena()
+{
+    Reset(true);
 }
 
-void* Arena::AllocAligned(size_t size, size_t align)
+void* Arena::BumpAlloc(ArenaBlock*& pCurBlock, size_t size, size_t align)
 {
-    if (m_pCurBlock)
+    if (pCurBlock)
     {
-        ArenaBlock* pCurBlock = m_pCurBlock;
-        pCurBlock->offset = AlignUp(pCurBlock->offset, align);
+        size_t offset = AlignUp(pCurBlock->offset, align);
 
-        if ((pCurBlock->offset + size) <= pCurBlock->blockSize)
+        if ((offset + size) <= pCurBlock->blockSize)
         {
-            void* pMem = PtrAdd(pCurBlock->pMem, pCurBlock->offset);
-            pCurBlock->offset += size;
-            m_size += size;
-            return pMem;
+            pCurBlock->offset = offset + size;
+            return PtrAdd(pCurBlock->pMem, offset);
         }
 
         // Not enough memory in this block, fall through to allocate
         // a new block
     }
 
-    static const size_t ArenaBlockSize = 1024*1024;
-    size_t blockSize = std::max(m_size + ArenaBlockSize, std::max(size, ArenaBlockSize));
-    blockSize = AlignUp(blockSize, KNOB_SIMD_WIDTH*4);
+    // blocks come in MB multiples, so that they can be shared through the cache
+    size_t blockSize = AlignUp(std::max(size, ArenaBlockSize), ArenaBlockSize);
 
-    void *pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
-    SWR_ASSERT(pMem != nullptr);
+    ArenaBlock* pNewBlock = gArenaBlockCache.Get(blockSize);
+    pNewBlock->pNext = pCurBlock;
+    pCurBlock = pNewBlock;
 
-    ArenaBlock* pNewBlock = new (std::nothrow) ArenaBlock();
-    SWR_ASSERT(pNewBlock != nullptr);
+    return BumpAlloc(pCurBlock, size, align);
+}
 
-    if (pNewBlock != nullptr)
+size_t Arena::ReleaseBlocks(ArenaBlock* pBlocks)
+{
+    size_t usedSize = 0;
+    while (pBlocks)
     {
-        pNewBlock->pNext        = m_pCurBlock;
-
-        m_pCurBlock             = pNewBlock;
-        m_pCurBlock->pMem       = pMem;
-        m_pCurBlock->blockSize  = blockSize;
+        ArenaBlock* pBlock = pBlocks;
+        pBlocks = pBlock->pNext;
 
+        usedSize += pBlock->offset;
+        gArenaBlockCache.Put(pBlock);
     }
-
-    return AllocAligned(size, align);
+    return usedSize;
 }
 
-void* Arena::Alloc(size_t size)
+void* Arena::AllocAligned(size_t size, size_t align)
 {
-    return AllocAligned(size, 1);
+    m_size += size;
+    return BumpAlloc(m_pCurBlock, size, align);
 }
 
-void* Arena::AllocAlignedSync(size_t size, size_t align)
+void* Arena::Alloc(size_t size)
 {
-    void* pAlloc = nullptr;
-
-    SWR_ASSERT(m_pMutex != nullptr);
-
-    m_pMutex->lock();
-    pAlloc = AllocAligned(size, align);
-    m_pMutex->unlock();
-
-    return pAlloc;
+    return AllocAligned(size, 1);
 }
 
-void* Arena::AllocSync(size_t size)
+void* Arena::AllocAlignedWorker(uint32_t workerId, size_t size, size_t align)
 {
-    void* pAlloc = nullptr;
-
-    SWR_ASSERT(m_pMutex != nullptr);
+    SWR_ASSERT(workerId < KNOB_MAX_NUM_THREADS);
 
-    m_pMutex->lock();
-    pAlloc = Alloc(size);
-    m_pMutex->unlock();
-
-    return pAlloc;
+    return BumpAlloc(m_pWorkerBlocks[workerId], size, align);
 }
 
 void Arena::Reset(bool removeAll)
 {
+    size_t usedSize = m_size;
+
     if (m_pCurBlock)
     {
-        m_pCurBlock->offset = 0;
-
+        // keep the current block, unless asked to remove all
         ArenaBlock *pUsedBlocks = m_pCurBlock->pNext;
         m_pCurBlock->pNext = nullptr;
-        while(pUsedBlocks)
-        {
-            ArenaBlock* pBlock = pUsedBlocks;
-            pUsedBlocks = pBlock->pNext;
-
-            _aligned_free(pBlock->pMem);
-            delete pBlock;
-        }
+        ReleaseBlocks(pUsedBlocks);
 
+        m_pCurBlock->offset = 0;
         if (removeAll)
         {
-            _aligned_free(m_pCurBlock->pMem);
-            delete m_pCurBlock;
+            ReleaseBlocks(m_pCurBlock);
             m_pCurBlock = nullptr;
         }
     }
 
+    for (uint32_t i = 0; i < KNOB_MAX_NUM_THREADS; ++i)
+    {
+        if (m_pWorkerBlocks[i])
+        {
+            usedSize += ReleaseBlocks(m_pWorkerBlocks[i]);
+            m_pWorkerBlocks[i] = nullptr;
+        }
+    }
+
+    if (usedSize)
+    {
+        gArenaBlockCache.AddBytesAllocated(usedSize);
+    }
+
     m_size = 0;
 }
+
+void Arena::EndFrame()
+{
+    gArenaBlockCache.EndFrame();
+}
+
+void Arena::GetFrameStats(SWR_STATS& stats)
+{
+    gArenaBlockCache.GetFrameStats(stats);
+}
@@ -32,7 +32,9 @@
 ******************************************************************************/
 #pragma once
 
-#include <mutex>
+#include "knobs.h"
+
+struct SWR_STATS;
 
 class Arena
 {
@@ -40,17 +42,23 @@ public:
     Arena();
    ~Arena();
 
-    void        Init();
-
     void*       AllocAligned(size_t size, size_t  align);
     void*       Alloc(size_t  size);
 
-    void*       AllocAlignedSync(size_t size, size_t align);
-    void*       AllocSync(size_t size);
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Allocation for workers allocating from the arena concurrently.
+    ///        Each worker bumps through its own blocks, no locking needed.
+    void*       AllocAlignedWorker(uint32_t workerId, size_t size, size_t align);
 
     void        Reset(bool removeAll = false);
     size_t      Size() { return m_size; }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Arena usage over the last complete frame of all contexts,
+    ///        see SwrEndFrame.
+    static void EndFrame();
+    static void GetFrameStats(SWR_STATS& stats);
+
 private:
 
     struct ArenaBlock
@@ -61,9 +69,14 @@ private:
         ArenaBlock* pNext       = nullptr;
     };
 
+    static void*    BumpAlloc(ArenaBlock*& pCurBlock, size_t size, size_t align);
+    static size_t   ReleaseBlocks(ArenaBlock* pBlocks);
+
+    friend class ArenaBlockCache;
+
     ArenaBlock*     m_pCurBlock = nullptr;
     size_t          m_size      = 0;
 
-    /// @note Mutex is only used by sync allocation functions.
-    std::mutex*     m_pMutex;
+    // Sub-arena of each worker, see AllocAlignedWorker.
+    ArenaBlock*     m_pWorkerBlocks[KNOB_MAX_NUM_THREADS] = {};
 };
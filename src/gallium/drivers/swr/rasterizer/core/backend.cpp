@@ -62,7 +62,7 @@ static const __m128 gMaskToVec[] = {
     MASKTOVEC(1,1,1,1),
 };
 
-typedef void(*PFN_CLEAR_TILES)(DRAW_CONTEXT*, SWR_RENDERTARGET_ATTACHMENT rt, uint32_t, DWORD[4]);
+typedef void(*PFN_CLEAR_TILES)(DRAW_CONTEXT*, SWR_RENDERTARGET_ATTACHMENT rt, uint32_t, DWORD[4], uint32_t);
 static PFN_CLEAR_TILES sClearTilesTable[NUM_SWR_FORMATS];
 
 //////////////////////////////////////////////////////////////////////////
@@ -83,7 +83,7 @@ void ProcessComputeBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t threadGroup
     if (pDC->pSpillFill[workerId] == nullptr)
     {
         ///@todo Add state which indicates the spill fill size.
-        pDC->pSpillFill[workerId] = (uint8_t*)pDC->pArena->AllocAlignedSync(4096 * 1024, sizeof(float) * 8);
+        pDC->pSpillFill[workerId] = (uint8_t*)pDC->pArena->AllocAlignedWorker(workerId, 4096 * 1024, sizeof(float) * 8);
     }
 
     const API_STATE& state = GetApiState(pDC);
@@ -96,9 +96,9 @@ void ProcessComputeBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t threadGroup
     csContext.pTGSM = pContext->pScratch[workerId];
     csContext.pSpillFillBuffer = pDC->pSpillFill[workerId];
 
-    state.pfnCsFunc(GetPrivateState(pDC), &csContext);
+    state.pShaders->pfnCsFunc(GetPrivateState(pDC), &csContext);
 
-    UPDATE_STAT(CsInvocations, state.totalThreadsInGroup);
+    UPDATE_STAT(CsInvocations, state.pShaders->totalThreadsInGroup);
 
     RDTSC_STOP(BEDispatch, 1, 0);
 }
@@ -132,6 +132,7 @@ void ProcessQueryStatsBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTil
         pStats->IaVertices    += pContext->stats[i].IaVertices;
         pStats->IaPrimitives  += pContext->stats[i].IaPrimitives;
         pStats->VsInvocations += pContext->stats[i].VsInvocations;
+        pStats->VsInvocationsSaved += pContext->stats[i].VsInvocationsSaved;
         pStats->HsInvocations += pContext->stats[i].HsInvocations;
         pStats->DsInvocations += pContext->stats[i].DsInvocations;
         pStats->GsInvocations += pContext->stats[i].GsInvocations;
@@ -141,6 +142,10 @@ void ProcessQueryStatsBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTil
         pStats->CPrimitives   += pContext->stats[i].CPrimitives;
         pStats->GsPrimitives  += pContext->stats[i].GsPrimitives;
 
+        pStats->HiZTrisTossedFE += pContext->stats[i].HiZTrisTossedFE;
+        pStats->HiZTrisTossedBE += pContext->stats[i].HiZTrisTossedBE;
+        pStats->HiZRasterTilesTossed += pContext->stats[i].HiZRasterTilesTossed;
+
         for (uint32_t stream = 0; stream < MAX_SO_STREAMS; ++stream)
         {
             pStats->SoWriteOffset[stream] += pContext->stats[i].SoWriteOffset[stream];
@@ -153,6 +158,9 @@ void ProcessQueryStatsBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTil
             pStats->SoNumPrimsWritten[stream] += pContext->stats[i].SoNumPrimsWritten[stream];
         }
     }
+    // not per worker, the pool is shared by all of them
+    pContext->pHotTileMgr->GetPoolStats(*pStats);
+    Arena::GetFrameStats(*pStats);
 }
 
 template<SWR_FORMAT format>
@@ -172,7 +180,7 @@ void ClearRasterTile(BYTE *pTileBuffer, simdvector &value)
 }
 
 template<SWR_FORMAT format>
-INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, uint32_t macroTile, DWORD clear[4])
+INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, uint32_t macroTile, DWORD clear[4], uint32_t renderTargetArrayIndex)
 {
     // convert clear color to hottile format
     // clear color is in RGBA float/uint32
@@ -181,6 +189,7 @@ INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, ui
     {
         simdscalar vComp;
         vComp = _simd_load1_ps((const float*)&clear[comp]);
+        vComp = Clamp<format>(vComp, comp);
         if (FormatTraits<format>::isNormalized(comp))
         {
             vComp = _simd_mul_ps(vComp, _simd_set1_ps(FormatTraits<format>::fromFloat(comp)));
@@ -217,14 +226,14 @@ INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, ui
     left >>= (KNOB_TILE_X_DIM_SHIFT + FIXED_POINT_SHIFT);
     right >>= (KNOB_TILE_X_DIM_SHIFT + FIXED_POINT_SHIFT);
 
-    const int numSamples = GetNumSamples(pDC->pState->state.rastState.sampleCount);
+    const int numSamples = GetNumSamples(pDC->pState->state.pRaster->rastState.sampleCount);
     // compute steps between raster tile samples / raster tiles / macro tile rows
     const uint32_t rasterTileSampleStep = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * FormatTraits<format>::bpp / 8;
     const uint32_t rasterTileStep = (KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<format>::bpp / 8)) * numSamples;
     const uint32_t macroTileRowStep = (KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * rasterTileStep;
     const uint32_t pitch = (FormatTraits<format>::bpp * KNOB_MACROTILE_X_DIM / 8);
 
-    HOTTILE *pHotTile = pDC->pContext->pHotTileMgr->GetHotTile(pDC->pContext, pDC, macroTile, rt, true, numSamples);
+    HOTTILE *pHotTile = pDC->pContext->pHotTileMgr->GetHotTile(pDC->pContext, pDC, macroTile, rt, true, numSamples, renderTargetArrayIndex);
     uint32_t rasterTileStartOffset = (ComputeTileOffset2D< TilingTraits<SWR_TILE_SWRZ, FormatTraits<format>::bpp > >(pitch, left, top)) * numSamples;
     uint8_t* pRasterTileRow = pHotTile->pBuffer + rasterTileStartOffset; //(ComputeTileOffset2D< TilingTraits<SWR_TILE_SWRZ, FormatTraits<format>::bpp > >(pitch, x, y)) * numSamples;
 
@@ -253,7 +262,7 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
     {
         CLEAR_DESC *pClear = (CLEAR_DESC*)pUserData;
         SWR_CONTEXT *pContext = pDC->pContext;
-        SWR_MULTISAMPLE_COUNT sampleCount = pDC->pState->state.rastState.sampleCount;
+        SWR_MULTISAMPLE_COUNT sampleCount = pDC->pState->state.pRaster->rastState.sampleCount;
         uint32_t numSamples = GetNumSamples(sampleCount);
 
         SWR_ASSERT(pClear->flags.bits != 0); // shouldn't be here without a reason.
@@ -276,6 +285,7 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
             HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, SWR_ATTACHMENT_DEPTH, true, numSamples);
             pHotTile->clearData[0] = *(DWORD*)&pClear->clearDepth;
             pHotTile->state = HOTTILE_CLEAR;
+            HotTileMgr::ClearHiZ(*pHotTile, pClear->clearDepth, pDC->hiZGeneration);
         }
 
         if (pClear->flags.mask & SWR_CLEAR_STENCIL)
@@ -290,7 +300,7 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
     }
     else
     {
-        // Legacy clear
+        // Legacy clear, only clears array slice 0 like the fast clear
         CLEAR_DESC *pClear = (CLEAR_DESC*)pUserData;
         RDTSC_START(BEClear);
 
@@ -308,10 +318,10 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
             clearData[2] = *(DWORD*)&clearFloat[2];
             clearData[3] = *(DWORD*)&clearFloat[3];
 
-            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[KNOB_COLOR_HOT_TILE_FORMAT];
+            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[GetApiState(pDC).colorHotTileFormat[0]];
             SWR_ASSERT(pfnClearTiles != nullptr);
 
-            pfnClearTiles(pDC, SWR_ATTACHMENT_COLOR0, macroTile, clearData);
+            pfnClearTiles(pDC, SWR_ATTACHMENT_COLOR0, macroTile, clearData, 0);
         }
 
         if (pClear->flags.mask & SWR_CLEAR_DEPTH)
@@ -321,7 +331,10 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
             PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[KNOB_DEPTH_HOT_TILE_FORMAT];
             SWR_ASSERT(pfnClearTiles != nullptr);
 
-            pfnClearTiles(pDC, SWR_ATTACHMENT_DEPTH, macroTile, clearData);
+            pfnClearTiles(pDC, SWR_ATTACHMENT_DEPTH, macroTile, clearData, 0);
+
+            HOTTILE *pHotTile = pDC->pContext->pHotTileMgr->GetHotTile(pDC->pContext, pDC, macroTile, SWR_ATTACHMENT_DEPTH, false);
+            HotTileMgr::UpdateHiZ(*pHotTile, GetNumSamples(GetApiState(pDC).pRaster->rastState.sampleCount), pDC->hiZGeneration);
         }
 
         if (pClear->flags.mask & SWR_CLEAR_STENCIL)
@@ -331,7 +344,7 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
             clearData[0] = *(DWORD*)&value;
             PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[KNOB_STENCIL_HOT_TILE_FORMAT];
 
-            pfnClearTiles(pDC, SWR_ATTACHMENT_STENCIL, macroTile, clearData);
+            pfnClearTiles(pDC, SWR_ATTACHMENT_STENCIL, macroTile, clearData, 0);
         }
 
         RDTSC_STOP(BEClear, 0, 0);
@@ -345,48 +358,39 @@ void ProcessStoreTileBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile
     STORE_TILES_DESC *pDesc = (STORE_TILES_DESC*)pData;
     SWR_CONTEXT *pContext = pDC->pContext;
 
-#ifdef KNOB_ENABLE_RDTSC
     uint32_t numTiles = 0;
-#endif
-    SWR_FORMAT srcFormat;
-    switch (pDesc->attachment)
-    {
-    case SWR_ATTACHMENT_COLOR0:
-    case SWR_ATTACHMENT_COLOR1:
-    case SWR_ATTACHMENT_COLOR2:
-    case SWR_ATTACHMENT_COLOR3:
-    case SWR_ATTACHMENT_COLOR4:
-    case SWR_ATTACHMENT_COLOR5:
-    case SWR_ATTACHMENT_COLOR6:
-    case SWR_ATTACHMENT_COLOR7: srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_DEPTH: srcFormat = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_STENCIL: srcFormat = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-    default: SWR_ASSERT(false, "Unknown attachment: %d", pDesc->attachment); srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    }
-
     uint32_t x, y;
     MacroTileMgr::getTileIndices(macroTile, x, y);
 
-    // Only need to store the hottile if it's been rendered to...
-    HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, pDesc->attachment, false);
-    if (pHotTile)
+    // Only need to store the hottiles if they've been rendered to, each array slice held has its own
+    for (HOTTILE *pLayer = pContext->pHotTileMgr->GetHotTileLayers(macroTile, pDesc->attachment); pLayer != nullptr; pLayer = pLayer->pNextLayer)
     {
+        HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, pDesc->attachment, false, 1, pLayer->renderTargetArrayIndex);
+        if (pHotTile == nullptr)
+        {
+            continue;
+        }
+
         // clear if clear is pending (i.e., not rendered to), then mark as dirty for store.
         if (pHotTile->state == HOTTILE_CLEAR)
         {
-            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[srcFormat];
+            // clear in the format the tile was allocated in, which the store below uses
+            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[pHotTile->format];
             SWR_ASSERT(pfnClearTiles != nullptr);
 
-            pfnClearTiles(pDC, pDesc->attachment, macroTile, pHotTile->clearData);
+            pfnClearTiles(pDC, pDesc->attachment, macroTile, pHotTile->clearData, pHotTile->renderTargetArrayIndex);
         }
 
+        // color hottiles may be kept in the render target format
+        SWR_FORMAT srcFormat = pHotTile->format;
+
         if (pHotTile->state == HOTTILE_DIRTY || pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
         {
             int destX = KNOB_MACROTILE_X_DIM * x;
             int destY = KNOB_MACROTILE_Y_DIM * y;
 
             pContext->pfnStoreTile(GetPrivateState(pDC), srcFormat,
-                pDesc->attachment, destX, destY, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+                pDesc->attachment, destX, destY, pHotTile->renderTargetArrayIndex, pHotTile->numSamples, pHotTile->pBuffer);
         }
         
 
@@ -394,6 +398,18 @@ void ProcessStoreTileBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile
         {
             pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
         }
+
+        // the surface may change before the tile is reloaded
+        if (pHotTile->state == HOTTILE_INVALID)
+        {
+            HotTileMgr::InvalidateHiZ(*pHotTile);
+        }
+
+        // contents are in the surface, the tile can be evicted
+        if (pHotTile->state == HOTTILE_RESOLVED || pHotTile->state == HOTTILE_INVALID)
+        {
+            pContext->pHotTileMgr->ReleaseHotTile(*pHotTile);
+        }
     }
     RDTSC_STOP(BEStoreTiles, numTiles, pDC->drawId);
 }
@@ -408,10 +424,16 @@ void ProcessInvalidateTilesBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t mac
     {
         if (pDesc->attachmentMask & (1 << i))
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, (SWR_RENDERTARGET_ATTACHMENT)i, false);
-            if (pHotTile)
+            SWR_RENDERTARGET_ATTACHMENT attachment = (SWR_RENDERTARGET_ATTACHMENT)i;
+            for (HOTTILE *pLayer = pContext->pHotTileMgr->GetHotTileLayers(macroTile, attachment); pLayer != nullptr; pLayer = pLayer->pNextLayer)
             {
-                pHotTile->state = HOTTILE_INVALID;
+                HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, attachment, false, 1, pLayer->renderTargetArrayIndex);
+                if (pHotTile)
+                {
+                    pHotTile->state = HOTTILE_INVALID;
+                    HotTileMgr::InvalidateHiZ(*pHotTile);
+                    pContext->pHotTileMgr->ReleaseHotTile(*pHotTile);
+                }
             }
         }
     }
@@ -759,12 +781,69 @@ INLINE void CalcCentroidBarycentrics(const BarycentricCoeffs& coeffs, SWR_PS_CON
     }
 }
 
-template<uint32_t NumRT, uint32_t sampleCountT>
+//////////////////////////////////////////////////////////////////////////
+/// @brief Blend and store one SIMD of pixels to a render target whose
+///        hottile is kept in the render target format.
+/// @param pColorSample - hottile SIMD tile location for this sample
+/// @param outputMask - final write mask
+template<SWR_FORMAT HotTileFormat>
+INLINE void OutputMergerNativeRT(SWR_PS_CONTEXT &psContext, uint32_t rt, uint8_t *pColorSample, uint32_t sample,
+                                 const SWR_BLEND_STATE *pBlendState, PFN_BLEND_JIT_FUNC pfnBlendFunc,
+                                 simdscalar &coverageMask, simdscalar depthPassMask)
+{
+    const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend = &pBlendState->renderTarget[rt];
+
+    // blend func expects RGBA32_FLOAT destination data
+    simdvector dst;
+    LoadSOA<HotTileFormat>(pColorSample, dst);
+
+    // Blend outputs and update coverage mask for alpha test
+    if(pfnBlendFunc != nullptr)
+    {
+        pfnBlendFunc(
+            pBlendState,
+            psContext.shaded[rt],
+            psContext.shaded[1],
+            sample,
+            (uint8_t*)&dst,
+            psContext.shaded[rt],
+            &psContext.oMask,
+            (simdscalari*)&coverageMask);
+    }
+
+    // final write mask
+    simdscalar outputMask = _simd_and_ps(coverageMask, depthPassMask);
+
+    // merge with color mask
+    simdvector &src = psContext.shaded[rt];
+    if(!pRTBlend->writeDisableRed)
+    {
+        dst.x = _simd_blendv_ps(dst.x, src.x, outputMask);
+    }
+    if(!pRTBlend->writeDisableGreen)
+    {
+        dst.y = _simd_blendv_ps(dst.y, src.y, outputMask);
+    }
+    if(!pRTBlend->writeDisableBlue)
+    {
+        dst.z = _simd_blendv_ps(dst.z, src.z, outputMask);
+    }
+    if(!pRTBlend->writeDisableAlpha)
+    {
+        dst.w = _simd_blendv_ps(dst.w, src.w, outputMask);
+    }
+
+    StoreSOA<HotTileFormat>(dst, pColorSample);
+}
+
+template<uint32_t NumRT, uint32_t sampleCountT, uint32_t nativeHotTiles>
 void OutputMerger(SWR_PS_CONTEXT &psContext, uint8_t* (&pColorBase)[SWR_NUM_RENDERTARGETS], uint32_t sample, const SWR_BLEND_STATE *pBlendState,
-                  const PFN_BLEND_JIT_FUNC (&pfnBlendFunc)[SWR_NUM_RENDERTARGETS], simdscalar &coverageMask, simdscalar depthPassMask)
+                  const PFN_BLEND_JIT_FUNC (&pfnBlendFunc)[SWR_NUM_RENDERTARGETS], const SWR_FORMAT (&hotTileFormats)[SWR_NUM_RENDERTARGETS],
+                  simdscalar &coverageMask, simdscalar depthPassMask)
 {
     // type safety guaranteed from template instantiation in BEChooser<>::GetFunc
     static const SWR_MULTISAMPLE_COUNT sampleCount = (SWR_MULTISAMPLE_COUNT)sampleCountT;
+    static const bool bNativeHotTiles = (bool)nativeHotTiles;
     uint32_t rasterTileColorOffset = MultisampleTraits<sampleCount>::RasterTileColorOffset(sample);
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
@@ -778,6 +857,26 @@ void OutputMerger(SWR_PS_CONTEXT &psContext, uint8_t* (&pColorBase)[SWR_NUM_REND
             pColorSample = pColorBase[rt] + rasterTileColorOffset;
         }
 
+        // native format hottiles are only selected for single sampled render targets
+        if(bNativeHotTiles && sampleCount == SWR_MULTISAMPLE_1X)
+        {
+            switch(hotTileFormats[rt])
+            {
+            case R8G8B8A8_UNORM:
+                OutputMergerNativeRT<R8G8B8A8_UNORM>(psContext, rt, pColorSample, sample, pBlendState, pfnBlendFunc[rt], coverageMask, depthPassMask);
+                continue;
+            case B8G8R8A8_UNORM:
+                OutputMergerNativeRT<B8G8R8A8_UNORM>(psContext, rt, pColorSample, sample, pBlendState, pfnBlendFunc[rt], coverageMask, depthPassMask);
+                continue;
+            case R16G16B16A16_FLOAT:
+                OutputMergerNativeRT<R16G16B16A16_FLOAT>(psContext, rt, pColorSample, sample, pBlendState, pfnBlendFunc[rt], coverageMask, depthPassMask);
+                continue;
+            default:
+                SWR_ASSERT(hotTileFormats[rt] == KNOB_COLOR_HOT_TILE_FORMAT, "Unsupported hot tile format");
+                break;
+            }
+        }
+
         const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend = &pBlendState->renderTarget[rt];
 
         // Blend outputs and update coverage mask for alpha test
@@ -832,9 +931,9 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
 
     SWR_CONTEXT *pContext = pDC->pContext;
     const API_STATE& state = GetApiState(pDC);
-    const SWR_RASTSTATE& rastState = state.rastState;
-    const SWR_PS_STATE *pPSState = &state.psState;
-    const SWR_BLEND_STATE *pBlendState = &state.blendState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
+    const SWR_PS_STATE *pPSState = &state.pShaders->psState;
+    const SWR_BLEND_STATE *pBlendState = &state.pOutput->blendState;
     const BACKEND_FUNCS& backendFuncs = pDC->pState->backendFuncs;
     uint64_t coverageMask = work.coverageMask[0];
 
@@ -859,10 +958,12 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
     coeffs.vCOneOverW = _simd_broadcast_ss(&work.OneOverW[2]);
 
     uint8_t *pColorBase[SWR_NUM_RENDERTARGETS];
-    uint32_t NumRT = state.psState.numRenderTargets;
+    uint32_t colorSimdStep[SWR_NUM_RENDERTARGETS];
+    uint32_t NumRT = state.pShaders->psState.numRenderTargets;
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
         pColorBase[rt] = renderBuffers.pColor[rt];
+        colorSimdStep[rt] = KNOB_SIMD_WIDTH * GetFormatInfo(state.colorHotTileFormat[rt]).Bpp;
     }
     uint8_t *pDepthBase = renderBuffers.pDepth, *pStencilBase = renderBuffers.pStencil;
     RDTSC_STOP(BESetup, 0, 0);
@@ -935,14 +1036,14 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
                 if(CanEarlyZ(pPSState))
                 {
                     RDTSC_START(BEEarlyDepthTest);
-                    depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                    depthPassMask = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                                                         psContext.vZ, pDepthBase, vCoverageMask, pStencilBase, &stencilPassMask);
                     RDTSC_STOP(BEEarlyDepthTest, 0, 0);
 
                     // early-exit if no pixels passed depth or earlyZ is forced on
                     if(pPSState->forceEarlyZ || !_simd_movemask_ps(depthPassMask))
                     {
-                        DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                        DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                                             pDepthBase, depthPassMask, vCoverageMask, pStencilBase, stencilPassMask);
 
                         if (!_simd_movemask_ps(depthPassMask))
@@ -958,7 +1059,7 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
                 // execute pixel shader
                 RDTSC_START(BEPixelShader);
                 UPDATE_STAT(PsInvocations, _mm_popcnt_u32(_simd_movemask_ps(vCoverageMask)));
-                state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
+                state.pShaders->psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
                 RDTSC_STOP(BEPixelShader, 0, 0);
 
                 vCoverageMask = _simd_castsi_ps(psContext.activeMask);
@@ -967,14 +1068,14 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
                 if(!CanEarlyZ(pPSState))
                 {
                     RDTSC_START(BELateDepthTest);
-                    depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                    depthPassMask = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                                                         psContext.vZ, pDepthBase, vCoverageMask, pStencilBase, &stencilPassMask);
                     RDTSC_STOP(BELateDepthTest, 0, 0);
 
                     if(!_simd_movemask_ps(depthPassMask))
                     {
                         // need to call depth/stencil write for stencil write
-                        DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                        DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                                             pDepthBase, depthPassMask, vCoverageMask, pStencilBase, stencilPassMask);
                         goto Endtile;
                     }
@@ -986,13 +1087,13 @@ void BackendSingleSample(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint3
 
                 // output merger
                 RDTSC_START(BEOutputMerger);
-                backendFuncs.pfnOutputMerger(psContext, pColorBase, 0, pBlendState, state.pfnBlendFunc,
+                backendFuncs.pfnOutputMerger(psContext, pColorBase, 0, pBlendState, state.pOutput->pfnBlendFunc, state.colorHotTileFormat,
                                              vCoverageMask, depthPassMask);
 
                 // do final depth write after all pixel kills
                 if (!pPSState->forceEarlyZ)
                 {
-                    DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                    DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                         pDepthBase, depthPassMask, vCoverageMask, pStencilBase, stencilPassMask);
                 }
                 RDTSC_STOP(BEOutputMerger, 0, 0);
@@ -1006,7 +1107,7 @@ Endtile:
 
             for(uint32_t rt = 0; rt < NumRT; ++rt)
             {
-                pColorBase[rt] += (KNOB_SIMD_WIDTH * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp) / 8;
+                pColorBase[rt] += colorSimdStep[rt];
             }
             RDTSC_STOP(BEEndTile, 0, 0);
         }
@@ -1025,9 +1126,9 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
 
     SWR_CONTEXT *pContext = pDC->pContext;
     const API_STATE& state = GetApiState(pDC);
-    const SWR_RASTSTATE& rastState = state.rastState;
-    const SWR_PS_STATE *pPSState = &state.psState;
-    const SWR_BLEND_STATE *pBlendState = &state.blendState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
+    const SWR_PS_STATE *pPSState = &state.pShaders->psState;
+    const SWR_BLEND_STATE *pBlendState = &state.pOutput->blendState;
     const BACKEND_FUNCS& backendFuncs = pDC->pState->backendFuncs;
 
     // broadcast scalars
@@ -1051,10 +1152,12 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
     coeffs.vCOneOverW = _simd_broadcast_ss(&work.OneOverW[2]);
 
     uint8_t *pColorBase[SWR_NUM_RENDERTARGETS];
-    uint32_t NumRT = state.psState.numRenderTargets;
+    uint32_t colorSimdStep[SWR_NUM_RENDERTARGETS];
+    uint32_t NumRT = state.pShaders->psState.numRenderTargets;
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
         pColorBase[rt] = renderBuffers.pColor[rt];
+        colorSimdStep[rt] = KNOB_SIMD_WIDTH * GetFormatInfo(state.colorHotTileFormat[rt]).Bpp;
     }
     uint8_t *pDepthBase = renderBuffers.pDepth, *pStencilBase = renderBuffers.pStencil;
     RDTSC_STOP(BESetup, 0, 0);
@@ -1142,14 +1245,14 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                     if (CanEarlyZ(pPSState))
                     {
                         RDTSC_START(BEEarlyDepthTest);
-                        depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                        depthPassMask = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                                               psContext.vZ, pDepthSample, vCoverageMask, pStencilSample, &stencilPassMask);
                         RDTSC_STOP(BEEarlyDepthTest, 0, 0);
 
                         // early-exit if no samples passed depth or earlyZ is forced on.
                         if (pPSState->forceEarlyZ || !_simd_movemask_ps(depthPassMask))
                         {
-                            DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                            DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                                 pDepthSample, depthPassMask, vCoverageMask, pStencilSample, stencilPassMask);
 
                             if (!_simd_movemask_ps(depthPassMask))
@@ -1166,7 +1269,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                     // execute pixel shader
                     RDTSC_START(BEPixelShader);
                     UPDATE_STAT(PsInvocations, _mm_popcnt_u32(_simd_movemask_ps(vCoverageMask)));
-                    state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
+                    state.pShaders->psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
                     RDTSC_STOP(BEPixelShader, 0, 0);
 
                     vCoverageMask = _simd_castsi_ps(psContext.activeMask);
@@ -1175,14 +1278,14 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                     if (!CanEarlyZ(pPSState))
                     {
                         RDTSC_START(BELateDepthTest);
-                        depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                        depthPassMask = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                                               psContext.vZ, pDepthSample, vCoverageMask, pStencilSample, &stencilPassMask);
                         RDTSC_STOP(BELateDepthTest, 0, 0);
 
                         if (!_simd_movemask_ps(depthPassMask))
                         {
                             // need to call depth/stencil write for stencil write
-                            DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                            DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                                 pDepthSample, depthPassMask, vCoverageMask, pStencilSample, stencilPassMask);
 
                             work.coverageMask[sample] >>= (SIMD_TILE_Y_DIM * SIMD_TILE_X_DIM);
@@ -1196,13 +1299,13 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
 
                     // output merger
                     RDTSC_START(BEOutputMerger);
-                    backendFuncs.pfnOutputMerger(psContext, pColorBase, sample, pBlendState, state.pfnBlendFunc, 
+                    backendFuncs.pfnOutputMerger(psContext, pColorBase, sample, pBlendState, state.pOutput->pfnBlendFunc, state.colorHotTileFormat,
                                                  vCoverageMask, depthPassMask);
 
                     // do final depth write after all pixel kills
                     if (!pPSState->forceEarlyZ)
                     {
-                        DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                        DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                             pDepthSample, depthPassMask, vCoverageMask, pStencilSample, stencilPassMask);
                     }
                     RDTSC_STOP(BEOutputMerger, 0, 0);
@@ -1215,7 +1318,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
 
             for (uint32_t rt = 0; rt < NumRT; ++rt)
             {
-                pColorBase[rt] += (KNOB_SIMD_WIDTH * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp) / 8;
+                pColorBase[rt] += colorSimdStep[rt];
             }
             RDTSC_STOP(BEEndTile, 0, 0);
         }
@@ -1236,9 +1339,9 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
 
     SWR_CONTEXT *pContext = pDC->pContext;
     const API_STATE& state = GetApiState(pDC);
-    const SWR_RASTSTATE& rastState = state.rastState;
-    const SWR_PS_STATE *pPSState = &state.psState;
-    const SWR_BLEND_STATE *pBlendState = &state.blendState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
+    const SWR_PS_STATE *pPSState = &state.pShaders->psState;
+    const SWR_BLEND_STATE *pBlendState = &state.pOutput->blendState;
     const BACKEND_FUNCS& backendFuncs = pDC->pState->backendFuncs;
 
     // broadcast scalars
@@ -1262,10 +1365,12 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
     coeffs.vCOneOverW = _simd_broadcast_ss(&work.OneOverW[2]);
 
     uint8_t *pColorBase[SWR_NUM_RENDERTARGETS];
-    uint32_t NumRT = state.psState.numRenderTargets;
+    uint32_t colorSimdStep[SWR_NUM_RENDERTARGETS];
+    uint32_t NumRT = state.pShaders->psState.numRenderTargets;
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
         pColorBase[rt] = renderBuffers.pColor[rt];
+        colorSimdStep[rt] = KNOB_SIMD_WIDTH * GetFormatInfo(state.colorHotTileFormat[rt]).Bpp;
     }
     uint8_t *pDepthBase = renderBuffers.pDepth, *pStencilBase = renderBuffers.pStencil;
     RDTSC_STOP(BESetup, 0, 0);
@@ -1348,7 +1453,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
 
                 // execute pixel shader
                 RDTSC_START(BEPixelShader);
-                state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
+                state.pShaders->psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
                 RDTSC_STOP(BEPixelShader, 0, 0);
             }
             else
@@ -1434,7 +1539,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                 // ZTest for this sample
                 RDTSC_START(BEEarlyDepthTest);
                 stencilPassMask[sample] = vCoverageMask[sample];
-                depthPassMask[sample] = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                depthPassMask[sample] = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                                         vZ[sample], pDepthSample, vCoverageMask[sample], pStencilSample, &stencilPassMask[sample]);
                 RDTSC_STOP(BEEarlyDepthTest, 0, 0);
 
@@ -1456,7 +1561,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
 
                 // execute pixel shader
                 RDTSC_START(BEPixelShader);
-                state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
+                state.pShaders->psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
                 RDTSC_STOP(BEPixelShader, 0, 0);
             }
             ///@todo: make sure this works for kill pixel
@@ -1492,7 +1597,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                     if(!_simd_movemask_ps(depthPassMask[sample]))
                     {
                         depthPassMask[sample] = _simd_setzero_ps();
-                        DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, vZ[sample], pDepthSample, depthPassMask[sample],
+                        DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, vZ[sample], pDepthSample, depthPassMask[sample],
                                           vCoverageMask[sample], pStencilSample, stencilPassMask[sample]);
                         continue;
                     }
@@ -1507,7 +1612,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                     if(!_simd_movemask_ps(depthPassMask[0]))
                     {
                         depthPassMask[0] = _simd_setzero_ps();
-                        DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, vZ[0], pDepthSample, depthPassMask[0],
+                        DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, vZ[0], pDepthSample, depthPassMask[0],
                                           vCoverageMask[0], pStencilSample, stencilPassMask[0]);
                         continue;
                     }
@@ -1519,10 +1624,10 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
 
                 // output merger
                 RDTSC_START(BEOutputMerger);
-                backendFuncs.pfnOutputMerger(psContext, pColorBase, sample, pBlendState, state.pfnBlendFunc,
+                backendFuncs.pfnOutputMerger(psContext, pColorBase, sample, pBlendState, state.pOutput->pfnBlendFunc, state.colorHotTileFormat,
                                              coverageMaskSample, depthMaskSample);
 
-                DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, vInterpolatedZ, pDepthSample, depthMaskSample,
+                DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, vInterpolatedZ, pDepthSample, depthMaskSample,
                                   coverageMaskSample, pStencilSample, stencilMaskSample);
                 RDTSC_STOP(BEOutputMerger, 0, 0);
             }
@@ -1539,7 +1644,7 @@ Endtile:
 
             for(uint32_t rt = 0; rt < NumRT; ++rt)
             {
-                pColorBase[rt] += (KNOB_SIMD_WIDTH * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp) / 8;
+                pColorBase[rt] += colorSimdStep[rt];
             }
             RDTSC_STOP(BEEndTile, 0, 0);
         }
@@ -1589,7 +1694,7 @@ void BackendNullPS(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y,
 
             // iterate over active samples
             unsigned long sample = 0;
-            uint32_t sampleMask = state.blendState.sampleMask;
+            uint32_t sampleMask = state.pOutput->blendState.sampleMask;
             while (_BitScanForward(&sample, sampleMask))
             {
                 sampleMask &= ~(1 << sample);
@@ -1615,9 +1720,9 @@ void BackendNullPS(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y,
                     uint8_t *pStencilSample = pStencilBase + MultisampleTraits<sampleCount>::RasterTileStencilOffset(sample);
 
                     RDTSC_START(BEEarlyDepthTest);
-                    simdscalar depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                    simdscalar depthPassMask = DepthStencilTest(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing,
                         psContext.vZ, pDepthSample, vCoverageMask, pStencilSample, &stencilPassMask);
-                    DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ,
+                    DepthStencilWrite(&state.pViewport->vp[0], &state.pRaster->depthStencilState, work.triFlags.frontFacing, psContext.vZ,
                         pDepthSample, depthPassMask, vCoverageMask, pStencilSample, stencilPassMask);
                     RDTSC_STOP(BEEarlyDepthTest, 0, 0);
 
@@ -1639,6 +1744,7 @@ void InitClearTilesTable()
 
     sClearTilesTable[R8G8B8A8_UNORM] = ClearMacroTile<R8G8B8A8_UNORM>;
     sClearTilesTable[B8G8R8A8_UNORM] = ClearMacroTile<B8G8R8A8_UNORM>;
+    sClearTilesTable[R16G16B16A16_FLOAT] = ClearMacroTile<R16G16B16A16_FLOAT>;
     sClearTilesTable[R32_FLOAT] = ClearMacroTile<R32_FLOAT>;
     sClearTilesTable[R32G32B32A32_FLOAT] = ClearMacroTile<R32G32B32A32_FLOAT>;
     sClearTilesTable[R8_UINT] = ClearMacroTile<R8_UINT>;
@@ -1648,7 +1754,7 @@ PFN_BACKEND_FUNC gBackendNullPs[SWR_MULTISAMPLE_TYPE_MAX];
 PFN_BACKEND_FUNC gBackendSingleSample[2][2] = {};
 PFN_BACKEND_FUNC gBackendPixelRateTable[SWR_MULTISAMPLE_TYPE_MAX][SWR_MSAA_SAMPLE_PATTERN_MAX][SWR_INPUT_COVERAGE_MAX][2][2] = {};
 PFN_BACKEND_FUNC gBackendSampleRateTable[SWR_MULTISAMPLE_TYPE_MAX][SWR_INPUT_COVERAGE_MAX][2] = {};
-PFN_OUTPUT_MERGER gBackendOutputMergerTable[SWR_NUM_RENDERTARGETS+1][SWR_MULTISAMPLE_TYPE_MAX] = {};
+PFN_OUTPUT_MERGER gBackendOutputMergerTable[SWR_NUM_RENDERTARGETS+1][SWR_MULTISAMPLE_TYPE_MAX][2] = {};
 PFN_CALC_PIXEL_BARYCENTRICS gPixelBarycentricTable[2] = {};
 PFN_CALC_SAMPLE_BARYCENTRICS gSampleBarycentricTable[2] = {};
 PFN_CALC_CENTROID_BARYCENTRICS gCentroidBarycentricTable[SWR_MULTISAMPLE_TYPE_MAX][2][2][2] = {};
@@ -1659,15 +1765,27 @@ template <uint32_t... ArgsT>
 struct OMChooser
 {
     // Last Arg Terminator
-    static PFN_OUTPUT_MERGER GetFunc(SWR_MULTISAMPLE_COUNT tArg)
+    static PFN_OUTPUT_MERGER GetFunc(uint32_t tArg)
+    {
+        if(tArg > 0)
+        {
+            return OutputMerger<ArgsT..., 1>;
+        }
+
+        return OutputMerger<ArgsT..., 0>;
+    }
+
+    // Recursively parse args
+    template <typename... TArgsT>
+    static PFN_OUTPUT_MERGER GetFunc(SWR_MULTISAMPLE_COUNT tArg, TArgsT... remainingArgs)
     {
         switch(tArg)
         {
-        case SWR_MULTISAMPLE_1X: return OutputMerger<ArgsT..., SWR_MULTISAMPLE_1X>; break;
-        case SWR_MULTISAMPLE_2X: return OutputMerger<ArgsT..., SWR_MULTISAMPLE_2X>; break;
-        case SWR_MULTISAMPLE_4X: return OutputMerger<ArgsT..., SWR_MULTISAMPLE_4X>; break;
-        case SWR_MULTISAMPLE_8X: return OutputMerger<ArgsT..., SWR_MULTISAMPLE_8X>; break;
-        case SWR_MULTISAMPLE_16X: return OutputMerger<ArgsT..., SWR_MULTISAMPLE_16X>; break;
+        case SWR_MULTISAMPLE_1X: return OMChooser<ArgsT..., SWR_MULTISAMPLE_1X>::GetFunc(remainingArgs...); break;
+        case SWR_MULTISAMPLE_2X: return OMChooser<ArgsT..., SWR_MULTISAMPLE_2X>::GetFunc(remainingArgs...); break;
+        case SWR_MULTISAMPLE_4X: return OMChooser<ArgsT..., SWR_MULTISAMPLE_4X>::GetFunc(remainingArgs...); break;
+        case SWR_MULTISAMPLE_8X: return OMChooser<ArgsT..., SWR_MULTISAMPLE_8X>::GetFunc(remainingArgs...); break;
+        case SWR_MULTISAMPLE_16X: return OMChooser<ArgsT..., SWR_MULTISAMPLE_16X>::GetFunc(remainingArgs...); break;
         default:
             SWR_ASSERT(0 && "Invalid sample count\n");
             return nullptr;
@@ -1800,14 +1918,16 @@ struct BEChooser
 };
 
 template <uint32_t numRenderTargets, SWR_MULTISAMPLE_COUNT numSampleRates>
-void InitBackendOMFuncTable(PFN_OUTPUT_MERGER (&table)[numRenderTargets][numSampleRates])
+void InitBackendOMFuncTable(PFN_OUTPUT_MERGER (&table)[numRenderTargets][numSampleRates][2])
 {
     for(uint32_t rtNum = SWR_ATTACHMENT_COLOR0; rtNum < numRenderTargets; rtNum++)
     {
         for(uint32_t sampleCount = SWR_MULTISAMPLE_1X; sampleCount < numSampleRates; sampleCount++)
         {
-            table[rtNum][sampleCount] =
-                OMChooser<>::GetFunc((SWR_RENDERTARGET_ATTACHMENT)rtNum, (SWR_MULTISAMPLE_COUNT)sampleCount);
+            table[rtNum][sampleCount][0] =
+                OMChooser<>::GetFunc((SWR_RENDERTARGET_ATTACHMENT)rtNum, (SWR_MULTISAMPLE_COUNT)sampleCount, 0);
+            table[rtNum][sampleCount][1] =
+                OMChooser<>::GetFunc((SWR_RENDERTARGET_ATTACHMENT)rtNum, (SWR_MULTISAMPLE_COUNT)sampleCount, 1);
         }
     }
 }
@@ -83,7 +83,7 @@ void ComputeClipCodes(DRIVER_TYPE type, const API_STATE& state, const simdvector
     vRes = _simd_cmpgt_ps(vertex.y, vertex.w);
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(FRUSTUM_BOTTOM))));
 
-    if (state.rastState.depthClipEnable)
+    if (state.pRaster->rastState.depthClipEnable)
     {
         // FRUSTUM_NEAR
         // DX clips depth [0..w], GL clips [-w..w]
@@ -107,22 +107,22 @@ void ComputeClipCodes(DRIVER_TYPE type, const API_STATE& state, const simdvector
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(NEGW))));
 
     // GUARDBAND_LEFT
-    simdscalar gbMult = _simd_mul_ps(vNegW, _simd_set1_ps(state.gbState.left));
+    simdscalar gbMult = _simd_mul_ps(vNegW, _simd_set1_ps(state.pViewport->gbState.left));
     vRes = _simd_cmplt_ps(vertex.x, gbMult);
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(GUARDBAND_LEFT))));
 
     // GUARDBAND_TOP
-    gbMult = _simd_mul_ps(vNegW, _simd_set1_ps(state.gbState.top));
+    gbMult = _simd_mul_ps(vNegW, _simd_set1_ps(state.pViewport->gbState.top));
     vRes = _simd_cmplt_ps(vertex.y, gbMult);
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(GUARDBAND_TOP))));
 
     // GUARDBAND_RIGHT
-    gbMult = _simd_mul_ps(vertex.w, _simd_set1_ps(state.gbState.right));
+    gbMult = _simd_mul_ps(vertex.w, _simd_set1_ps(state.pViewport->gbState.right));
     vRes = _simd_cmpgt_ps(vertex.x, gbMult);
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(GUARDBAND_RIGHT))));
 
     // GUARDBAND_BOTTOM
-    gbMult = _simd_mul_ps(vertex.w, _simd_set1_ps(state.gbState.bottom));
+    gbMult = _simd_mul_ps(vertex.w, _simd_set1_ps(state.pViewport->gbState.bottom));
     vRes = _simd_cmpgt_ps(vertex.y, gbMult);
     clipCodes = _simd_or_ps(clipCodes, _simd_and_ps(vRes, _simd_castsi_ps(_simd_set1_epi32(GUARDBAND_BOTTOM))));
 }
@@ -196,7 +196,7 @@ public:
 
     int ComputeUserClipCullMask(PA_STATE& pa, simdvector prim[])
     {
-        uint8_t cullMask = this->state.rastState.cullDistanceMask;
+        uint8_t cullMask = this->state.pRaster->rastState.cullDistanceMask;
         simdscalar vClipCullMask = _simd_setzero_ps();
         DWORD index;
 
@@ -232,7 +232,7 @@ public:
         }
 
         // clipper should also discard any primitive with NAN clip distance
-        uint8_t clipMask = this->state.rastState.clipDistanceMask;
+        uint8_t clipMask = this->state.pRaster->rastState.clipDistanceMask;
         while (_BitScanForward(&index, clipMask))
         {
             clipMask &= ~(1 << index);
@@ -273,17 +273,17 @@ public:
         _mm_store_ps(&inVerts[8], verts[2]);
 
         // transpose attribs
-        uint32_t numScalarAttribs = this->state.linkageCount * 4;
+        uint32_t numScalarAttribs = this->state.pFrontend->linkageCount * 4;
 
         int idx = 0;
         DWORD slot = 0;
         uint32_t mapIdx = 0;
-        uint32_t tmpLinkage = uint32_t(this->state.linkageMask);
+        uint32_t tmpLinkage = uint32_t(this->state.pFrontend->linkageMask);
         while (_BitScanForward(&slot, tmpLinkage))
         {
             tmpLinkage &= ~(1 << slot);
             // Compute absolute attrib slot in vertex array
-            uint32_t inputSlot = VERTEX_ATTRIB_START_SLOT + this->state.linkageMap[mapIdx++];
+            uint32_t inputSlot = VERTEX_ATTRIB_START_SLOT + this->state.pFrontend->linkageMap[mapIdx++];
             __m128 attrib[3];    // triangle attribs (always 4 wide)
             pa.AssembleSingle(inputSlot, primIndex, attrib);
             _mm_store_ps(&inAttribs[idx], attrib[0]);
@@ -304,11 +304,11 @@ public:
         // input/output vertex store for clipper
         simdvertex vertices[7]; // maximum 7 verts generated per triangle
 
-        LONG constantInterpMask = this->state.backendState.constantInterpolationMask;
+        LONG constantInterpMask = this->state.pRaster->backendState.constantInterpolationMask;
         uint32_t provokingVertex = 0;
         if(pa.binTopology == TOP_TRIANGLE_FAN)
         {
-            provokingVertex = this->state.frontendState.provokingVertex.triFan;
+            provokingVertex = this->state.pFrontend->frontendState.provokingVertex.triFan;
         }
         ///@todo: line topology for wireframe?
 
@@ -323,14 +323,14 @@ public:
         // assemble attribs
         DWORD slot = 0;
         uint32_t mapIdx = 0;
-        uint32_t tmpLinkage = this->state.linkageMask;
+        uint32_t tmpLinkage = this->state.pFrontend->linkageMask;
 
         int32_t maxSlot = -1;
         while (_BitScanForward(&slot, tmpLinkage))
         {
             tmpLinkage &= ~(1 << slot);
             // Compute absolute attrib slot in vertex array
-            uint32_t mapSlot = this->state.linkageMap[mapIdx++];
+            uint32_t mapSlot = this->state.pFrontend->linkageMap[mapIdx++];
             maxSlot = std::max<int32_t>(maxSlot, mapSlot);
             uint32_t inputSlot = VERTEX_ATTRIB_START_SLOT + mapSlot;
 
@@ -491,7 +491,7 @@ public:
         primMask &= ~ComputeNaNMask(prim);
 
         // user cull distance cull 
-        if (this->state.rastState.cullDistanceMask)
+        if (this->state.pRaster->rastState.cullDistanceMask)
         {
             primMask &= ~ComputeUserClipCullMask(pa, prim);
         }
@@ -31,6 +31,7 @@
 ******************************************************************************/
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <algorithm>
 
@@ -52,6 +53,7 @@
 
 struct SWR_CONTEXT;
 struct DRAW_CONTEXT;
+struct HIZ_TILE;
 
 struct TRI_FLAGS
 {
@@ -170,6 +172,8 @@ struct BE_WORK
     } desc;
 };
 
+typedef void(*PFN_FE_WORK_FUNC)(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t workerId, void* pDesc);
+
 struct DRAW_WORK
 {
     DRAW_CONTEXT*   pDC;
@@ -189,9 +193,10 @@ struct DRAW_WORK
     uint32_t   startPrimID;         // starting primitiveID for this draw batch
     uint32_t   startVertexID;       // starting VertexID for this draw batch (only needed for non-indexed draws)
     SWR_FORMAT type;                // index buffer type
+    const void* pIndirectArgs;      // DrawIndirect: args read by the FE when the draw runs
+    PFN_FE_WORK_FUNC pfnIndirectDraw; // DrawIndirect: FE draw function run with those args
 };
 
-typedef void(*PFN_FE_WORK_FUNC)(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t workerId, void* pDesc);
 struct FE_WORK
 {
     WORK_TYPE type;
@@ -218,13 +223,46 @@ struct PA_STATE;
 typedef void(*PFN_PROCESS_PRIMS)(DRAW_CONTEXT *pDC, PA_STATE& pa, uint32_t workerId, simdvector prims[], 
     uint32_t primMask, simdscalari primID);
 
-OSALIGNLINE(struct) API_STATE
+//////////////////////////////////////////////////////////////////////////
+/// @brief Kinds of state blocks, see STATE_BLOCK.
+enum STATE_BLOCK_TYPE
+{
+    STATE_BLOCK_VERTEX_INPUT,
+    STATE_BLOCK_SHADERS,
+    STATE_BLOCK_FRONTEND,
+    STATE_BLOCK_RASTER,
+    STATE_BLOCK_VIEWPORT,
+    STATE_BLOCK_OUTPUT,
+
+    STATE_BLOCK_COUNT
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Reference counted block of API state. Draw states share the
+///        blocks that didn't change between them. Changing state that is
+///        still shared with another draw state gives the current draw
+///        state a new version of the block, so the state seen by queued
+///        draws never changes. Only the API thread touches refCount.
+struct STATE_BLOCK
 {
+    uint32_t refCount;          // number of DRAW_STATEs using the block
+    STATE_BLOCK* pNextFree;     // link in the free list of the context
+};
+
+struct VERTEX_INPUT_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_VERTEX_INPUT;
+
     // Vertex Buffers
     SWR_VERTEX_BUFFER_STATE vertexBuffers[KNOB_NUM_STREAMS];
 
     // Index Buffer
     SWR_INDEX_BUFFER_STATE  indexBuffer;
+};
+
+struct SHADER_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_SHADERS;
 
     // FS - Fetch Shader State
     PFN_FETCH_FUNC          pfnFetchFunc;
@@ -240,59 +278,106 @@ OSALIGNLINE(struct) API_STATE
     PFN_CS_FUNC             pfnCsFunc;
     uint32_t                totalThreadsInGroup;
 
-    // FE - Frontend State
-    SWR_FRONTEND_STATE      frontendState;
-
     // SOS - Streamout Shader State
     PFN_SO_FUNC             pfnSoFunc[MAX_SO_STREAMS];
 
-    // Streamout state
-    SWR_STREAMOUT_STATE     soState;
-    mutable SWR_STREAMOUT_BUFFER soBuffer[MAX_SO_STREAMS];
-
     // Tessellation State
     PFN_HS_FUNC             pfnHsFunc;
     PFN_DS_FUNC             pfnDsFunc;
     SWR_TS_STATE            tsState;
 
+    // PS - Pixel shader state
+    SWR_PS_STATE            psState;
+
+    // Jitted functions set with SwrSetDeferredFunc.  Copied over the
+    // function pointers above before the FE starts.
+    void* volatile*         ppDeferredFuncs[SWR_NUM_DEFERRED_FUNCS];
+    uint32_t                deferredFuncMask;
+};
+
+struct FRONTEND_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_FRONTEND;
+
+    // FE - Frontend State
+    SWR_FRONTEND_STATE      frontendState;
+
+    // Streamout state
+    SWR_STREAMOUT_STATE     soState;
+
     // Specifies which VS outputs are sent to PS.
     // Does not include position
     uint32_t                linkageMask; 
     uint32_t                linkageCount;
     uint8_t                 linkageMap[MAX_ATTRIBUTES];
+};
 
-    // attrib mask, specifies the total set of attributes used
-    // by the frontend (vs, so, gs)
-    uint32_t                feAttribMask;
-
-    PRIMITIVE_TOPOLOGY      topology;
-    bool                    forceFront;
+struct RASTER_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_RASTER;
 
     // RS - Rasterizer State
     SWR_RASTSTATE           rastState;
     // floating point multisample offsets
     float samplePos[SWR_MAX_NUM_MULTISAMPLES * 2];
 
+    SWR_DEPTH_STENCIL_STATE depthStencilState;
+
+    // Backend state
+    SWR_BACKEND_STATE       backendState;
+};
+
+struct VIEWPORT_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_VIEWPORT;
+
     GUARDBAND               gbState;
 
     SWR_VIEWPORT            vp[KNOB_NUM_VIEWPORTS_SCISSORS];
     SWR_VIEWPORT_MATRIX     vpMatrix[KNOB_NUM_VIEWPORTS_SCISSORS];
 
     BBOX                    scissorRects[KNOB_NUM_VIEWPORTS_SCISSORS];
-    BBOX                    scissorInFixedPoint;
-
-    // Backend state
-    SWR_BACKEND_STATE       backendState;
-
-    // PS - Pixel shader state
-    SWR_PS_STATE            psState;
+};
 
-    SWR_DEPTH_STENCIL_STATE depthStencilState;
+struct OUTPUT_BLOCK : STATE_BLOCK
+{
+    static const STATE_BLOCK_TYPE TYPE = STATE_BLOCK_OUTPUT;
 
     // OM - Output Merger State
     SWR_BLEND_STATE         blendState;
     PFN_BLEND_JIT_FUNC      pfnBlendFunc[SWR_NUM_RENDERTARGETS];
 
+    // Render target surface formats
+    SWR_FORMAT              renderTargetFormat[SWR_NUM_RENDERTARGETS];
+};
+
+OSALIGNLINE(struct) API_STATE
+{
+    // Shared state blocks, see STATE_BLOCK
+    VERTEX_INPUT_BLOCK*     pVertexInput;
+    SHADER_BLOCK*           pShaders;
+    FRONTEND_BLOCK*         pFrontend;
+    RASTER_BLOCK*           pRaster;
+    VIEWPORT_BLOCK*         pViewport;
+    OUTPUT_BLOCK*           pOutput;
+
+    // The members below are copied for each draw state.
+
+    // Streamout buffers, the FE updates the stream offsets of a draw
+    mutable SWR_STREAMOUT_BUFFER soBuffer[MAX_SO_STREAMS];
+
+    // attrib mask, specifies the total set of attributes used
+    // by the frontend (vs, so, gs)
+    uint32_t                feAttribMask;
+
+    PRIMITIVE_TOPOLOGY      topology;
+    bool                    forceFront;
+
+    BBOX                    scissorInFixedPoint;
+
+    // Derived hottile format per RT
+    SWR_FORMAT              colorHotTileFormat[SWR_NUM_RENDERTARGETS];
+
     // Stats are incremented when this is true.
     bool enableStats;
 
@@ -312,6 +397,7 @@ struct RenderOutputBuffers
     uint8_t* pColor[SWR_NUM_RENDERTARGETS];
     uint8_t* pDepth;
     uint8_t* pStencil;
+    HIZ_TILE* pHiZ;     // coarse depth of the depth hottile, if tracked
 };
 
 // Plane equation A/B/C coeffs used to evaluate I/J barycentric coords
@@ -339,7 +425,8 @@ struct BarycentricCoeffs
 // pipeline function pointer types
 typedef void(*PFN_BACKEND_FUNC)(DRAW_CONTEXT*, uint32_t, uint32_t, uint32_t, SWR_TRIANGLE_DESC&, RenderOutputBuffers&);
 typedef void(*PFN_OUTPUT_MERGER)(SWR_PS_CONTEXT &, uint8_t* (&)[SWR_NUM_RENDERTARGETS], uint32_t, const SWR_BLEND_STATE*,
-                                 const PFN_BLEND_JIT_FUNC (&)[SWR_NUM_RENDERTARGETS], simdscalar&, simdscalar);
+                                 const PFN_BLEND_JIT_FUNC (&)[SWR_NUM_RENDERTARGETS], const SWR_FORMAT (&)[SWR_NUM_RENDERTARGETS],
+                                 simdscalar&, simdscalar);
 typedef void(*PFN_CALC_PIXEL_BARYCENTRICS)(const BarycentricCoeffs&, SWR_PS_CONTEXT &);
 typedef void(*PFN_CALC_SAMPLE_BARYCENTRICS)(const BarycentricCoeffs&, SWR_PS_CONTEXT&);
 typedef void(*PFN_CALC_CENTROID_BARYCENTRICS)(const BarycentricCoeffs&, SWR_PS_CONTEXT &, const uint64_t *const, const uint32_t,
@@ -376,6 +463,7 @@ struct DRAW_CONTEXT
     SWR_CONTEXT *pContext;
 
     uint64_t drawId;
+    uint32_t hiZGeneration;     // see HIZ_TILE
 
     bool isCompute;    // Is this DC a compute context?
 
@@ -389,6 +477,7 @@ struct DRAW_CONTEXT
     volatile OSALIGNLINE(uint32_t) threadsDoneBE;
 
     uint64_t dependency;
+    bool dependentFE;  // FE can't start until the FE of all previous draws is done
 
     MacroTileMgr* pTileMgr;
 
@@ -410,6 +499,87 @@ INLINE const API_STATE& GetApiState(const DRAW_CONTEXT* pDC)
     return pDC->pState->state;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the draw has a pixel shader, including one that
+///        is still being compiled.
+INLINE bool HasPixelShader(const API_STATE& state)
+{
+    return (state.pShaders->psState.pfnPixelShader != nullptr) ||
+           (state.pShaders->deferredFuncMask & (1 << SWR_DEFERRED_PIXEL_SHADER));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true once the FE is done with a draw. Everything the FE
+///        queued for the draw is visible to the caller once this is true.
+INLINE bool IsFEDone(const DRAW_CONTEXT* pDC)
+{
+    bool doneFE = pDC->doneFE;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return doneFE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true once all deferred functions of a draw are compiled.
+INLINE bool IsDeferredFuncsReady(const API_STATE& state)
+{
+    uint32_t mask = state.pShaders->deferredFuncMask;
+    DWORD func;
+    while (_BitScanForward(&func, mask))
+    {
+        mask &= ~(1 << func);
+        if (*state.pShaders->ppDeferredFuncs[func] == nullptr)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Publishes a resolved deferred function in the shader block.
+///        Workers running draws that share the block store the same value,
+///        and the API thread may read the slot while it copies the block,
+///        so it is only written with an atomic store, and only if it
+///        doesn't hold the function yet.
+template <typename PFN>
+INLINE void PublishDeferredFunc(PFN& pfnDst, void* pfnFunc)
+{
+    void* volatile* ppDst = (void* volatile*)&pfnDst;
+    if (*ppDst != pfnFunc)
+    {
+        (void)InterlockedExchangePointer(ppDst, pfnFunc);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Copies the compiled deferred functions into the draw state.
+///        The deferred functions are kept set, so state copied from this
+///        draw by the API thread stays valid whether or not it sees the
+///        function pointers written here. Draws sharing the shader block
+///        all resolve to the same functions, see PublishDeferredFunc.
+INLINE void ResolveDeferredFuncs(API_STATE& state)
+{
+    uint32_t mask = state.pShaders->deferredFuncMask;
+    DWORD func;
+    while (_BitScanForward(&func, mask))
+    {
+        mask &= ~(1 << func);
+        void* pfnFunc = *state.pShaders->ppDeferredFuncs[func];
+        switch (func)
+        {
+        case SWR_DEFERRED_FETCH_FUNC:
+            PublishDeferredFunc(state.pShaders->pfnFetchFunc, pfnFunc);
+            break;
+        case SWR_DEFERRED_PIXEL_SHADER:
+            PublishDeferredFunc(state.pShaders->psState.pfnPixelShader, pfnFunc);
+            break;
+        default:
+            PublishDeferredFunc(state.pShaders->pfnSoFunc[func - SWR_DEFERRED_SO_FUNC], pfnFunc);
+            break;
+        }
+    }
+}
+
 INLINE void* GetPrivateState(const DRAW_CONTEXT* pDC)
 {
     SWR_ASSERT(pDC != nullptr);
@@ -452,20 +622,31 @@ struct SWR_CONTEXT
 
     uint32_t curStateId;               // Current index to the next available entry in the DS ring.
 
+    // Size of both rings. Changed to nextMaxDrawsInFlight by the API thread when it starts a
+    // draw context with all queued draws retired, see ResizeDrawRings.
+    uint32_t maxDrawsInFlight;
+    uint32_t nextMaxDrawsInFlight;     // 0 if no change is pending.
+    bool     growDrawRings;            // The change is a growth, made only once the rings drain on their own.
+
+    SWR_DRAW_RING_STATS ringStats;     // API thread side of SwrGetDrawRingStats.
+
+    STATE_BLOCK* pFreeStateBlocks[STATE_BLOCK_COUNT];  // Unused state blocks of each STATE_BLOCK_TYPE.
+
     DRAW_STATE*   subCtxSave;          // Save area for inactive contexts.
     uint32_t      curSubCtxId;         // Current index for active state subcontext.
     uint32_t      numSubContexts;      // Number of available subcontexts
 
     uint32_t NumWorkerThreads;
 
-    THREAD_POOL threadPool; // Thread pool associated with this context
-
-    std::condition_variable FifosNotEmpty;
-    std::mutex WaitLock;
+    THREAD_POOL* pThreadPool;   // Thread pool working on this context, may be shared with other contexts
+    bool ownsThreadPool;        // pThreadPool was created with the context
 
     // Draw Contexts will get a unique drawId generated from this
     uint64_t nextDrawId;
 
+    // HiZ generation of the next op, see HIZ_TILE
+    uint32_t hiZGeneration;
+
     // most recent draw id enqueued by the API thread
     // written by api thread, read by multiple workers
     OSALIGNLINE(volatile uint64_t) DrawEnqueued;
@@ -31,75 +31,99 @@
 #include "common/os.h"
 #include "arena.h"
 
+#include <atomic>
 #include <vector>
 #include <cassert>
 
 template<class T>
 struct QUEUE
 {
-    OSALIGNLINE(volatile uint32_t) mLock{ 0 };
-    OSALIGNLINE(volatile uint32_t) mNumEntries{ 0 };
-    std::vector<T*> mBlocks;
+    // The producer publishes entries with a release store of mNumEnqueued and the
+    // lock owner retires them with one of mNumDequeued. Consumers read both with
+    // acquire loads, so an entry, and the block link it may follow, is complete
+    // once it is counted. The lock hands the head over the same way.
+    OSALIGNLINE(std::atomic<uint32_t>) mLock{ 0 };
+    OSALIGNLINE(std::atomic<uint32_t>) mNumEnqueued{ 0 };   // only written by the producer (FE)
+    OSALIGNLINE(std::atomic<uint32_t>) mNumDequeued{ 0 };   // only written by the lock owner (BE)
+    T* mHeadBlock{ nullptr };
     T* mCurBlock{ nullptr };
     uint32_t mHead{ 0 };
     uint32_t mTail{ 0 };
-    uint32_t mCurBlockIdx{ 0 };
 
     // power of 2
     static const uint32_t mBlockSizeShift = 6;
     static const uint32_t mBlockSize = 1 << mBlockSizeShift;
 
+    // Blocks are chained through a pointer stored after the last entry, so a
+    // consumer can walk them while the producer is still appending.
+    static T*& nextBlock(T* pBlock)
+    {
+        return *(T**)(pBlock + mBlockSize);
+    }
+
+    static T* allocBlock(Arena& arena)
+    {
+        T* pNewBlock = (T*)arena.Alloc(sizeof(T)*mBlockSize + sizeof(T*));
+        SWR_ASSERT(pNewBlock);
+        nextBlock(pNewBlock) = nullptr;
+        return pNewBlock;
+    }
+
     void clear(Arena& arena)
     {
         mHead = 0;
         mTail = 0;
-        mBlocks.clear();
-        T* pNewBlock = (T*)arena.Alloc(sizeof(T)*mBlockSize);
-        mBlocks.push_back(pNewBlock);
-        mCurBlock = pNewBlock;
-        mCurBlockIdx = 0;
-
-        mNumEntries = 0;
-        _ReadWriteBarrier();
-        mLock = 0;
+        mHeadBlock = allocBlock(arena);
+        mCurBlock = mHeadBlock;
+
+        mNumEnqueued.store(0, std::memory_order_relaxed);
+        mNumDequeued.store(0, std::memory_order_relaxed);
+        mLock.store(0, std::memory_order_release);
     }
 
     uint32_t getNumQueued()
     {
-        return mNumEntries;
+        return mNumEnqueued.load(std::memory_order_acquire) - mNumDequeued.load(std::memory_order_acquire);
     }
 
     bool tryLock()
     {
-        if (mLock)
+        if (mLock.load(std::memory_order_relaxed))
         {
             return false;
         }
 
-        // try to lock the FIFO
-        LONG initial = InterlockedCompareExchange(&mLock, 1, 0);
-        return (initial == 0);
+        // try to lock the FIFO. BE workers mostly get here with a ticket for the tile,
+        // see MacroTileMgr::takeTileTicket, so the CAS is rarely contended. The plain
+        // load above keeps workers sweeping past a taken FIFO from writing its line.
+        uint32_t initial = 0;
+        return mLock.compare_exchange_strong(initial, 1, std::memory_order_acquire);
     }
         
     void unlock()
     {
-        mLock = 0;
+        mLock.store(0, std::memory_order_release);
     }
 
     T* peek()
     {
-        if (mNumEntries == 0)
+        if (getNumQueued() == 0)
         {
             return nullptr;
         }
-        uint32_t block = mHead >> mBlockSizeShift;
-        return &mBlocks[block][mHead & (mBlockSize-1)];
+        return &mHeadBlock[mHead];
     }
 
     void dequeue_noinc()
     {
         mHead ++;
-        mNumEntries --;
+        if (mHead == mBlockSize)
+        {
+            mHeadBlock = nextBlock(mHeadBlock);
+            mHead = 0;
+        }
+
+        mNumDequeued.store(mNumDequeued.load(std::memory_order_relaxed) + 1, std::memory_order_release);
     }
 
     bool enqueue_try_nosync(Arena& arena, const T* entry)
@@ -109,23 +133,17 @@ struct QUEUE
         mTail ++;
         if (mTail == mBlockSize)
         {
-            if (++mCurBlockIdx < mBlocks.size())
-            {
-                mCurBlock = mBlocks[mCurBlockIdx];
-            }
-            else
-            {
-                T* newBlock = (T*)arena.Alloc(sizeof(T)*mBlockSize);
-                SWR_ASSERT(newBlock);
-
-                mBlocks.push_back(newBlock);
-                mCurBlock = newBlock;
-            }
+            // link the next block before the entry is published, a consumer
+            // may step past the end of this block as soon as it sees it
+            T* newBlock = allocBlock(arena);
+            nextBlock(mCurBlock) = newBlock;
+            mCurBlock = newBlock;
 
             mTail = 0;
         }
 
-        mNumEntries ++;
+        // publish the entry
+        mNumEnqueued.store(mNumEnqueued.load(std::memory_order_relaxed) + 1, std::memory_order_release);
         return true;
     }
 
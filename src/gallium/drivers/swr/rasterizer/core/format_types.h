@@ -96,7 +96,7 @@ struct PackTraits<8, false>
         __m256i result = _mm256_castsi128_si256(resLo);
         result = _mm256_insertf128_si256(result, resHi, 1);
         return _mm256_castsi256_ps(result);
-#elif KNOB_ARCH==KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
         return _mm256_castsi256_ps(_mm256_cvtepu8_epi32(_mm_castps_si128(_mm256_castps256_ps128(in))));
 #endif
 #else
@@ -159,7 +159,7 @@ struct PackTraits<8, true>
         __m256i result = _mm256_castsi128_si256(resLo);
         result = _mm256_insertf128_si256(result, resHi, 1);
         return _mm256_castsi256_ps(result);
-#elif KNOB_ARCH==KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
         return _mm256_castsi256_ps(_mm256_cvtepi8_epi32(_mm_castps_si128(_mm256_castps256_ps128(in))));
 #endif
 #else
@@ -221,7 +221,7 @@ struct PackTraits<16, false>
         __m256i result = _mm256_castsi128_si256(resLo);
         result = _mm256_insertf128_si256(result, resHi, 1);
         return _mm256_castsi256_ps(result);
-#elif KNOB_ARCH==KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
         return _mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm_castps_si128(_mm256_castps256_ps128(in))));
 #endif
 #else
@@ -283,7 +283,7 @@ struct PackTraits<16, true>
         __m256i result = _mm256_castsi128_si256(resLo);
         result = _mm256_insertf128_si256(result, resHi, 1);
         return _mm256_castsi256_ps(result);
-#elif KNOB_ARCH==KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
         return _mm256_castsi256_ps(_mm256_cvtepi16_epi32(_mm_castps_si128(_mm256_castps256_ps128(in))));
 #endif
 #else
@@ -716,8 +716,41 @@ template<> struct TypeTraits<SWR_TYPE_FLOAT, 16> : PackTraits<16>
     static simdscalar unpack(const simdscalar &in)
     {
         // input is 8 packed float16, output is 8 packed float32
-        SWR_ASSERT(0); // @todo
-        return _simd_setzero_ps();
+#if KNOB_SIMD_WIDTH == 8
+#if (KNOB_ARCH == KNOB_ARCH_AVX)
+        // widen 16-bit channels to 32-bits
+        simdscalar tmp = in;
+        simdscalari src = _simd_castps_si(PackTraits<16>::unpack(tmp));
+
+        static const uint32_t FLOAT_MANTISSA_BITS = 23;
+        static const uint32_t HALF_MANTISSA_BITS = 10;
+
+        const simdscalari vSignMask     = _simd_set1_epi32(0x8000);
+        const simdscalari vExpManMask   = _simd_set1_epi32(0x7FFF);
+        const simdscalari vHalfInfNan   = _simd_set1_epi32(0x7BFF);
+
+        simdscalari vSign   = _simd_and_si(src, vSignMask);
+        simdscalari vExpMan = _simd_and_si(src, vExpManMask);
+        simdscalari vInfMask = _simd_cmpgt_epi32(vExpMan, vHalfInfNan);
+
+        // shift exponent/mantissa into place and rebias (2^112 == 2^(127 - 15)),
+        // which also normalizes half denormals
+        simdscalar vDst = _simd_castsi_ps(_simd_slli_epi32(vExpMan, FLOAT_MANTISSA_BITS - HALF_MANTISSA_BITS));
+        vDst = _simd_mul_ps(vDst, _simd_castsi_ps(_simd_set1_epi32(0x77800000)));
+
+        // Apply Infinites / NaN
+        vDst = _simd_or_ps(vDst, _simd_and_ps(_simd_castsi_ps(vInfMask), _simd_castsi_ps(_simd_set1_epi32(0x7F800000))));
+
+        // Add in sign bits
+        vDst = _simd_or_ps(vDst, _simd_castsi_ps(_simd_slli_epi32(vSign, 16)));
+
+        return vDst;
+#else
+        return _mm256_cvtph_ps(_mm256_castsi256_si128(_simd_castps_si(in)));
+#endif
+#else
+#error Unsupported vector width
+#endif
     }
 };
 
@@ -731,7 +764,7 @@ template<> struct TypeTraits<SWR_TYPE_FLOAT, 32> : PackTraits<32>
     static float fromFloat() { return 1.0f; }
     static inline simdscalar convertSrgb(simdscalar &in)
     {
-#if (KNOB_ARCH == KNOB_ARCH_AVX || KNOB_ARCH == KNOB_ARCH_AVX2)
+#if KNOB_SIMD_WIDTH == 8
         __m128 srcLo = _mm256_extractf128_ps(in, 0);
         __m128 srcHi = _mm256_extractf128_ps(in, 1);
 
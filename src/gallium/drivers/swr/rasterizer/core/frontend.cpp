@@ -166,8 +166,8 @@ void ProcessStoreTiles(
     const uint32_t macroWidth = KNOB_MACROTILE_X_DIM;
     const uint32_t macroHeight = KNOB_MACROTILE_Y_DIM;
 
-    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (macroWidth - 1)) / macroWidth;
-    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (macroHeight - 1)) / macroHeight;
+    uint32_t numMacroTilesX = ((uint32_t)state.pViewport->vp[0].width + (uint32_t)state.pViewport->vp[0].x + (macroWidth - 1)) / macroWidth;
+    uint32_t numMacroTilesY = ((uint32_t)state.pViewport->vp[0].height + (uint32_t)state.pViewport->vp[0].y + (macroHeight - 1)) / macroHeight;
 
     // store tiles
     BE_WORK work;
@@ -210,8 +210,8 @@ void ProcessInvalidateTiles(
     uint32_t macroWidth = KNOB_MACROTILE_X_DIM;
     uint32_t macroHeight = KNOB_MACROTILE_Y_DIM;
 
-    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (macroWidth - 1)) / macroWidth;
-    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (macroHeight - 1)) / macroHeight;
+    uint32_t numMacroTilesX = ((uint32_t)state.pViewport->vp[0].width + (uint32_t)state.pViewport->vp[0].x + (macroWidth - 1)) / macroWidth;
+    uint32_t numMacroTilesY = ((uint32_t)state.pViewport->vp[0].height + (uint32_t)state.pViewport->vp[0].y + (macroHeight - 1)) / macroHeight;
 
     // load tiles
     BE_WORK work;
@@ -500,7 +500,7 @@ static void StreamOut(
     SWR_CONTEXT* pContext = pDC->pContext;
 
     const API_STATE& state = GetApiState(pDC);
-    const SWR_STREAMOUT_STATE &soState = state.soState;
+    const SWR_STREAMOUT_STATE &soState = state.pFrontend->soState;
 
     uint32_t soVertsPerPrim = NumVertsPerPrim(pa.binTopology, false);
 
@@ -548,8 +548,8 @@ static void StreamOut(
         soContext.pPrimData = pPrimData;
 
         // Call SOS
-        SWR_ASSERT(state.pfnSoFunc[streamIndex] != nullptr, "Trying to execute uninitialized streamout jit function.");
-        state.pfnSoFunc[streamIndex](soContext);
+        SWR_ASSERT(state.pShaders->pfnSoFunc[streamIndex] != nullptr, "Trying to execute uninitialized streamout jit function.");
+        state.pShaders->pfnSoFunc[streamIndex](soContext);
     }
 
     // Update SO write offset. The driver provides memory for the update.
@@ -655,7 +655,7 @@ static void GeometryShaderStage(
     SWR_CONTEXT* pContext = pDC->pContext;
 
     const API_STATE& state = GetApiState(pDC);
-    const SWR_GS_STATE* pState = &state.gsState;
+    const SWR_GS_STATE* pState = &state.pShaders->gsState;
 
     SWR_ASSERT(pGsOut != nullptr, "GS output buffer should be initialized");
     SWR_ASSERT(pCutBuffer != nullptr, "GS output cut buffer should be initialized");
@@ -687,7 +687,7 @@ static void GeometryShaderStage(
     }
 
     const uint32_t vertexStride = sizeof(simdvertex);
-    const uint32_t numSimdBatches = (state.gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
+    const uint32_t numSimdBatches = (state.pShaders->gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
     const uint32_t inputPrimStride = numSimdBatches * vertexStride;
     const uint32_t instanceStride = inputPrimStride * KNOB_SIMD_WIDTH;
     uint32_t cutPrimStride;
@@ -695,12 +695,12 @@ static void GeometryShaderStage(
 
     if (pState->isSingleStream)
     {
-        cutPrimStride = (state.gsState.maxNumVerts + 7) / 8;
+        cutPrimStride = (state.pShaders->gsState.maxNumVerts + 7) / 8;
         cutInstanceStride = cutPrimStride * KNOB_SIMD_WIDTH;
     }
     else
     {
-        cutPrimStride = AlignUp(state.gsState.maxNumVerts * 2 / 8, 4);
+        cutPrimStride = AlignUp(state.pShaders->gsState.maxNumVerts * 2 / 8, 4);
         cutInstanceStride = cutPrimStride * KNOB_SIMD_WIDTH;
     }
 
@@ -714,7 +714,7 @@ static void GeometryShaderStage(
         gsContext.mask = GenerateMask(numInputPrims);
 
         // execute the geometry shader
-        state.pfnGsFunc(GetPrivateState(pDC), &gsContext);
+        state.pShaders->pfnGsFunc(GetPrivateState(pDC), &gsContext);
 
         gsContext.pStream += instanceStride;
         gsContext.pCutOrStreamIdBuffer += cutInstanceStride;
@@ -776,7 +776,7 @@ static void GeometryShaderStage(
                 else
                 {
                     // early exit if this stream is not enabled for streamout
-                    if (HasStreamOutT && !state.soState.streamEnable[stream])
+                    if (HasStreamOutT && !state.pFrontend->soState.streamEnable[stream])
                     {
                         continue;
                     }
@@ -804,11 +804,11 @@ static void GeometryShaderStage(
                                 StreamOut(pDC, gsPa, workerId, pSoPrimData, stream);
                             }
 
-                            if (HasRastT && state.soState.streamToRasterizer == stream)
+                            if (HasRastT && state.pFrontend->soState.streamToRasterizer == stream)
                             {
                                 simdscalari vPrimId;
                                 // pull primitiveID from the GS output if available
-                                if (state.gsState.emitsPrimitiveID)
+                                if (state.pShaders->gsState.emitsPrimitiveID)
                                 {
                                     simdvector primIdAttrib[3];
                                     gsPa.Assemble(VERTEX_PRIMID_SLOT, primIdAttrib);
@@ -846,25 +846,25 @@ static INLINE void AllocateGsBuffers(DRAW_CONTEXT* pDC, const API_STATE& state,
 {
     Arena* pArena = pDC->pArena;
     SWR_ASSERT(pArena != nullptr);
-    SWR_ASSERT(state.gsState.gsEnable);
+    SWR_ASSERT(state.pShaders->gsState.gsEnable);
     // allocate arena space to hold GS output verts
     // @todo pack attribs
     // @todo support multiple streams
     const uint32_t vertexStride = sizeof(simdvertex);
-    const uint32_t numSimdBatches = (state.gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
-    uint32_t size = state.gsState.instanceCount * numSimdBatches * vertexStride * KNOB_SIMD_WIDTH;
+    const uint32_t numSimdBatches = (state.pShaders->gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
+    uint32_t size = state.pShaders->gsState.instanceCount * numSimdBatches * vertexStride * KNOB_SIMD_WIDTH;
     *ppGsOut = pArena->AllocAligned(size, KNOB_SIMD_WIDTH * sizeof(float));
 
-    const uint32_t cutPrimStride = (state.gsState.maxNumVerts + 7) / 8;
-    const uint32_t streamIdPrimStride = AlignUp(state.gsState.maxNumVerts * 2 / 8, 4);
-    const uint32_t cutBufferSize = cutPrimStride * state.gsState.instanceCount * KNOB_SIMD_WIDTH;
-    const uint32_t streamIdSize = streamIdPrimStride * state.gsState.instanceCount * KNOB_SIMD_WIDTH;
+    const uint32_t cutPrimStride = (state.pShaders->gsState.maxNumVerts + 7) / 8;
+    const uint32_t streamIdPrimStride = AlignUp(state.pShaders->gsState.maxNumVerts * 2 / 8, 4);
+    const uint32_t cutBufferSize = cutPrimStride * state.pShaders->gsState.instanceCount * KNOB_SIMD_WIDTH;
+    const uint32_t streamIdSize = streamIdPrimStride * state.pShaders->gsState.instanceCount * KNOB_SIMD_WIDTH;
 
     // allocate arena space to hold cut or streamid buffer, which is essentially a bitfield sized to the
     // maximum vertex output as defined by the GS state, per SIMD lane, per GS instance
 
     // allocate space for temporary per-stream cut buffer if multi-stream is enabled
-    if (state.gsState.isSingleStream)
+    if (state.pShaders->gsState.isSingleStream)
     {
         *ppCutBuffer = pArena->AllocAligned(cutBufferSize, KNOB_SIMD_WIDTH * sizeof(float));
         *ppStreamCutBuffer = nullptr;
@@ -928,7 +928,7 @@ static void TessellationStages(
     simdscalari primID)
 {
     const API_STATE& state = GetApiState(pDC);
-    const SWR_TS_STATE& tsState = state.tsState;
+    const SWR_TS_STATE& tsState = state.pShaders->tsState;
     SWR_CONTEXT *pContext = pDC->pContext; // Needed for UPDATE_STATS macro
 
     SWR_ASSERT(gt_pTessellationThreadData);
@@ -992,7 +992,7 @@ static void TessellationStages(
 
     // Run the HS
     RDTSC_START(FEHullShader);
-    state.pfnHsFunc(GetPrivateState(pDC), &hsContext);
+    state.pShaders->pfnHsFunc(GetPrivateState(pDC), &hsContext);
     RDTSC_STOP(FEHullShader, 0, 0);
 
     UPDATE_STAT(HsInvocations, numPrims);
@@ -1046,7 +1046,7 @@ static void TessellationStages(
             dsContext.mask = GenerateMask(tsData.NumDomainPoints - dsInvocations);
 
             RDTSC_START(FEDomainShader);
-            state.pfnDsFunc(GetPrivateState(pDC), &dsContext);
+            state.pShaders->pfnDsFunc(GetPrivateState(pDC), &dsContext);
             RDTSC_STOP(FEDomainShader, 0, 0);
 
             dsInvocations += KNOB_SIMD_WIDTH;
@@ -1102,6 +1102,367 @@ static void TessellationStages(
     TSDestroyCtx(tsCtx);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Sends a SIMD of assembled primitives through the remaining FE stages.
+/// @param pa - The primitive assembly object.
+/// @param prim - Assembled positions of the primitives.
+/// @param startPrimID - Primitive ID of the first primitive of the draw.
+template <
+    bool HasTessellationT,
+    bool HasGeometryShaderT,
+    bool HasStreamOutT,
+    bool HasRastT>
+static INLINE void ProcessAssembledPrims(
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId,
+    PA_STATE& pa,
+    simdvector prim[],
+    void* pGsOut,
+    void* pCutBuffer,
+    void* pStreamCutBuffer,
+    uint32_t* pSoPrimData,
+    uint32_t startPrimID)
+{
+    SWR_CONTEXT *pContext = pDC->pContext; // Needed for UPDATE_STATS macro
+
+    UPDATE_STAT(IaPrimitives, pa.NumPrims());
+
+    if (HasTessellationT)
+    {
+        TessellationStages<HasGeometryShaderT, HasStreamOutT, HasRastT>(
+            pDC, workerId, pa, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, pa.GetPrimID(startPrimID));
+    }
+    else if (HasGeometryShaderT)
+    {
+        GeometryShaderStage<HasStreamOutT, HasRastT>(
+            pDC, workerId, pa, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, pa.GetPrimID(startPrimID));
+    }
+    else
+    {
+        // If streamout is enabled then stream vertices out to memory.
+        if (HasStreamOutT)
+        {
+            StreamOut(pDC, pa, workerId, pSoPrimData, 0);
+        }
+
+        if (HasRastT)
+        {
+            SWR_ASSERT(pDC->pState->pfnProcessPrims);
+            pDC->pState->pfnProcessPrims(pDC, pa, workerId, prim,
+                GenMask(pa.NumPrims()), pa.GetPrimID(startPrimID));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief State of the vertex reuse path for one indexed draw.
+///        Primitives are walked on the CPU in windows. Each unique index of a
+///        window is fetched and shaded once into a cache of simdvertex and the
+///        PA gathers primitive vertices back out of the cache.
+struct VERTEX_REUSE_STATE
+{
+    struct HASH_ENTRY
+    {
+        uint32_t index;
+        uint32_t slot;
+        uint32_t window;        // window the entry belongs to, older entries are empty
+    };
+
+    uint32_t vertsPerPrim;
+    uint32_t maxVerts;          // cache size in vertices, multiple of the SIMD width
+    uint32_t maxPrims;          // primitives per window
+
+    // topology state carried across windows, holds index values
+    uint32_t vert[3];
+    uint32_t curIndex;
+    bool reverseWinding;
+    bool isStrip;
+
+    HASH_ENTRY* pHash;
+    uint32_t hashMask;
+    uint32_t window;
+
+    uint8_t* pUnique;           // unique indices of the window in the index buffer format
+    uint32_t numUnique;
+    uint32_t numCutIndices;     // cut indices consumed by the window, never shaded
+    uint32_t* pSlots[MAX_NUM_VERTS_PER_PRIM];   // cache slot per prim, for each vertex of the prim
+    uint32_t numPrims;
+    simdvertex* pCache;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns vertices per primitive for topologies the vertex reuse
+///        path can assemble, 0 if it can't.
+static INLINE uint32_t GetVertexReuseVertsPerPrim(PRIMITIVE_TOPOLOGY topology)
+{
+    switch (topology)
+    {
+    case TOP_POINT_LIST:        return 1;
+    case TOP_LINE_LIST:
+    case TOP_LINE_STRIP:        return 2;
+    case TOP_TRIANGLE_LIST:
+    case TOP_TRIANGLE_STRIP:    return 3;
+    default:                    return 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Allocates the vertex reuse state for a draw from the draw arena.
+static VERTEX_REUSE_STATE* AllocateVertexReuseState(DRAW_CONTEXT* pDC, PRIMITIVE_TOPOLOGY topology, uint32_t indexSize)
+{
+    Arena* pArena = pDC->pArena;
+    VERTEX_REUSE_STATE* pState = (VERTEX_REUSE_STATE*)pArena->AllocAligned(sizeof(VERTEX_REUSE_STATE), 16);
+    memset(pState, 0, sizeof(*pState));
+
+    pState->vertsPerPrim = GetVertexReuseVertsPerPrim(topology);
+    pState->isStrip = (topology == TOP_LINE_STRIP || topology == TOP_TRIANGLE_STRIP);
+    pState->maxVerts = AlignUp(std::min<uint32_t>(std::max<uint32_t>(KNOB_VERTEX_REUSE_WINDOW, pState->vertsPerPrim), 1024), KNOB_SIMD_WIDTH);
+
+    // enough for a closed triangle mesh, which has about two triangles per vertex
+    pState->maxPrims = pState->maxVerts * 2;
+
+    uint32_t hashSize = 1;
+    while (hashSize < pState->maxVerts * 2)
+    {
+        hashSize <<= 1;
+    }
+    pState->hashMask = hashSize - 1;
+    pState->pHash = (VERTEX_REUSE_STATE::HASH_ENTRY*)pArena->AllocAligned(hashSize * sizeof(VERTEX_REUSE_STATE::HASH_ENTRY), 16);
+    memset(pState->pHash, 0, hashSize * sizeof(VERTEX_REUSE_STATE::HASH_ENTRY));
+
+    // the fetch shader always reads a full SIMD of indices and the PA a full SIMD of slots
+    pState->pUnique = (uint8_t*)pArena->AllocAligned(pState->maxVerts * indexSize, 16);
+    for (uint32_t v = 0; v < pState->vertsPerPrim; ++v)
+    {
+        pState->pSlots[v] = (uint32_t*)pArena->AllocAligned((pState->maxPrims + KNOB_SIMD_WIDTH) * sizeof(uint32_t), 16);
+        memset(pState->pSlots[v], 0, (pState->maxPrims + KNOB_SIMD_WIDTH) * sizeof(uint32_t));
+    }
+    pState->pCache = (simdvertex*)pArena->AllocAligned(pState->maxVerts / KNOB_SIMD_WIDTH * sizeof(simdvertex), KNOB_SIMD_WIDTH * sizeof(float));
+
+    return pState;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the cache slot of an index in the current window, adding
+///        the index to the window's unique indices if it's new.
+static INLINE uint32_t GetVertexReuseSlot(VERTEX_REUSE_STATE& rs, uint32_t index, uint32_t indexSize)
+{
+    uint32_t h = (index * 0x9E3779B1) >> 8;
+    for (;;)
+    {
+        VERTEX_REUSE_STATE::HASH_ENTRY& entry = rs.pHash[h & rs.hashMask];
+        if (entry.window != rs.window)
+        {
+            entry.index = index;
+            entry.slot = rs.numUnique++;
+            entry.window = rs.window;
+
+            switch (indexSize)
+            {
+            case sizeof(uint8_t):   rs.pUnique[entry.slot] = (uint8_t)index; break;
+            case sizeof(uint16_t):  ((uint16_t*)rs.pUnique)[entry.slot] = (uint16_t)index; break;
+            default:                ((uint32_t*)rs.pUnique)[entry.slot] = index; break;
+            }
+            return entry.slot;
+        }
+        if (entry.index == index)
+        {
+            return entry.slot;
+        }
+        h++;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Walks the index buffer from curVertex and fills the next window
+///        of primitives. Stops when the cache or primitive slots are full.
+/// @param pIB - Index buffer of the draw.
+/// @param numValidIndices - Indices past this read as 0, like in the fetch shader.
+/// @returns Position in the index buffer the next window starts at.
+static uint32_t FillVertexReuseWindow(
+    VERTEX_REUSE_STATE& rs,
+    const SWR_FRONTEND_STATE& feState,
+    const uint8_t* pIB,
+    uint32_t indexSize,
+    uint32_t numValidIndices,
+    uint32_t curVertex,
+    uint32_t endVertex)
+{
+    rs.window++;
+    rs.numUnique = 0;
+    rs.numCutIndices = 0;
+    rs.numPrims = 0;
+
+    while (curVertex < endVertex &&
+        rs.numPrims < rs.maxPrims &&
+        rs.numUnique + rs.vertsPerPrim <= rs.maxVerts)
+    {
+        uint32_t index = 0;
+        if (curVertex < numValidIndices)
+        {
+            switch (indexSize)
+            {
+            case sizeof(uint8_t):   index = pIB[curVertex]; break;
+            case sizeof(uint16_t):  index = ((const uint16_t*)pIB)[curVertex]; break;
+            default:                index = ((const uint32_t*)pIB)[curVertex]; break;
+            }
+        }
+        curVertex++;
+
+        // if cut index, restart topology
+        if (feState.bEnableCutIndex && index == feState.cutIndex)
+        {
+            rs.curIndex = 0;
+            rs.reverseWinding = false;
+            rs.numCutIndices++;
+            continue;
+        }
+
+        rs.vert[rs.curIndex++] = index;
+        if (rs.curIndex < rs.vertsPerPrim)
+        {
+            continue;
+        }
+
+        // same winding as the cut-aware PA
+        for (uint32_t v = 0; v < rs.vertsPerPrim; ++v)
+        {
+            uint32_t vertex = (rs.reverseWinding && v != 0) ? 3 - v : v;
+            rs.pSlots[v][rs.numPrims] = GetVertexReuseSlot(rs, rs.vert[vertex], indexSize);
+        }
+        rs.numPrims++;
+
+        // set up next prim state
+        if (rs.isStrip)
+        {
+            rs.vert[0] = rs.vert[1];
+            rs.vert[1] = rs.vert[2];
+            rs.curIndex = rs.vertsPerPrim - 1;
+            rs.reverseWinding ^= (rs.vertsPerPrim == 3);
+        }
+        else
+        {
+            rs.curIndex = 0;
+        }
+    }
+
+    return curVertex;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief FE handler for indexed draws with vertex reuse. Fetches and shades
+///        each unique vertex of a window once, then assembles the window's
+///        primitives from the shaded cache.
+/// @param indexSize - Size of an index in bytes.
+template <
+    bool HasGeometryShaderT,
+    bool HasStreamOutT,
+    bool HasRastT>
+static void ProcessDrawVertexReuse(
+    SWR_CONTEXT *pContext,
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId,
+    DRAW_WORK& work,
+    SWR_FETCH_CONTEXT& fetchInfo,
+    uint32_t indexSize,
+    void* pGsOut,
+    void* pCutBuffer,
+    void* pStreamCutBuffer,
+    uint32_t* pSoPrimData)
+{
+    const API_STATE& state = GetApiState(pDC);
+    SWR_VS_CONTEXT vsContext;
+    simdvertex vin;
+
+    VERTEX_REUSE_STATE& rs = *AllocateVertexReuseState(pDC, state.topology, indexSize);
+    PA_STATE_REUSE pa(pDC, state.topology, rs.vertsPerPrim);
+
+    const uint8_t* pIB = (const uint8_t*)work.pIB;
+    uint32_t endVertex = work.numVerts;
+    uint32_t numValidIndices = std::min<uint32_t>(endVertex,
+        (uint32_t)(((const uint8_t*)fetchInfo.pLastIndex - pIB) / indexSize));
+
+    vsContext.pVin = &vin;
+
+    // the fetch shader bounds checks against the window's unique indices now
+    const int32_t* pLastIndex = fetchInfo.pLastIndex;
+
+    for (uint32_t instanceNum = 0; instanceNum < work.numInstances; instanceNum++)
+    {
+        fetchInfo.CurInstance = instanceNum;
+        vsContext.InstanceID = instanceNum;
+
+        rs.curIndex = 0;
+        rs.reverseWinding = false;
+
+        uint32_t curVertex = 0;
+        while (curVertex < endVertex)
+        {
+            uint32_t windowStart = curVertex;
+            curVertex = FillVertexReuseWindow(rs, state.pFrontend->frontendState, pIB, indexSize, numValidIndices, curVertex, endVertex);
+
+            UPDATE_STAT(IaVertices, curVertex - windowStart);
+
+            // 1. Execute FS/VS once per unique vertex of the window.
+            fetchInfo.pLastIndex = (const int32_t*)(rs.pUnique + rs.numUnique * indexSize);
+            for (uint32_t u = 0; u < rs.numUnique; u += KNOB_SIMD_WIDTH)
+            {
+                fetchInfo.pIndices = (const int32_t*)(rs.pUnique + u * indexSize);
+
+                RDTSC_START(FEFetchShader);
+                state.pShaders->pfnFetchFunc(fetchInfo, vin);
+                RDTSC_STOP(FEFetchShader, 0, 0);
+
+                // forward fetch generated vertex IDs to the vertex shader
+                vsContext.VertexID = fetchInfo.VertexID;
+                vsContext.mask = GenerateMask(rs.numUnique - u);
+                vsContext.pVout = &rs.pCache[u / KNOB_SIMD_WIDTH];
+
+#if KNOB_ENABLE_TOSS_POINTS
+                if (!KNOB_TOSS_FETCH)
+#endif
+                {
+                    RDTSC_START(FEVertexShader);
+                    state.pShaders->pfnVertexFunc(GetPrivateState(pDC), &vsContext);
+                    RDTSC_STOP(FEVertexShader, 0, 0);
+
+                    UPDATE_STAT(VsInvocations, GetNumInvocations(u, rs.numUnique));
+                }
+            }
+            fetchInfo.pLastIndex = pLastIndex;
+
+            UPDATE_STAT(VsInvocationsSaved, (curVertex - windowStart) - rs.numCutIndices - rs.numUnique);
+
+            if (rs.numPrims == 0)
+            {
+                continue;
+            }
+
+            // 2. Assemble and process the window's primitives.
+            pa.SetWindow(rs.pCache, rs.numUnique, rs.pSlots, rs.numPrims);
+            do
+            {
+                simdvector prim[MAX_NUM_VERTS_PER_PRIM];
+                RDTSC_START(FEPAAssemble);
+                bool assemble = pa.Assemble(VERTEX_POSITION_SLOT, prim);
+                RDTSC_STOP(FEPAAssemble, 1, 0);
+
+#if KNOB_ENABLE_TOSS_POINTS
+                if (!KNOB_TOSS_FETCH && !KNOB_TOSS_VS)
+#endif
+                {
+                    if (assemble)
+                    {
+                        ProcessAssembledPrims<false, HasGeometryShaderT, HasStreamOutT, HasRastT>(
+                            pDC, workerId, pa, prim, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, work.startPrimID);
+                    }
+                }
+            } while (pa.NextPrim());
+        }
+        pa.Reset();
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief FE handler for SwrDraw.
 /// @tparam IsIndexedT - Is indexed drawing enabled
@@ -1174,7 +1535,7 @@ void ProcessDraw(
     }
 
     SWR_FETCH_CONTEXT fetchInfo = { 0 };
-    fetchInfo.pStreams = &state.vertexBuffers[0];
+    fetchInfo.pStreams = &state.pVertexInput->vertexBuffers[0];
     fetchInfo.StartInstance = work.startInstance;
     fetchInfo.StartVertex = 0;
 
@@ -1186,7 +1547,7 @@ void ProcessDraw(
 
         // if the entire index buffer isn't being consumed, set the last index
         // so that fetches < a SIMD wide will be masked off
-        fetchInfo.pLastIndex = (const int32_t*)(((BYTE*)state.indexBuffer.pIndices) + state.indexBuffer.size);
+        fetchInfo.pLastIndex = (const int32_t*)(((BYTE*)state.pVertexInput->indexBuffer.pIndices) + state.pVertexInput->indexBuffer.size);
         if (pLastRequestedIndex < fetchInfo.pLastIndex)
         {
             fetchInfo.pLastIndex = pLastRequestedIndex;
@@ -1197,9 +1558,7 @@ void ProcessDraw(
         fetchInfo.StartVertex = work.startVertex;
     }
 
-#ifdef KNOB_ENABLE_RDTSC
     uint32_t numPrims = GetNumPrims(state.topology, work.numVerts);
-#endif
 
     void* pGsOut = nullptr;
     void* pCutBuffer = nullptr;
@@ -1211,17 +1570,17 @@ void ProcessDraw(
 
     if (HasTessellationT)
     {
-        SWR_ASSERT(state.tsState.tsEnable == true);
-        SWR_ASSERT(state.pfnHsFunc != nullptr);
-        SWR_ASSERT(state.pfnDsFunc != nullptr);
+        SWR_ASSERT(state.pShaders->tsState.tsEnable == true);
+        SWR_ASSERT(state.pShaders->pfnHsFunc != nullptr);
+        SWR_ASSERT(state.pShaders->pfnDsFunc != nullptr);
 
         AllocateTessellationData(pContext);
     }
     else
     {
-        SWR_ASSERT(state.tsState.tsEnable == false);
-        SWR_ASSERT(state.pfnHsFunc == nullptr);
-        SWR_ASSERT(state.pfnDsFunc == nullptr);
+        SWR_ASSERT(state.pShaders->tsState.tsEnable == false);
+        SWR_ASSERT(state.pShaders->pfnHsFunc == nullptr);
+        SWR_ASSERT(state.pShaders->pfnDsFunc == nullptr);
     }
 
     // allocate space for streamout input prim data
@@ -1238,6 +1597,16 @@ void ProcessDraw(
 
     }
 
+    if (IsIndexedT && !HasTessellationT && KNOB_VERTEX_REUSE_WINDOW &&
+        GetVertexReuseVertsPerPrim(state.topology))
+    {
+        ProcessDrawVertexReuse<HasGeometryShaderT, HasStreamOutT, HasRastT>(pContext, pDC, workerId, work,
+            fetchInfo, indexSize, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData);
+
+        RDTSC_STOP(FEProcessDraw, numPrims * work.numInstances, pDC->drawId);
+        return;
+    }
+
     // choose primitive assembler
     PA_FACTORY<IsIndexedT> paFactory(pDC, state.topology, work.numVerts);
     PA_STATE& pa = paFactory.GetPA();
@@ -1279,7 +1648,7 @@ void ProcessDraw(
 
                 // 1. Execute FS/VS for a single SIMD.
                 RDTSC_START(FEFetchShader);
-                state.pfnFetchFunc(fetchInfo, vin);
+                state.pShaders->pfnFetchFunc(fetchInfo, vin);
                 RDTSC_STOP(FEFetchShader, 0, 0);
 
                 // forward fetch generated vertex IDs to the vertex shader
@@ -1301,7 +1670,7 @@ void ProcessDraw(
 #endif
                 {
                     RDTSC_START(FEVertexShader);
-                    state.pfnVertexFunc(GetPrivateState(pDC), &vsContext);
+                    state.pShaders->pfnVertexFunc(GetPrivateState(pDC), &vsContext);
                     RDTSC_STOP(FEVertexShader, 0, 0);
 
                     UPDATE_STAT(VsInvocations, GetNumInvocations(i, endVertex));
@@ -1327,33 +1696,8 @@ void ProcessDraw(
                     {
                         if (assemble)
                         {
-                            UPDATE_STAT(IaPrimitives, pa.NumPrims());
-
-                            if (HasTessellationT)
-                            {
-                                TessellationStages<HasGeometryShaderT, HasStreamOutT, HasRastT>(
-                                    pDC, workerId, pa, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, pa.GetPrimID(work.startPrimID));
-                            }
-                            else if (HasGeometryShaderT)
-                            {
-                                GeometryShaderStage<HasStreamOutT, HasRastT>(
-                                    pDC, workerId, pa, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, pa.GetPrimID(work.startPrimID));
-                            }
-                            else
-                            {
-                                // If streamout is enabled then stream vertices out to memory.
-                                if (HasStreamOutT)
-                                {
-                                    StreamOut(pDC, pa, workerId, pSoPrimData, 0);
-                                }
-
-                                if (HasRastT)
-                                {
-                                    SWR_ASSERT(pDC->pState->pfnProcessPrims);
-                                    pDC->pState->pfnProcessPrims(pDC, pa, workerId, prim,
-                                        GenMask(pa.NumPrims()), pa.GetPrimID(work.startPrimID));
-                                }
-                            }
+                            ProcessAssembledPrims<HasTessellationT, HasGeometryShaderT, HasStreamOutT, HasRastT>(
+                                pDC, workerId, pa, prim, pGsOut, pCutBuffer, pStreamCutBuffer, pSoPrimData, work.startPrimID);
                         }
                     }
                 }
@@ -1408,6 +1752,79 @@ template void ProcessDraw<true,  true,  true,  false, true >(SWR_CONTEXT *pConte
 template void ProcessDraw<true,  true,  true,  true,  false>(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint32_t workerId, void *pUserData);
 template void ProcessDraw<true,  true,  true,  true,  true >(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint32_t workerId, void *pUserData);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief FE handler for SwrDrawIndirect.  Reads the draw arguments and
+///        runs the draw's FE handler with them.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id. Even thread has a unique id.
+/// @param pUserData - Pointer to DRAW_WORK
+void ProcessDrawIndirect(
+    SWR_CONTEXT *pContext,
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId,
+    void *pUserData)
+{
+    DRAW_WORK& work = *(DRAW_WORK*)pUserData;
+    const SWR_DRAW_INDIRECT_ARGS& args = *(const SWR_DRAW_INDIRECT_ARGS*)work.pIndirectArgs;
+
+    work.numVerts = args.numVertices;
+    work.startVertex = args.startVertex;
+    work.numInstances = args.numInstances;
+    work.startInstance = args.startInstance;
+    work.startPrimID = 0;
+    work.startVertexID = 0;
+
+    if (work.numVerts == 0 || work.numInstances == 0)
+    {
+        return;
+    }
+
+    work.pfnIndirectDraw(pContext, pDC, workerId, pUserData);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief FE handler for SwrDrawIndexedIndirect.  Reads the draw arguments
+///        and runs the draw's FE handler with them.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id. Even thread has a unique id.
+/// @param pUserData - Pointer to DRAW_WORK
+void ProcessDrawIndexedIndirect(
+    SWR_CONTEXT *pContext,
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId,
+    void *pUserData)
+{
+    DRAW_WORK& work = *(DRAW_WORK*)pUserData;
+    const API_STATE& state = GetApiState(pDC);
+    const SWR_DRAW_INDEXED_INDIRECT_ARGS& args = *(const SWR_DRAW_INDEXED_INDIRECT_ARGS*)work.pIndirectArgs;
+
+    uint32_t indexSize = 0;
+    switch (work.type)
+    {
+    case R32_UINT: indexSize = sizeof(uint32_t); break;
+    case R16_UINT: indexSize = sizeof(uint16_t); break;
+    case R8_UINT: indexSize = sizeof(uint8_t); break;
+    default:
+        SWR_ASSERT(0);
+    }
+
+    work.numIndices = args.numIndices;
+    work.pIB = (const int32_t*)((const uint8_t*)state.pVertexInput->indexBuffer.pIndices + (uint64_t)args.indexOffset * indexSize);
+    work.baseVertex = args.baseVertex;
+    work.numInstances = args.numInstances;
+    work.startInstance = args.startInstance;
+    work.startPrimID = 0;
+
+    if (work.numIndices == 0 || work.numInstances == 0)
+    {
+        return;
+    }
+
+    work.pfnIndirectDraw(pContext, pDC, workerId, pUserData);
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief Processes attributes for the backend based on linkage mask and
@@ -1429,8 +1846,8 @@ INLINE void ProcessAttributes(
 {
     DWORD slot = 0;
     uint32_t mapIdx = 0;
-    LONG constantInterpMask = pDC->pState->state.backendState.constantInterpolationMask;
-    const uint32_t provokingVertex = pDC->pState->state.frontendState.topologyProvokingVertex;
+    LONG constantInterpMask = pDC->pState->state.pRaster->backendState.constantInterpolationMask;
+    const uint32_t provokingVertex = pDC->pState->state.pFrontend->frontendState.topologyProvokingVertex;
 
     while (_BitScanForward(&slot, linkageMask))
     {
@@ -1538,9 +1955,17 @@ void BinTriangles(
     RDTSC_START(FEBinTriangles);
 
     const API_STATE& state = GetApiState(pDC);
-    const SWR_RASTSTATE& rastState = state.rastState;
-    const SWR_FRONTEND_STATE& feState = state.frontendState;
-    const SWR_GS_STATE& gsState = state.gsState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
+    const SWR_FRONTEND_STATE& feState = state.pFrontend->frontendState;
+    const SWR_GS_STATE& gsState = state.pShaders->gsState;
+    SWR_CONTEXT *pContext = pDC->pContext;
+    HotTileMgr *pHotTileMgr = pContext->pHotTileMgr;
+
+    // test against the coarse depth of the macrotiles, see HIZ_TILE; depth bias
+    // isn't known until the rasterizer
+    const bool hiZTest = KNOB_ENABLE_HIZ && CanHiZReject(state) &&
+        rastState.depthBias == 0 && rastState.slopeScaledDepthBias == 0;
+    const SWR_ZFUNCTION depthTestFunc = (SWR_ZFUNCTION)state.pRaster->depthStencilState.depthTestFunc;
 
     // Simple wireframe mode for debugging purposes only
 
@@ -1568,7 +1993,7 @@ void BinTriangles(
         tri[2].v[2] = _simd_mul_ps(tri[2].v[2], vRecipW2);
 
         // viewport transform to screen coords
-        viewportTransform<3>(tri, state.vpMatrix[0]);
+        viewportTransform<3>(tri, state.pViewport->vpMatrix[0]);
     }
 
     // adjust for pixel center location
@@ -1749,11 +2174,38 @@ void BinTriangles(
         _simd_store_si((simdscalari*)aRTAI, _simd_setzero_si());
     }
 
+    // min z for the HiZ test, clamped like DepthStencilTest does
+    OSALIGNSIMD(float) aMinZ[KNOB_SIMD_WIDTH];
+    if (hiZTest)
+    {
+        simdscalar vMinZ = _simd_min_ps(tri[0].z, _simd_min_ps(tri[1].z, tri[2].z));
+        vMinZ = _simd_min_ps(_simd_broadcast_ss(&state.pViewport->vp[0].maxZ), _simd_max_ps(_simd_broadcast_ss(&state.pViewport->vp[0].minZ), vMinZ));
+        _simd_store_ps(aMinZ, vMinZ);
+    }
+
     // scan remaining valid triangles and bin each separately
     while (_BitScanForward(&triIndex, triMask))
     {
-        uint32_t linkageCount = state.linkageCount;
-        uint32_t linkageMask  = state.linkageMask;
+        // drop triangles behind the coarse depth of all of their macrotiles
+        bool hiZOccluded = hiZTest;
+        for (uint32_t y = aMTTop[triIndex]; hiZOccluded && y <= aMTBottom[triIndex]; ++y)
+        {
+            for (uint32_t x = aMTLeft[triIndex]; hiZOccluded && x <= aMTRight[triIndex]; ++x)
+            {
+                hiZOccluded = HiZOccluded(depthTestFunc, aMinZ[triIndex],
+                    pHotTileMgr->GetHiZMaxZ(x, y, pDC->hiZGeneration, aRTAI[triIndex]));
+            }
+        }
+
+        if (hiZOccluded)
+        {
+            UPDATE_STAT(HiZTrisTossedFE, 1);
+            triMask &= ~(1 << triIndex);
+            continue;
+        }
+
+        uint32_t linkageCount = state.pFrontend->linkageCount;
+        uint32_t linkageMask  = state.pFrontend->linkageMask;
         uint32_t numScalarAttribs = linkageCount * 4;
         
         BE_WORK work;
@@ -1783,7 +2235,7 @@ void BinTriangles(
         float *pAttribs = (float*)pArena->AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
         desc.pAttribs = pAttribs;
         desc.numAttribs = linkageCount;
-        ProcessAttributes<3>(pDC, pa, linkageMask, state.linkageMap, triIndex, desc.pAttribs);
+        ProcessAttributes<3>(pDC, pa, linkageMask, state.pFrontend->linkageMap, triIndex, desc.pAttribs);
 
         // store triangle vertex data
         desc.pTriBuffer = (float*)pArena->AllocAligned(4 * 4 * sizeof(float), 16);
@@ -1806,6 +2258,12 @@ void BinTriangles(
         {
             for (uint32_t x = aMTLeft[triIndex]; x <= aMTRight[triIndex]; ++x)
             {
+                if (hiZTest && HiZOccluded(depthTestFunc, aMinZ[triIndex],
+                    pHotTileMgr->GetHiZMaxZ(x, y, pDC->hiZGeneration, aRTAI[triIndex])))
+                {
+                    continue;
+                }
+
 #if KNOB_ENABLE_TOSS_POINTS
                 if (!KNOB_TOSS_SETUP_TRIS)
 #endif
@@ -1844,9 +2302,9 @@ void BinPoints(
     simdvector& primVerts = prim[0];
 
     const API_STATE& state = GetApiState(pDC);
-    const SWR_FRONTEND_STATE& feState = state.frontendState;
-    const SWR_GS_STATE& gsState = state.gsState;
-    const SWR_RASTSTATE& rastState = state.rastState;
+    const SWR_FRONTEND_STATE& feState = state.pFrontend->frontendState;
+    const SWR_GS_STATE& gsState = state.pShaders->gsState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
 
     if (!feState.vpTransformDisable)
     {
@@ -1857,7 +2315,7 @@ void BinPoints(
         primVerts.z = _simd_mul_ps(primVerts.z, vRecipW0);
 
         // viewport transform to screen coords
-        viewportTransform<1>(&primVerts, state.vpMatrix[0]);
+        viewportTransform<1>(&primVerts, state.pViewport->vpMatrix[0]);
     }
 
     // adjust for pixel center location
@@ -1931,8 +2389,8 @@ void BinPoints(
         // scan remaining valid triangles and bin each separately
         while (_BitScanForward(&primIndex, primMask))
         {
-            uint32_t linkageCount = state.linkageCount;
-            uint32_t linkageMask = state.linkageMask;
+            uint32_t linkageCount = state.pFrontend->linkageCount;
+            uint32_t linkageMask = state.pFrontend->linkageMask;
 
             uint32_t numScalarAttribs = linkageCount * 4;
 
@@ -1956,7 +2414,7 @@ void BinPoints(
             desc.pAttribs = pAttribs;
             desc.numAttribs = linkageCount;
 
-            ProcessAttributes<1>(pDC, pa, linkageMask, state.linkageMap, primIndex, pAttribs);
+            ProcessAttributes<1>(pDC, pa, linkageMask, state.pFrontend->linkageMap, primIndex, pAttribs);
 
             // store raster tile aligned x, y, perspective correct z
             float *pTriBuffer = (float*)pArena->AllocAligned(4 * sizeof(float), 16);
@@ -2066,8 +2524,8 @@ void BinPoints(
         DWORD primIndex;
         while (_BitScanForward(&primIndex, primMask))
         {
-            uint32_t linkageCount = state.linkageCount;
-            uint32_t linkageMask = state.linkageMask;
+            uint32_t linkageCount = state.pFrontend->linkageCount;
+            uint32_t linkageMask = state.pFrontend->linkageMask;
             uint32_t numScalarAttribs = linkageCount * 4;
 
             BE_WORK work;
@@ -2088,7 +2546,7 @@ void BinPoints(
             // store active attribs
             desc.pAttribs = (float*)pArena->AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
             desc.numAttribs = linkageCount;
-            ProcessAttributes<1>(pDC, pa, linkageMask, state.linkageMap, primIndex, desc.pAttribs);
+            ProcessAttributes<1>(pDC, pa, linkageMask, state.pFrontend->linkageMap, primIndex, desc.pAttribs);
 
             // store point vertex data
             float *pTriBuffer = (float*)pArena->AllocAligned(4 * sizeof(float), 16);
@@ -2147,9 +2605,9 @@ void BinLines(
     RDTSC_START(FEBinLines);
 
     const API_STATE& state = GetApiState(pDC);
-    const SWR_RASTSTATE& rastState = state.rastState;
-    const SWR_FRONTEND_STATE& feState = state.frontendState;
-    const SWR_GS_STATE& gsState = state.gsState;
+    const SWR_RASTSTATE& rastState = state.pRaster->rastState;
+    const SWR_FRONTEND_STATE& feState = state.pFrontend->frontendState;
+    const SWR_GS_STATE& gsState = state.pShaders->gsState;
 
     simdscalar vRecipW0 = _simd_set1_ps(1.0f);
     simdscalar vRecipW1 = _simd_set1_ps(1.0f);
@@ -2170,7 +2628,7 @@ void BinLines(
         prim[1].v[2] = _simd_mul_ps(prim[1].v[2], vRecipW1);
 
         // viewport transform to screen coords
-        viewportTransform<2>(prim, state.vpMatrix[0]);
+        viewportTransform<2>(prim, state.pViewport->vpMatrix[0]);
     }
 
     // adjust for pixel center location
@@ -2283,8 +2741,8 @@ void BinLines(
     DWORD primIndex;
     while (_BitScanForward(&primIndex, primMask))
     {
-        uint32_t linkageCount = state.linkageCount;
-        uint32_t linkageMask = state.linkageMask;
+        uint32_t linkageCount = state.pFrontend->linkageCount;
+        uint32_t linkageMask = state.pFrontend->linkageMask;
         uint32_t numScalarAttribs = linkageCount * 4;
 
         BE_WORK work;
@@ -2305,7 +2763,7 @@ void BinLines(
         // store active attribs
         desc.pAttribs = (float*)pArena->AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
         desc.numAttribs = linkageCount;
-        ProcessAttributes<2>(pDC, pa, linkageMask, state.linkageMap, primIndex, desc.pAttribs);
+        ProcessAttributes<2>(pDC, pa, linkageMask, state.pFrontend->linkageMap, primIndex, desc.pAttribs);
 
         // store line vertex data
         desc.pTriBuffer = (float*)pArena->AllocAligned(4 * 4 * sizeof(float), 16);
@@ -52,8 +52,13 @@
 #elif (KNOB_ARCH == KNOB_ARCH_AVX512)
 #define KNOB_ARCH_ISA AVX512F
 #define KNOB_ARCH_STR "AVX512"
-#define KNOB_SIMD_WIDTH 16
-#error "AVX512 not yet supported"
+// An AVX512 build of the 8 wide pipeline.  The pipeline interfaces
+// (simdvertex, PA, coverage masks, jitted shader signatures) are the AVX2
+// ones.  AVX512 code is used internally where it is a drop in replacement,
+// via the simd16 wrappers.
+#define KNOB_SIMD_WIDTH 8
+#define KNOB_SIMD16_WIDTH 16
+#define ENABLE_AVX512_SIMD16 1
 #else
 #error "Unknown architecture"
 #endif
@@ -133,8 +138,6 @@
 ///////////////////////////////////////////////////////////////////////////////
 // Debug knobs
 ///////////////////////////////////////////////////////////////////////////////
-//#define KNOB_ENABLE_RDTSC
-
 // Set to 1 to use the dynamic KNOB_TOSS_XXXX knobs.
 #if !defined(KNOB_ENABLE_TOSS_POINTS)
 #define KNOB_ENABLE_TOSS_POINTS                 0
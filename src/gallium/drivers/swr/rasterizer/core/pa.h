@@ -383,7 +383,7 @@ struct PA_STATE_CUT : public PA_STATE
         reverseWinding = false;
         adjExtraVert = -1;
 
-        bool gsEnabled = pDC->pState->state.gsState.gsEnable;
+        bool gsEnabled = pDC->pState->state.pShaders->gsState.gsEnable;
         vertsPerPrim = NumVertsPerPrim(topo, gsEnabled);
 
         switch (topo)
@@ -957,6 +957,165 @@ struct PA_STATE_CUT : public PA_STATE
     }
 };
 
+// Primitive assembler for the frontend vertex reuse path. The frontend shades every
+// unique vertex of a window of primitives once into a cache of simdvertex and hands the
+// PA the cache slot of each primitive vertex. The PA then gathers SIMD primitives
+// straight out of the cache.
+struct PA_STATE_REUSE : public PA_STATE
+{
+    const uint32_t* pSlots[MAX_NUM_VERTS_PER_PRIM]; // cache slot per prim, for each vertex of the prim
+    uint32_t numVertsPerPrim;       // vertices per primitive
+    uint32_t numPrims;              // number of primitives in the current window
+    uint32_t curPrim;               // first primitive of the current SIMD
+    uint32_t primIdBase;            // primitives emitted by previous windows
+    simdscalari vPrimId;            // vector of prim ID, continues across windows
+    simdscalari vOffsets[MAX_NUM_VERTS_PER_PRIM];   // byte offsets for currently assembling simd
+    simdvertex tmpVertex;           // temporary simdvertex for unimplemented API
+    simdmask tmpIndices;            // temporary index store for unimplemented API
+
+    PA_STATE_REUSE() {}
+    PA_STATE_REUSE(DRAW_CONTEXT* pDC, PRIMITIVE_TOPOLOGY topo, uint32_t in_numVertsPerPrim)
+        : PA_STATE(pDC, nullptr, 0)
+    {
+        binTopology = topo;
+        numVertsPerPrim = in_numVertsPerPrim;
+        numPrims = curPrim = primIdBase = 0;
+        memset(pSlots, 0, sizeof(pSlots));
+        vPrimId = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    }
+
+    // Starts assembling a new window. The slot arrays must be readable a full
+    // SIMD past in_numPrims.
+    void SetWindow(simdvertex* pCache, uint32_t in_numVertsInCache, uint32_t* const in_pSlots[], uint32_t in_numPrims)
+    {
+        this->pStreamBase = (uint8_t*)pCache;
+        this->streamSizeInVerts = in_numVertsInCache;
+        for (uint32_t v = 0; v < this->numVertsPerPrim; ++v)
+        {
+            this->pSlots[v] = in_pSlots[v];
+        }
+        // the last SIMD of the previous window may have been partial
+        this->primIdBase += this->numPrims;
+        this->numPrims = in_numPrims;
+        this->curPrim = 0;
+        this->vPrimId = _simd_add_epi32(_simd_set1_epi32(this->primIdBase), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        ComputeOffsets();
+    }
+
+    void ComputeOffsets()
+    {
+        for (uint32_t v = 0; v < this->numVertsPerPrim; ++v)
+        {
+            simdscalari vSlots = _simd_loadu_si((const simdscalari*)&this->pSlots[v][this->curPrim]);
+
+            // step to simdvertex batch
+            simdscalari vVertexBatch = _simd_srai_epi32(vSlots, 3);
+            this->vOffsets[v] = _simd_mullo_epi32(vVertexBatch, _simd_set1_epi32(sizeof(simdvertex)));
+
+            // step to lane
+            simdscalari vVertexLane = _simd_and_si(vSlots, _simd_set1_epi32(KNOB_SIMD_WIDTH - 1));
+            this->vOffsets[v] = _simd_add_epi32(this->vOffsets[v], _simd_mullo_epi32(vVertexLane, _simd_set1_epi32(sizeof(float))));
+        }
+    }
+
+    bool HasWork()
+    {
+        return this->curPrim < this->numPrims;
+    }
+
+    simdvector& GetSimdVector(uint32_t index, uint32_t slot)
+    {
+        SWR_ASSERT(0, "%s NOT IMPLEMENTED", __FUNCTION__);
+        return this->tmpVertex.attrib[0];
+    }
+
+    bool Assemble(uint32_t slot, simdvector result[])
+    {
+        if (!HasWork())
+        {
+            return false;
+        }
+
+        // lanes past the last primitive gather stale slots, still inside the cache
+        for (uint32_t v = 0; v < this->numVertsPerPrim; ++v)
+        {
+            simdscalari offsets = _simd_add_epi32(this->vOffsets[v], _simd_set1_epi32(slot * sizeof(simdvector)));
+
+            float* pBase = (float*)this->pStreamBase;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                result[v].v[c] = _simd_i32gather_ps(pBase, offsets, 1);
+
+                // move base to next component
+                pBase += KNOB_SIMD_WIDTH;
+            }
+        }
+
+        return true;
+    }
+
+    void AssembleSingle(uint32_t slot, uint32_t primIndex, __m128 verts[])
+    {
+        for (uint32_t v = 0; v < this->numVertsPerPrim; ++v)
+        {
+            uint32_t offset = ((uint32_t*)&this->vOffsets[v])[primIndex];
+            offset += sizeof(simdvector) * slot;
+            float* pVert = (float*)&verts[v];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                pVert[c] = *(float*)(this->pStreamBase + offset);
+                offset += KNOB_SIMD_WIDTH * sizeof(float);
+            }
+        }
+    }
+
+    bool NextPrim()
+    {
+        this->curPrim += KNOB_SIMD_WIDTH;
+        this->vPrimId = _simd_add_epi32(this->vPrimId, _simd_set1_epi32(KNOB_SIMD_WIDTH));
+        if (!HasWork())
+        {
+            return false;
+        }
+        ComputeOffsets();
+        return true;
+    }
+
+    simdvertex& GetNextVsOutput()
+    {
+        SWR_ASSERT(0, "%s", __FUNCTION__);
+        return this->tmpVertex;
+    }
+
+    bool GetNextStreamOutput()
+    {
+        SWR_ASSERT(0, "%s", __FUNCTION__);
+        return false;
+    }
+
+    simdmask& GetNextVsIndices()
+    {
+        SWR_ASSERT(0, "%s", __FUNCTION__);
+        return this->tmpIndices;
+    }
+
+    uint32_t NumPrims()
+    {
+        return std::min<uint32_t>(this->numPrims - this->curPrim, KNOB_SIMD_WIDTH);
+    }
+
+    void Reset()
+    {
+        this->numPrims = this->curPrim = this->primIdBase = 0;
+        this->vPrimId = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    }
+
+    simdscalari GetPrimID(uint32_t startID)
+    {
+        return _simd_add_epi32(_simd_set1_epi32(startID), this->vPrimId);
+    }
+};
+
 // Primitive Assembly for data output from the DomainShader.
 struct PA_TESS : PA_STATE
 {
@@ -40,9 +40,9 @@
 
 void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t x, uint32_t y, RenderOutputBuffers &renderBuffers, 
     uint32_t numSamples, uint32_t renderTargetArrayIndex);
-void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, uint32_t colorTileStep, uint32_t depthTileStep, uint32_t stencilTileStep);
+void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, const uint32_t (&colorTileStep)[SWR_NUM_RENDERTARGETS], uint32_t depthTileStep, uint32_t stencilTileStep);
 void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, 
-                     uint32_t colorRowStep, uint32_t depthRowStep, uint32_t stencilRowStep);
+                     const uint32_t (&colorRowStep)[SWR_NUM_RENDERTARGETS], uint32_t depthRowStep, uint32_t stencilRowStep);
 
 #define MASKTOVEC(i3,i2,i1,i0) {-i0,-i1,-i2,-i3}
 const __m128 gMaskToVec[] = {
@@ -92,6 +92,7 @@ struct POS
 struct EDGE
 {
     double a, b;                // a, b edge coefficients in fix8
+    int32_t ai, bi;             // a, b for the 32 bit path, see rasterizePartialTileInt
     double stepQuadX;           // step to adjacent horizontal quad in fix16
     double stepQuadY;           // step to adjacent vertical quad in fix16
     double stepRasterTileX;     // step to adjacent horizontal raster tile in fix16
@@ -107,6 +108,99 @@ struct EDGE
 /// @param vA, vB - A & B coefs for each edge of the triangle (Ax + Bx + C)
 /// @param vStepQuad0-2 - edge equations evaluated at the UL corners of the 2x2 pixel quad.
 ///        Used to step between quads when sweeping over the raster tile.
+#if ENABLE_AVX512_SIMD16 && KNOB_TILE_X_DIM == 8 && KNOB_TILE_Y_DIM == 8
+template<uint32_t NumEdges>
+INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdges], EDGE *pRastEdges)
+{
+    uint64_t coverageMask = 0;
+
+    // evaluate 2 horizontally adjacent quads at a time, lanes 0-3 are the
+    // left quad and lanes 4-7 the right quad
+    __m512d vEdges[NumEdges];
+    __m512d vStepX[NumEdges];
+    __m512d vStepY[NumEdges];
+
+    for (uint32_t e = 0; e < NumEdges; ++e)
+    {
+        __m256d vNextQuadOffsets = _mm256_add_pd(pRastEdges[e].vQuadOffsets, _mm256_set1_pd(pRastEdges[e].stepQuadX));
+        __m512d vQuadOffsets = _mm512_insertf64x4(_mm512_castpd256_pd512(pRastEdges[e].vQuadOffsets), vNextQuadOffsets, 1);
+
+        // Step to the pixel sample locations of the 1st quad pair
+        vEdges[e] = _mm512_add_pd(_mm512_set1_pd(startEdges[e]), vQuadOffsets);
+
+        // compute step to next quad pair (mul by 4 in x, 2 in y direction)
+        vStepX[e] = _mm512_set1_pd(2 * pRastEdges[e].stepQuadX);
+        vStepY[e] = _mm512_set1_pd(pRastEdges[e].stepQuadY);
+    }
+
+    int edgeMask[NumEdges];
+    uint64_t mask;
+
+    auto eval_lambda = [&](int e){edgeMask[e] = _mm512_movepi64_mask(_mm512_castpd_si512(vEdges[e]));};
+    auto update_lambda = [&](int e){mask &= edgeMask[e];};
+    auto incx_lambda = [&](int e){vEdges[e] = _mm512_add_pd(vEdges[e], vStepX[e]);};
+    auto incy_lambda = [&](int e){vEdges[e] = _mm512_add_pd(vEdges[e], vStepY[e]);};
+    auto decx_lambda = [&](int e){vEdges[e] = _mm512_sub_pd(vEdges[e], vStepX[e]);};
+
+#define EVAL \
+            UnrollerL<0, NumEdges, 1>::step(eval_lambda);
+
+#define UPDATE_MASK(bit) \
+            mask = edgeMask[0]; \
+            UnrollerL<1, NumEdges, 1>::step(update_lambda); \
+            coverageMask |= (mask << bit);
+
+#define INCX \
+            UnrollerL<0, NumEdges, 1>::step(incx_lambda);
+
+#define INCY \
+            UnrollerL<0, NumEdges, 1>::step(incy_lambda);
+
+#define DECX \
+            UnrollerL<0, NumEdges, 1>::step(decx_lambda);
+
+    // same serpentine sweep as the 4 wide version, 2 quads per step
+
+    // row 0
+    EVAL;
+    UPDATE_MASK(0);
+    INCX;
+    EVAL;
+    UPDATE_MASK(8);
+    INCY;
+
+    // row 1
+    EVAL;
+    UPDATE_MASK(24);
+    DECX;
+    EVAL;
+    UPDATE_MASK(16);
+    INCY;
+
+    // row 2
+    EVAL;
+    UPDATE_MASK(32);
+    INCX;
+    EVAL;
+    UPDATE_MASK(40);
+    INCY;
+
+    // row 3
+    EVAL;
+    UPDATE_MASK(56);
+    DECX;
+    EVAL;
+    UPDATE_MASK(48);
+
+#undef EVAL
+#undef UPDATE_MASK
+#undef INCX
+#undef INCY
+#undef DECX
+
+    return coverageMask;
+}
+#else
 template<uint32_t NumEdges>
 INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdges], EDGE *pRastEdges)
 {
@@ -267,6 +361,110 @@ INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdg
     return coverageMask;
 
 }
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief 32 bit fixed point version of rasterizePartialTile, for triangles
+///        whose edge equations fit in 32 bits over the raster tiles they
+///        touch, see RasterizeTriangle. Evaluates twice as many samples per
+///        instruction as the double version.
+/// @param startEdges - edge equations evaluated at the UL sample of the raster tile
+#if ENABLE_AVX512_SIMD16 && KNOB_TILE_X_DIM == 8 && KNOB_TILE_Y_DIM == 8
+template<uint32_t NumEdges>
+INLINE uint64_t rasterizePartialTileInt(DRAW_CONTEXT *pDC, const int32_t startEdges[NumEdges], const EDGE *pRastEdges)
+{
+    uint64_t coverageMask = 0;
+
+    // evaluate a row of 4 quads at a time
+    simd16scalari vEdges[NumEdges];
+    simd16scalari vStepY[NumEdges];
+
+    // offsets of the samples from the UL sample, in pixels
+    const simd16scalari vOffsetsX = _mm512_set_epi32(7, 6, 7, 6, 5, 4, 5, 4, 3, 2, 3, 2, 1, 0, 1, 0);
+    const simd16scalari vOffsetsY = _mm512_set_epi32(1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0);
+
+    // unrolled so the edges stay in registers
+    auto setup_lambda = [&](int e)
+    {
+        const simd16scalari vA = _simd16_set1_epi32(pRastEdges[e].ai * FIXED_POINT_SCALE);
+        const simd16scalari vB = _simd16_set1_epi32(pRastEdges[e].bi * FIXED_POINT_SCALE);
+        const simd16scalari vQuadOffsets = _simd16_add_epi32(_simd16_mullo_epi32(vA, vOffsetsX), _simd16_mullo_epi32(vB, vOffsetsY));
+
+        vEdges[e] = _simd16_add_epi32(_simd16_set1_epi32(startEdges[e]), vQuadOffsets);
+        vStepY[e] = _simd16_add_epi32(vB, vB);
+    };
+    UnrollerL<0, NumEdges, 1>::step(setup_lambda);
+
+    auto row_lambda = [&](int y)
+    {
+        // samples with all edges negative are covered
+        simd16mask mask = 0xffff;
+        auto eval_lambda = [&](int e)
+        {
+            mask &= _simd16_cmpgt_epi32_mask(_simd16_setzero_si(), vEdges[e]);
+            vEdges[e] = _simd16_add_epi32(vEdges[e], vStepY[e]);
+        };
+        UnrollerL<0, NumEdges, 1>::step(eval_lambda);
+        coverageMask |= (uint64_t)mask << (y * 16);
+    };
+    UnrollerL<0, KNOB_TILE_Y_DIM / 2, 1>::step(row_lambda);
+
+    return coverageMask;
+}
+#else
+template<uint32_t NumEdges>
+INLINE uint64_t rasterizePartialTileInt(DRAW_CONTEXT *pDC, const int32_t startEdges[NumEdges], const EDGE *pRastEdges)
+{
+    uint64_t coverageMask = 0;
+
+    // evaluate 2 horizontally adjacent quads at a time, lanes 0-3 are the
+    // left quad and lanes 4-7 the right quad. Each pair of quads of a row
+    // steps down the tile on its own, so rows need no restart.
+    static const int numQuadPairsX = KNOB_TILE_X_DIM / 4;
+    simdscalari vEdges[NumEdges][numQuadPairsX];
+    simdscalari vStepY[NumEdges];
+
+    // offsets of the samples from the UL sample, in pixels
+    const simdscalari vOffsetsX = _mm256_set_epi32(3, 2, 3, 2, 1, 0, 1, 0);
+    const simdscalari vOffsetsY = _mm256_set_epi32(1, 1, 0, 0, 1, 1, 0, 0);
+
+    // unrolled so the edges stay in registers
+    auto setup_lambda = [&](int e)
+    {
+        const simdscalari vA = _simd_set1_epi32(pRastEdges[e].ai * FIXED_POINT_SCALE);
+        const simdscalari vB = _simd_set1_epi32(pRastEdges[e].bi * FIXED_POINT_SCALE);
+        const simdscalari vQuadOffsets = _simd_add_epi32(_simd_mullo_epi32(vA, vOffsetsX), _simd_mullo_epi32(vB, vOffsetsY));
+        const simdscalari vStepX = _simd_slli_epi32(vA, 2);
+
+        vEdges[e][0] = _simd_add_epi32(_simd_set1_epi32(startEdges[e]), vQuadOffsets);
+        auto incx_lambda = [&](int x){vEdges[e][x] = _simd_add_epi32(vEdges[e][x - 1], vStepX);};
+        UnrollerL<1, numQuadPairsX, 1>::step(incx_lambda);
+        vStepY[e] = _simd_add_epi32(vB, vB);
+    };
+    UnrollerL<0, NumEdges, 1>::step(setup_lambda);
+
+    auto row_lambda = [&](int y)
+    {
+        auto quadPair_lambda = [&](int x)
+        {
+            // samples with all edges negative are covered
+            simdscalari vMask = vEdges[0][x];
+            auto and_lambda = [&](int e){vMask = _simd_and_si(vMask, vEdges[e][x]);};
+            UnrollerL<1, NumEdges, 1>::step(and_lambda);
+            coverageMask |= (uint64_t)_simd_movemask_ps(_simd_castsi_ps(vMask)) << ((y * numQuadPairsX + x) * 8);
+
+            // step to the next row
+            auto incy_lambda = [&](int e){vEdges[e][x] = _simd_add_epi32(vEdges[e][x], vStepY[e]);};
+            UnrollerL<0, NumEdges, 1>::step(incy_lambda);
+        };
+        UnrollerL<0, numQuadPairsX, 1>::step(quadPair_lambda);
+    };
+    UnrollerL<0, KNOB_TILE_Y_DIM / 2, 1>::step(row_lambda);
+
+    return coverageMask;
+}
+#endif
+
 // Top left rule:
 // Top: if an edge is horizontal, and it is above other edges in tri pixel space, it is a 'top' edge
 // Left: if an edge is not horizontal, and it is on the left side of the triangle in pixel space, it is a 'left' edge
@@ -390,6 +588,8 @@ void ComputeEdgeData(int32_t a, int32_t b, EDGE& edge)
 {
     edge.a = a;
     edge.b = b;
+    edge.ai = a;
+    edge.bi = b;
 
     // compute constant steps to adjacent quads
     edge.stepQuadX = (double)((int64_t)a * (int64_t)(2 * FIXED_POINT_SCALE));
@@ -416,10 +616,17 @@ void ComputeEdgeData(int32_t a, int32_t b, EDGE& edge)
     edge.vRasterTileOffsets = _mm256_add_pd(vTileStepXFix16, vTileStepYFix16);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Edge data for an axis aligned edge, i.e. a scissor edge. Only the
+///        sign of an edge equation matters, so it is normalized to unit
+///        coefficients to keep it in range of the 32 bit path.
 INLINE
 void ComputeEdgeData(const POS& p0, const POS& p1, EDGE& edge)
 {
-    ComputeEdgeData(p0.y - p1.y, p1.x - p0.x, edge);
+    SWR_ASSERT(p0.x == p1.x || p0.y == p1.y);
+    int32_t a = p0.y - p1.y;
+    int32_t b = p1.x - p0.x;
+    ComputeEdgeData((a > 0) - (a < 0), (b > 0) - (b < 0), edge);
 }
 
 template<bool RasterizeScissorEdges, SWR_MULTISAMPLE_COUNT sampleCount>
@@ -436,7 +643,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 
     RDTSC_START(BETriangleSetup);
     const API_STATE &state = GetApiState(pDC);
-    const SWR_RASTSTATE &rastState = state.rastState;
+    const SWR_RASTSTATE &rastState = state.pRaster->rastState;
     const BACKEND_FUNCS& backendFuncs = pDC->pState->backendFuncs;
 
     OSALIGN(SWR_TRIANGLE_DESC, 16) triDesc;
@@ -578,6 +785,16 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     OSALIGN(BBOX, 16) bbox;
     calcBoundingBoxInt(vXi, vYi, bbox);
 
+    // Triangles no larger than a macrotile have |a|, |b| <= 2^14 and the samples of the raster
+    // tiles they touch lie within 2^15 of their vertices, so their edge equations fit in 32 bits.
+    // Scissor edges have unit coefficients and fit as well. The 32 bit path is about twice as
+    // fast on AVX2 and AVX512, but AVX lacks 256 bit integer ops and the double path is faster
+    // there, see swr_test_raster.
+    static_assert(KNOB_MACROTILE_X_DIM_FIXED <= (1 << 14) && KNOB_MACROTILE_Y_DIM_FIXED <= (1 << 14), "Macrotile too large for 32 bit edge equations");
+    const bool useIntEdges = (KNOB_ARCH >= KNOB_ARCH_AVX2) &&
+                             ((bbox.right - bbox.left) <= KNOB_MACROTILE_X_DIM_FIXED) &&
+                             ((bbox.bottom - bbox.top) <= KNOB_MACROTILE_Y_DIM_FIXED);
+
     // Intersect with scissor/viewport
     bbox.left = std::max(bbox.left, state.scissorInFixedPoint.left);
     bbox.right = std::min(bbox.right - 1, state.scissorInFixedPoint.right);
@@ -732,8 +949,14 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     uint32_t maxX = maxTileX;
 
     // compute steps between raster tiles for render output buffers
-    static const uint32_t colorRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
-    static const uint32_t colorRasterTileRowStep{(KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * colorRasterTileStep};
+    // color hottiles may be kept in the render target format
+    uint32_t colorRasterTileStep[SWR_NUM_RENDERTARGETS];
+    uint32_t colorRasterTileRowStep[SWR_NUM_RENDERTARGETS];
+    for (uint32_t rt = 0; rt < state.pShaders->psState.numRenderTargets; ++rt)
+    {
+        colorRasterTileStep[rt] = (KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * GetFormatInfo(state.colorHotTileFormat[rt]).Bpp) * MultisampleTraits<sampleCount>::numSamples;
+        colorRasterTileRowStep[rt] = (KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * colorRasterTileStep[rt];
+    }
     static const uint32_t depthRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
     static const uint32_t depthRasterTileRowStep{(KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM)* depthRasterTileStep};
     static const uint32_t stencilRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_STENCIL_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
@@ -744,6 +967,30 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
         triDesc.triFlags.renderTargetArrayIndex);
     currentRenderBufferRow = renderBuffers;
 
+    // drop the triangle, or the raster tiles where it is behind the coarse depth; it is
+    // exact for the hottile here, unlike in the binner
+    SWR_CONTEXT *pContext = pDC->pContext;
+    const HIZ_TILE* pHiZ = renderBuffers.pHiZ;
+    const bool hiZTest = (pHiZ != nullptr) && CanHiZReject(state);
+    const bool hiZUpdate = (pHiZ != nullptr) && state.pRaster->depthStencilState.depthWriteEnable && HiZTracksDepthWrites(state);
+    const SWR_ZFUNCTION depthTestFunc = (SWR_ZFUNCTION)state.pRaster->depthStencilState.depthTestFunc;
+    float triMinZ = 0.0f;
+    if (hiZTest)
+    {
+        // z is interpolated between the vertices, then clamped like DepthStencilTest does
+        triMinZ = std::min(std::min(a[0], a[1]), a[2]) + (triDesc.Z[2] - a[2]);
+        triMinZ = std::min(state.pViewport->vp[0].maxZ, std::max(state.pViewport->vp[0].minZ, triMinZ));
+
+        if (HiZOccluded(depthTestFunc, triMinZ, pHiZ->macroMaxZ))
+        {
+            UPDATE_STAT(HiZTrisTossedBE, 1);
+            RDTSC_STOP(BERasterizeTriangle, 1, 0);
+            return;
+        }
+    }
+    uint32_t macroTileX = macroX * KNOB_MACROTILE_X_DIM_IN_TILES;
+    uint32_t macroTileY = macroY * KNOB_MACROTILE_Y_DIM_IN_TILES;
+
     // rasterize and generate coverage masks per sample
     uint32_t maxSamples = MultisampleTraits<sampleCount>::numSamples;
     for (uint32_t tileY = tY; tileY <= maxY; ++tileY)
@@ -778,6 +1025,13 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                 mask2 = _mm256_movemask_pd(vSampleBboxTest2);
             }
 
+            if (hiZTest && HiZOccluded(depthTestFunc, triMinZ, pHiZ->maxZ[tileY - macroTileY][tileX - macroTileX]))
+            {
+                // trivially reject all samples
+                mask0 = mask1 = mask2 = 0;
+                UPDATE_STAT(HiZRasterTilesTossed, 1);
+            }
+
             for (uint32_t sampleNum = 0; sampleNum < maxSamples; sampleNum++)
             {
                 // trivial reject, at least one edge has all 4 corners of raster tile outside
@@ -844,7 +1098,17 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 
                         // not trivial accept or reject, must rasterize full tile
                         RDTSC_START(BERasterizePartial);
-                        if (RasterizeScissorEdges)
+                        if (useIntEdges)
+                        {
+                            // edge equations are integers, exactly representable either way
+                            int32_t startQuadEdgesInt[numEdges];
+                            for (uint32_t e = 0; e < numEdges; ++e)
+                            {
+                                startQuadEdgesInt[e] = (int32_t)startQuadEdges[e];
+                            }
+                            triDesc.coverageMask[sampleNum] = rasterizePartialTileInt<numEdges>(pDC, startQuadEdgesInt, rastEdges);
+                        }
+                        else if (RasterizeScissorEdges)
                         {
                             triDesc.coverageMask[sampleNum] = rasterizePartialTile<7>(pDC, startQuadEdges, rastEdges);
                         }
@@ -880,6 +1144,11 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                 RDTSC_START(BEPixelBackend);
                 backendFuncs.pfnBackend(pDC, workerId, tileX << KNOB_TILE_X_DIM_SHIFT, tileY << KNOB_TILE_Y_DIM_SHIFT, triDesc, renderBuffers);
                 RDTSC_STOP(BEPixelBackend, 0, 0);
+
+                if (hiZUpdate)
+                {
+                    HotTileMgr::UpdateHiZRasterTile(renderBuffers.pHiZ, tileX - macroTileX, tileY - macroTileY, renderBuffers.pDepth, maxSamples);
+                }
             }
 
             // step to the next tile in X
@@ -887,7 +1156,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
             {
                 vEdgeFix16[e] = _mm256_add_pd(vEdgeFix16[e], _mm256_set1_pd(rastEdges[e].stepRasterTileX));
             }
-            StepRasterTileX(state.psState.numRenderTargets, renderBuffers, colorRasterTileStep, depthRasterTileStep, stencilRasterTileStep);
+            StepRasterTileX(state.pShaders->psState.numRenderTargets, renderBuffers, colorRasterTileStep, depthRasterTileStep, stencilRasterTileStep);
         }
 
         // step to the next tile in Y
@@ -895,7 +1164,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
         {
             vEdgeFix16[e] = _mm256_add_pd(vStartOfRowEdge[e], _mm256_set1_pd(rastEdges[e].stepRasterTileY));
         }
-        StepRasterTileY(state.psState.numRenderTargets, renderBuffers, currentRenderBufferRow, colorRasterTileRowStep, depthRasterTileRowStep, stencilRasterTileRowStep);
+        StepRasterTileY(state.pShaders->psState.numRenderTargets, renderBuffers, currentRenderBufferRow, colorRasterTileRowStep, depthRasterTileRowStep, stencilRasterTileRowStep);
     }
 
     RDTSC_STOP(BERasterizeTriangle, 1, 0);
@@ -904,8 +1173,8 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 void RasterizeTriPoint(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void* pData)
 {
     const TRIANGLE_WORK_DESC& workDesc = *(const TRIANGLE_WORK_DESC*)pData;
-    const SWR_RASTSTATE& rastState = pDC->pState->state.rastState;
-    const SWR_BACKEND_STATE& backendState = pDC->pState->state.backendState;
+    const SWR_RASTSTATE& rastState = pDC->pState->state.pRaster->rastState;
+    const SWR_BACKEND_STATE& backendState = pDC->pState->state.pRaster->backendState;
 
     bool isPointSpriteTexCoordEnabled = backendState.pointSpriteTexCoordMask != 0;
 
@@ -1096,6 +1365,17 @@ void RasterizeSimplePoint(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTi
     RDTSC_START(BEPixelBackend);
     backendFuncs.pfnBackend(pDC, workerId, tileAlignedX, tileAlignedY, triDesc, renderBuffers);
     RDTSC_STOP(BEPixelBackend, 0, 0);
+
+    const API_STATE& state = GetApiState(pDC);
+    if (renderBuffers.pHiZ != nullptr && state.pRaster->depthStencilState.depthWriteEnable && HiZTracksDepthWrites(state))
+    {
+        uint32_t macroX, macroY;
+        MacroTileMgr::getTileIndices(macroTile, macroX, macroY);
+        HotTileMgr::UpdateHiZRasterTile(renderBuffers.pHiZ,
+            (tileAlignedX >> KNOB_TILE_X_DIM_SHIFT) - macroX * KNOB_MACROTILE_X_DIM_IN_TILES,
+            (tileAlignedY >> KNOB_TILE_Y_DIM_SHIFT) - macroY * KNOB_MACROTILE_Y_DIM_IN_TILES,
+            renderBuffers.pDepth, 1);
+    }
 }
 
 // Get pointers to hot tile memory for color RT, depth, stencil
@@ -1110,9 +1390,10 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
     tileX -= KNOB_MACROTILE_X_DIM_IN_TILES * mx;
     tileY -= KNOB_MACROTILE_Y_DIM_IN_TILES * my;
 
-    // compute tile offset for active hottile buffers
-    const uint32_t pitch = KNOB_MACROTILE_X_DIM * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8;
-    uint32_t offset = ComputeTileOffset2D<TilingTraits<SWR_TILE_SWRZ, FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp> >(pitch, tileX, tileY);
+    // compute tile offset for active hottile buffers; SWRZ layout is linear in bytes per pixel
+    // so the 8bpp offset is scaled by the hottile format of each RT
+    const uint32_t pitch = KNOB_MACROTILE_X_DIM;
+    uint32_t offset = ComputeTileOffset2D<TilingTraits<SWR_TILE_SWRZ, 8> >(pitch, tileX, tileY);
     offset*=numSamples;
 
     unsigned long rtSlot = 0;
@@ -1122,7 +1403,7 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
         HOTTILE *pColor = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rtSlot), true, 
             numSamples, renderTargetArrayIndex);
         pColor->state = HOTTILE_DIRTY;
-        renderBuffers.pColor[rtSlot] = pColor->pBuffer + offset;
+        renderBuffers.pColor[rtSlot] = pColor->pBuffer + offset * GetFormatInfo(pColor->format).Bpp;
         
         colorHottileEnableMask &= ~(1 << rtSlot);
     }
@@ -1136,6 +1417,11 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
         pDepth->state = HOTTILE_DIRTY;
         SWR_ASSERT(pDepth->pBuffer != nullptr);
         renderBuffers.pDepth = pDepth->pBuffer + offset;
+        renderBuffers.pHiZ = pDepth->pHiZ;
+    }
+    else
+    {
+        renderBuffers.pHiZ = nullptr;
     }
     if(state.stencilHottileEnable)
     {
@@ -1151,11 +1437,11 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
 }
 
 INLINE
-void StepRasterTileX(uint32_t NumRT, RenderOutputBuffers &buffers, uint32_t colorTileStep, uint32_t depthTileStep, uint32_t stencilTileStep)
+void StepRasterTileX(uint32_t NumRT, RenderOutputBuffers &buffers, const uint32_t (&colorTileStep)[SWR_NUM_RENDERTARGETS], uint32_t depthTileStep, uint32_t stencilTileStep)
 {
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
-        buffers.pColor[rt] += colorTileStep;
+        buffers.pColor[rt] += colorTileStep[rt];
     }
     
     buffers.pDepth += depthTileStep;
@@ -1163,11 +1449,11 @@ void StepRasterTileX(uint32_t NumRT, RenderOutputBuffers &buffers, uint32_t colo
 }
 
 INLINE
-void StepRasterTileY(uint32_t NumRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, uint32_t colorRowStep, uint32_t depthRowStep, uint32_t stencilRowStep)
+void StepRasterTileY(uint32_t NumRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, const uint32_t (&colorRowStep)[SWR_NUM_RENDERTARGETS], uint32_t depthRowStep, uint32_t stencilRowStep)
 {
     for(uint32_t rt = 0; rt < NumRT; ++rt)
     {
-        startBufferRow.pColor[rt] += colorRowStep;
+        startBufferRow.pColor[rt] += colorRowStep[rt];
         buffers.pColor[rt] = startBufferRow.pColor[rt];
     }
     startBufferRow.pDepth += depthRowStep;
@@ -1206,7 +1492,7 @@ void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, voi
     RDTSC_START(BERasterizeLine);
 
     const API_STATE &state = GetApiState(pDC);
-    const SWR_RASTSTATE &rastState = state.rastState;
+    const SWR_RASTSTATE &rastState = state.pRaster->rastState;
 
     // macrotile dimensioning
     uint32_t macroX, macroY;
@@ -1242,7 +1528,7 @@ void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, voi
     __m128 vZa = _mm_shuffle_ps(vZ, vZ, _MM_SHUFFLE(1, 1, 0, 0));
     __m128 vRecipWa = _mm_shuffle_ps(vRecipW, vRecipW, _MM_SHUFFLE(1, 1, 0, 0));
 
-    __m128 vLineWidth = _mm_set1_ps(pDC->pState->state.rastState.lineWidth);
+    __m128 vLineWidth = _mm_set1_ps(pDC->pState->state.pRaster->rastState.lineWidth);
     __m128 vAdjust = _mm_mul_ps(vLineWidth, vBloat0);
     if (workDesc.triFlags.yMajor)
     {
@@ -1273,7 +1559,7 @@ void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, voi
 
     // Store user clip distances for triangle 0
     float newClipBuffer[3 * 8];
-    uint32_t numClipDist = _mm_popcnt_u32(state.rastState.clipDistanceMask);
+    uint32_t numClipDist = _mm_popcnt_u32(state.pRaster->rastState.clipDistanceMask);
     if (numClipDist)
     {
         newWorkDesc.pUserClipBuffer = newClipBuffer;
@@ -82,6 +82,10 @@ BUCKET_DESC gCoreBuckets[] = {
     { "BEStoreTiles", "", true, 0xff00cccc },
     { "BEEndTile", "", false, 0xffffffff },
     { "WorkerWaitForThreadEvent", "", false, 0xffffffff },
+    { "JITCompileFetch", "", true, 0xffcc6600 },
+    { "JITCompileBlend", "", true, 0xffcc6600 },
+    { "JITCompileStreamout", "", true, 0xffcc6600 },
+    { "JITCompileShader", "", true, 0xffcc6600 },
 };
 
 /// @todo bucketmanager and mapping should probably be a part of the SWR context
@@ -87,32 +87,32 @@ enum CORE_BUCKETS
     BEStoreTiles,
     BEEndTile,
     WorkerWaitForThreadEvent,
+    JITCompileFetch,
+    JITCompileBlend,
+    JITCompileStreamout,
+    JITCompileShader,
 
     NumBuckets
 };
 
 void rdtscReset();
 void rdtscInit(int threadId);
+void rdtscInitThread(const char* name);
 void rdtscStart(uint32_t bucketId);
 void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId);
 void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2);
 void rdtscEndFrame();
 
-#ifdef KNOB_ENABLE_RDTSC
+// Buckets are always compiled in and only collected between
+// KNOB_BUCKETS_START_FRAME and KNOB_BUCKETS_END_FRAME when KNOB_ENABLE_BUCKETS
+// is set.  Outside of that a bucket costs a load and a branch.
 #define RDTSC_RESET() rdtscReset()
 #define RDTSC_INIT(threadId) rdtscInit(threadId)
-#define RDTSC_START(bucket) rdtscStart(bucket)
-#define RDTSC_STOP(bucket, count, draw) rdtscStop(bucket, count, draw)
-#define RDTSC_EVENT(bucket, count1, count2) rdtscEvent(bucket, count1, count2)
+#define RDTSC_INIT_THREAD(name) rdtscInitThread(name)
+#define RDTSC_START(bucket) do { if (gBucketMgr.IsCapturing()) rdtscStart(bucket); } while (0)
+#define RDTSC_STOP(bucket, count, draw) do { if (gBucketMgr.IsActive()) rdtscStop(bucket, count, draw); } while (0)
+#define RDTSC_EVENT(bucket, count1, count2) do { if (gBucketMgr.IsCapturing()) rdtscEvent(bucket, count1, count2); } while (0)
 #define RDTSC_ENDFRAME() rdtscEndFrame()
-#else
-#define RDTSC_RESET()
-#define RDTSC_INIT(threadId)
-#define RDTSC_START(bucket)
-#define RDTSC_STOP(bucket, count, draw)
-#define RDTSC_EVENT(bucket, count1, count2)
-#define RDTSC_ENDFRAME()
-#endif
 
 extern std::vector<uint32_t> gBucketMap;
 extern BucketManager gBucketMgr;
@@ -122,14 +122,13 @@ extern uint32_t gCurrentFrame;
 INLINE void rdtscReset()
 {
     gCurrentFrame = 0;
-    gBucketMgr.ClearThreads();
-    gBucketMgr.ClearBuckets();
 }
 
 INLINE void rdtscInit(int threadId)
 {
-    // register all the buckets once
-    if (threadId == 0)
+    // register all the buckets once, threads of earlier contexts keep
+    // their ids in the manager
+    if (threadId == 0 && gBucketMap.empty())
     {
         gBucketMap.resize(NumBuckets);
         for (uint32_t i = 0; i < NumBuckets; ++i)
@@ -138,8 +137,16 @@ INLINE void rdtscInit(int threadId)
         }
     }
 
-    std::string name = threadId == 0 ? "API" : "WORKER";
-    gBucketMgr.RegisterThread(name);
+    rdtscInitThread(threadId == 0 ? "API" : "WORKER");
+}
+
+INLINE void rdtscInitThread(const char* name)
+{
+    // threads are registered once, the API thread may create many contexts
+    if (tlsBucketThread == nullptr)
+    {
+        gBucketMgr.RegisterThread(name);
+    }
 }
 
 INLINE void rdtscStart(uint32_t bucketId)
@@ -151,7 +158,7 @@ INLINE void rdtscStart(uint32_t bucketId)
 INLINE void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId)
 {
     uint32_t id = gBucketMap[bucketId];
-    gBucketMgr.StopBucket(id);
+    gBucketMgr.StopBucket(id, drawId);
 }
 
 INLINE void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2)
@@ -164,14 +171,23 @@ INLINE void rdtscEndFrame()
 {
     gCurrentFrame++;
 
+    if (!KNOB_ENABLE_BUCKETS)
+    {
+        return;
+    }
+
     if (gCurrentFrame == KNOB_BUCKETS_START_FRAME)
     {
-        gBucketMgr.StartCapture();
+        gBucketMgr.StartCapture(KNOB_BUCKETS_CHROME_TRACE);
     }
 
     if (gCurrentFrame == KNOB_BUCKETS_END_FRAME)
     {
         gBucketMgr.StopCapture();
         gBucketMgr.PrintReport("rdtsc.txt");
+        if (KNOB_BUCKETS_CHROME_TRACE)
+        {
+            gBucketMgr.PrintChromeTrace("rdtsc.json");
+        }
     }
 }
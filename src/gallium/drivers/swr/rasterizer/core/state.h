@@ -562,6 +562,7 @@ struct SWR_STATS
     uint64_t IaVertices;    // Number of Fetch Shader vertices
     uint64_t IaPrimitives;  // Number of PA primitives.
     uint64_t VsInvocations; // Number of Vertex Shader invocations
+    uint64_t VsInvocationsSaved; // Number of Vertex Shader invocations skipped by vertex reuse
     uint64_t HsInvocations; // Number of Hull Shader invocations
     uint64_t DsInvocations; // Number of Domain Shader invocations
     uint64_t GsInvocations; // Number of Geometry Shader invocations
@@ -571,6 +572,22 @@ struct SWR_STATS
     uint64_t CPrimitives;   // Number of clipper primitives.
     uint64_t GsPrimitives;  // Number of prims GS outputs.
 
+    // HiZ Stats
+    uint64_t HiZTrisTossedFE;       // Number of triangles dropped by the binner
+    uint64_t HiZTrisTossedBE;       // Number of triangles dropped from a macrotile by the rasterizer
+    uint64_t HiZRasterTilesTossed;  // Number of raster tiles skipped by the rasterizer
+
+    // Hot Tile Stats, state of the hot tile pool when the stats were taken
+    uint64_t HotTileBytes;          // Hot tile memory currently allocated
+    uint64_t HotTileBytesPeak;      // Most hot tile memory allocated at once
+    uint64_t HotTileEvictions;      // Number of hot tiles evicted to stay within KNOB_HOT_TILE_BUDGET_MB
+    uint64_t HotTileReuses;         // Number of evicted hot tile buffers reused by another hot tile
+    uint64_t HotTileLayerSwaps;     // Number of times a hot tile was switched to another array slice
+
+    // Arena Stats, over the last complete frame of all contexts, see SwrEndFrame
+    uint64_t ArenaBytesAllocated;   // Bytes allocated from draw and state arenas
+    uint64_t ArenaBlockMallocs;     // Number of arena blocks malloc'ed rather than reused
+
     // Streamout Stats
     uint32_t SoWriteOffset[4];
     uint64_t SoPrimStorageNeeded[4];
@@ -807,6 +824,11 @@ struct SWR_FRONTEND_STATE
         uint32_t bits;
     }provokingVertex;
     uint32_t topologyProvokingVertex; // provoking vertex for the draw topology
+
+    // primitive restart for indexed draws. The fetch shader compiles in its own
+    // copy, this one is read by the vertex reuse path which assembles on the CPU.
+    bool bEnableCutIndex;
+    uint32_t cutIndex;
 };
 
 //////////////////////////////////////////////////////////////////////////
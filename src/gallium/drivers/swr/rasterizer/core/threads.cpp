@@ -24,7 +24,6 @@
 #include <stdio.h>
 #include <thread>
 #include <algorithm>
-#include <unordered_set>
 #include <float.h>
 #include <vector>
 #include <utility>
@@ -44,6 +43,7 @@
 #include "rasterizer.h"
 #include "rdtsc_core.h"
 #include "tilemgr.h"
+#include "format_conversion.h"
 #include "core/multisample.h"
 
 
@@ -273,7 +273,7 @@ uint64_t GetEnqueuedDraw(SWR_CONTEXT *pContext)
 INLINE
 DRAW_CONTEXT *GetDC(SWR_CONTEXT *pContext, uint64_t drawId)
 {
-    return &pContext->dcRing[(drawId-1) % KNOB_MAX_DRAWS_IN_FLIGHT];
+    return &pContext->dcRing[(drawId-1) % pContext->maxDrawsInFlight];
 }
 
 // returns true if dependency not met
@@ -283,8 +283,75 @@ bool CheckDependency(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint64_t lastReti
     return (pDC->dependency > lastRetiredDraw);
 }
 
+// returns true if the FE of all draws queued before pDC is done
+INLINE
+bool CheckPriorFEDone(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
+{
+    uint32_t ringSize = pContext->maxDrawsInFlight;
+    uint32_t dcSlot = (uint32_t)(pDC - pContext->dcRing);
+    for (uint32_t i = 1; i < ringSize && i < pDC->drawId; ++i)
+    {
+        DRAW_CONTEXT *pPrevDC = &pContext->dcRing[(dcSlot + ringSize - i) % ringSize];
+
+        // Slot reused by a later draw or never used. Either way this draw and
+        // everything before it has retired, which the BE only allows once
+        // their FE is done.
+        if (pPrevDC->drawId != pDC->drawId - i)
+        {
+            break;
+        }
+
+        if (pPrevDC->isCompute ? !pPrevDC->doneCompute : !pPrevDC->doneFE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Clear a macro tile kept in the render target format from float4
+///        clear data.
+template<SWR_FORMAT format>
+void ClearColorHotTileNative(const HOTTILE* pHotTile)
+{
+    static const uint32_t numSimdPerBlock = (KNOB_SIMD_WIDTH * FormatTraits<format>::bpp / 8) / sizeof(simdscalar);
+    static_assert(numSimdPerBlock > 0, "Unsupported hot tile format");
+
+    // convert clear color to one SIMD tile in the hottile format
+    float *pClearData = (float*)(pHotTile->clearData);
+    simdvector vClear;
+    vClear.x = _simd_broadcast_ss(&pClearData[0]);
+    vClear.y = _simd_broadcast_ss(&pClearData[1]);
+    vClear.z = _simd_broadcast_ss(&pClearData[2]);
+    vClear.w = _simd_broadcast_ss(&pClearData[3]);
+
+    simdscalar vBlock[numSimdPerBlock];
+    StoreSOA<format>(vClear, (BYTE*)vBlock);
+
+    simdscalar *pBuf = (simdscalar*)pHotTile->pBuffer;
+    uint32_t numSimdTiles = (KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * pHotTile->numSamples) / KNOB_SIMD_WIDTH;
+
+    for (uint32_t si = 0; si < numSimdTiles; ++si)
+    {
+        for (uint32_t i = 0; i < numSimdPerBlock; ++i)
+        {
+            _simd_store_ps((float*)pBuf, vBlock[i]);
+            pBuf += 1;
+        }
+    }
+}
+
 void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
 {
+    switch (pHotTile->format)
+    {
+    case R8G8B8A8_UNORM: ClearColorHotTileNative<R8G8B8A8_UNORM>(pHotTile); return;
+    case B8G8R8A8_UNORM: ClearColorHotTileNative<B8G8R8A8_UNORM>(pHotTile); return;
+    case R16G16B16A16_FLOAT: ClearColorHotTileNative<R16G16B16A16_FLOAT>(pHotTile); return;
+    default: SWR_ASSERT(pHotTile->format == KNOB_COLOR_HOT_TILE_FORMAT, "Unsupported hot tile format"); break;
+    }
+
     // Load clear color into SIMD register...
     float *pClearData = (float*)(pHotTile->clearData);
     simdscalar valR = _simd_broadcast_ss(&pClearData[0]);
@@ -295,6 +362,20 @@ void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
     float *pfBuf = (float*)pHotTile->pBuffer;
     uint32_t numSamples = pHotTile->numSamples;
 
+#if ENABLE_AVX512_SIMD16
+    // each SOA simd tile is RRRRRRRR GGGGGGGG BBBBBBBB AAAAAAAA, i.e. 2 full simd16 stores
+    simd16scalar valRG = _simd16_combine_ps(valR, valG);
+    simd16scalar valBA = _simd16_combine_ps(valB, valA);
+    const uint32_t numSimdTiles = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * numSamples / (SIMD_TILE_X_DIM * SIMD_TILE_Y_DIM);
+
+    for (uint32_t si = 0; si < numSimdTiles; ++si)
+    {
+        _simd16_store_ps(pfBuf, valRG);
+        pfBuf += KNOB_SIMD16_WIDTH;
+        _simd16_store_ps(pfBuf, valBA);
+        pfBuf += KNOB_SIMD16_WIDTH;
+    }
+#else
     for (uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
     {
         for (uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
@@ -312,6 +393,7 @@ void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
             }
         }
     }
+#endif
 }
 
 void ClearDepthHotTile(const HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
@@ -323,6 +405,16 @@ void ClearDepthHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
     float *pfBuf = (float*)pHotTile->pBuffer;
     uint32_t numSamples = pHotTile->numSamples;
 
+#if ENABLE_AVX512_SIMD16
+    simd16scalar valZ16 = _simd16_combine_ps(valZ, valZ);
+    const uint32_t numPixels = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * numSamples;
+
+    for (uint32_t si = 0; si < numPixels; si += KNOB_SIMD16_WIDTH)
+    {
+        _simd16_store_ps(pfBuf, valZ16);
+        pfBuf += KNOB_SIMD16_WIDTH;
+    }
+#else
     for (uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
     {
         for (uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
@@ -334,6 +426,7 @@ void ClearDepthHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
             }
         }
     }
+#endif
 }
 
 void ClearStencilHotTile(const HOTTILE* pHotTile)
@@ -376,20 +469,21 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
     x *= KNOB_MACROTILE_X_DIM;
     y *= KNOB_MACROTILE_Y_DIM;
 
-    uint32_t numSamples = GetNumSamples(state.rastState.sampleCount);
+    uint32_t numSamples = GetNumSamples(state.pRaster->rastState.sampleCount);
+    uint32_t renderTargetArrayIndex = pWork->triFlags.renderTargetArrayIndex;
 
     // check RT if enabled
     unsigned long rtSlot = 0;
     uint32_t colorHottileEnableMask = state.colorHottileEnable;
     while(_BitScanForward(&rtSlot, colorHottileEnableMask))
     {
-        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rtSlot), true, numSamples);
+        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rtSlot), true, numSamples, renderTargetArrayIndex);
 
         if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_START(BELoadTiles);
             // invalid hottile before draw requires a load from surface before we can draw to it
-            pContext->pfnLoadTile(GetPrivateState(pDC), KNOB_COLOR_HOT_TILE_FORMAT, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rtSlot), x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+            pContext->pfnLoadTile(GetPrivateState(pDC), pHotTile->format, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rtSlot), x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
             pHotTile->state = HOTTILE_DIRTY;
             RDTSC_STOP(BELoadTiles, 0, 0);
         }
@@ -407,13 +501,14 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
     // check depth if enabled
     if (state.depthHottileEnable)
     {
-        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_DEPTH, true, numSamples);
+        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_DEPTH, true, numSamples, renderTargetArrayIndex);
         if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_START(BELoadTiles);
             // invalid hottile before draw requires a load from surface before we can draw to it
             pContext->pfnLoadTile(GetPrivateState(pDC), KNOB_DEPTH_HOT_TILE_FORMAT, SWR_ATTACHMENT_DEPTH, x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
             pHotTile->state = HOTTILE_DIRTY;
+            HotTileMgr::UpdateHiZ(*pHotTile, numSamples, pDC->hiZGeneration);
             RDTSC_STOP(BELoadTiles, 0, 0);
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
@@ -424,12 +519,23 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
             pHotTile->state = HOTTILE_DIRTY;
             RDTSC_STOP(BELoadTiles, 0, 0);
         }
+
+        if (state.pRaster->depthStencilState.depthWriteEnable && !HiZTracksDepthWrites(state))
+        {
+            // coarse depth won't follow the draw
+            HotTileMgr::ClearHiZ(*pHotTile, FLT_MAX, pDC->hiZGeneration);
+        }
+        else
+        {
+            // coarse depth is up to date with the hottile, let the binner use it
+            HotTileMgr::RefreshHiZ(*pHotTile, pDC->hiZGeneration);
+        }
     }
 
     // check stencil if enabled
     if (state.stencilHottileEnable)
     {
-        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_STENCIL, true, numSamples);
+        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_STENCIL, true, numSamples, renderTargetArrayIndex);
         if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_START(BELoadTiles);
@@ -455,10 +561,10 @@ INLINE bool FindFirstIncompleteDraw(SWR_CONTEXT* pContext, uint64_t& curDrawBE)
     uint64_t drawEnqueued = GetEnqueuedDraw(pContext);
     while (curDrawBE < drawEnqueued)
     {
-        DRAW_CONTEXT *pDC = &pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT];
+        DRAW_CONTEXT *pDC = &pContext->dcRing[curDrawBE % pContext->maxDrawsInFlight];
 
         // If its not compute and FE is not done then break out of loop.
-        if (!pDC->doneFE && !pDC->isCompute) break;
+        if (!pDC->isCompute && !IsFEDone(pDC)) break;
 
         bool isWorkComplete = (pDC->isCompute) ?
             pDC->pDispatch->isWorkComplete() : pDC->pTileMgr->isWorkComplete();
@@ -492,11 +598,14 @@ INLINE bool FindFirstIncompleteDraw(SWR_CONTEXT* pContext, uint64_t& curDrawBE)
 ///                      still have work pending in a previous draw. Additionally, the lockedTiles is
 ///                      hueristic that can steer a worker back to the same macrotile that it had been
 ///                      working on in a previous draw.
+/// @param numaNode - NUMA node of this worker. With KNOB_NUMA_TILE_AFFINITY only the macrotiles
+///                   owned by this node are worked on.
 void WorkOnFifoBE(
     SWR_CONTEXT *pContext,
     uint32_t workerId,
     uint64_t &curDrawBE,
-    std::unordered_set<uint32_t>& lockedTiles)
+    TileSet& lockedTiles,
+    uint32_t numaNode)
 {
     // Find the first incomplete draw that has pending work. If no such draw is found then
     // return. FindFirstIncompleteDraw is responsible for incrementing the curDrawBE.
@@ -505,7 +614,8 @@ void WorkOnFifoBE(
         return;
     }
 
-    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT].drawId - 1;
+    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % pContext->maxDrawsInFlight].drawId - 1;
+    uint32_t numNumaNodes = pContext->pThreadPool->numNumaNodes;
 
     // Reset our history for locked tiles. We'll have to re-learn which tiles are locked.
     lockedTiles.clear();
@@ -517,14 +627,18 @@ void WorkOnFifoBE(
     //      maintain order. The locked tiles provides the history to ensures this.
     for (uint64_t i = curDrawBE; i < GetEnqueuedDraw(pContext); ++i)
     {
-        DRAW_CONTEXT *pDC = &pContext->dcRing[i % KNOB_MAX_DRAWS_IN_FLIGHT];
+        DRAW_CONTEXT *pDC = &pContext->dcRing[i % pContext->maxDrawsInFlight];
 
         if (pDC->isCompute) return; // We don't look at compute work.
 
         // First wait for FE to be finished with this draw. This keeps threading model simple
         // but if there are lots of bubbles between draws then serializing FE and BE may
         // need to be revisited.
-        if (!pDC->doneFE) return;
+        // With KNOB_OVERLAP_FE_BE the oldest draw can be worked on while its FE is still
+        // binning. Later draws must still wait, since until the FE is done a drained tile
+        // can't be told apart from a completed one, which the locked tiles history relies on.
+        bool doneFE = IsFEDone(pDC);
+        if (!doneFE && !(KNOB_OVERLAP_FE_BE && i == curDrawBE)) return;
         
         // If this draw is dependent on a previous draw then we need to bail.
         if (CheckDependency(pContext, pDC, lastRetiredDraw))
@@ -532,69 +646,124 @@ void WorkOnFifoBE(
             return;
         }
 
-        // Grab the list of all dirty macrotiles. A tile is dirty if it has work queued to it.
-        std::vector<uint32_t> &macroTiles = pDC->pTileMgr->getDirtyTiles();
-
-        for (uint32_t tileID : macroTiles)
+        // Works on a dirty macrotile if it's available. Returns true once this worker
+        // has retired the draw.
+        auto workOnTile = [&](MacroTileQueue &tile) -> bool
         {
-            MacroTileQueue &tile = pDC->pTileMgr->getMacroTileQueue(tileID);
-            
+            uint32_t tileID = tile.mId;
+
+            // Tiles owned by another node are never worked on by this thread, so
+            // skipping them doesn't affect ordering.
+            if (numNumaNodes > 1 && MacroTileMgr::getTileNumaNode(tileID, numNumaNodes) != numaNode)
+            {
+                return false;
+            }
+
             // can only work on this draw if it's not in use by other threads
-            if (lockedTiles.find(tileID) == lockedTiles.end())
+            if (lockedTiles.contains(tileID) || !tile.getNumQueued())
             {
-                if (tile.getNumQueued())
+                return false;
+            }
+
+            if (!tile.tryLock())
+            {
+                // This tile is already locked. So let's add it to our locked tiles set. This way we don't try locking this one again.
+                lockedTiles.insert(tileID);
+                return false;
+            }
+
+            BE_WORK *pWork;
+
+            RDTSC_START(WorkerFoundWork);
+
+            uint32_t numWorkItems = 0;
+
+            // array slice the hottiles were last initialized for
+            uint32_t hotTileArrayIndex = UINT32_MAX;
+
+            while ((pWork = tile.peek()) != nullptr)
+            {
+                if (pWork->type == DRAW)
                 {
-                    if (tile.tryLock())
+                    // layered rendering may switch array slices between primitives
+                    const TRIANGLE_WORK_DESC* pTriWork = (const TRIANGLE_WORK_DESC*)&pWork->desc;
+                    if (pTriWork->triFlags.renderTargetArrayIndex != hotTileArrayIndex)
                     {
-                        BE_WORK *pWork;
-
-                        RDTSC_START(WorkerFoundWork);
-
-                        uint32_t numWorkItems = tile.getNumQueued();
-
-                        if (numWorkItems != 0)
-                        {
-                            pWork = tile.peek();
-                            SWR_ASSERT(pWork);
-                            if (pWork->type == DRAW)
-                            {
-                                InitializeHotTiles(pContext, pDC, tileID, (const TRIANGLE_WORK_DESC*)&pWork->desc);
-                            }
-                        }
-
-                        while ((pWork = tile.peek()) != nullptr)
-                        {
-                            pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
-                            tile.dequeue();
-                        }
-                        RDTSC_STOP(WorkerFoundWork, numWorkItems, pDC->drawId);
-
-                        _ReadWriteBarrier();
-
-                        pDC->pTileMgr->markTileComplete(tileID);
-
-                        // Optimization: If the draw is complete and we're the last one to have worked on it then
-                        // we can reset the locked list as we know that all previous draws before the next are guaranteed to be complete.
-                        if ((curDrawBE == i) && pDC->pTileMgr->isWorkComplete())
-                        {
-                            // We can increment the current BE and safely move to next draw since we know this draw is complete.
-                            curDrawBE++;
-                            InterlockedIncrement(&pDC->threadsDoneBE);
-
-                            lastRetiredDraw++;
-
-                            lockedTiles.clear();
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        // This tile is already locked. So let's add it to our locked tiles set. This way we don't try locking this one again.
-                        lockedTiles.insert(tileID);
+                        InitializeHotTiles(pContext, pDC, tileID, pTriWork);
+                        hotTileArrayIndex = pTriWork->triFlags.renderTargetArrayIndex;
                     }
                 }
+                else
+                {
+                    // clears, stores and invalidates change the hottile state
+                    hotTileArrayIndex = UINT32_MAX;
+                }
+
+                pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
+                tile.dequeue();
+                numWorkItems++;
+            }
+            RDTSC_STOP(WorkerFoundWork, numWorkItems, pDC->drawId);
+
+            _ReadWriteBarrier();
+
+            pDC->pTileMgr->markWorkComplete(numWorkItems);
+
+            // The FE may still queue more work to this tile, hand it back so
+            // that whichever worker gets to it next can continue in order.
+            if (!doneFE)
+            {
+                tile.unlock();
+            }
+
+            // Optimization: If the draw is complete and we're the last one to have worked on it then
+            // we can reset the locked list as we know that all previous draws before the next are guaranteed to be complete.
+            if ((curDrawBE == i) && IsFEDone(pDC) && pDC->pTileMgr->isWorkComplete())
+            {
+                // We can increment the current BE and safely move to next draw since we know this draw is complete.
+                curDrawBE++;
+                InterlockedIncrement(&pDC->threadsDoneBE);
+
+                lastRetiredDraw++;
+
+                lockedTiles.clear();
+                return true;
+            }
+
+            return false;
+        };
+
+        // Grab the list of all dirty macrotiles. A tile is dirty if it has work queued to it.
+        // Tiles are first claimed by ticket, each ticket names a different tile so workers
+        // spread out over the draw instead of all trying to lock the same tiles in order.
+        DirtyTileList::Range dirtyTiles = pDC->pTileMgr->getDirtyTiles();
+        DirtyTileList::Range::iterator ticketTile = dirtyTiles.begin();
+        uint32_t first, last;
+        bool retired = false;
+        while (!retired && pDC->pTileMgr->takeTileTicket(dirtyTiles.numTiles, first, last))
+        {
+            for (ticketTile.seek(first); !retired && ticketTile.index < last; ++ticketTile)
+            {
+                retired = workOnTile(**ticketTile);
+            }
+        }
+
+        // Then sweep all of them. This picks up the tiles whose ticket went to a worker
+        // that couldn't take them and, while the FE is running, tiles that got more work
+        // after their ticket. It also leaves lockedTiles complete for the draws after this.
+        if (!retired)
+        {
+            for (MacroTileQueue *pTile : pDC->pTileMgr->getDirtyTiles())
+            {
+                if (workOnTile(*pTile))
+                {
+                    break;
+                }
             }
         }
+
+        // The FE is still running, so nothing past this draw is safe to work on yet.
+        if (!doneFE) return;
     }
 }
 
@@ -604,7 +773,7 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawFE,
     uint64_t drawEnqueued = GetEnqueuedDraw(pContext);
     while (curDrawFE < drawEnqueued)
     {
-        uint32_t dcSlot = curDrawFE % KNOB_MAX_DRAWS_IN_FLIGHT;
+        uint32_t dcSlot = curDrawFE % pContext->maxDrawsInFlight;
         DRAW_CONTEXT *pDC = &pContext->dcRing[dcSlot];
         if (pDC->isCompute || pDC->doneFE || pDC->FeLock)
         {
@@ -620,18 +789,24 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawFE,
     uint64_t curDraw = curDrawFE;
     while (curDraw < drawEnqueued)
     {
-        uint32_t dcSlot = curDraw % KNOB_MAX_DRAWS_IN_FLIGHT;
+        uint32_t dcSlot = curDraw % pContext->maxDrawsInFlight;
         DRAW_CONTEXT *pDC = &pContext->dcRing[dcSlot];
 
-        if (!pDC->isCompute && !pDC->FeLock)
+        // draws with functions still being compiled, or whose FE depends on
+        // earlier FEs, are skipped, but curDrawFE isn't advanced past them above
+        if (!pDC->isCompute && !pDC->FeLock && IsDeferredFuncsReady(GetApiState(pDC)) &&
+            (!pDC->dependentFE || CheckPriorFEDone(pContext, pDC)))
         {
             uint32_t initial = InterlockedCompareExchange((volatile uint32_t*)&pDC->FeLock, 1, 0);
             if (initial == 0)
             {
+                ResolveDeferredFuncs(pDC->pState->state);
+
                 // successfully grabbed the DC, now run the FE
                 pDC->FeWork.pfnWork(pContext, pDC, workerId, &pDC->FeWork.desc);
 
-                _ReadWriteBarrier();
+                // publish everything the FE queued, see IsFEDone
+                std::atomic_thread_fence(std::memory_order_release);
                 pDC->doneFE = true;
             }
         }
@@ -656,9 +831,9 @@ void WorkOnCompute(
         return;
     }
 
-    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT].drawId - 1;
+    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % pContext->maxDrawsInFlight].drawId - 1;
 
-    DRAW_CONTEXT *pDC = &pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT];
+    DRAW_CONTEXT *pDC = &pContext->dcRing[curDrawBE % pContext->maxDrawsInFlight];
     if (pDC->isCompute == false) return;
 
     // check dependencies
@@ -693,10 +868,23 @@ void WorkOnCompute(
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief A worker's progress through the DC ring of an attached context.
+struct WORKER_CONTEXT_STATE
+{
+    uint64_t curDrawBE;
+    uint64_t curDrawFE;
+    uint64_t pass;          // stride scheduling pass, the context with work and the lowest pass goes next
+    uint32_t generation;    // POOL_CONTEXT::generation this state is for
+};
+
+// Pass added for each time a context of weight 1 is worked on.
+static const uint64_t POOL_STRIDE = 1 << 16;
+
 DWORD workerThreadMain(LPVOID pData)
 {
     THREAD_DATA *pThreadData = (THREAD_DATA*)pData;
-    SWR_CONTEXT *pContext = pThreadData->pContext;
+    THREAD_POOL *pPool = pThreadData->pPool;
     uint32_t threadId = pThreadData->threadId;
     uint32_t workerId = pThreadData->workerId;
 
@@ -711,7 +899,8 @@ DWORD workerThreadMain(LPVOID pData)
 
     // Track tiles locked by other threads. If we try to lock a macrotile and find its already
     // locked then we'll add it to this list so that we don't try and lock it again.
-    std::unordered_set<uint32_t> lockedTiles;
+    // It is reset on every WorkOnFifoBE, so one set serves all the contexts.
+    TileSet lockedTiles;
 
     // each worker has the ability to work on any of the queued draws as long as certain
     // conditions are met. the data associated
@@ -730,58 +919,155 @@ DWORD workerThreadMain(LPVOID pData)
     //    any work left by comparing the total # of binned work items and the total # of completed
     //    work items. If they are equal, then there is no more work to do for this draw, and
     //    the worker can safely increment its oldestDraw counter and move on to the next draw.
-    std::unique_lock<std::mutex> lock(pContext->WaitLock, std::defer_lock);
-
-    auto threadHasWork = [&](uint64_t curDraw) { return curDraw != pContext->DrawEnqueued; };
+    // With several contexts attached to the pool, the above applies to each context's DC ring.
+    std::unique_lock<std::mutex> lock(pPool->WaitLock, std::defer_lock);
 
-    uint64_t curDrawBE = 1;
-    uint64_t curDrawFE = 1;
+    WORKER_CONTEXT_STATE contextState[THREAD_POOL::MAX_CONTEXTS] = {};
+    uint64_t virtualTime = 0;
 
-    while (pContext->threadPool.inThreadShutdown == false)
+    // Publishes the context the worker looks at. The caller has to check the context is
+    // still attached afterwards, a detach that didn't see it has cleared the slot by then.
+    auto setActiveContext = [&](SWR_CONTEXT* pContext)
     {
-        uint32_t loop = 0;
-        while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && !threadHasWork(curDrawBE))
+        SWR_CONTEXT *pPrev = pThreadData->pActiveContext;
+        if (pPrev == pContext)
         {
-            _mm_pause();
+            return;
         }
 
-        if (!threadHasWork(curDrawBE))
-        {
-            lock.lock();
+        pThreadData->pActiveContext = pContext;
+        _mm_mfence();
 
-            // check for thread idle condition again under lock
-            if (threadHasWork(curDrawBE))
+        // wake a quiesce that waits for the worker to let go of the previous context
+        if (pPrev != nullptr && pPool->numQuiescing != 0)
+        {
+            if (lock.owns_lock())
             {
+                pPool->ContextReleased.notify_all();
+            }
+            else
+            {
+                lock.lock();
+                pPool->ContextReleased.notify_all();
                 lock.unlock();
+            }
+        }
+    };
+
+    // Returns the context with pending work to work on next, or null if there is none.
+    // The worker holds on to the context returned, see setActiveContext.
+    auto pickContext = [&](uint32_t& slot) -> SWR_CONTEXT*
+    {
+        SWR_CONTEXT *pNext = nullptr;
+        for (uint32_t i = 0; i < THREAD_POOL::MAX_CONTEXTS; ++i)
+        {
+            const POOL_CONTEXT &poolContext = pPool->contexts[i];
+            SWR_CONTEXT *pContext = poolContext.pContext;
+            if (pContext == nullptr)
+            {
                 continue;
             }
 
-            if (pContext->threadPool.inThreadShutdown)
+            setActiveContext(pContext);
+            if (poolContext.pContext != pContext)
             {
-                lock.unlock();
-                break;
+                continue;
+            }
+
+            // the generation is written before the context is published
+            WORKER_CONTEXT_STATE &state = contextState[i];
+            if (state.generation != poolContext.generation)
+            {
+                state.curDrawBE = 1;
+                state.curDrawFE = 1;
+                state.pass = virtualTime;
+                state.generation = poolContext.generation;
             }
 
-            RDTSC_START(WorkerWaitForThreadEvent);
+            if (state.curDrawBE == pContext->DrawEnqueued)
+            {
+                // idle contexts don't bank time to burst with later
+                state.pass = std::max(state.pass, virtualTime);
+                continue;
+            }
 
-            pContext->FifosNotEmpty.wait(lock);
-            lock.unlock();
+            if (pNext == nullptr || state.pass < contextState[slot].pass)
+            {
+                pNext = pContext;
+                slot = i;
+            }
+        }
 
-            RDTSC_STOP(WorkerWaitForThreadEvent, 0, 0);
+        // it may have been detached, and another context attached, while looking at the others
+        setActiveContext(pNext);
+        if (pNext != nullptr &&
+            (pPool->contexts[slot].pContext != pNext || pPool->contexts[slot].generation != contextState[slot].generation))
+        {
+            setActiveContext(nullptr);
+            return nullptr;
+        }
+        return pNext;
+    };
 
-            if (pContext->threadPool.inThreadShutdown)
+    while (pPool->inThreadShutdown == false)
+    {
+        uint32_t slot = 0;
+        SWR_CONTEXT *pContext = pickContext(slot);
+
+        if (pContext == nullptr)
+        {
+            uint64_t idleStart = __rdtsc();
+
+            uint32_t loop = 1;
+            while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && (pContext = pickContext(slot)) == nullptr)
+            {
+                _mm_pause();
+            }
+
+            if (pContext == nullptr)
             {
-                break;
+                lock.lock();
+
+                // check for thread idle condition again under lock
+                if (pickContext(slot) != nullptr)
+                {
+                    lock.unlock();
+                    pThreadData->idleTicks += __rdtsc() - idleStart;
+                    continue;
+                }
+
+                if (pPool->inThreadShutdown)
+                {
+                    lock.unlock();
+                    break;
+                }
+
+                RDTSC_START(WorkerWaitForThreadEvent);
+
+                pPool->FifosNotEmpty.wait(lock);
+                lock.unlock();
+
+                RDTSC_STOP(WorkerWaitForThreadEvent, 0, 0);
+
+                pThreadData->idleTicks += __rdtsc() - idleStart;
+                continue;
             }
+
+            pThreadData->idleTicks += __rdtsc() - idleStart;
         }
 
+        WORKER_CONTEXT_STATE &state = contextState[slot];
+
         RDTSC_START(WorkerWorkOnFifoBE);
-        WorkOnFifoBE(pContext, workerId, curDrawBE, lockedTiles);
+        WorkOnFifoBE(pContext, workerId, state.curDrawBE, lockedTiles, numaNode);
         RDTSC_STOP(WorkerWorkOnFifoBE, 0, 0);
 
-        WorkOnCompute(pContext, workerId, curDrawBE);
+        WorkOnCompute(pContext, workerId, state.curDrawBE);
 
-        WorkOnFifoFE(pContext, workerId, curDrawFE, numaNode);
+        WorkOnFifoFE(pContext, workerId, state.curDrawFE, numaNode);
+
+        virtualTime = state.pass;
+        state.pass += POOL_STRIDE / pPool->contexts[slot].weight;
     }
 
     return 0;
@@ -806,7 +1092,7 @@ DWORD workerThreadInit(LPVOID pData)
     return 1;
 }
 
-void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
+void CreateThreadPool(THREAD_POOL *pPool)
 {
     bindThread(0);
 
@@ -814,6 +1100,8 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     uint32_t numThreadsPerProcGroup = 0;
     CalculateProcessorTopology(nodes, numThreadsPerProcGroup);
 
+    pPool->numNumaNodes = 1;
+
     uint32_t numHWNodes         = (uint32_t)nodes.size();
     uint32_t numHWCoresPerNode  = (uint32_t)nodes[0].cores.size();
     uint32_t numHWHyperThreads  = (uint32_t)nodes[0].cores[0].threadIds.size();
@@ -883,7 +1171,6 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     }
 
     pPool->numThreads = numThreads;
-    pContext->NumWorkerThreads = pPool->numThreads;
 
     pPool->inThreadShutdown = false;
     pPool->pThreadData = (THREAD_DATA *)malloc(pPool->numThreads * sizeof(THREAD_DATA));
@@ -900,7 +1187,9 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
             pPool->pThreadData[workerId].procGroupId = workerId % numProcGroups;
             pPool->pThreadData[workerId].threadId = 0;
             pPool->pThreadData[workerId].numaId = 0;
-            pPool->pThreadData[workerId].pContext = pContext;
+            pPool->pThreadData[workerId].pPool = pPool;
+            pPool->pThreadData[workerId].pActiveContext = nullptr;
+            pPool->pThreadData[workerId].idleTicks = 0;
             pPool->pThreadData[workerId].forceBindProcGroup = bForceBindProcGroup;
             pPool->threads[workerId] = new std::thread(workerThreadInit, &pPool->pThreadData[workerId]);
         }
@@ -928,25 +1217,35 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
                     pPool->pThreadData[workerId].procGroupId = core.procGroup;
                     pPool->pThreadData[workerId].threadId = core.threadIds[t];
                     pPool->pThreadData[workerId].numaId = n;
-                    pPool->pThreadData[workerId].pContext = pContext;
+                    pPool->pThreadData[workerId].pPool = pPool;
+                    pPool->pThreadData[workerId].pActiveContext = nullptr;
+                    pPool->pThreadData[workerId].idleTicks = 0;
                     pPool->threads[workerId] = new std::thread(workerThreadInit, &pPool->pThreadData[workerId]);
 
                     ++workerId;
                 }
             }
         }
+
+        // Interleave macrotiles over the nodes, as long as every node has a worker to own them.
+        // Node 0 is the only one that can be left without a worker, by reserving the API thread.
+        bool node0HasWorker = (numCoresPerNode * numHyperThreads) > 1;
+        if (KNOB_NUMA_TILE_AFFINITY && numNodes > 1 && node0HasWorker)
+        {
+            pPool->numNumaNodes = numNodes;
+        }
     }
 }
 
-void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
+void DestroyThreadPool(THREAD_POOL *pPool)
 {
-    if (!KNOB_SINGLE_THREADED)
+    if (pPool->numThreads)
     {
         // Inform threads to finish up
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
+        std::unique_lock<std::mutex> lock(pPool->WaitLock);
         pPool->inThreadShutdown = true;
         _mm_mfence();
-        pContext->FifosNotEmpty.notify_all();
+        pPool->FifosNotEmpty.notify_all();
         lock.unlock();
 
         // Wait for threads to finish and destroy them
@@ -960,3 +1259,95 @@ void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
         free(pPool->pThreadData);
     }
 }
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Makes the pool's workers work on a context. Returns false if the
+///        pool has no room for it.
+/// @param weight - share of the workers relative to the other contexts, when
+///                 several have work pending.
+bool AttachThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext, uint32_t weight)
+{
+    std::unique_lock<std::mutex> lock(pPool->WaitLock);
+
+    for (uint32_t i = 0; i < THREAD_POOL::MAX_CONTEXTS; ++i)
+    {
+        POOL_CONTEXT &poolContext = pPool->contexts[i];
+        if (poolContext.pContext == nullptr)
+        {
+            poolContext.generation++;
+            poolContext.weight = std::max(weight, 1u);
+
+            // workers reset their progress when they see the new generation
+            _ReadWriteBarrier();
+            poolContext.pContext = pContext;
+
+            pContext->pThreadPool = pPool;
+            pContext->NumWorkerThreads = pPool->numThreads;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stops the pool's workers from working on a context, and waits
+///        until none of them still looks at it. The context must be idle.
+void DetachThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext)
+{
+    {
+        std::unique_lock<std::mutex> lock(pPool->WaitLock);
+
+        for (uint32_t i = 0; i < THREAD_POOL::MAX_CONTEXTS; ++i)
+        {
+            if (pPool->contexts[i].pContext == pContext)
+            {
+                pPool->contexts[i].pContext = nullptr;
+            }
+        }
+    }
+
+    QuiesceThreadPool(pPool, pContext);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Waits until no worker holds the context, so that none still uses
+///        what it read from it before. Workers busy with other contexts of
+///        the pool aren't waited for. The context must be idle, or detached.
+void QuiesceThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext)
+{
+    std::unique_lock<std::mutex> lock(pPool->WaitLock);
+
+    pPool->numQuiescing++;
+    _mm_mfence();
+
+    auto isReleased = [&]()
+    {
+        for (uint32_t t = 0; t < pPool->numThreads; ++t)
+        {
+            if (pPool->pThreadData[t].pActiveContext == pContext)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    pPool->ContextReleased.wait(lock, isReleased);
+
+    pPool->numQuiescing--;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Changes the share of the pool's workers a context gets.
+void SetThreadPoolWeight(THREAD_POOL *pPool, SWR_CONTEXT *pContext, uint32_t weight)
+{
+    std::unique_lock<std::mutex> lock(pPool->WaitLock);
+
+    for (uint32_t i = 0; i < THREAD_POOL::MAX_CONTEXTS; ++i)
+    {
+        if (pPool->contexts[i].pContext == pContext)
+        {
+            pPool->contexts[i].weight = std::max(weight, 1u);
+        }
+    }
+}
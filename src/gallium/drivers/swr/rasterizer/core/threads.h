@@ -29,35 +29,126 @@
 
 #include "knobs.h"
 
-#include <unordered_set>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 typedef std::thread* THREAD_PTR;
 
 struct SWR_CONTEXT;
 
+//////////////////////////////////////////////////////////////////////////
+/// TileSet - Compact set of macrotile ids, one bit per hot tile.
+/// Clearing only touches the words that were written since the last clear.
+//////////////////////////////////////////////////////////////////////////
+struct TileSet
+{
+    static const uint32_t NUM_TILES = KNOB_NUM_HOT_TILES_X * KNOB_NUM_HOT_TILES_Y;
+    static const uint32_t NUM_WORDS = NUM_TILES / 64;
+    static_assert((NUM_TILES % 64) == 0, "Hot tile count must be a multiple of 64");
+
+    INLINE bool contains(uint32_t tileID) const
+    {
+        uint32_t index = GetIndex(tileID);
+        return (mBits[index / 64] >> (index % 64)) & 1;
+    }
+
+    INLINE void insert(uint32_t tileID)
+    {
+        uint32_t index = GetIndex(tileID);
+        uint64_t &word = mBits[index / 64];
+        if (word == 0)
+        {
+            mUsedWords[mNumUsedWords++] = index / 64;
+        }
+        word |= 1ULL << (index % 64);
+    }
+
+    INLINE void clear()
+    {
+        for (uint32_t i = 0; i < mNumUsedWords; ++i)
+        {
+            mBits[mUsedWords[i]] = 0;
+        }
+        mNumUsedWords = 0;
+    }
+
+private:
+    // tile ids are (x << 16 | y), see MacroTileMgr::getTileIndices
+    static INLINE uint32_t GetIndex(uint32_t tileID)
+    {
+        return (tileID >> 16) * KNOB_NUM_HOT_TILES_Y + (tileID & 0xffff);
+    }
+
+    uint64_t mBits[NUM_WORDS] = {};
+    uint32_t mUsedWords[NUM_WORDS];
+    uint32_t mNumUsedWords = 0;
+};
+
+struct THREAD_POOL;
+
 struct THREAD_DATA
 {
     uint32_t procGroupId;   // Will always be 0 for non-Windows OS
     uint32_t threadId;      // within the procGroup for Windows
     uint32_t numaId;        // NUMA node id
     uint32_t workerId;
-    SWR_CONTEXT *pContext;
+    THREAD_POOL *pPool;
     bool forceBindProcGroup; // Only useful when KNOB_MAX_WORKER_THREADS is set.
+
+    // Context the worker is looking at, null if none. A quiesce of the context
+    // waits until the worker lets go of it.
+    OSALIGNLINE(SWR_CONTEXT* volatile) pActiveContext;
+
+    uint64_t idleTicks;     // RDTSC ticks spent with no draw queued to any context
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// POOL_CONTEXT - A context serviced by a thread pool.
+//////////////////////////////////////////////////////////////////////////
+struct POOL_CONTEXT
+{
+    SWR_CONTEXT* volatile pContext; // null if the slot is free
+    uint32_t generation;            // bumped when a context is attached to the slot
+    volatile uint32_t weight;       // share of the workers, relative to the other contexts
+};
 
+//////////////////////////////////////////////////////////////////////////
+/// THREAD_POOL - Worker threads servicing the DC rings of one or more
+/// contexts. Each context creates its own, unless it is given a pool
+/// shared with other contexts, see SwrCreateWorkerPool. Every worker works
+/// on every attached context, picking the next one with pending work by
+/// stride scheduling on the context weights.
+//////////////////////////////////////////////////////////////////////////
 struct THREAD_POOL
 {
+    static const uint32_t MAX_CONTEXTS = 32;
+
     THREAD_PTR threads[KNOB_MAX_NUM_THREADS];
     uint32_t numThreads;
+    uint32_t numNumaNodes;  // # of nodes macrotiles are interleaved over, <= 1 if no tile affinity
     volatile bool inThreadShutdown;
     THREAD_DATA *pThreadData;
+
+    // Idle workers wait for new draws of any attached context on these.
+    std::mutex WaitLock;
+    std::condition_variable FifosNotEmpty;
+
+    POOL_CONTEXT contexts[MAX_CONTEXTS];
+
+    // Quiesces wait on ContextReleased for the workers to let go of their
+    // context. Workers only notify while numQuiescing, under WaitLock, is set.
+    std::condition_variable ContextReleased;
+    volatile uint32_t numQuiescing;
 };
 
-void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
-void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
+void CreateThreadPool(THREAD_POOL *pPool);
+void DestroyThreadPool(THREAD_POOL *pPool);
+bool AttachThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext, uint32_t weight);
+void DetachThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext);
+void QuiesceThreadPool(THREAD_POOL *pPool, SWR_CONTEXT *pContext);
+void SetThreadPoolWeight(THREAD_POOL *pPool, SWR_CONTEXT *pContext, uint32_t weight);
 
 // Expose FE and BE worker functions to the API thread if single threaded
 void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawFE, UCHAR numaNode);
-void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE, std::unordered_set<uint32_t> &usedTiles);
+void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE, TileSet &lockedTiles, uint32_t numaNode);
 void WorkOnCompute(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t &curDrawBE);
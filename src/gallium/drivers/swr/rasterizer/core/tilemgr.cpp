@@ -28,6 +28,10 @@
 ******************************************************************************/
 #include <unordered_map>
 
+#if defined(__linux__) || defined(__gnu_linux__)
+#include <sys/mman.h>
+#endif
+
 #include "fifo.hpp"
 #include "tilemgr.h"
 
@@ -62,6 +66,8 @@ void MacroTileMgr::initialize()
 {
     mWorkItemsProduced = 0;
     mWorkItemsConsumed = 0;
+    mNextTicket = 0;
+    mGeneration++;
 
     mDirtyTiles.clear();
 }
@@ -75,31 +81,400 @@ void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK *pWork)
     uint32_t id = TILE_ID(x, y);
 
     MacroTileQueue &tile = mTiles[id];
-    tile.mWorkItemsFE++;
 
-    if (tile.mWorkItemsFE == 1)
+    // First work for this tile in the draw, clear the fifo left over from
+    // the previous draw and make the tile visible to the BE.
+    if (tile.mGeneration != mGeneration)
     {
+        tile.mId = id;
+        tile.mGeneration = mGeneration;
         tile.clear(mArena);
-        mDirtyTiles.push_back(id);
+        mDirtyTiles.push_back(mArena, &tile);
     }
 
     mWorkItemsProduced++;
     tile.enqueue_try_nosync(mArena, pWork);
 }
 
-void MacroTileMgr::markTileComplete(uint32_t id)
+void MacroTileMgr::markWorkComplete(uint32_t numWorkItems)
 {
-    SWR_ASSERT(mTiles.find(id) != mTiles.end());
-    MacroTileQueue &tile = mTiles[id];
-    uint32_t numTiles = tile.mWorkItemsFE;
-    InterlockedExchangeAdd(&mWorkItemsConsumed, numTiles);
+    InterlockedExchangeAdd(&mWorkItemsConsumed, numWorkItems);
+}
+
+void HotTileMgr::MapHotTileMem(SWR_CONTEXT* pContext, uint32_t macroID, HOTTILE& hotTile, uint32_t size)
+{
+    if (!KNOB_NUMA_TILE_AFFINITY)
+    {
+        hotTile.pBuffer = (BYTE*)_aligned_malloc(size, 64);
+        SWR_ASSERT(hotTile.pBuffer != nullptr, "Failed to allocate hot tile");
+        hotTile.bufferSize = size;
+        return;
+    }
+
+    // Hot tiles get their own pages, so that placement is decided by the node of the
+    // worker that owns the tile and not whoever last touched nearby heap memory.
+#if defined(_WIN32)
+    DWORD numaNode = NUMA_NO_PREFERRED_NODE;
+    uint32_t numNumaNodes = pContext->pThreadPool->numNumaNodes;
+    if (numNumaNodes > 1)
+    {
+        numaNode = MacroTileMgr::getTileNumaNode(macroID, numNumaNodes);
+    }
+
+    hotTile.pBuffer = (BYTE*)VirtualAllocExNuma(GetCurrentProcess(), nullptr, size,
+        MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, numaNode);
+#else
+    // Linux places fresh pages on the node of the first thread to touch them. With
+    // tile affinity that is always a worker on the tile's node, since hot tiles are
+    // only allocated and initialized by the BE worker processing the tile.
+    void* pMem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    hotTile.pBuffer = (pMem == MAP_FAILED) ? nullptr : (BYTE*)pMem;
+#endif
+    SWR_ASSERT(hotTile.pBuffer != nullptr, "Failed to allocate hot tile");
+    hotTile.bufferSize = size;
+}
+
+void HotTileMgr::UnmapHotTileMem(HOTTILE& hotTile)
+{
+    if (!KNOB_NUMA_TILE_AFFINITY)
+    {
+        _aligned_free(hotTile.pBuffer);
+    }
+    else
+    {
+#if defined(_WIN32)
+        VirtualFree(hotTile.pBuffer, 0, MEM_RELEASE);
+#else
+        munmap(hotTile.pBuffer, hotTile.bufferSize);
+#endif
+    }
+    hotTile.pBuffer = nullptr;
+    hotTile.bufferSize = 0;
+}
+
+bool HotTileMgr::AllocHotTileMem(SWR_CONTEXT* pContext, uint32_t macroID, HOTTILE& hotTile, uint32_t size, bool evict)
+{
+    std::unique_lock<std::mutex> lock(mPoolLock);
+
+    hotTile.pBuffer = nullptr;
+    if (!evict && mBudget != 0 && mHotTileBytes + size > mBudget)
+    {
+        return false;
+    }
+
+    // Make room by evicting the least recently released tiles. Their contents are in
+    // the surface already, so they are just reloaded on their next use.
+    while (mBudget != 0 && mpLruHead != nullptr && hotTile.pBuffer == nullptr &&
+           mHotTileBytes + size > mBudget)
+    {
+        HOTTILE& victim = *mpLruHead;
+        UnlinkHotTile(victim);
+
+        mHotTileBytes -= victim.bufferSize;
+        if (victim.bufferSize >= size)
+        {
+            // hand the buffer over, saving the unmap and page faults of a new one
+            hotTile.pBuffer = victim.pBuffer;
+            hotTile.bufferSize = victim.bufferSize;
+            victim.pBuffer = nullptr;
+            victim.bufferSize = 0;
+            mNumReuses++;
+        }
+        else
+        {
+            UnmapHotTileMem(victim);
+        }
+
+        victim.state = HOTTILE_INVALID;
+        InvalidateHiZ(victim);
+        mNumEvictions++;
+
+        // the owner may read the tile without the lock once it's not evictable
+        _ReadWriteBarrier();
+        victim.evictable = false;
+    }
+
+    if (hotTile.pBuffer == nullptr)
+    {
+        MapHotTileMem(pContext, macroID, hotTile, size);
+    }
+
+    mHotTileBytes += hotTile.bufferSize;
+    mHotTileBytesPeak = std::max(mHotTileBytesPeak, mHotTileBytes);
+    return true;
+}
 
+void HotTileMgr::FreeHotTileMem(HOTTILE& hotTile)
+{
+    std::unique_lock<std::mutex> lock(mPoolLock);
+
+    mHotTileBytes -= hotTile.bufferSize;
+    UnmapHotTileMem(hotTile);
+}
+
+void HotTileMgr::ReleaseHotTile(HOTTILE& hotTile)
+{
+    if (mBudget == 0 || hotTile.pBuffer == nullptr || hotTile.evictable)
+    {
+        return;
+    }
+
+    SWR_ASSERT(hotTile.state == HOTTILE_RESOLVED || hotTile.state == HOTTILE_INVALID);
+
+    std::unique_lock<std::mutex> lock(mPoolLock);
+
+    hotTile.pLruPrev = mpLruTail;
+    hotTile.pLruNext = nullptr;
+    if (mpLruTail)
+    {
+        mpLruTail->pLruNext = &hotTile;
+    }
+    else
+    {
+        mpLruHead = &hotTile;
+    }
+    mpLruTail = &hotTile;
+    hotTile.evictable = true;
+}
+
+void HotTileMgr::ClaimHotTile(HOTTILE& hotTile)
+{
+    std::unique_lock<std::mutex> lock(mPoolLock);
+
+    // another worker may have evicted it meanwhile
+    if (hotTile.evictable)
+    {
+        UnlinkHotTile(hotTile);
+        hotTile.evictable = false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Finds a hottile for an array slice of a macrotile attachment that
+///        has none. A layer without memory is taken first, then a new layer
+///        as long as KNOB_HOT_TILE_LAYERS and the budget allow; otherwise the
+///        least recently used slice is stored if dirty and swapped out.
+///        Returns the hottile INVALID, for the caller to load.
+HOTTILE* HotTileMgr::AddHotTileLayer(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment,
+    uint32_t numSamples, uint32_t renderTargetArrayIndex)
+{
+    uint32_t x, y;
+    MacroTileMgr::getTileIndices(macroID, x, y);
+
+    uint32_t numLayers = 0;
+    HOTTILE* pLastLayer = nullptr;
+    HOTTILE* pLeastRecent = nullptr;
+    for (HOTTILE* pHotTile = &mHotTiles[x][y].Attachment[attachment]; pHotTile != nullptr; pHotTile = pHotTile->pNextLayer)
+    {
+        // evicted tiles are only free once they are off the eviction list
+        bool evictable = pHotTile->evictable;
+        _ReadWriteBarrier();
+        if (!evictable && pHotTile->pBuffer == nullptr)
+        {
+            pHotTile->renderTargetArrayIndex = renderTargetArrayIndex;
+            return pHotTile;
+        }
+
+        // a pending clear has nowhere to go but the hottile
+        if (pHotTile->state != HOTTILE_CLEAR &&
+            (pLeastRecent == nullptr || pHotTile->lastUse < pLeastRecent->lastUse))
+        {
+            pLeastRecent = pHotTile;
+        }
+        numLayers++;
+        pLastLayer = pHotTile;
+    }
+
+    // Extra layers only use free room in the budget, they don't evict other tiles. The
+    // exception is a slice no other layer can be swapped out for, it evicts if it must.
+    bool mustAdd = (pLeastRecent == nullptr);
+    if (numLayers < KNOB_HOT_TILE_LAYERS || mustAdd)
+    {
+        SWR_FORMAT format = GetHotTileFormat(pDC, attachment);
+        HOTTILE* pLayer = (HOTTILE*)_aligned_malloc(sizeof(HOTTILE), 64);
+        SWR_ASSERT(pLayer != nullptr, "Failed to allocate hot tile layer");
+        memset(pLayer, 0, sizeof(HOTTILE));
+
+        if (AllocHotTileMem(pContext, macroID, *pLayer, GetHotTileSize(format, numSamples), mustAdd))
+        {
+            pLayer->state = HOTTILE_INVALID;
+            pLayer->numSamples = numSamples;
+            pLayer->renderTargetArrayIndex = renderTargetArrayIndex;
+            pLayer->format = format;
+            if (KNOB_ENABLE_HIZ && attachment == SWR_ATTACHMENT_DEPTH)
+            {
+                AllocHiZ(*pLayer);
+            }
+
+            // the binner may walk the layers as soon as it's linked
+            _ReadWriteBarrier();
+            pLastLayer->pNextLayer = pLayer;
+            return pLayer;
+        }
+        _aligned_free(pLayer);
+    }
+
+    HOTTILE& hotTile = *pLeastRecent;
+    if (hotTile.evictable)
+    {
+        ClaimHotTile(hotTile);
+    }
+
+    if (hotTile.state == HOTTILE_DIRTY)
+    {
+        pContext->pfnStoreTile(GetPrivateState(pDC), hotTile.format, attachment,
+            x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, hotTile.renderTargetArrayIndex, hotTile.numSamples, hotTile.pBuffer);
+    }
+
+    hotTile.state = HOTTILE_INVALID;
+    InvalidateHiZ(hotTile);
+    hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+
+    std::unique_lock<std::mutex> lock(mPoolLock);
+    mNumLayerSwaps++;
+
+    return &hotTile;
+}
+
+void HotTileMgr::UnlinkHotTile(HOTTILE& hotTile)
+{
+    if (hotTile.pLruPrev)
+    {
+        hotTile.pLruPrev->pLruNext = hotTile.pLruNext;
+    }
+    else
+    {
+        mpLruHead = hotTile.pLruNext;
+    }
+
+    if (hotTile.pLruNext)
+    {
+        hotTile.pLruNext->pLruPrev = hotTile.pLruPrev;
+    }
+    else
+    {
+        mpLruTail = hotTile.pLruPrev;
+    }
+
+    hotTile.pLruPrev = nullptr;
+    hotTile.pLruNext = nullptr;
+}
+
+void HotTileMgr::GetPoolStats(SWR_STATS& stats)
+{
+    std::unique_lock<std::mutex> lock(mPoolLock);
+
+    stats.HotTileBytes = mHotTileBytes;
+    stats.HotTileBytesPeak = mHotTileBytesPeak;
+    stats.HotTileEvictions = mNumEvictions;
+    stats.HotTileReuses = mNumReuses;
+    stats.HotTileLayerSwaps = mNumLayerSwaps;
+}
+
+void HotTileMgr::AllocHiZ(HOTTILE& hotTile)
+{
+    HIZ_TILE* pHiZ = (HIZ_TILE*)_aligned_malloc(sizeof(HIZ_TILE), 64);
+    SWR_ASSERT(pHiZ != nullptr, "Failed to allocate HiZ");
+    for (uint32_t y = 0; y < KNOB_MACROTILE_Y_DIM_IN_TILES; ++y)
+    {
+        for (uint32_t x = 0; x < KNOB_MACROTILE_X_DIM_IN_TILES; ++x)
+        {
+            pHiZ->maxZ[y][x] = FLT_MAX;
+        }
+    }
+    pHiZ->macroMaxZ = FLT_MAX;
+    pHiZ->renderTargetArrayIndex = 0;
+    pHiZ->generation = 0;
+
+    // the binner may look at it as soon as the pointer is visible
     _ReadWriteBarrier();
-    tile.mWorkItemsBE += numTiles;
-    SWR_ASSERT(tile.mWorkItemsFE == tile.mWorkItemsBE);
+    hotTile.pHiZ = pHiZ;
+}
+
+void HotTileMgr::InvalidateHiZ(HOTTILE& hotTile)
+{
+    if (hotTile.pHiZ != nullptr)
+    {
+        hotTile.pHiZ->generation = 0;
+    }
+}
 
-    // clear out tile, but defer fifo clear until the next DC first queues to it.
-    // this prevents worker threads from constantly locking a completed macro tile
-    tile.mWorkItemsFE = 0;
-    tile.mWorkItemsBE = 0;
+void HotTileMgr::ClearHiZ(HOTTILE& hotTile, float depth, uint32_t generation)
+{
+    HIZ_TILE* pHiZ = hotTile.pHiZ;
+    if (pHiZ == nullptr)
+    {
+        return;
+    }
+
+    pHiZ->generation = 0;
+    _ReadWriteBarrier();
+
+    for (uint32_t y = 0; y < KNOB_MACROTILE_Y_DIM_IN_TILES; ++y)
+    {
+        for (uint32_t x = 0; x < KNOB_MACROTILE_X_DIM_IN_TILES; ++x)
+        {
+            pHiZ->maxZ[y][x] = depth;
+        }
+    }
+    pHiZ->macroMaxZ = depth;
+    pHiZ->renderTargetArrayIndex = hotTile.renderTargetArrayIndex;
+
+    _ReadWriteBarrier();
+    pHiZ->generation = generation;
+}
+
+void HotTileMgr::UpdateHiZ(HOTTILE& hotTile, uint32_t numSamples, uint32_t generation)
+{
+    HIZ_TILE* pHiZ = hotTile.pHiZ;
+    if (pHiZ == nullptr)
+    {
+        return;
+    }
+
+    pHiZ->generation = 0;
+    _ReadWriteBarrier();
+
+    // raster tiles are stored in SWRZ order, all samples of a raster tile together
+    const uint32_t rasterTileStep = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8) * numSamples;
+    const uint8_t* pRasterTile = hotTile.pBuffer;
+    pHiZ->macroMaxZ = -FLT_MAX;
+    for (uint32_t y = 0; y < KNOB_MACROTILE_Y_DIM_IN_TILES; ++y)
+    {
+        for (uint32_t x = 0; x < KNOB_MACROTILE_X_DIM_IN_TILES; ++x)
+        {
+            UpdateHiZRasterTile(pHiZ, x, y, pRasterTile, numSamples);
+            pRasterTile += rasterTileStep;
+        }
+    }
+    pHiZ->renderTargetArrayIndex = hotTile.renderTargetArrayIndex;
+
+    _ReadWriteBarrier();
+    pHiZ->generation = generation;
+}
+
+void HotTileMgr::RefreshHiZ(HOTTILE& hotTile, uint32_t generation)
+{
+    HIZ_TILE* pHiZ = hotTile.pHiZ;
+    if (pHiZ == nullptr || pHiZ->generation == generation)
+    {
+        return;
+    }
+
+    pHiZ->generation = 0;
+    _ReadWriteBarrier();
+
+    float macroMaxZ = -FLT_MAX;
+    for (uint32_t y = 0; y < KNOB_MACROTILE_Y_DIM_IN_TILES; ++y)
+    {
+        for (uint32_t x = 0; x < KNOB_MACROTILE_X_DIM_IN_TILES; ++x)
+        {
+            macroMaxZ = std::max(macroMaxZ, pHiZ->maxZ[y][x]);
+        }
+    }
+    pHiZ->macroMaxZ = macroMaxZ;
+    pHiZ->renderTargetArrayIndex = hotTile.renderTargetArrayIndex;
+
+    _ReadWriteBarrier();
+    pHiZ->generation = generation;
 }
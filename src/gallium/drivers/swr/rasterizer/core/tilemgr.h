@@ -28,6 +28,9 @@
 ******************************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 #include "common/formats.h"
@@ -57,6 +60,14 @@ struct MacroTileQueue
         return mFifo.tryLock();
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Release the work fifo so another worker can pick up work that
+    ///        is queued after this point.
+    void unlock()
+    {
+        mFifo.unlock();
+    }
+
     //////////////////////////////////////////////////////////////////////////
     /// @brief Clear fifo and unlock it.
     void clear(Arena& arena)
@@ -91,19 +102,123 @@ struct MacroTileQueue
     }
 
     ///@todo This will all be private.
-    uint32_t mWorkItemsFE = 0;
-    uint32_t mWorkItemsBE = 0;
+    uint32_t mId = 0;
+    uint32_t mGeneration = 0;   // MacroTileMgr generation this tile was last queued in
 
 private:
     QUEUE<BE_WORK> mFifo;
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// DirtyTileList - Append only list of the macrotiles that have work queued
+/// for a draw.  The FE appends to it while BE workers may be walking it, so
+/// entries live in arena blocks that never move and the count is published
+/// with a release store after the entry is written.
+//////////////////////////////////////////////////////////////////////////
+class DirtyTileList
+{
+    static const uint32_t BLOCK_SIZE = 63;
+
+    struct Block
+    {
+        MacroTileQueue* pTiles[BLOCK_SIZE];
+        Block* pNext;
+    };
+
+public:
+    //////////////////////////////////////////////////////////////////////////
+    /// Range - Snapshot of the tiles appended so far, iterable by BE workers.
+    struct Range
+    {
+        struct iterator
+        {
+            Block* pBlock;
+            uint32_t index;
+
+            MacroTileQueue* operator*() const { return pBlock->pTiles[index % BLOCK_SIZE]; }
+            bool operator!=(const iterator& rhs) const { return index != rhs.index; }
+            iterator& operator++()
+            {
+                if ((++index % BLOCK_SIZE) == 0)
+                {
+                    pBlock = pBlock->pNext;
+                }
+                return *this;
+            }
+
+            // move forward to entry i, i must be in the range
+            void seek(uint32_t i)
+            {
+                for (uint32_t block = index / BLOCK_SIZE; block < i / BLOCK_SIZE; ++block)
+                {
+                    pBlock = pBlock->pNext;
+                }
+                index = i;
+            }
+        };
+
+        iterator begin() const { return { pHead, 0 }; }
+        iterator end() const { return { nullptr, numTiles }; }
+
+        Block* pHead;
+        uint32_t numTiles;
+    };
+
+    void clear()
+    {
+        mpHead = nullptr;
+        mpTail = nullptr;
+        mNumTiles.store(0, std::memory_order_relaxed);
+    }
+
+    void push_back(Arena& arena, MacroTileQueue* pTile)
+    {
+        uint32_t numTiles = mNumTiles.load(std::memory_order_relaxed);
+        uint32_t slot = numTiles % BLOCK_SIZE;
+        if (slot == 0)
+        {
+            Block* pBlock = (Block*)arena.Alloc(sizeof(Block));
+            SWR_ASSERT(pBlock);
+            pBlock->pNext = nullptr;
+            if (mpTail)
+            {
+                mpTail->pNext = pBlock;
+            }
+            else
+            {
+                mpHead = pBlock;
+            }
+            mpTail = pBlock;
+        }
+        mpTail->pTiles[slot] = pTile;
+
+        // publish the entry
+        mNumTiles.store(numTiles + 1, std::memory_order_release);
+    }
+
+    Range getRange()
+    {
+        // read the count first, everything it covers is already linked in
+        uint32_t numTiles = mNumTiles.load(std::memory_order_acquire);
+        return { numTiles ? mpHead : nullptr, numTiles };
+    }
+
+private:
+    Block* mpHead = nullptr;
+    Block* mpTail = nullptr;
+    OSALIGNLINE(std::atomic<uint32_t>) mNumTiles{ 0 };
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// MacroTileMgr - Manages macrotiles for a draw.
 //////////////////////////////////////////////////////////////////////////
 class MacroTileMgr
 {
 public:
+    // Tiles handed out per takeTileTicket, enough to keep the shared counter
+    // off the per tile path.
+    static const uint32_t TILES_PER_TICKET = 4;
+
     MacroTileMgr(Arena& arena);
     ~MacroTileMgr()
     {
@@ -114,10 +229,33 @@ public:
     }
 
     void initialize();
-    INLINE std::vector<uint32_t>& getDirtyTiles() { return mDirtyTiles; }
-    INLINE MacroTileQueue& getMacroTileQueue(uint32_t id) { return mTiles[id]; }
-    void markTileComplete(uint32_t id);
+    INLINE DirtyTileList::Range getDirtyTiles() { return mDirtyTiles.getRange(); }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Hands out the dirty tiles a few at a time, so that BE workers
+    ///        each start on different tiles instead of racing for the same ones.
+    /// @param numTiles - Number of dirty tiles in the caller's range.
+    /// @param first - Index of the first tile of the ticket in the dirty tile list.
+    /// @param last - One past the index of the last tile of the ticket.
+    /// @return false once every tile in the range has been handed out.
+    INLINE bool takeTileTicket(uint32_t numTiles, uint32_t& first, uint32_t& last)
+    {
+        // once the tickets run out, workers only read the counter
+        if ((uint32_t)mNextTicket >= numTiles)
+        {
+            return false;
+        }
 
+        first = (uint32_t)InterlockedExchangeAdd(&mNextTicket, TILES_PER_TICKET);
+        last = std::min(first + TILES_PER_TICKET, numTiles);
+        return first < numTiles;
+    }
+
+    void markWorkComplete(uint32_t numWorkItems);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns true if all queued work has been consumed. Only
+    ///        meaningful once the FE is done queuing work for the draw.
     INLINE bool isWorkComplete()
     {
         return mWorkItemsProduced == mWorkItemsConsumed;
@@ -131,6 +269,17 @@ public:
         x = (tileID >> 16) & 0xffff;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the NUMA node owning a macrotile, see KNOB_NUMA_TILE_AFFINITY.
+    ///        Tiles are interleaved diagonally so any screen region is spread
+    ///        evenly across the nodes.
+    static INLINE uint32_t getTileNumaNode(uint32_t tileID, uint32_t numNumaNodes)
+    {
+        uint32_t x, y;
+        getTileIndices(tileID, x, y);
+        return (x + y) % numNumaNodes;
+    }
+
     void *operator new(size_t size);
     void operator delete (void *p);
 
@@ -140,10 +289,14 @@ private:
     std::unordered_map<uint32_t, MacroTileQueue> mTiles;
 
     // Any tile that has work queued to it is a dirty tile.
-    std::vector<uint32_t> mDirtyTiles;
+    DirtyTileList mDirtyTiles;
 
-    OSALIGNLINE(LONG) mWorkItemsProduced;
+    // Bumped for each draw, tiles queued in an older generation are reset on first use.
+    uint32_t mGeneration = 0;
+
+    OSALIGNLINE(volatile LONG) mWorkItemsProduced;
     OSALIGNLINE(volatile LONG) mWorkItemsConsumed;
+    OSALIGNLINE(volatile LONG) mNextTicket;     // next dirty tile handed out by takeTileTicket
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -239,15 +392,79 @@ enum HOTTILE_STATE
     HOTTILE_RESOLVED,       // tile has been stored to memory
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// HIZ_TILE - coarse depth of a depth hottile, see KNOB_ENABLE_HIZ.
+/// Holds an upper bound of the depth of each raster tile and of the whole
+/// macrotile, over all samples. Maintained by the BE, which updates it on
+/// loads, clears and after every raster tile written with depth writes.
+/// The binner runs ahead of the BE and only trusts it if 'generation'
+/// matches the HiZ generation of its draw. Ops that may raise depth start
+/// a new generation, see StartHiZGeneration. A generation of 0 means the
+/// tile is being updated or doesn't describe the hottile contents.
+//////////////////////////////////////////////////////////////////////////
+struct HIZ_TILE
+{
+    float maxZ[KNOB_MACROTILE_Y_DIM_IN_TILES][KNOB_MACROTILE_X_DIM_IN_TILES];
+    float macroMaxZ;
+    uint32_t renderTargetArrayIndex;
+    volatile uint32_t generation;
+};
+
 struct HOTTILE
 {
     BYTE *pBuffer;
     HOTTILE_STATE state;
     DWORD clearData[4];                 // May need to change based on pfnClearTile implementation.  Reorder for alignment?
     uint32_t numSamples;
-    uint32_t renderTargetArrayIndex;    // current render target array index loaded
+    uint32_t renderTargetArrayIndex;    // render target array slice held
+    SWR_FORMAT format;                  // format of the data in pBuffer
+    uint32_t bufferSize;                // size of the allocation behind pBuffer
+    HIZ_TILE *pHiZ;                     // coarse depth, depth hottile only (KNOB_ENABLE_HIZ)
+    HOTTILE *pLruPrev;                  // eviction list links, see HotTileMgr::ReleaseHotTile
+    HOTTILE *pLruNext;
+    volatile bool evictable;            // on the eviction list, only set by the owning worker
+    HOTTILE *pNextLayer;                // hottile of another array slice of the same attachment, see KNOB_HOT_TILE_LAYERS
+    uint64_t lastUse;                   // macrotile use count at its last use, picks the slice to swap out
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the rasterizer keeps the HiZ up to date with the
+///        depth writes of the draw. Multisampled depth isn't tracked.
+INLINE bool HiZTracksDepthWrites(const API_STATE& state)
+{
+    return state.pRaster->rastState.sampleCount == SWR_MULTISAMPLE_1X;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if fragments behind the HiZ always fail the depth
+///        test of the draw, and can be dropped without side effects.
+INLINE bool CanHiZReject(const API_STATE& state)
+{
+    const SWR_DEPTH_STENCIL_STATE& dsState = state.pRaster->depthStencilState;
+    return state.depthHottileEnable &&
+           dsState.depthTestEnable &&
+           (dsState.depthTestFunc == ZFUNC_LT || dsState.depthTestFunc == ZFUNC_LE) &&
+           !dsState.stencilWriteEnable &&
+           !state.pShaders->psState.writesODepth &&
+           !state.pShaders->psState.usesUAV;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if a primitive whose depth is at least minZ fails
+///        the LT/LE depth test everywhere the HiZ bound is maxZ. Leaves
+///        some slack for the interpolation error of the backend.
+INLINE bool HiZOccluded(SWR_ZFUNCTION depthTestFunc, float minZ, float maxZ)
+{
+    minZ -= 1.0f / (1 << 16);
+    return (depthTestFunc == ZFUNC_LT) ? (minZ >= maxZ) : (minZ > maxZ);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// HotTileSet - hottiles of a macrotile. Each attachment is the first of a
+/// list of hottiles linked by pNextLayer, one per render target array slice
+/// held. Layers are only added to a list, and only by the BE worker owning
+/// the macrotile, so the binner may walk it at any time.
+//////////////////////////////////////////////////////////////////////////
 union HotTileSet
 {
     struct
@@ -265,14 +482,8 @@ public:
     HotTileMgr()
     {
         memset(&mHotTiles[0][0], 0, sizeof(mHotTiles));
-
-        // cache hottile size
-        for (uint32_t i = SWR_ATTACHMENT_COLOR0; i <= SWR_ATTACHMENT_COLOR7; ++i)
-        {
-            mHotTileSize[i] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8;
-        }
-        mHotTileSize[SWR_ATTACHMENT_DEPTH] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8;
-        mHotTileSize[SWR_ATTACHMENT_STENCIL] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_STENCIL_HOT_TILE_FORMAT>::bpp / 8;
+        memset(&mUseCount[0][0], 0, sizeof(mUseCount));
+        mBudget = (uint64_t)KNOB_HOT_TILE_BUDGET_MB * 1024 * 1024;
     }
 
     ~HotTileMgr()
@@ -283,16 +494,56 @@ public:
             {
                 for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
                 {
-                    if (mHotTiles[x][y].Attachment[a].pBuffer != NULL)
+                    HOTTILE* pHotTile = &mHotTiles[x][y].Attachment[a];
+                    while (pHotTile != nullptr)
                     {
-                        _aligned_free(mHotTiles[x][y].Attachment[a].pBuffer);
-                        mHotTiles[x][y].Attachment[a].pBuffer = NULL;
+                        HOTTILE* pNextLayer = pHotTile->pNextLayer;
+                        if (pHotTile->pBuffer != NULL)
+                        {
+                            UnmapHotTileMem(*pHotTile);
+                        }
+                        if (pHotTile->pHiZ != nullptr)
+                        {
+                            _aligned_free(pHotTile->pHiZ);
+                        }
+                        if (pHotTile != &mHotTiles[x][y].Attachment[a])
+                        {
+                            _aligned_free(pHotTile);
+                        }
+                        pHotTile = pNextLayer;
                     }
                 }
             }
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the hottile format the current draw uses for an attachment.
+    ///        Color hottiles may be kept in the render target format, see
+    ///        KNOB_NATIVE_COLOR_HOT_TILES.
+    static SWR_FORMAT GetHotTileFormat(DRAW_CONTEXT* pDC, SWR_RENDERTARGET_ATTACHMENT attachment)
+    {
+        switch (attachment)
+        {
+        case SWR_ATTACHMENT_COLOR0:
+        case SWR_ATTACHMENT_COLOR1:
+        case SWR_ATTACHMENT_COLOR2:
+        case SWR_ATTACHMENT_COLOR3:
+        case SWR_ATTACHMENT_COLOR4:
+        case SWR_ATTACHMENT_COLOR5:
+        case SWR_ATTACHMENT_COLOR6:
+        case SWR_ATTACHMENT_COLOR7: return pDC->pState->state.colorHotTileFormat[attachment];
+        case SWR_ATTACHMENT_DEPTH: return KNOB_DEPTH_HOT_TILE_FORMAT;
+        case SWR_ATTACHMENT_STENCIL: return KNOB_STENCIL_HOT_TILE_FORMAT;
+        default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); return KNOB_COLOR_HOT_TILE_FORMAT;
+        }
+    }
+
+    static uint32_t GetHotTileSize(SWR_FORMAT format, uint32_t numSamples)
+    {
+        return numSamples * KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * GetFormatInfo(format).Bpp;
+    }
+
     HOTTILE *GetHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment, bool create, uint32_t numSamples = 1, 
         uint32_t renderTargetArrayIndex = 0)
     {
@@ -302,17 +553,49 @@ public:
         assert(x < KNOB_NUM_HOT_TILES_X);
         assert(y < KNOB_NUM_HOT_TILES_Y);
 
-        HotTileSet &tile = mHotTiles[x][y];
-        HOTTILE& hotTile = tile.Attachment[attachment];
+        // find the hottile of the array slice, new slices need a layer first
+        HOTTILE* pHotTile = &mHotTiles[x][y].Attachment[attachment];
+        while (pHotTile != nullptr && pHotTile->renderTargetArrayIndex != renderTargetArrayIndex)
+        {
+            pHotTile = pHotTile->pNextLayer;
+        }
+
+        if (pHotTile == nullptr)
+        {
+            if (!create)
+            {
+                return NULL;
+            }
+            pHotTile = AddHotTileLayer(pContext, pDC, macroID, attachment, numSamples, renderTargetArrayIndex);
+        }
+
+        HOTTILE& hotTile = *pHotTile;
+        // layered draws switch slices within a draw, so count uses rather than draws
+        if (create)
+        {
+            hotTile.lastUse = ++mUseCount[x][y];
+        }
+
+        // take the tile back from the eviction list, it may have been evicted already
+        if (hotTile.evictable)
+        {
+            ClaimHotTile(hotTile);
+        }
+
         if (hotTile.pBuffer == NULL)
         {
             if (create)
             {
-                uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+                SWR_FORMAT format = GetHotTileFormat(pDC, attachment);
+                AllocHotTileMem(pContext, macroID, hotTile, GetHotTileSize(format, numSamples));
                 hotTile.state = HOTTILE_INVALID;
                 hotTile.numSamples = numSamples;
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+                hotTile.format = format;
+
+                if (KNOB_ENABLE_HIZ && attachment == SWR_ATTACHMENT_DEPTH && hotTile.pHiZ == nullptr)
+                {
+                    AllocHiZ(hotTile);
+                }
             }
             else
             {
@@ -321,6 +604,34 @@ public:
         }
         else
         {
+            // switch hottile format if the render target format changed; contents are
+            // flushed to the surface in the old format and reloaded in the new one
+            if (create)
+            {
+                SWR_FORMAT format = GetHotTileFormat(pDC, attachment);
+                if (format != hotTile.format)
+                {
+                    if (hotTile.state == HOTTILE_DIRTY)
+                    {
+                        pContext->pfnStoreTile(GetPrivateState(pDC), hotTile.format, attachment,
+                            x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, hotTile.renderTargetArrayIndex, hotTile.numSamples, hotTile.pBuffer);
+                    }
+
+                    if (GetHotTileSize(format, hotTile.numSamples) > hotTile.bufferSize)
+                    {
+                        FreeHotTileMem(hotTile);
+                        AllocHotTileMem(pContext, macroID, hotTile, GetHotTileSize(format, hotTile.numSamples));
+                    }
+
+                    // pending clears are stored as RGBA32_FLOAT and remain valid
+                    if (hotTile.state != HOTTILE_CLEAR)
+                    {
+                        hotTile.state = HOTTILE_INVALID;
+                    }
+                    hotTile.format = format;
+                }
+            }
+
             // free the old tile and create a new one with enough space to hold all samples
             if (numSamples > hotTile.numSamples)
             {
@@ -329,50 +640,122 @@ public:
                 assert((hotTile.state == HOTTILE_INVALID) ||
                        (hotTile.state == HOTTILE_RESOLVED) || 
                        (hotTile.state == HOTTILE_CLEAR));
-                _aligned_free(hotTile.pBuffer);
-
-                uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+                FreeHotTileMem(hotTile);
+                AllocHotTileMem(pContext, macroID, hotTile, GetHotTileSize(hotTile.format, numSamples));
                 hotTile.state = HOTTILE_INVALID;
                 hotTile.numSamples = numSamples;
+                InvalidateHiZ(hotTile);
             }
+        }
+        return pHotTile;
+    }
 
-            // if requested render target array index isn't currently loaded, need to store out the current hottile 
-            // and load the requested array slice
-            if (renderTargetArrayIndex != hotTile.renderTargetArrayIndex)
-            {
-                SWR_FORMAT format;
-                switch (attachment)
-                {
-                case SWR_ATTACHMENT_COLOR0:
-                case SWR_ATTACHMENT_COLOR1:
-                case SWR_ATTACHMENT_COLOR2:
-                case SWR_ATTACHMENT_COLOR3:
-                case SWR_ATTACHMENT_COLOR4:
-                case SWR_ATTACHMENT_COLOR5:
-                case SWR_ATTACHMENT_COLOR6:
-                case SWR_ATTACHMENT_COLOR7: format = KNOB_COLOR_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_DEPTH: format = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_STENCIL: format = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-                default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); format = KNOB_COLOR_HOT_TILE_FORMAT; break;
-                }
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the first hottile of an attachment of a macrotile, the
+    ///        hottiles of other array slices follow through pNextLayer. They
+    ///        are only safe to use once claimed with GetHotTile.
+    HOTTILE *GetHotTileLayers(uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(macroID, x, y);
+        assert(x < KNOB_NUM_HOT_TILES_X);
+        assert(y < KNOB_NUM_HOT_TILES_Y);
 
-                if (hotTile.state == HOTTILE_DIRTY)
-                {
-                    pContext->pfnStoreTile(GetPrivateState(pDC), format, attachment,
-                        x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, hotTile.renderTargetArrayIndex, hotTile.pBuffer);
-                }
+        return &mHotTiles[x][y].Attachment[attachment];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief HiZ maintenance, see HIZ_TILE. Only the BE worker owning the
+    ///        macrotile may call these; they are no-ops without a HiZ.
+    static void AllocHiZ(HOTTILE& hotTile);
+    static void InvalidateHiZ(HOTTILE& hotTile);
+    static void ClearHiZ(HOTTILE& hotTile, float depth, uint32_t generation);
+    static void UpdateHiZ(HOTTILE& hotTile, uint32_t numSamples, uint32_t generation);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Makes the HiZ valid for a new generation, tightening the
+    ///        macrotile bound. Contents must be unchanged since it was last
+    ///        valid, which holds for DIRTY and RESOLVED hottiles.
+    static void RefreshHiZ(HOTTILE& hotTile, uint32_t generation);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Recomputes the bound of a raster tile after the backend wrote
+    ///        depth to it.
+    /// @param x, y - raster tile within the macrotile
+    /// @param pDepth - depth hottile memory of the raster tile
+    static INLINE void UpdateHiZRasterTile(HIZ_TILE* pHiZ, uint32_t x, uint32_t y, const uint8_t* pDepth, uint32_t numSamples)
+    {
+        static_assert(KNOB_DEPTH_HOT_TILE_FORMAT == R32_FLOAT, "Unsupported depth hot tile format");
 
-                pContext->pfnLoadTile(GetPrivateState(pDC), format, attachment,
-                    x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, renderTargetArrayIndex, hotTile.pBuffer);
+        const float* pZ = (const float*)pDepth;
+        simdscalar vMaxZ = _simd_load_ps(pZ);
+        for (uint32_t i = KNOB_SIMD_WIDTH; i < KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * numSamples; i += KNOB_SIMD_WIDTH)
+        {
+            vMaxZ = _simd_max_ps(vMaxZ, _simd_load_ps(pZ + i));
+        }
+
+        OSALIGNSIMD(float) aMaxZ[KNOB_SIMD_WIDTH];
+        _simd_store_ps(aMaxZ, vMaxZ);
+        float maxZ = aMaxZ[0];
+        for (uint32_t i = 1; i < KNOB_SIMD_WIDTH; ++i)
+        {
+            maxZ = std::max(maxZ, aMaxZ[i]);
+        }
 
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
-                hotTile.state = HOTTILE_DIRTY;
+        pHiZ->maxZ[y][x] = maxZ;
+        if (maxZ > pHiZ->macroMaxZ)
+        {
+            pHiZ->macroMaxZ = maxZ;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the depth bound of a macrotile for the binner, or
+    ///        FLT_MAX if its HiZ can't be trusted by the draw.
+    /// @param x, y - macrotile
+    float GetHiZMaxZ(uint32_t x, uint32_t y, uint32_t generation, uint32_t renderTargetArrayIndex)
+    {
+        for (const HOTTILE* pHotTile = &mHotTiles[x][y].Depth; pHotTile != nullptr; pHotTile = pHotTile->pNextLayer)
+        {
+            const HIZ_TILE* pHiZ = pHotTile->pHiZ;
+            if (pHiZ == nullptr || pHiZ->generation != generation)
+            {
+                continue;
+            }
+
+            _ReadWriteBarrier();
+            float maxZ = pHiZ->macroMaxZ;
+            bool sameSlice = (pHiZ->renderTargetArrayIndex == renderTargetArrayIndex);
+            _ReadWriteBarrier();
+
+            // the BE may have started updating it meanwhile
+            if (sameSlice && pHiZ->generation == generation)
+            {
+                return maxZ;
             }
         }
-        return &tile.Attachment[attachment];
+        return FLT_MAX;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Allocate backing memory for a hot tile. With macrotile NUMA
+    ///        affinity the memory comes from the node that owns the tile.
+    ///        Over KNOB_HOT_TILE_BUDGET_MB, evictable tiles are evicted first
+    ///        and a large enough buffer of theirs is reused. Without 'evict',
+    ///        nothing is allocated and false is returned instead.
+    bool AllocHotTileMem(SWR_CONTEXT* pContext, uint32_t macroID, HOTTILE& hotTile, uint32_t size, bool evict = true);
+    void FreeHotTileMem(HOTTILE& hotTile);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Puts a RESOLVED or INVALID hottile on the eviction list, least
+    ///        recently released tiles are evicted first. Its owner takes it
+    ///        back on the next GetHotTile. Only used with a hot tile budget.
+    void ReleaseHotTile(HOTTILE& hotTile);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Fills in the hot tile pool stats of a query.
+    void GetPoolStats(SWR_STATS& stats);
+
     HotTileSet &GetHotTile(uint32_t macroID)
     {
         uint32_t x, y;
@@ -384,7 +767,28 @@ public:
     }
 
 private:
+    static void MapHotTileMem(SWR_CONTEXT* pContext, uint32_t macroID, HOTTILE& hotTile, uint32_t size);
+    static void UnmapHotTileMem(HOTTILE& hotTile);
+
+    void ClaimHotTile(HOTTILE& hotTile);
+    void UnlinkHotTile(HOTTILE& hotTile);
+
+    HOTTILE* AddHotTileLayer(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment,
+        uint32_t numSamples, uint32_t renderTargetArrayIndex);
+
     HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
-    uint32_t mHotTileSize[SWR_NUM_ATTACHMENTS];
+    uint64_t mUseCount[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];    // hottile uses per macrotile, by its BE worker
+
+    // Hot tile pool, guards the eviction list and counters. Buffers are only
+    // allocated, freed or evicted with it held.
+    std::mutex mPoolLock;
+    HOTTILE* mpLruHead = nullptr;       // least recently released
+    HOTTILE* mpLruTail = nullptr;
+    uint64_t mBudget;                   // 0 for no budget
+    uint64_t mHotTileBytes = 0;
+    uint64_t mHotTileBytesPeak = 0;
+    uint64_t mNumEvictions = 0;
+    uint64_t mNumReuses = 0;
+    uint64_t mNumLayerSwaps = 0;
 };
 
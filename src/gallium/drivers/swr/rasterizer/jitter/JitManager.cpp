@@ -42,6 +42,7 @@
 #include "llvm/Support/DynamicLibrary.h"
 
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 
 #include "llvm/Analysis/CFGPrinter.h"
@@ -53,6 +54,7 @@
 #include "state_llvm.h"
 
 #include <sstream>
+#include <iomanip>
 #if defined(_WIN32)
 #include <psapi.h>
 #include <cstring>
@@ -60,15 +62,207 @@
 #define INTEL_OUTPUT_DIR "c:\\Intel"
 #define SWR_OUTPUT_DIR INTEL_OUTPUT_DIR "\\SWR"
 #define JITTER_OUTPUT_DIR SWR_OUTPUT_DIR "\\Jitter"
+#else
+#include <dlfcn.h>
 #endif
 
 using namespace llvm;
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Identifies the build of the library the jitter lives in, so
+///        objects cached by a different build are never reused.
+static std::string GetBuildId()
+{
+    std::string fileName;
+#if defined(_WIN32)
+    HMODULE hModule = nullptr;
+    char moduleName[MAX_PATH];
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (LPCSTR)&GetBuildId, &hModule) &&
+        GetModuleFileNameA(hModule, moduleName, MAX_PATH))
+    {
+        fileName = moduleName;
+    }
+#else
+    Dl_info info;
+    if (dladdr((void*)&GetBuildId, &info) && info.dli_fname)
+    {
+        fileName = info.dli_fname;
+    }
+#endif
+
+    std::stringstream buildId;
+    sys::fs::file_status status;
+    if (!fileName.empty() && !sys::fs::status(fileName, status))
+    {
+        buildId << fileName << " " << status.getLastModificationTime().toEpochTime() << " " << status.getSize();
+    }
+    else
+    {
+        buildId << __DATE__ " " __TIME__;
+    }
+    return buildId.str();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// JitCacheHeader
+/// @brief Header of a cache file.  Followed by the full key and the object.
+struct JitCacheHeader
+{
+    uint32_t magic;
+    uint32_t keySize;
+    uint64_t objectSize;
+};
+
+static const uint32_t JIT_CACHE_MAGIC = 0x4a525753; // "SWRJ"
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Constructor for JitCache.
+/// @param dir - directory holding the cache files.
+/// @param identity - everything outside of the keys that affects codegen.
+JitCache::JitCache(const std::string& dir, const std::string& identity)
+    : mDir(dir), mIdentity(identity)
+{
+    sys::fs::create_directories(mDir);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the key including the cache identity.
+std::string JitCache::GetFullKey(const JitCacheKey& key) const
+{
+    std::string fullKey = mIdentity;
+    fullKey.push_back('\0');
+    fullKey += key.mName;
+    fullKey.push_back('\0');
+    fullKey += key.mData;
+    return fullKey;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the name of the function and module cached for key.
+///        The name is the same in every process that uses the same key.
+std::string JitCache::GetFuncName(const JitCacheKey& key) const
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : GetFullKey(key))
+    {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    std::stringstream funcName;
+    funcName << key.mName << "_" << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return funcName.str();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the cache file for a function.
+std::string JitCache::GetFileName(const std::string& funcName) const
+{
+    SmallString<256> fileName(mDir);
+    sys::path::append(fileName, funcName + ".o");
+    return std::string(fileName.str());
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Looks up the object for key and holds on to it until MCJIT asks
+///        for it.  On a miss the object is written to the cache once MCJIT
+///        has compiled it.
+/// @return true if the object was found.
+bool JitCache::Load(const JitCacheKey& key)
+{
+    std::string fullKey = GetFullKey(key);
+
+    auto file = MemoryBuffer::getFile(GetFileName(key.mFuncName));
+    if (file)
+    {
+        StringRef contents = (*file)->getBuffer();
+        JitCacheHeader header;
+        if (contents.size() >= sizeof(header))
+        {
+            memcpy(&header, contents.data(), sizeof(header));
+            if (header.magic == JIT_CACHE_MAGIC &&
+                header.keySize == fullKey.size() &&
+                contents.size() == sizeof(header) + header.keySize + header.objectSize &&
+                contents.substr(sizeof(header), header.keySize) == fullKey)
+            {
+                mLoadedObjects[key.mFuncName] = MemoryBuffer::getMemBufferCopy(
+                    contents.substr(sizeof(header) + header.keySize), key.mFuncName);
+                return true;
+            }
+        }
+    }
+
+    mPendingKeys[key.mFuncName] = fullKey;
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Called by MCJIT after compiling a module.  Writes the object to
+///        a temporary file which is then renamed, so concurrent processes
+///        never see partial files.
+void JitCache::notifyObjectCompiled(const Module* M, MemoryBufferRef Obj)
+{
+    auto pending = mPendingKeys.find(M->getModuleIdentifier());
+    if (pending == mPendingKeys.end())
+    {
+        return;
+    }
+
+    const std::string& fullKey = pending->second;
+    std::string fileName = GetFileName(pending->first);
+
+    int fd;
+    SmallString<256> tmpFileName;
+    if (!sys::fs::createUniqueFile(fileName + "-%%%%%%.tmp", fd, tmpFileName))
+    {
+        JitCacheHeader header;
+        header.magic = JIT_CACHE_MAGIC;
+        header.keySize = (uint32_t)fullKey.size();
+        header.objectSize = Obj.getBufferSize();
+
+        bool written;
+        {
+            raw_fd_ostream out(fd, true);
+            out.write((const char*)&header, sizeof(header));
+            out << fullKey;
+            out << Obj.getBuffer();
+            out.close();
+            written = !out.has_error();
+            out.clear_error();
+        }
+
+        if (!written || sys::fs::rename(tmpFileName, fileName))
+        {
+            sys::fs::remove(tmpFileName);
+        }
+    }
+
+    mPendingKeys.erase(pending);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Called by MCJIT before compiling a module.  Returning an object
+///        skips codegen for the module.
+std::unique_ptr<MemoryBuffer> JitCache::getObject(const Module* M)
+{
+    auto loaded = mLoadedObjects.find(M->getModuleIdentifier());
+    if (loaded == mLoadedObjects.end())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<MemoryBuffer> pObject = std::move(loaded->second);
+    mLoadedObjects.erase(loaded);
+    return pObject;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Contructor for JitManager.
 /// @param simdWidth - SIMD width to be used in generated program.
 JitManager::JitManager(uint32_t simdWidth, const char *arch)
-    : mContext(), mBuilder(mContext), mIsModuleFinalized(true), mJitNumber(0), mVWidth(simdWidth), mArch(arch)
+    : mContext(), mBuilder(mContext), mpCache(nullptr), mIsModuleFinalized(true), mJitNumber(0), mVWidth(simdWidth), mArch(arch)
 {
     InitializeNativeTarget();
     InitializeNativeTargetAsmPrinter();
@@ -101,8 +295,9 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
     // force JIT to use the same CPU arch as the rest of swr
     if(mArch.AVX512F())
     {
-        assert(0 && "Implement AVX512 jitter");
-        hostCPUName = sys::getHostCPUName();
+        // Skylake-SP.  Jitted code keeps the requested simd width, so the
+        // 8 wide shader interfaces still match the rest of swr.
+        hostCPUName = StringRef("skx");
         if (mVWidth == 0)
         {
             mVWidth = 16;
@@ -151,6 +346,15 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
 
     mpExec = EB.create();
 
+    if (!KNOB_JIT_CACHE_DIR.empty())
+    {
+        std::stringstream identity;
+        identity << GetBuildId() << " LLVM " << LLVM_VERSION_MAJOR << "." << LLVM_VERSION_MINOR << " "
+                 << sys::getProcessTriple() << " " << hostCPUName.str() << " " << mVWidth;
+        mpCache = new JitCache(KNOB_JIT_CACHE_DIR, identity.str());
+        mpExec->setObjectCache(mpCache);
+    }
+
 #if LLVM_USE_INTEL_JITEVENTS
     JITEventListener *vTune = JITEventListener::createIntelJITEventListener();
     mpExec->RegisterJITEventListener(vTune);
@@ -252,6 +456,48 @@ bool JitManager::SetupModuleFromIR(const uint8_t *pIR)
     return true;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Names the current module after key so its object can be cached
+///        on disk.  Must be called right after SetupNewModule.
+/// @return true if the object is already cached.  The function can then
+///         be created with CreateCachedFunction instead of building IR.
+bool JitManager::SetupCachedModule(JitCacheKey& key)
+{
+    if (mpCache == nullptr)
+    {
+        return false;
+    }
+
+    key.mFuncName = mpCache->GetFuncName(key);
+    mpCurrentModule->setModuleIdentifier(key.mFuncName);
+
+    return mpCache->Load(key);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Creates a placeholder for a function whose object is cached.
+///        MCJIT only needs a definition to know which module to compile,
+///        the cached object replaces its code and signature.
+Function* JitManager::CreateCachedFunction(const JitCacheKey& key)
+{
+    FunctionType* pFuncTy = FunctionType::get(Type::getVoidTy(mContext), false);
+    Function* pFunc = Function::Create(pFuncTy, GlobalValue::ExternalLinkage, key.mFuncName, mpCurrentModule);
+    BasicBlock* pBlock = BasicBlock::Create(mContext, "entry", pFunc);
+    new UnreachableInst(mContext, pBlock);
+    return pFunc;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Renames a newly built function so its name in the cached object
+///        does not depend on the order functions were compiled in.
+void JitManager::NameCachedFunction(const JitCacheKey& key, Function* pFunc)
+{
+    if (mpCache != nullptr)
+    {
+        pFunc->setName(key.mFuncName);
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Dump function to file.
 void JitManager::DumpToFile(Function *f, const char *fileName)
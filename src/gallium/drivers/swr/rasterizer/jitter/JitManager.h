@@ -69,6 +69,8 @@ using namespace llvm::legacy;
 
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Transforms/IPO.h"
@@ -78,6 +80,8 @@ using namespace llvm::legacy;
 
 #pragma pop_macro("DEBUG")
 
+#include <unordered_map>
+
 using namespace llvm;
 //////////////////////////////////////////////////////////////////////////
 /// JitInstructionSet
@@ -105,14 +109,12 @@ public:
             bForceAVX2 = true;
             bForceAVX512 = false;
         }
-        #if 0
         else if(isaRequest == "avx512")
         {
             bForceAVX = false;
             bForceAVX2 = false;
             bForceAVX512 = true;
         }
-        #endif
     };
 
     bool AVX2(void) { return bForceAVX ? 0 : InstructionSet::AVX2(); }
@@ -132,6 +134,56 @@ struct JitLLVMContext : LLVMContext
 {
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// JitCacheKey
+/// @brief Raw bytes of all the state a jitted function is generated from.
+/// Two functions with the same key must generate identical code.
+//////////////////////////////////////////////////////////////////////////
+struct JitCacheKey
+{
+    JitCacheKey(const char* pName) : mName(pName) {}
+
+    void Add(const void* pData, size_t size) { mData.append((const char*)pData, size); }
+
+    template <typename T>
+    void Add(const T& value) { Add(&value, sizeof(T)); }
+
+    std::string mName;      ///< function name prefix, e.g. "FetchShader"
+    std::string mData;      ///< key bytes
+    std::string mFuncName;  ///< unique function name, set by JitManager::SetupCachedModule
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// JitCache
+/// @brief On-disk cache of MCJIT objects.  Each cached module is named
+/// after the hash of its key, and the file stores the full key so hash
+/// collisions and objects from other builds, LLVM versions or CPUs are
+/// treated as misses.
+//////////////////////////////////////////////////////////////////////////
+class JitCache : public ObjectCache
+{
+public:
+    JitCache(const std::string& dir, const std::string& identity);
+
+    std::string GetFuncName(const JitCacheKey& key) const;
+    bool Load(const JitCacheKey& key);
+
+    void notifyObjectCompiled(const Module* M, MemoryBufferRef Obj) override;
+    std::unique_ptr<MemoryBuffer> getObject(const Module* M) override;
+
+private:
+    std::string GetFullKey(const JitCacheKey& key) const;
+    std::string GetFileName(const std::string& funcName) const;
+
+    std::string mDir;
+    std::string mIdentity;  ///< driver build, LLVM version and target cpu
+
+    // full keys of modules waiting on codegen, and objects loaded for
+    // modules waiting on MCJIT to ask for them, by module identifier
+    std::unordered_map<std::string, std::string> mPendingKeys;
+    std::unordered_map<std::string, std::unique_ptr<MemoryBuffer>> mLoadedObjects;
+};
+
 
 //////////////////////////////////////////////////////////////////////////
 /// JitManager
@@ -139,11 +191,12 @@ struct JitLLVMContext : LLVMContext
 struct JitManager
 {
     JitManager(uint32_t w, const char *arch);
-    ~JitManager(){};
+    ~JitManager(){ delete mpCache; };
 
     JitLLVMContext          mContext;   ///< LLVM compiler
     IRBuilder<>             mBuilder;   ///< LLVM IR Builder
     ExecutionEngine*        mpExec;
+    JitCache*               mpCache;    ///< null unless KNOB_JIT_CACHE_DIR is set
 
     // Need to be rebuilt after a JIT and before building new IR
     Module* mpCurrentModule;
@@ -182,5 +235,9 @@ struct JitManager
     void SetupNewModule();
     bool SetupModuleFromIR(const uint8_t *pIR);
 
+    bool SetupCachedModule(JitCacheKey& key);
+    Function* CreateCachedFunction(const JitCacheKey& key);
+    void NameCachedFunction(const JitCacheKey& key, Function* pFunc);
+
     static void DumpToFile(Function *f, const char *fileName);
 };
@@ -29,6 +29,7 @@
 ******************************************************************************/
 #include "jit_api.h"
 #include "blend_jit.h"
+#include "core/rdtsc_core.h"
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
@@ -761,12 +762,29 @@ PFN_BLEND_JIT_FUNC JitBlendFunc(HANDLE hJitMgr, const HANDLE hFunc)
 /// @param state   - blend state to build function from
 extern "C" PFN_BLEND_JIT_FUNC JITCALL JitCompileBlend(HANDLE hJitMgr, const BLEND_COMPILE_STATE& state)
 {
+    RDTSC_START(JITCompileBlend);
+
     JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
 
     pJitMgr->SetupNewModule();
 
-    BlendJit theJit(pJitMgr);
-    HANDLE hFunc = theJit.Create(state);
+    JitCacheKey key("BlendShader");
+    key.Add(state);
+
+    HANDLE hFunc;
+    if (pJitMgr->SetupCachedModule(key))
+    {
+        hFunc = pJitMgr->CreateCachedFunction(key);
+    }
+    else
+    {
+        BlendJit theJit(pJitMgr);
+        hFunc = theJit.Create(state);
+        pJitMgr->NameCachedFunction(key, (Function*)hFunc);
+    }
+
+    PFN_BLEND_JIT_FUNC pfn = JitBlendFunc(hJitMgr, hFunc);
+    RDTSC_STOP(JITCompileBlend, 1, 0);
 
-    return JitBlendFunc(hJitMgr, hFunc);
+    return pfn;
 }
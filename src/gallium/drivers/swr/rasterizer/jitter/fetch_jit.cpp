@@ -29,6 +29,7 @@
 ******************************************************************************/
 #include "jit_api.h"
 #include "fetch_jit.h"
+#include "core/rdtsc_core.h"
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
@@ -1420,12 +1421,39 @@ PFN_FETCH_FUNC JitFetchFunc(HANDLE hJitMgr, const HANDLE hFunc)
 /// @param state   - fetch state to build function from
 extern "C" PFN_FETCH_FUNC JITCALL JitCompileFetch(HANDLE hJitMgr, const FETCH_COMPILE_STATE& state)
 {
+    RDTSC_START(JITCompileFetch);
+
     JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
 
     pJitMgr->SetupNewModule();
 
-    FetchJit theJit(pJitMgr);
-    HANDLE hFunc = theJit.Create(state);
+    JitCacheKey key("FetchShader");
+    key.Add(state.numAttribs);
+    for (uint32_t i = 0; i < state.numAttribs; ++i)
+    {
+        key.Add(state.layout[i].bits);
+        key.Add(state.layout[i].InstanceDataStepRate);
+    }
+    key.Add(state.indexType);
+    key.Add(state.cutIndex);
+    key.Add(state.bDisableVGATHER);
+    key.Add(state.bDisableIndexOOBCheck);
+    key.Add(state.bEnableCutIndex);
+
+    HANDLE hFunc;
+    if (pJitMgr->SetupCachedModule(key))
+    {
+        hFunc = pJitMgr->CreateCachedFunction(key);
+    }
+    else
+    {
+        FetchJit theJit(pJitMgr);
+        hFunc = theJit.Create(state);
+        pJitMgr->NameCachedFunction(key, (Function*)hFunc);
+    }
+
+    PFN_FETCH_FUNC pfn = JitFetchFunc(hJitMgr, hFunc);
+    RDTSC_STOP(JITCompileFetch, 1, 0);
 
-    return JitFetchFunc(hJitMgr, hFunc);
+    return pfn;
 }
@@ -29,6 +29,7 @@
 ******************************************************************************/
 #include "jit_api.h"
 #include "streamout_jit.h"
+#include "core/rdtsc_core.h"
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
@@ -337,6 +338,8 @@ PFN_SO_FUNC JitStreamoutFunc(HANDLE hJitMgr, const HANDLE hFunc)
 /// @param state   - SO state to build function from
 extern "C" PFN_SO_FUNC JITCALL JitCompileStreamout(HANDLE hJitMgr, const STREAMOUT_COMPILE_STATE& state)
 {
+    RDTSC_START(JITCompileStreamout);
+
     JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
 
     STREAMOUT_COMPILE_STATE soState = state;
@@ -350,8 +353,31 @@ extern "C" PFN_SO_FUNC JITCALL JitCompileStreamout(HANDLE hJitMgr, const STREAMO
 
     pJitMgr->SetupNewModule();
 
-    StreamOutJit theJit(pJitMgr);
-    HANDLE hFunc = theJit.Create(soState);
+    JitCacheKey key("SOShader");
+    key.Add(soState.numVertsPerPrim);
+    key.Add(soState.stream.numDecls);
+    for (uint32_t i = 0; i < soState.stream.numDecls; ++i)
+    {
+        key.Add(soState.stream.decl[i].bufferIndex);
+        key.Add(soState.stream.decl[i].attribSlot);
+        key.Add(soState.stream.decl[i].componentMask);
+        key.Add(soState.stream.decl[i].hole);
+    }
+
+    HANDLE hFunc;
+    if (pJitMgr->SetupCachedModule(key))
+    {
+        hFunc = pJitMgr->CreateCachedFunction(key);
+    }
+    else
+    {
+        StreamOutJit theJit(pJitMgr);
+        hFunc = theJit.Create(soState);
+        pJitMgr->NameCachedFunction(key, (Function*)hFunc);
+    }
+
+    PFN_SO_FUNC pfn = JitStreamoutFunc(hJitMgr, hFunc);
+    RDTSC_STOP(JITCompileStreamout, 1, 0);
 
-    return JitStreamoutFunc(hJitMgr, hFunc);
+    return pfn;
 }
@@ -44,6 +44,11 @@ static PFN_LOAD_TILES sLoadTilesDepthTable_SWR_TILE_NONE[NUM_SWR_FORMATS];
 static PFN_LOAD_TILES sLoadTilesColorTable_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
 static PFN_LOAD_TILES sLoadTilesColorTable_SWR_TILE_MODE_XMAJOR[NUM_SWR_FORMATS];
 
+// color hot tiles kept in the render target format
+static PFN_LOAD_TILES sLoadTilesColorNativeTable_SWR_TILE_NONE[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorNativeTable_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorNativeTable_SWR_TILE_MODE_XMAJOR[NUM_SWR_FORMATS];
+
 static PFN_LOAD_TILES sLoadTilesDepthTable_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
 
 //////////////////////////////////////////////////////////////////////////
@@ -52,31 +57,6 @@ static PFN_LOAD_TILES sLoadTilesDepthTable_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS]
 template<typename TTraits, SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat>
 struct LoadRasterTile
 {
-    //////////////////////////////////////////////////////////////////////////
-    /// @brief Retrieve color from hot tile source which is always float.
-    /// @param pSrc - Pointer to raster tile.
-    /// @param x, y - Coordinates to raster tile.
-    /// @param output - output color
-    INLINE static void SetSwizzledDstColor(
-        const float srcColor[4],
-        uint32_t x, uint32_t y,
-        uint8_t* pDst)
-    {
-        typedef SimdTile<DstFormat, SrcFormat> SimdT;
-
-        SimdT* pDstSimdTiles = (SimdT*)pDst;
-
-        // Compute which simd tile we're accessing within 8x8 tile.
-        //   i.e. Compute linear simd tile coordinate given (x, y) in pixel coordinates.
-        uint32_t simdIndex = (y / SIMD_TILE_Y_DIM) * (KNOB_TILE_X_DIM / SIMD_TILE_X_DIM) + (x / SIMD_TILE_X_DIM);
-
-        SimdT* pSimdTile = &pDstSimdTiles[simdIndex];
-
-        uint32_t simdOffset = (y % SIMD_TILE_Y_DIM) * SIMD_TILE_X_DIM + (x % SIMD_TILE_X_DIM);
-
-        pSimdTile->SetSwizzledColor(simdOffset, srcColor);
-    }
-
     //////////////////////////////////////////////////////////////////////////
     /// @brief Loads an 8x8 raster tile from the src surface.
     /// @param pSrcSurface - Src surface state
@@ -90,24 +70,37 @@ struct LoadRasterTile
         uint32_t lodWidth = (pSrcSurface->width == 1) ? 1 : pSrcSurface->width >> pSrcSurface->lod;
         uint32_t lodHeight = (pSrcSurface->height == 1) ? 1 : pSrcSurface->height >> pSrcSurface->lod;
 
-        // For each raster tile pixel (rx, ry)
-        for (uint32_t ry = 0; ry < KNOB_TILE_Y_DIM; ++ry)
+        typedef SimdTile<DstFormat, SrcFormat> SimdT;
+        SimdT* pDstSimdTile = (SimdT*)pDst;
+
+        // For each simd tile (sx, sy), in the order they are laid out in the raster tile
+        for (uint32_t sy = 0; sy < KNOB_TILE_Y_DIM; sy += SIMD_TILE_Y_DIM)
         {
-            for (uint32_t rx = 0; rx < KNOB_TILE_X_DIM; ++rx)
+            for (uint32_t sx = 0; sx < KNOB_TILE_X_DIM; sx += SIMD_TILE_X_DIM)
             {
-                if (((x + rx) < lodWidth) &&
-                    ((y + ry) < lodHeight))
+                // pixels outside the surface are cleared
+                float srcColors[KNOB_SIMD_WIDTH][4] = {};
+
+                // For each simd tile pixel (rx, ry)
+                for (uint32_t simdOffset = 0; simdOffset < KNOB_SIMD_WIDTH; ++simdOffset)
                 {
-                    uint8_t* pSrc = (uint8_t*)ComputeSurfaceAddress<false>(x + rx, y + ry, pSrcSurface->arrayIndex + renderTargetArrayIndex,
-                                                                           pSrcSurface->arrayIndex + renderTargetArrayIndex, sampleNum, 
-                                                                           pSrcSurface->lod, pSrcSurface);
+                    uint32_t rx = sx + simdOffset % SIMD_TILE_X_DIM;
+                    uint32_t ry = sy + simdOffset / SIMD_TILE_X_DIM;
 
-                    float srcColor[4];
-                    ConvertPixelToFloat<SrcFormat>(srcColor, pSrc);
+                    if (((x + rx) < lodWidth) &&
+                        ((y + ry) < lodHeight))
+                    {
+                        uint8_t* pSrc = (uint8_t*)ComputeSurfaceAddress<false>(x + rx, y + ry, pSrcSurface->arrayIndex + renderTargetArrayIndex,
+                                                                               pSrcSurface->arrayIndex + renderTargetArrayIndex, sampleNum, 
+                                                                               pSrcSurface->lod, pSrcSurface);
 
-                    // store pixel to hottile
-                    SetSwizzledDstColor(srcColor, rx, ry, pDst);
+                        ConvertPixelToFloat<SrcFormat>(srcColors[simdOffset], pSrc);
+                    }
                 }
+
+                // store simd tile to hottile
+                pDstSimdTile->SetSwizzledColors(srcColors);
+                pDstSimdTile++;
             }
         }
     }
@@ -145,18 +138,20 @@ struct LoadMacroTile
     }
 };
 
-static void BUCKETS_START(UINT id)
+static void BUCKETS_START(int32_t id)
 {
-#ifdef KNOB_ENABLE_RDTSC
-    gBucketMgr.StartBucket(id);
-#endif
+    if (id != -1)
+    {
+        gBucketMgr.StartBucket(id);
+    }
 }
 
-static void BUCKETS_STOP(UINT id)
+static void BUCKETS_STOP(int32_t id)
 {
-#ifdef KNOB_ENABLE_RDTSC
-    gBucketMgr.StopBucket(id);
-#endif
+    if (id != -1)
+    {
+        gBucketMgr.StopBucket(id);
+    }
 }
 
 // on demand buckets for load tiles
@@ -191,7 +186,27 @@ void LoadHotTile(
         renderTargetArrayIndex = 0;
     }
 
-    if (renderTargetIndex < SWR_ATTACHMENT_DEPTH)
+    if ((renderTargetIndex < SWR_ATTACHMENT_DEPTH) && (dstFormat != KNOB_COLOR_HOT_TILE_FORMAT))
+    {
+        // hot tile is kept in the render target format
+        SWR_ASSERT(dstFormat == pSrcSurface->format, "Hot tile / render target format mismatch");
+        switch (pSrcSurface->tileMode)
+        {
+        case SWR_TILE_NONE:
+            pfnLoadTiles = sLoadTilesColorNativeTable_SWR_TILE_NONE[dstFormat];
+            break;
+        case SWR_TILE_MODE_YMAJOR:
+            pfnLoadTiles = sLoadTilesColorNativeTable_SWR_TILE_MODE_YMAJOR[dstFormat];
+            break;
+        case SWR_TILE_MODE_XMAJOR:
+            pfnLoadTiles = sLoadTilesColorNativeTable_SWR_TILE_MODE_XMAJOR[dstFormat];
+            break;
+        default:
+            SWR_ASSERT(0, "Unsupported tiling mode");
+            break;
+        }
+    }
+    else if (renderTargetIndex < SWR_ATTACHMENT_DEPTH)
     {
         switch (pSrcSurface->tileMode)
         {
@@ -254,8 +269,8 @@ void LoadHotTile(
     }
 
     // Load a macro tile.
-#ifdef KNOB_ENABLE_RDTSC
-    if (sBuckets[pSrcSurface->format] == -1)
+    // per format buckets are registered the first time they are captured
+    if (gBucketMgr.IsCapturing() && sBuckets[pSrcSurface->format] == -1)
     {
         // guard sBuckets update since storetiles is called by multiple threads
         sBucketMutex.lock();
@@ -267,11 +282,11 @@ void LoadHotTile(
         }
         sBucketMutex.unlock();
     }
-#endif
 
-    BUCKETS_START(sBuckets[pSrcSurface->format]);
+    int32_t bucket = sBuckets[pSrcSurface->format];
+    BUCKETS_START(bucket);
     pfnLoadTiles(pSrcSurface, pDstHotTile, x, y, renderTargetArrayIndex);
-    BUCKETS_STOP(sBuckets[pSrcSurface->format]);
+    BUCKETS_STOP(bucket);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -373,6 +388,16 @@ void LoadHotTile(
     sLoadTilesColorTable_##tilemode[R8G8B8_UINT]      = LoadMacroTile<TilingTraits<tilemode, 24>, R8G8B8_UINT, R32G32B32A32_FLOAT>::Load; \
     sLoadTilesColorTable_##tilemode[R8G8B8_SINT]      = LoadMacroTile<TilingTraits<tilemode, 24>, R8G8B8_SINT, R32G32B32A32_FLOAT>::Load; \
 
+//////////////////////////////////////////////////////////////////////////
+/// INIT_LOAD_TILES_COLOR_NATIVE_TABLE - Helper macro for setting up the
+/// tables for color hot tiles kept in the render target format.
+#define INIT_LOAD_TILES_COLOR_NATIVE_TABLE(tilemode) \
+    memset(sLoadTilesColorNativeTable_##tilemode, 0, sizeof(sLoadTilesColorNativeTable_##tilemode)); \
+    \
+    sLoadTilesColorNativeTable_##tilemode[R16G16B16A16_FLOAT] = LoadMacroTile<TilingTraits<tilemode, 64>, R16G16B16A16_FLOAT, R16G16B16A16_FLOAT>::Load; \
+    sLoadTilesColorNativeTable_##tilemode[B8G8R8A8_UNORM] = LoadMacroTile<TilingTraits<tilemode, 32>, B8G8R8A8_UNORM, B8G8R8A8_UNORM>::Load; \
+    sLoadTilesColorNativeTable_##tilemode[R8G8B8A8_UNORM] = LoadMacroTile<TilingTraits<tilemode, 32>, R8G8B8A8_UNORM, R8G8B8A8_UNORM>::Load; \
+
 //////////////////////////////////////////////////////////////////////////
 /// INIT_LOAD_TILES_TABLE - Helper macro for setting up the tables.
 #define INIT_LOAD_TILES_DEPTH_TABLE(tilemode) \
@@ -387,10 +412,13 @@ void LoadHotTile(
 void InitSimLoadTilesTable()
 {
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_NONE);
+    INIT_LOAD_TILES_COLOR_NATIVE_TABLE(SWR_TILE_NONE);
     INIT_LOAD_TILES_DEPTH_TABLE(SWR_TILE_NONE);
 
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_MODE_YMAJOR);
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_MODE_XMAJOR);
+    INIT_LOAD_TILES_COLOR_NATIVE_TABLE(SWR_TILE_MODE_YMAJOR);
+    INIT_LOAD_TILES_COLOR_NATIVE_TABLE(SWR_TILE_MODE_XMAJOR);
 
     INIT_LOAD_TILES_DEPTH_TABLE(SWR_TILE_MODE_YMAJOR);
 }
@@ -39,12 +39,13 @@
 #include <array>
 #include <sstream>
 
-typedef void(*PFN_STORE_TILES)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t);
+typedef void(*PFN_STORE_TILES)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t, uint32_t);
 
 //////////////////////////////////////////////////////////////////////////
 /// Store Raster Tile Function Tables.
 //////////////////////////////////////////////////////////////////////////
 static PFN_STORE_TILES sStoreTilesTableColor[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
+static PFN_STORE_TILES sStoreTilesTableColorNative[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 static PFN_STORE_TILES sStoreTilesTableDepth[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 static PFN_STORE_TILES sStoreTilesTableStencil[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 
@@ -454,7 +455,7 @@ INLINE static void FlatConvert(const uint8_t* pSrc, uint8_t* pDst, uint8_t* pDst
     __m256i final = _mm256_castsi128_si256(vRow00);
     final = _mm256_insertf128_si256(final, vRow10, 1);
 
-#elif KNOB_ARCH == KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
 
     // logic is as above, only wider
     src1 = _mm256_slli_si256(src1, 1);
@@ -542,7 +543,7 @@ INLINE static void FlatConvertNoAlpha(const uint8_t* pSrc, uint8_t* pDst, uint8_
     __m256i final = _mm256_castsi128_si256(vRow00);
     final = _mm256_insertf128_si256(final, vRow10, 1);
 
-#elif KNOB_ARCH == KNOB_ARCH_AVX2
+#elif KNOB_ARCH >= KNOB_ARCH_AVX2
 
                                               // logic is as above, only wider
     src1 = _mm256_slli_si256(src1, 1);
@@ -646,31 +647,6 @@ struct ConvertPixelsSOAtoAOS < R32G32B32A32_FLOAT, R8G8B8X8_UNORM_SRGB >
 template<typename TTraits, SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat>
 struct StoreRasterTile
 {
-    //////////////////////////////////////////////////////////////////////////
-    /// @brief Retrieve color from hot tile source which is always float.
-    /// @param pSrc - Pointer to raster tile.
-    /// @param x, y - Coordinates to raster tile.
-    /// @param output - output color
-    INLINE static void GetSwizzledSrcColor(
-        uint8_t* pSrc,
-        uint32_t x, uint32_t y,
-        float outputColor[4])
-    {
-        typedef SimdTile<SrcFormat, DstFormat> SimdT;
-
-        SimdT* pSrcSimdTiles = (SimdT*)pSrc;
-
-        // Compute which simd tile we're accessing within 8x8 tile.
-        //   i.e. Compute linear simd tile coordinate given (x, y) in pixel coordinates.
-        uint32_t simdIndex = (y / SIMD_TILE_Y_DIM) * (KNOB_TILE_X_DIM / SIMD_TILE_X_DIM) + (x / SIMD_TILE_X_DIM);
-
-        SimdT* pSimdTile = &pSrcSimdTiles[simdIndex];
-
-        uint32_t simdOffset = (y % SIMD_TILE_Y_DIM) * SIMD_TILE_X_DIM + (x % SIMD_TILE_X_DIM);
-
-        pSimdTile->GetSwizzledColor(simdOffset, outputColor);
-    }
-
     //////////////////////////////////////////////////////////////////////////
     /// @brief Stores an 8x8 raster tile to the destination surface.
     /// @param pSrc - Pointer to raster tile.
@@ -684,22 +660,33 @@ struct StoreRasterTile
         uint32_t lodWidth = std::max(pDstSurface->width >> pDstSurface->lod, 1U);
         uint32_t lodHeight = std::max(pDstSurface->height >> pDstSurface->lod, 1U);
 
-        // For each raster tile pixel (rx, ry)
-        for (uint32_t ry = 0; ry < KNOB_TILE_Y_DIM; ++ry)
+        typedef SimdTile<SrcFormat, DstFormat> SimdT;
+        SimdT* pSrcSimdTile = (SimdT*)pSrc;
+
+        // For each simd tile (sx, sy), in the order they are laid out in the raster tile
+        for (uint32_t sy = 0; sy < KNOB_TILE_Y_DIM; sy += SIMD_TILE_Y_DIM)
         {
-            for (uint32_t rx = 0; rx < KNOB_TILE_X_DIM; ++rx)
+            for (uint32_t sx = 0; sx < KNOB_TILE_X_DIM; sx += SIMD_TILE_X_DIM)
             {
-                // Perform bounds checking.
-                if (((x + rx) < lodWidth) &&
-                    ((y + ry) < lodHeight))
-                {
-                    float srcColor[4];
-                    GetSwizzledSrcColor(pSrc, rx, ry, srcColor);
+                float srcColors[KNOB_SIMD_WIDTH][4];
+                pSrcSimdTile->GetSwizzledColors(srcColors);
+                pSrcSimdTile++;
 
-                    uint8_t *pDst = (uint8_t*)ComputeSurfaceAddress<false>((x + rx), (y + ry), 
-                        pDstSurface->arrayIndex + renderTargetArrayIndex, pDstSurface->arrayIndex + renderTargetArrayIndex, 
-                        sampleNum, pDstSurface->lod, pDstSurface);
-                    ConvertPixelFromFloat<DstFormat>(pDst, srcColor);
+                // For each simd tile pixel (rx, ry)
+                for (uint32_t simdOffset = 0; simdOffset < KNOB_SIMD_WIDTH; ++simdOffset)
+                {
+                    uint32_t rx = sx + simdOffset % SIMD_TILE_X_DIM;
+                    uint32_t ry = sy + simdOffset / SIMD_TILE_X_DIM;
+
+                    // Perform bounds checking.
+                    if (((x + rx) < lodWidth) &&
+                        ((y + ry) < lodHeight))
+                    {
+                        uint8_t *pDst = (uint8_t*)ComputeSurfaceAddress<false>((x + rx), (y + ry), 
+                            pDstSurface->arrayIndex + renderTargetArrayIndex, pDstSurface->arrayIndex + renderTargetArrayIndex, 
+                            sampleNum, pDstSurface->lod, pDstSurface);
+                        ConvertPixelFromFloat<DstFormat>(pDst, srcColors[simdOffset]);
+                    }
                 }
             }
         }
@@ -1403,22 +1390,147 @@ struct OptStoreRasterTile< TilingTraits<SWR_TILE_MODE_YMAJOR, 128>, SrcFormat, D
     }
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// ResolveRasterTile - Resolves the samples of a multisampled raster tile
+/// into a single sampled raster tile in the same (SWRZ) layout.
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat>
+struct ResolveRasterTile
+{
+    static const uint32_t RASTER_TILE_BYTES = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<SrcFormat>::bpp / 8);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Averages color samples in float, takes sample 0 of anything else
+    ///        (depth, stencil and integer render targets).
+    /// @param pSrc - Pointer to sample 0 of the raster tile in the hot tile.
+    /// @param numSamples - Number of sample planes following pSrc.
+    /// @param pDst - Pointer to the resolved raster tile.
+    INLINE static void Resolve(const uint8_t *pSrc, uint32_t numSamples, uint8_t *pDst)
+    {
+        const bool bAverage = (SrcFormat != KNOB_DEPTH_HOT_TILE_FORMAT) &&
+                              (SrcFormat != KNOB_STENCIL_HOT_TILE_FORMAT) &&
+                              (FormatTraits<DstFormat>::GetType(0) != SWR_TYPE_UINT) &&
+                              (FormatTraits<DstFormat>::GetType(0) != SWR_TYPE_SINT);
+        if (!bAverage)
+        {
+            memcpy(pDst, pSrc, RASTER_TILE_BYTES);
+            return;
+        }
+
+        if (SrcFormat != KNOB_COLOR_HOT_TILE_FORMAT)
+        {
+            ResolveNative(pSrc, numSamples, pDst);
+            return;
+        }
+
+        static_assert(RASTER_TILE_BYTES % sizeof(simdscalar) == 0, "Raster tile must be a multiple of the SIMD width");
+        const simdscalar vScale = _simd_set1_ps(1.0f / numSamples);
+        for (uint32_t offset = 0; offset < RASTER_TILE_BYTES; offset += sizeof(simdscalar))
+        {
+            simdscalar vSum = _simd_load_ps((const float*)(pSrc + offset));
+            for (uint32_t sampleNum = 1; sampleNum < numSamples; ++sampleNum)
+            {
+                vSum = _simd_add_ps(vSum, _simd_load_ps((const float*)(pSrc + sampleNum * RASTER_TILE_BYTES + offset)));
+            }
+            _simd_store_ps((float*)(pDst + offset), _simd_mul_ps(vSum, vScale));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Averages the samples of a color hot tile kept in the render
+    ///        target format, converting each simd tile to float and back.
+    INLINE static void ResolveNative(const uint8_t *pSrc, uint32_t numSamples, uint8_t *pDst)
+    {
+        typedef SimdTile<SrcFormat, SrcFormat> SimdT;
+        static const uint32_t NUM_SIMD_TILES = RASTER_TILE_BYTES / sizeof(SimdT);
+
+        const float scale = 1.0f / numSamples;
+        for (uint32_t t = 0; t < NUM_SIMD_TILES; ++t)
+        {
+            float sum[KNOB_SIMD_WIDTH][4] = {};
+            for (uint32_t sampleNum = 0; sampleNum < numSamples; ++sampleNum)
+            {
+                float colors[KNOB_SIMD_WIDTH][4] = {};
+                ((SimdT*)(pSrc + sampleNum * RASTER_TILE_BYTES) + t)->GetSwizzledColors(colors);
+                for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+                {
+                    for (uint32_t comp = 0; comp < 4; ++comp)
+                    {
+                        sum[index][comp] += colors[index][comp];
+                    }
+                }
+            }
+
+            for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+            {
+                for (uint32_t comp = 0; comp < 4; ++comp)
+                {
+                    sum[index][comp] *= scale;
+                }
+            }
+            ((SimdT*)pDst + t)->SetSwizzledColors(sum);
+        }
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// StoreMacroTile - Stores a macro tile which consists of raster tiles.
 //////////////////////////////////////////////////////////////////////////
 template<typename TTraits, SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat>
 struct StoreMacroTile
 {
+    typedef void(*PFN_STORE_TILES_INTERNAL)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t, uint32_t);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Resolves a multisampled macrotile while storing it to a single
+    ///        sampled destination surface. Each raster tile is resolved into
+    ///        a stack buffer that stays in cache and stored from there, so the
+    ///        hot tile is only read once.
+    /// @param pSrc - Pointer to macro tile.
+    /// @param pDstSurface - Destination surface state
+    /// @param x, y - Coordinates to macro tile
+    /// @param numSrcSamples - Number of samples in the hot tile
+    /// @param pfnStore - Raster tile store function
+    static void StoreResolved(
+        uint8_t *pSrcHotTile,
+        SWR_SURFACE_STATE* pDstSurface,
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSrcSamples,
+        PFN_STORE_TILES_INTERNAL pfnStore)
+    {
+        typedef ResolveRasterTile<SrcFormat, DstFormat> Resolver;
+        OSALIGNSIMD(uint8_t) resolvedTile[Resolver::RASTER_TILE_BYTES];
+
+        SWR_ASSERT(pDstSurface->numSamples == 1, "Multisampled hot tiles can only be resolved to single sampled surfaces");
+
+        for(uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
+        {
+            for(uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
+            {
+                Resolver::Resolve(pSrcHotTile, numSrcSamples, resolvedTile);
+                pfnStore(resolvedTile, pDstSurface, (x + col), (y + row), 0, renderTargetArrayIndex);
+                pSrcHotTile += Resolver::RASTER_TILE_BYTES * numSrcSamples;
+            }
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////
     /// @brief Stores a macrotile to the destination surface using safe implementation.
     /// @param pSrc - Pointer to macro tile.
     /// @param pDstSurface - Destination surface state
     /// @param x, y - Coordinates to macro tile
+    /// @param numSrcSamples - Number of samples in the hot tile
     static void StoreGeneric(
         uint8_t *pSrcHotTile,
         SWR_SURFACE_STATE* pDstSurface,
-        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSrcSamples)
     {
+        if (numSrcSamples > pDstSurface->numSamples)
+        {
+            StoreResolved(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex, numSrcSamples,
+                StoreRasterTile<TTraits, SrcFormat, DstFormat>::Store);
+            return;
+        }
+
         // Store each raster tile from the hot tile to the destination surface.
         for(uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
         {
@@ -1434,18 +1546,18 @@ struct StoreMacroTile
         }
     }
 
-    typedef void(*PFN_STORE_TILES_INTERNAL)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t, uint32_t, uint32_t);
     //////////////////////////////////////////////////////////////////////////
     /// @brief Stores a macrotile to the destination surface.
     /// @param pSrc - Pointer to macro tile.
     /// @param pDstSurface - Destination surface state
     /// @param x, y - Coordinates to macro tile
+    /// @param numSrcSamples - Number of samples in the hot tile
     static void Store(
         uint8_t *pSrcHotTile,
         SWR_SURFACE_STATE* pDstSurface,
-        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSrcSamples)
     {
-        PFN_STORE_TILES_INTERNAL pfnStore[SWR_MAX_NUM_MULTISAMPLES];
+        PFN_STORE_TILES_INTERNAL pfnStore[SWR_MAX_NUM_MULTISAMPLES] = {};
         for(uint32_t sampleNum = 0; sampleNum < pDstSurface->numSamples; sampleNum++)
         {
             size_t dstSurfAddress = (size_t)ComputeSurfaceAddress<false>(
@@ -1463,6 +1575,12 @@ struct StoreMacroTile
             pfnStore[sampleNum] = (bForceGeneric || KNOB_USE_GENERIC_STORETILE) ? StoreRasterTile<TTraits, SrcFormat, DstFormat>::Store : OptStoreRasterTile<TTraits, SrcFormat, DstFormat>::Store;
         }
 
+        if (numSrcSamples > pDstSurface->numSamples)
+        {
+            StoreResolved(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex, numSrcSamples, pfnStore[0]);
+            return;
+        }
+
         // Store each raster tile from the hot tile to the destination surface.
         for(uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
         {
@@ -1478,18 +1596,20 @@ struct StoreMacroTile
     }
 };
 
-static void BUCKETS_START(UINT id)
+static void BUCKETS_START(int32_t id)
 {
-#ifdef KNOB_ENABLE_RDTSC
-    gBucketMgr.StartBucket(id);
-#endif
+    if (id != -1)
+    {
+        gBucketMgr.StartBucket(id);
+    }
 }
 
-static void BUCKETS_STOP(UINT id)
+static void BUCKETS_STOP(int32_t id)
 {
-#ifdef KNOB_ENABLE_RDTSC
-    gBucketMgr.StopBucket(id);
-#endif
+    if (id != -1)
+    {
+        gBucketMgr.StopBucket(id);
+    }
 }
 
 // on demand buckets for store tiles
@@ -1502,13 +1622,15 @@ static std::vector<int32_t> sBuckets(NUM_SWR_FORMATS, -1);
 /// @param srcFormat - Format for hot tile.
 /// @param renderTargetIndex - Index to destination render target
 /// @param x, y - Coordinates to raster tile.
+/// @param numSamples - Number of samples in the hot tile. Resolved if the
+///        render surface has fewer.
 /// @param pSrcHotTile - Pointer to Hot Tile
 void StoreHotTile(
     SWR_SURFACE_STATE *pDstSurface,
     SWR_FORMAT srcFormat,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
     uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
-    uint8_t *pSrcHotTile)
+    uint32_t numSamples, uint8_t *pSrcHotTile)
 {
     if (pDstSurface->type == SURFACE_NULL)
     {
@@ -1525,7 +1647,16 @@ void StoreHotTile(
 
     if ((renderTargetIndex <= SWR_ATTACHMENT_COLOR7) && (pDstSurface->tileMode != SWR_TILE_MODE_WMAJOR))
     {
-        pfnStoreTiles = sStoreTilesTableColor[pDstSurface->tileMode][pDstSurface->format];
+        if (srcFormat != KNOB_COLOR_HOT_TILE_FORMAT)
+        {
+            // hot tile is kept in the render target format
+            SWR_ASSERT(srcFormat == pDstSurface->format, "Hot tile / render target format mismatch");
+            pfnStoreTiles = sStoreTilesTableColorNative[pDstSurface->tileMode][srcFormat];
+        }
+        else
+        {
+            pfnStoreTiles = sStoreTilesTableColor[pDstSurface->tileMode][pDstSurface->format];
+        }
     }
     else if (renderTargetIndex == SWR_ATTACHMENT_DEPTH)
     {
@@ -1543,8 +1674,8 @@ void StoreHotTile(
     }
 
     // Store a macro tile
-#ifdef KNOB_ENABLE_RDTSC
-    if (sBuckets[pDstSurface->format] == -1)
+    // per format buckets are registered the first time they are captured
+    if (gBucketMgr.IsCapturing() && sBuckets[pDstSurface->format] == -1)
     {
         // guard sBuckets update since storetiles is called by multiple threads
         sBucketMutex.lock();
@@ -1556,11 +1687,11 @@ void StoreHotTile(
         }
         sBucketMutex.unlock();
     }
-#endif
 
-    BUCKETS_START(sBuckets[pDstSurface->format]);
-    pfnStoreTiles(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex);
-    BUCKETS_STOP(sBuckets[pDstSurface->format]);
+    int32_t bucket = sBuckets[pDstSurface->format];
+    BUCKETS_START(bucket);
+    pfnStoreTiles(pSrcHotTile, pDstSurface, x, y, renderTargetArrayIndex, numSamples);
+    BUCKETS_STOP(bucket);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1679,6 +1810,18 @@ void InitStoreTilesTableColor(
     table[TileModeT][R8G8B8_SINT]               = StoreMacroTile<TilingTraits<TileModeT, 24>, R32G32B32A32_FLOAT, R8G8B8_SINT>::Store;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// InitStoreTilesTableColorNative - Helper for setting up the tables for
+/// color hot tiles kept in the render target format.
+template <SWR_TILE_MODE TileModeT, size_t NumTileModesT, size_t ArraySizeT>
+void InitStoreTilesTableColorNative(
+    PFN_STORE_TILES (&table)[NumTileModesT][ArraySizeT])
+{
+    table[TileModeT][R16G16B16A16_FLOAT]        = StoreMacroTile<TilingTraits<TileModeT, 64>, R16G16B16A16_FLOAT, R16G16B16A16_FLOAT>::Store;
+    table[TileModeT][B8G8R8A8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, B8G8R8A8_UNORM, B8G8R8A8_UNORM>::Store;
+    table[TileModeT][R8G8B8A8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, R8G8B8A8_UNORM, R8G8B8A8_UNORM>::Store;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// INIT_STORE_TILES_TABLE - Helper macro for setting up the tables.
 template <SWR_TILE_MODE TileModeT, size_t NumTileModes, size_t ArraySizeT>
@@ -1703,14 +1846,18 @@ void InitStoreTilesTableStencil(
 void InitSimStoreTilesTable()
 {
     memset(sStoreTilesTableColor, 0, sizeof(sStoreTilesTableColor));
+    memset(sStoreTilesTableColorNative, 0, sizeof(sStoreTilesTableColorNative));
     memset(sStoreTilesTableDepth, 0, sizeof(sStoreTilesTableDepth));
 
     InitStoreTilesTableColor<SWR_TILE_NONE>(sStoreTilesTableColor);
+    InitStoreTilesTableColorNative<SWR_TILE_NONE>(sStoreTilesTableColorNative);
     InitStoreTilesTableDepth<SWR_TILE_NONE>(sStoreTilesTableDepth);
     InitStoreTilesTableStencil<SWR_TILE_NONE>(sStoreTilesTableStencil);
 
     InitStoreTilesTableColor<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableColor);
     InitStoreTilesTableColor<SWR_TILE_MODE_XMAJOR>(sStoreTilesTableColor);
+    InitStoreTilesTableColorNative<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableColorNative);
+    InitStoreTilesTableColorNative<SWR_TILE_MODE_XMAJOR>(sStoreTilesTableColorNative);
 
     InitStoreTilesTableDepth<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableDepth);
     InitStoreTilesTableStencil<SWR_TILE_MODE_WMAJOR>(sStoreTilesTableStencil);
@@ -29,6 +29,7 @@
 
 #include "core/state.h"
 #include "core/format_traits.h"
+#include "core/format_conversion.h"
 #include "memory/tilingtraits.h"
 
 #include <algorithm>
@@ -94,6 +95,28 @@ struct SimdTile
             this->color[i][offset[index]] = src[i];
         }
     }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve the colors of all pixels of the simd tile.
+    /// @param outputColors - output colors, in GetSwizzledColor index order
+    INLINE void GetSwizzledColors(float outputColors[KNOB_SIMD_WIDTH][4])
+    {
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            GetSwizzledColor(index, outputColors[index]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Set the colors of all pixels of the simd tile.
+    /// @param srcColors - colors, in SetSwizzledColor index order
+    INLINE void SetSwizzledColors(const float srcColors[KNOB_SIMD_WIDTH][4])
+    {
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            SetSwizzledColor(index, srcColors[index]);
+        }
+    }
 };
 
 template<>
@@ -151,6 +174,109 @@ struct SimdTile <R8_UINT,R8_UINT>
             this->color[i][offset[index]] = *(uint8_t*)&src[i];
         }
     }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve the colors of all pixels of the simd tile.
+    /// @param outputColors - output colors, in GetSwizzledColor index order
+    INLINE void GetSwizzledColors(float outputColors[KNOB_SIMD_WIDTH][4])
+    {
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            GetSwizzledColor(index, outputColors[index]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Set the colors of all pixels of the simd tile.
+    /// @param srcColors - colors, in SetSwizzledColor index order
+    INLINE void SetSwizzledColors(const float srcColors[KNOB_SIMD_WIDTH][4])
+    {
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            SetSwizzledColor(index, srcColors[index]);
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SimdTileNative - SimdTile for hot tiles kept in the render target format
+/// (see KNOB_NATIVE_COLOR_HOT_TILES). Data is SOA in the packed format.
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT Format>
+struct SimdTileNative
+{
+    // SimdTile is packed SOA (e.g. bbbbbbbb gggggggg rrrrrrrr aaaaaaaa for BGRA8)
+    uint8_t color[KNOB_SIMD_WIDTH * FormatTraits<Format>::bpp / 8];
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve the colors of all pixels of the simd tile. The packed
+    ///        data is unpacked once for the whole tile.
+    /// @param outputColors - output colors, in SimdTile::GetSwizzledColor index order
+    INLINE void GetSwizzledColors(float outputColors[KNOB_SIMD_WIDTH][4])
+    {
+        // SOA pattern for 2x2 is a subset of 4x2.
+        //   0 1 4 5
+        //   2 3 6 7
+        // The offset converts pattern to linear
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        simdvector vColor;
+        LoadSOA<Format>(this->color, vColor);
+
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            for (uint32_t i = 0; i < FormatTraits<Format>::numComps; ++i)
+            {
+                outputColors[index][i] = ((float*)&vColor.v[FormatTraits<Format>::swizzle(i)])[offset[index]];
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Set the colors of all pixels of the simd tile, packing it once.
+    /// @param srcColors - colors, in SimdTile::SetSwizzledColor index order
+    INLINE void SetSwizzledColors(const float srcColors[KNOB_SIMD_WIDTH][4])
+    {
+        // SOA pattern for 2x2 is a subset of 4x2.
+        //   0 1 4 5
+        //   2 3 6 7
+        // The offset converts pattern to linear
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        simdvector vColor;
+        for (uint32_t index = 0; index < KNOB_SIMD_WIDTH; ++index)
+        {
+            for (uint32_t i = 0; i < FormatTraits<Format>::numComps; ++i)
+            {
+                ((float*)&vColor.v[i])[offset[index]] = srcColors[index][i];
+            }
+        }
+
+        StoreSOA<Format>(vColor, this->color);
+    }
+};
+
+template<>
+struct SimdTile <R8G8B8A8_UNORM, R8G8B8A8_UNORM> : SimdTileNative<R8G8B8A8_UNORM>
+{
+};
+
+template<>
+struct SimdTile <B8G8R8A8_UNORM, B8G8R8A8_UNORM> : SimdTileNative<B8G8R8A8_UNORM>
+{
+};
+
+template<>
+struct SimdTile <R16G16B16A16_FLOAT, R16G16B16A16_FLOAT> : SimdTileNative<R16G16B16A16_FLOAT>
+{
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -54,6 +54,9 @@ template<int X> struct TilingTraits <SWR_TILE_NONE, X>
     static UINT GetPdepY() { return 0x00; }
 };
 
+// SWR-Z raster tiles hold 4x2 pixel simd tiles, 2 across and 4 down, with
+// the pixels of a simd tile in quad order. From the low bit up, an offset is
+// the element byte bits then x0, y0, x1, x2, y1, y2 of the pixel.
 template<> struct TilingTraits <SWR_TILE_SWRZ, 8>
 {
     static const SWR_TILE_MODE TileMode{ SWR_TILE_SWRZ };
@@ -62,9 +65,8 @@ template<> struct TilingTraits <SWR_TILE_SWRZ, 8>
     static UINT GetCr() { return 0; }
     static UINT GetTileIDShift() { return KNOB_TILE_X_DIM_SHIFT + KNOB_TILE_Y_DIM_SHIFT; }
 
-    /// @todo correct pdep shifts for all rastertile dims.  Unused for now
-    static UINT GetPdepX() { SWR_ASSERT(0); return 0x00; }
-    static UINT GetPdepY() { SWR_ASSERT(0); return 0x00; }
+    static UINT GetPdepX() { return 0x0D; }
+    static UINT GetPdepY() { return 0x32; }
 };
 
 template<> struct TilingTraits <SWR_TILE_SWRZ, 32>
@@ -79,6 +81,18 @@ template<> struct TilingTraits <SWR_TILE_SWRZ, 32>
     static UINT GetPdepY() { return 0xC8; }
 };
 
+template<> struct TilingTraits <SWR_TILE_SWRZ, 64>
+{
+    static const SWR_TILE_MODE TileMode{ SWR_TILE_SWRZ };
+    static UINT GetCu() { return KNOB_TILE_X_DIM_SHIFT + 3; }
+    static UINT GetCv() { return KNOB_TILE_Y_DIM_SHIFT; }
+    static UINT GetCr() { return 0; }
+    static UINT GetTileIDShift() { return KNOB_TILE_X_DIM_SHIFT + KNOB_TILE_Y_DIM_SHIFT + 3; }
+
+    static UINT GetPdepX() { return 0x6F; }
+    static UINT GetPdepY() { return 0x190; }
+};
+
 template<> struct TilingTraits <SWR_TILE_SWRZ, 128>
 {
     static const SWR_TILE_MODE TileMode{ SWR_TILE_SWRZ };
@@ -87,9 +101,8 @@ template<> struct TilingTraits <SWR_TILE_SWRZ, 128>
     static UINT GetCr() { return 0; }
     static UINT GetTileIDShift() { return KNOB_TILE_X_DIM_SHIFT + KNOB_TILE_Y_DIM_SHIFT + 4; }
 
-    /// @todo correct pdep shifts for all rastertile dims.  Unused for now
-    static UINT GetPdepX() { SWR_ASSERT(0); return 0x37; }
-    static UINT GetPdepY() { SWR_ASSERT(0); return 0xC8; }
+    static UINT GetPdepX() { return 0xDF; }
+    static UINT GetPdepY() { return 0x320; }
 };
 
 // y-major tiling layout unaffected by element size
@@ -133,7 +146,7 @@ template<int X> struct TilingTraits <SWR_TILE_MODE_WMAJOR, X>
 INLINE
 UINT pdep_u32(UINT a, UINT mask)
 {
-#if KNOB_ARCH==KNOB_ARCH_AVX2
+#if KNOB_ARCH >= KNOB_ARCH_AVX2
     return _pdep_u32(a, mask);
 #else
     UINT result = 0;
@@ -166,7 +179,7 @@ UINT pdep_u32(UINT a, UINT mask)
 INLINE
 UINT pext_u32(UINT a, UINT mask)
 {
-#if KNOB_ARCH==KNOB_ARCH_AVX2
+#if KNOB_ARCH >= KNOB_ARCH_AVX2
     return _pext_u32(a, mask);
 #else
     UINT result = 0;
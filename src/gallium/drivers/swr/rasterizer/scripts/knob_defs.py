@@ -41,6 +41,33 @@ KNOBS = [
        'desc'       : ['Dumps shader LLVM IR at various stages of jit compilation.'],
     }],
 
+    ['JIT_CACHE_DIR', {
+       'type'       : 'std::string',
+       'default'    : '""',
+       'desc'       : ['Directory for the on-disk cache of jitted fetch, blend, streamout',
+                       'and shader objects.  Empty disables the cache.',
+                       'Objects are keyed by their compile state, the driver build,',
+                       'the LLVM version and the target CPU.'],
+    }],
+
+    ['JIT_COMPILE_THREADS', {
+       'type'       : 'uint32_t',
+       'default'    : '0',
+       'desc'       : ['Number of background threads compiling fetch, streamout and pixel shaders.',
+                       '  0 == Compile on the API thread',
+                       '  N == Draws needing a function still being compiled are queued',
+                       '       and held back by the workers until it is ready.',
+                       'Ignored if SINGLE_THREADED is enabled.'],
+    }],
+
+    ['TILED_TEXTURES', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Lay out 2D, array and cube color textures in Y-major tiles (128B x 32 rows)',
+                       'instead of linearly, keeping vertically neighboring texels in the same page.',
+                       'Shared, scanout and display textures are always linear.'],
+    }],
+
     ['USE_GENERIC_STORETILE', {
         'type'      : 'bool',
         'default'   : 'false',
@@ -55,6 +82,58 @@ KNOBS = [
                        'defer clear execution to first backend op on hottile, or hottile store'],
     }],
 
+    ['NATIVE_COLOR_HOT_TILES', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Keep color hottiles in the render target format instead of R32G32B32A32_FLOAT',
+                       'for single sampled RGBA8/BGRA8 UNORM and RGBA16 FLOAT render targets.',
+                       'Reduces hottile memory and load/store tile bandwidth by up to 4x.'],
+    }],
+
+    ['HOT_TILE_BUDGET_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Hot tile memory budget per context in MB. Past it, hot tiles that were',
+                       'stored or invalidated are evicted least recently stored first, and their',
+                       'buffers reused. Dirty hot tiles are never evicted, so it may be exceeded.',
+                       '  0 == No budget, hot tiles are kept until the context is destroyed'],
+    }],
+
+    ['HOT_TILE_LAYERS', {
+        'type'      : 'uint32_t',
+        'default'   : '8',
+        'desc'      : ['Number of render target array slices a macrotile keeps hot tiles for, per',
+                       'attachment. Layered rendering switches between them without storing and',
+                       'reloading. Slices past the first only take free room in the hot tile',
+                       'budget; when none is left the least recently used slice is swapped out.',
+                       '  1 == Store and reload on every array slice change'],
+    }],
+
+    ['ENABLE_HIZ', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Track the max depth of each macrotile and 8x8 raster tile of the depth',
+                       'hottiles. Triangles behind it are dropped by the binner and rasterizer',
+                       'for LESS/LEQUAL depth tests without stencil writes or depth output.'],
+    }],
+
+    ['OVERLAP_FE_BE', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Allow backend work on the oldest draw to start while its frontend is',
+                       'still binning, instead of waiting for the whole draw to be binned.',
+                       'Per macrotile work is still processed in order.'],
+    }],
+
+    ['NUMA_TILE_AFFINITY', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Interleave macrotiles across NUMA nodes. Backend work for a macrotile',
+                       'is only done by worker threads on its node and its hot tiles are',
+                       'allocated from that node\'s memory.',
+                       'Ignored if MAX_WORKER_THREADS is set, since workers are not bound then.'],
+    }],
+
     ['MAX_NUMA_NODES', {
         'type'      : 'uint32_t',
         'default'   : '0',
@@ -89,13 +168,35 @@ KNOBS = [
                        'In this case, the above 3 KNOBS will be ignored.'],
     }],
 
+    ['ARENA_BLOCK_CACHE_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '64',
+        'desc'      : ['Maximum size in MB of the free arena blocks kept for reuse by the draw and',
+                       'state arenas of all contexts, instead of being freed on arena reset.'],
+    }],
+
+    ['SHARED_WORKER_POOL', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Share one pool of worker threads between all contexts of a screen, instead',
+                       'of every context creating as many workers as there are HW threads.',
+                       'Workers take turns between the contexts with work pending.'],
+    }],
+
+    ['ENABLE_BUCKETS', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Collect RDTSC buckets between BUCKETS_START_FRAME and BUCKETS_END_FRAME',
+                       'and write a report to rdtsc.txt (or threadviz data) at the end frame.',
+                       'Buckets cost a load and a branch while not collecting.'],
+    }],
+
     ['BUCKETS_START_FRAME', {
         'type'      : 'uint32_t',
         'default'   : '1200',
         'desc'      : ['Frame from when to start saving buckets data.',
                        '',
-                       'NOTE: KNOB_ENABLE_RDTSC must be enabled in core/knobs.h',
-                       'for this to have an effect.'],
+                       'NOTE: ENABLE_BUCKETS must be set for this to have an effect.'],
     }],
 
     ['BUCKETS_END_FRAME', {
@@ -103,8 +204,15 @@ KNOBS = [
         'default'   : '1400',
         'desc'      : ['Frame at which to stop saving buckets data.',
                        '',
-                       'NOTE: KNOB_ENABLE_RDTSC must be enabled in core/knobs.h',
-                       'for this to have an effect.'],
+                       'NOTE: ENABLE_BUCKETS must be set for this to have an effect.'],
+    }],
+
+    ['BUCKETS_CHROME_TRACE', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Also record every bucket span per thread and write them to rdtsc.json',
+                       'in Chrome trace event format (chrome://tracing) at the end frame.',
+                       'Ignored with BUCKETS_ENABLE_THREADVIZ.'],
     }],
 
     ['WORKER_SPIN_LOOP_COUNT', {
@@ -114,10 +222,39 @@ KNOBS = [
                        'before going to sleep when waiting for work'],
     }],
 
+    ['FENCE_SPIN_US', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Maximum time in microseconds the driver spins on a fence before sleeping.',
+                       'The spin time adapts to how long recent waits took.',
+                       '  0 == Always sleep until the fence is signaled'],
+    }],
+
     ['MAX_DRAWS_IN_FLIGHT', {
         'type'      : 'uint32_t',
         'default'   : '160',
-        'desc'      : ['Maximum number of draws outstanding before API thread blocks.'],
+        'desc'      : ['Maximum number of draws outstanding before API thread blocks.',
+                       'Default for contexts that don\'t set their own.'],
+    }],
+
+    ['MAX_DRAWS_IN_FLIGHT_LIMIT', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Limit to grow the number of draws outstanding to, when the API thread',
+                       'blocks on a full draw ring. The ring is doubled once its queued draws',
+                       'have retired.',
+                       '  0 == Never grow'],
+    }],
+
+    ['VERTEX_REUSE_WINDOW', {
+       'type'       : 'uint32_t',
+       'default'    : '0',
+       'desc'       : ['Vertex cache size for indexed point, line and triangle lists and strips.',
+                       'Primitives are walked in windows whose unique vertices fit the cache',
+                       'and each unique vertex is shaded once per window.',
+                       '  0 == Shade every index',
+                       '  N == Cache up to N vertices, rounded up to the SIMD width (max 1024)',
+                       'Ignored with tessellation.'],
     }],
 
     ['MAX_PRIMS_PER_DRAW', {
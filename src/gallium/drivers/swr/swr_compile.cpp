@@ -0,0 +1,296 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/u_debug.h"
+#include "util/u_inlines.h"
+#include "gallivm/lp_bld_init.h"
+
+#include "swr_context.h"
+#include "swr_screen.h"
+#include "swr_compile.h"
+#include "gen_knobs.h"
+
+#include "jit_api.h"
+#include "rdtsc_core.h"
+
+namespace std
+{
+/* Hashes the same fields FETCH_COMPILE_STATE::operator== compares. */
+template <> struct hash<FETCH_COMPILE_STATE> {
+   std::size_t operator()(const FETCH_COMPILE_STATE &state) const
+   {
+      uint64_t hash = 0xcbf29ce484222325ull;
+      auto add = [&hash](uint64_t value) {
+         hash = (hash ^ value) * 0x100000001b3ull;
+      };
+
+      add(state.numAttribs);
+      add(state.indexType);
+      add(state.cutIndex);
+      add(state.bDisableVGATHER | (state.bDisableIndexOOBCheck << 1)
+          | (state.bEnableCutIndex << 2));
+      for (uint32_t i = 0; i < state.numAttribs; i++) {
+         add(state.layout[i].bits);
+         if (state.layout[i].InstanceEnable)
+            add(state.layout[i].InstanceDataStepRate);
+      }
+
+      return (std::size_t)hash;
+   }
+};
+}
+
+struct swr_compile_pool {
+   std::mutex mutex;
+   std::condition_variable cond;
+   std::condition_variable compiled; /* a job has finished */
+   std::deque<std::pair<swr_jit_func *, swr_compile_job>> jobs;
+   std::vector<std::thread> threads;
+   bool shutdown = false;
+
+   /* Screen wide fetch shaders, most recently used first in fetch_lru.
+    * Entries past SWR_FETCH_CACHE_SIZE are evicted from the back. */
+   std::mutex fetch_mutex;
+   std::list<FETCH_COMPILE_STATE> fetch_lru;
+   std::unordered_map<FETCH_COMPILE_STATE,
+                      std::pair<swr_jit_func *,
+                                std::list<FETCH_COMPILE_STATE>::iterator>>
+      fetch_cache;
+   swr_fetch_cache_stats fetch_stats = {0, 0};
+};
+
+/* Distinct vertex layouts kept compiled.  Evicted functions live on as long
+ * as vertex element states still use them. */
+#define SWR_FETCH_CACHE_SIZE 256
+
+
+static swr_jit_func *
+swr_alloc_jit_func()
+{
+   swr_jit_func *func = new swr_jit_func;
+   pipe_reference_init(&func->reference, 1);
+   func->pfn = NULL;
+   return func;
+}
+
+static void
+swr_jit_func_unreference(struct swr_jit_func *func)
+{
+   if (pipe_reference(&func->reference, NULL))
+      delete func;
+}
+
+static void
+swr_compile_thread(struct swr_compile_pool *pool)
+{
+   RDTSC_INIT_THREAD("JIT");
+
+   /* JitManager isn't thread safe, each compile thread gets its own. */
+   HANDLE hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
+
+   for (;;) {
+      std::pair<swr_jit_func *, swr_compile_job> job;
+      {
+         std::unique_lock<std::mutex> lock(pool->mutex);
+         pool->cond.wait(lock, [pool] {
+            return pool->shutdown || !pool->jobs.empty();
+         });
+         /* Drain the queue before exiting, draws may be waiting on it. */
+         if (pool->jobs.empty())
+            break;
+         job = std::move(pool->jobs.front());
+         pool->jobs.pop_front();
+      }
+
+      void *pfn = job.second(hJitMgr);
+      assert(pfn && "Error: async compile failed");
+
+      /* Function must be complete before workers can see it. */
+      _ReadWriteBarrier();
+      job.first->pfn = pfn;
+      swr_jit_func_unreference(job.first);
+
+      {
+         std::lock_guard<std::mutex> lock(pool->mutex);
+         pool->compiled.notify_all();
+      }
+   }
+
+   JitDestroyContext(hJitMgr);
+}
+
+void
+swr_compile_pool_init(struct swr_screen *screen)
+{
+   struct swr_compile_pool *pool = new swr_compile_pool;
+   screen->compile_pool = pool;
+
+   if (!KNOB_JIT_COMPILE_THREADS || KNOB_SINGLE_THREADED)
+      return;
+
+   /* Make sure gallivm's one time init isn't raced by the compile threads. */
+   lp_build_init();
+
+   for (uint32_t i = 0; i < KNOB_JIT_COMPILE_THREADS; i++)
+      pool->threads.emplace_back(swr_compile_thread, pool);
+}
+
+void
+swr_compile_pool_destroy(struct swr_screen *screen)
+{
+   struct swr_compile_pool *pool = screen->compile_pool;
+
+   {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      pool->shutdown = true;
+   }
+   pool->cond.notify_all();
+
+   for (std::thread &thread : pool->threads)
+      thread.join();
+
+   for (auto &entry : pool->fetch_cache)
+      swr_jit_func_unreference(entry.second.first);
+
+   debug_printf("swr: fetch shader cache %llu hits, %llu misses\n",
+                (unsigned long long)pool->fetch_stats.hits,
+                (unsigned long long)pool->fetch_stats.misses);
+
+   delete pool;
+   screen->compile_pool = NULL;
+}
+
+struct swr_jit_func *
+swr_compile_async(struct swr_screen *screen, swr_compile_job job)
+{
+   struct swr_compile_pool *pool = screen->compile_pool;
+   swr_jit_func *func = swr_alloc_jit_func();
+
+   /* A single threaded core can't hold draws back for the compile. */
+   if (pool->threads.empty() || KNOB_SINGLE_THREADED) {
+      func->pfn = job(screen->hJitMgr);
+      assert(func->pfn && "Error: compile failed");
+      return func;
+   }
+
+   /* The job's reference, the owner may release func before it runs. */
+   pipe_reference(NULL, &func->reference);
+   {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      pool->jobs.emplace_back(func, std::move(job));
+   }
+   pool->cond.notify_one();
+
+   return func;
+}
+
+bool
+swr_compile_ready(struct swr_screen *screen, struct swr_jit_func *func)
+{
+   struct swr_compile_pool *pool = screen->compile_pool;
+
+   if (func->pfn || !KNOB_SINGLE_THREADED)
+      return func->pfn != NULL;
+
+   /* Queued before the core went single threaded */
+   std::unique_lock<std::mutex> lock(pool->mutex);
+   pool->compiled.wait(lock, [func] { return func->pfn != NULL; });
+   return true;
+}
+
+static void
+swr_release_jit_funcs_cb(UINT64 userData, UINT64 userData2, UINT64 userData3)
+{
+   std::vector<swr_jit_func *> *funcs = (std::vector<swr_jit_func *> *)userData;
+
+   for (swr_jit_func *func : *funcs)
+      swr_jit_func_unreference(func);
+   delete funcs;
+}
+
+void
+swr_release_jit_funcs(struct swr_context *ctx,
+                      std::vector<struct swr_jit_func *> funcs)
+{
+   if (funcs.empty())
+      return;
+
+   SwrSync(ctx->swrContext, swr_release_jit_funcs_cb,
+           (UINT64)new std::vector<swr_jit_func *>(std::move(funcs)), 0, 0);
+}
+
+struct swr_jit_func *
+swr_compile_fetch(struct swr_screen *screen, const FETCH_COMPILE_STATE &state)
+{
+   struct swr_compile_pool *pool = screen->compile_pool;
+   std::lock_guard<std::mutex> lock(pool->fetch_mutex);
+   swr_jit_func *func;
+
+   auto search = pool->fetch_cache.find(state);
+   if (search != pool->fetch_cache.end()) {
+      pool->fetch_stats.hits++;
+      pool->fetch_lru.splice(pool->fetch_lru.begin(), pool->fetch_lru,
+                             search->second.second);
+      func = search->second.first;
+   } else {
+      pool->fetch_stats.misses++;
+      if (pool->fetch_cache.size() >= SWR_FETCH_CACHE_SIZE) {
+         auto evict = pool->fetch_cache.find(pool->fetch_lru.back());
+         swr_jit_func_unreference(evict->second.first);
+         pool->fetch_cache.erase(evict);
+         pool->fetch_lru.pop_back();
+      }
+
+      func = swr_compile_async(screen, [state](HANDLE hJitMgr) {
+         PFN_FETCH_FUNC func = JitCompileFetch(hJitMgr, state);
+         assert(func && "Error: FetchShader = NULL");
+         return (void *)func;
+      });
+      pool->fetch_lru.push_front(state);
+      pool->fetch_cache.insert(
+         std::make_pair(state, std::make_pair(func, pool->fetch_lru.begin())));
+   }
+
+   /* The caller's reference */
+   pipe_reference(NULL, &func->reference);
+   return func;
+}
+
+void
+swr_get_fetch_cache_stats(struct swr_screen *screen,
+                          struct swr_fetch_cache_stats *stats)
+{
+   struct swr_compile_pool *pool = screen->compile_pool;
+   std::lock_guard<std::mutex> lock(pool->fetch_mutex);
+
+   *stats = pool->fetch_stats;
+}
@@ -0,0 +1,106 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+#ifndef SWR_COMPILE_H
+#define SWR_COMPILE_H
+
+#include <functional>
+#include <vector>
+
+#include "pipe/p_state.h"
+
+#include "api.h"
+
+struct swr_screen;
+struct swr_context;
+struct FETCH_COMPILE_STATE;
+
+/*
+ * A jitted function that may still be compiling on a background thread.
+ * pfn is NULL until the compile finishes and is never changed after that.
+ * The core can be handed &pfn via SwrSetDeferredFunc so a draw queued before
+ * the function is ready is held back until it is.  Entries are reference
+ * counted: the owner (shader variant or fetch cache) holds one reference and
+ * a queued compile job another, see swr_release_jit_funcs.
+ */
+struct swr_jit_func {
+   struct pipe_reference reference;
+   void *volatile pfn;
+};
+
+/* Compile job, run with the JitManager of the thread it executes on. */
+typedef std::function<void *(HANDLE hJitMgr)> swr_compile_job;
+
+void swr_compile_pool_init(struct swr_screen *screen);
+void swr_compile_pool_destroy(struct swr_screen *screen);
+
+/*
+ * swr_compile_async
+ * Queues job on the screen's compile threads (KNOB_JIT_COMPILE_THREADS).
+ * Without compile threads, or with a single threaded core, the job runs
+ * immediately on the calling thread.
+ *
+ * Returns:
+ *   function whose pfn is filled in once job has run.
+ */
+struct swr_jit_func *swr_compile_async(struct swr_screen *screen,
+                                       swr_compile_job job);
+
+/*
+ * swr_compile_ready
+ * Whether func can be set on the core directly, rather than deferred with
+ * SwrSetDeferredFunc.  A single threaded core has no workers that can hold
+ * a draw back, so there this blocks until a pending compile is done.
+ */
+bool swr_compile_ready(struct swr_screen *screen, struct swr_jit_func *func);
+
+/*
+ * swr_release_jit_funcs
+ * Drops the owner's reference to funcs once all draws ctx has queued so far
+ * are done, as they may still wait on or call them.
+ */
+void swr_release_jit_funcs(struct swr_context *ctx,
+                           std::vector<struct swr_jit_func *> funcs);
+
+/*
+ * swr_compile_fetch
+ * Looks up state in the screen wide fetch shader cache, compiling it with
+ * swr_compile_async on a miss.  Vertex element states and contexts with
+ * the same fetch state share one function.  The cache only keeps the most
+ * recently used ones.
+ *
+ * Returns:
+ *   a reference for the caller, dropped with swr_release_jit_funcs.
+ */
+struct swr_jit_func *swr_compile_fetch(struct swr_screen *screen,
+                                       const FETCH_COMPILE_STATE &state);
+
+struct swr_fetch_cache_stats {
+   uint64_t hits;
+   uint64_t misses;
+};
+
+void swr_get_fetch_cache_stats(struct swr_screen *screen,
+                               struct swr_fetch_cache_stats *stats);
+
+#endif
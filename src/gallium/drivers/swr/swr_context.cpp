@@ -96,6 +96,171 @@ swr_surface_destroy(struct pipe_context *pipe, struct pipe_surface *surf)
 }
 
 
+/* Transfers of tiled textures go through a linear staging copy */
+struct swr_transfer {
+   struct pipe_transfer base;
+   uint8_t *staging;
+};
+
+/*
+ * Copy a box of a tiled texture level to or from a linear buffer.
+ * Runs of bytes within a 16 byte tile column are contiguous.
+ */
+static void
+swr_tiled_copy(struct swr_resource *spr,
+               unsigned level,
+               const struct pipe_box *box,
+               uint8_t *linear,
+               unsigned stride,
+               unsigned layer_stride,
+               boolean to_linear)
+{
+   const unsigned row_bytes =
+      box->width * util_format_get_blocksize(spr->base.format);
+   const unsigned x_start =
+      box->x * util_format_get_blocksize(spr->base.format);
+   uint8_t *level_base = spr->swr.pBaseAddress + spr->mip_offsets[level];
+
+   for (int z = 0; z < box->depth; z++) {
+      uint8_t *image = level_base + (box->z + z) * spr->img_stride[level];
+      for (int y = 0; y < box->height; y++) {
+         uint8_t *row = linear + z * layer_stride + y * stride;
+         unsigned x_bytes = x_start;
+         for (unsigned done = 0; done < row_bytes;) {
+            unsigned chunk = MIN2(16 - (x_bytes & 0xf), row_bytes - done);
+            uint8_t *tiled = image
+               + swr_tiled_offset(spr->row_stride[level], x_bytes, box->y + y);
+            if (to_linear)
+               memcpy(row + done, tiled, chunk);
+            else
+               memcpy(tiled, row + done, chunk);
+            done += chunk;
+            x_bytes += chunk;
+         }
+      }
+   }
+}
+
+/*
+ * Copy a row of stencil between the separate R8 stencil plane and the
+ * stencil byte of Z24S8 pixels, 16 pixels at a time.
+ */
+static void
+swr_copy_stencil_row_z24s8(uint8_t *zs, uint8_t *s, unsigned width,
+                           boolean interleave)
+{
+   unsigned x = 0;
+
+   if (interleave) {
+      const __m128i depth_mask = _mm_set1_epi32(0x00ffffff);
+      for (; x + 16 <= width; x += 16) {
+         __m128i stencil = _mm_loadu_si128((const __m128i *)(s + x));
+         for (unsigned i = 0; i < 4; i++) {
+            __m128i *dst = (__m128i *)(zs + 4 * (x + 4 * i));
+            __m128i st = _mm_slli_epi32(_mm_cvtepu8_epi32(stencil), 24);
+            __m128i z = _mm_and_si128(_mm_loadu_si128(dst), depth_mask);
+            _mm_storeu_si128(dst, _mm_or_si128(z, st));
+            stencil = _mm_srli_si128(stencil, 4);
+         }
+      }
+      for (; x < width; x++)
+         zs[4 * x + 3] = s[x];
+   } else {
+      for (; x + 16 <= width; x += 16) {
+         const __m128i *src = (const __m128i *)(zs + 4 * x);
+         __m128i s0 = _mm_srli_epi32(_mm_loadu_si128(src + 0), 24);
+         __m128i s1 = _mm_srli_epi32(_mm_loadu_si128(src + 1), 24);
+         __m128i s2 = _mm_srli_epi32(_mm_loadu_si128(src + 2), 24);
+         __m128i s3 = _mm_srli_epi32(_mm_loadu_si128(src + 3), 24);
+         __m128i lo = _mm_packus_epi32(s0, s1);
+         __m128i hi = _mm_packus_epi32(s2, s3);
+         _mm_storeu_si128((__m128i *)(s + x), _mm_packus_epi16(lo, hi));
+      }
+      for (; x < width; x++)
+         s[x] = zs[4 * x + 3];
+   }
+}
+
+/* As above for Z32S8X24, stencil is the low byte of each odd dword. */
+static void
+swr_copy_stencil_row_z32s8x24(uint8_t *zs, uint8_t *s, unsigned width,
+                              boolean interleave)
+{
+   unsigned x = 0;
+
+   if (interleave) {
+      const __m128i keep_mask = _mm_set_epi32(~0xff, -1, ~0xff, -1);
+      for (; x + 16 <= width; x += 16) {
+         __m128i stencil = _mm_loadu_si128((const __m128i *)(s + x));
+         for (unsigned i = 0; i < 4; i++) {
+            __m128i *dst = (__m128i *)(zs + 8 * (x + 4 * i));
+            __m128i st = _mm_cvtepu8_epi32(stencil);
+            __m128i lo = _mm_unpacklo_epi32(_mm_setzero_si128(), st);
+            __m128i hi = _mm_unpackhi_epi32(_mm_setzero_si128(), st);
+            __m128i z0 = _mm_and_si128(_mm_loadu_si128(dst), keep_mask);
+            __m128i z1 = _mm_and_si128(_mm_loadu_si128(dst + 1), keep_mask);
+            _mm_storeu_si128(dst, _mm_or_si128(z0, lo));
+            _mm_storeu_si128(dst + 1, _mm_or_si128(z1, hi));
+            stencil = _mm_srli_si128(stencil, 4);
+         }
+      }
+      for (; x < width; x++)
+         zs[8 * x + 4] = s[x];
+   } else {
+      const __m128i stencil_mask = _mm_set1_epi32(0xff);
+      for (; x + 16 <= width; x += 16) {
+         const __m128 *src = (const __m128 *)(zs + 8 * x);
+         __m128i st[4];
+         for (unsigned i = 0; i < 4; i++) {
+            __m128 odd = _mm_shuffle_ps(_mm_loadu_ps((const float *)(src + 2 * i)),
+                                        _mm_loadu_ps((const float *)(src + 2 * i + 1)),
+                                        _MM_SHUFFLE(3, 1, 3, 1));
+            st[i] = _mm_and_si128(_mm_castps_si128(odd), stencil_mask);
+         }
+         __m128i lo = _mm_packus_epi32(st[0], st[1]);
+         __m128i hi = _mm_packus_epi32(st[2], st[3]);
+         _mm_storeu_si128((__m128i *)(s + x), _mm_packus_epi16(lo, hi));
+      }
+      for (; x < width; x++)
+         s[x] = zs[8 * x + 4];
+   }
+}
+
+/*
+ * Copy the stencil of a mapped box between the separate stencil plane and
+ * the merged depth/stencil storage handed out by transfer_map.  The stencil
+ * plane only holds level 0, layer 0.
+ */
+static void
+swr_copy_stencil(struct swr_resource *spr,
+                 unsigned level,
+                 const struct pipe_box *box,
+                 boolean interleave)
+{
+   void (*copy_row)(uint8_t *, uint8_t *, unsigned, boolean);
+   unsigned bpp;
+
+   if (spr->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT) {
+      copy_row = swr_copy_stencil_row_z24s8;
+      bpp = 4;
+   } else if (spr->base.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT) {
+      copy_row = swr_copy_stencil_row_z32s8x24;
+      bpp = 8;
+   } else {
+      return;
+   }
+
+   if (!spr->has_stencil || level != 0 || box->z != 0)
+      return;
+
+   for (int y = box->y; y < box->y + box->height; y++) {
+      uint8_t *zs = spr->swr.pBaseAddress + y * spr->swr.pitch + box->x * bpp;
+      uint8_t *s = spr->secondary.pBaseAddress + y * spr->secondary.pitch
+         + box->x;
+      copy_row(zs, s, box->width, interleave);
+   }
+}
+
 static void *
 swr_transfer_map(struct pipe_context *pipe,
                  struct pipe_resource *resource,
@@ -131,32 +296,54 @@ swr_transfer_map(struct pipe_context *pipe,
             if (!swr_is_fence_pending(screen->flush_fence))
                swr_fence_submit(swr_context(pipe), screen->flush_fence);
 
-            swr_fence_finish(pipe->screen, screen->flush_fence, 0);
+            swr_fence_finish(pipe->screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
             swr_resource_unused(pipe, spr);
          }
       }
    }
 
-   pt = CALLOC_STRUCT(pipe_transfer);
-   if (!pt)
+   struct swr_transfer *st = CALLOC_STRUCT(swr_transfer);
+   if (!st)
       return NULL;
+   pt = &st->base;
    pipe_resource_reference(&pt->resource, resource);
    pt->level = level;
+   pt->usage = (enum pipe_transfer_usage)usage;
    pt->box = *box;
+
+   if (spr->swr.tileMode != SWR_TILE_NONE) {
+      pt->stride = box->width * util_format_get_blocksize(format);
+      pt->layer_stride = pt->stride * box->height;
+      st->staging = (uint8_t *)MALLOC(pt->layer_stride * box->depth);
+      if (!st->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(st);
+         return NULL;
+      }
+
+      if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+         swr_tiled_copy(spr, level, box, st->staging,
+                        pt->stride, pt->layer_stride, TRUE);
+
+      *transfer = pt;
+
+      return st->staging;
+   }
+
    pt->stride = spr->row_stride[level];
    pt->layer_stride = spr->img_stride[level];
 
-   /* if we're mapping the depth/stencil, copy in stencil */
-   if (spr->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && spr->has_stencil) {
-      for (unsigned i = 0; i < spr->alignedWidth * spr->alignedHeight; i++) {
-         spr->swr.pBaseAddress[4 * i + 3] = spr->secondary.pBaseAddress[i];
-      }
-   } else if (spr->base.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT
-              && spr->has_stencil) {
-      for (unsigned i = 0; i < spr->alignedWidth * spr->alignedHeight; i++) {
-         spr->swr.pBaseAddress[8 * i + 4] = spr->secondary.pBaseAddress[i];
-      }
+   /* if we're mapping the depth/stencil, copy in the box's stencil unless
+    * it's discarded or already there */
+   if (spr->has_stencil && !spr->stencil_interleaved
+       && !(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE))) {
+      swr_copy_stencil(spr, level, box, TRUE);
+      if (level == 0 && box->x == 0 && box->y == 0 && box->z == 0
+          && box->width >= (int)resource->width0
+          && box->height >= (int)resource->height0)
+         spr->stencil_interleaved = true;
    }
 
    unsigned offset = box->z * pt->layer_stride + box->y * pt->stride
@@ -172,20 +359,20 @@ swr_transfer_unmap(struct pipe_context *pipe, struct pipe_transfer *transfer)
 {
    assert(transfer->resource);
 
+   struct swr_transfer *st = (struct swr_transfer *)transfer;
    struct swr_resource *res = swr_resource(transfer->resource);
-   /* if we're mapping the depth/stencil, copy out stencil */
-   if (res->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && res->has_stencil) {
-      for (unsigned i = 0; i < res->alignedWidth * res->alignedHeight; i++) {
-         res->secondary.pBaseAddress[i] = res->swr.pBaseAddress[4 * i + 3];
-      }
-   } else if (res->base.format == PIPE_FORMAT_Z32_FLOAT_S8X24_UINT
-              && res->has_stencil) {
-      for (unsigned i = 0; i < res->alignedWidth * res->alignedHeight; i++) {
-         res->secondary.pBaseAddress[i] = res->swr.pBaseAddress[8 * i + 4];
-      }
+
+   if (st->staging) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         swr_tiled_copy(res, transfer->level, &transfer->box, st->staging,
+                        transfer->stride, transfer->layer_stride, FALSE);
+      FREE(st->staging);
    }
 
+   /* if the depth/stencil was written, copy out the box's stencil */
+   if (res->has_stencil && (transfer->usage & PIPE_TRANSFER_WRITE))
+      swr_copy_stencil(res, transfer->level, &transfer->box, FALSE);
+
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
 }
@@ -211,7 +398,7 @@ swr_resource_copy(struct pipe_context *pipe,
    if (swr_resource(dst)->status & SWR_RESOURCE_WRITE)
       swr_store_resource(pipe, dst, SWR_TILE_RESOLVED);
 
-   swr_fence_finish(pipe->screen, screen->flush_fence, 0);
+   swr_fence_finish(pipe->screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
    swr_resource_unused(pipe, swr_resource(src));
    swr_resource_unused(pipe, swr_resource(dst));
 
@@ -238,8 +425,16 @@ swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
    if (info.src.resource->nr_samples > 1 && info.dst.resource->nr_samples <= 1
        && !util_format_is_depth_or_stencil(info.src.resource->format)
        && !util_format_is_pure_integer(info.src.resource->format)) {
-      debug_printf("swr: color resolve unimplemented\n");
-      return;
+      struct pipe_resource *resolve_target =
+         swr_resource(info.src.resource)->resolve_target;
+      if (!resolve_target) {
+         debug_printf("swr: color resolve unimplemented\n");
+         return;
+      }
+
+      /* Storing the tiles resolves them, blit from the resolved copy. */
+      swr_store_resource(pipe, info.src.resource, SWR_TILE_RESOLVED);
+      info.src.resource = resolve_target;
    }
 
    if (util_try_blit_via_copy_region(pipe, &info)) {
@@ -305,8 +500,22 @@ swr_destroy(struct pipe_context *pipe)
 
    /* Idle core before deleting context */
    SwrWaitForIdle(ctx->swrContext);
-   if (ctx->swrContext)
+   if (ctx->swrContext) {
+      SWR_DRAW_RING_STATS ring_stats;
+      SwrGetDrawRingStats(ctx->swrContext, &ring_stats);
+      debug_printf("swr: draw ring of %u after %u grows, %llu draws, "
+                   "%llu full ring waits (%llu ticks), workers idle %llu ticks, "
+                   "%llu state block copies\n",
+                   ring_stats.maxDrawsInFlight,
+                   ring_stats.numGrows,
+                   (unsigned long long)ring_stats.numDraws,
+                   (unsigned long long)ring_stats.numRingFullWaits,
+                   (unsigned long long)ring_stats.ringFullWaitTicks,
+                   (unsigned long long)ring_stats.workerIdleTicks,
+                   (unsigned long long)ring_stats.numStateBlockCopies);
+
       SwrDestroyContext(ctx->swrContext);
+   }
 
    delete ctx->blendJIT;
 
@@ -343,6 +552,9 @@ swr_create_context(struct pipe_screen *screen, void *priv, unsigned flags)
    createInfo.pfnLoadTile = swr_LoadHotTile;
    createInfo.pfnStoreTile = swr_StoreHotTile;
    createInfo.pfnClearTile = swr_StoreHotTileClear;
+   createInfo.hWorkerPool = swr_screen(screen)->hWorkerPool;
+   createInfo.workerPoolWeight = 1;
+   createInfo.maxDrawsInFlight = 0;
    ctx->swrContext = SwrCreateContext(&createInfo);
 
    /* Init Load/Store/ClearTiles Tables */
@@ -90,6 +90,7 @@ struct swr_draw_context {
    swr_jit_sampler samplersFS[PIPE_MAX_SAMPLERS];
 
    SWR_SURFACE_STATE renderTargets[SWR_NUM_ATTACHMENTS];
+   SWR_SURFACE_STATE resolveTargets[SWR_NUM_ATTACHMENTS];
 };
 
 struct swr_context {
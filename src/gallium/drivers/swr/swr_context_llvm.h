@@ -109,6 +109,8 @@ Gen_swr_draw_context(JitManager *pShG)
                                     PIPE_MAX_SAMPLERS)); // samplersFS
    members.push_back(ArrayType::get(Gen_SWR_SURFACE_STATE(pShG),
                                     SWR_NUM_ATTACHMENTS)); // renderTargets
+   members.push_back(ArrayType::get(Gen_SWR_SURFACE_STATE(pShG),
+                                    SWR_NUM_ATTACHMENTS)); // resolveTargets
 
    return StructType::get(ctx, members, false);
 }
@@ -122,3 +124,4 @@ static const UINT swr_draw_context_samplersVS = 5;
 static const UINT swr_draw_context_texturesFS = 6;
 static const UINT swr_draw_context_samplersFS = 7;
 static const UINT swr_draw_context_renderTargets = 8;
+static const UINT swr_draw_context_resolveTargets = 9;
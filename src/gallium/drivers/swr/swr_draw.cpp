@@ -73,8 +73,25 @@ swr_convert_prim_topology(const unsigned mode)
 };
 
 
+static bool
+swr_draw_uses_user_buffers(struct swr_context *ctx,
+                           const struct pipe_draw_info *info)
+{
+   if (info->indexed && ctx->index_buffer.user_buffer)
+      return true;
+
+   for (unsigned i = 0; i < ctx->num_vertex_buffers; i++)
+      if (ctx->vertex_buffer[i].user_buffer)
+         return true;
+
+   return false;
+}
+
+
 /*
  * Draw vertex arrays, with optional indexing, optional instancing.
+ * Indirect draw arguments are read by the core's frontend when the draw
+ * executes, so they may come from prior streamout without a stall here.
  */
 static void
 swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
@@ -84,7 +101,9 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (!swr_check_render_cond(pipe))
       return;
 
-   if (info->indirect) {
+   /* Client arrays are sized from the draw info, so those indirect draws
+    * still need the arguments on the API thread. */
+   if (info->indirect && swr_draw_uses_user_buffers(ctx, info)) {
       util_draw_indirect(pipe, info);
       return;
    }
@@ -132,34 +151,75 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 
          state.stream.numDecls = num;
 
-         HANDLE hJitMgr = swr_screen(pipe->screen)->hJitMgr;
-         ctx->vs->soFunc[info->mode] = JitCompileStreamout(hJitMgr, state);
-         debug_printf("so shader    %p\n", ctx->vs->soFunc[info->mode]);
-         assert(ctx->vs->soFunc[info->mode] && "Error: SoShader = NULL");
+         ctx->vs->soFunc[info->mode] = swr_compile_async(
+            swr_screen(pipe->screen), [state](HANDLE hJitMgr) {
+               PFN_SO_FUNC func = JitCompileStreamout(hJitMgr, state);
+               debug_printf("so shader    %p\n", func);
+               assert(func && "Error: SoShader = NULL");
+               return (void *)func;
+            });
       }
 
-      SwrSetSoFunc(ctx->swrContext, ctx->vs->soFunc[info->mode], 0);
+      struct swr_jit_func *soFunc = ctx->vs->soFunc[info->mode];
+      if (swr_compile_ready(swr_screen(pipe->screen), soFunc))
+         SwrSetSoFunc(ctx->swrContext, (PFN_SO_FUNC)soFunc->pfn, 0);
+      else
+         SwrSetDeferredFunc(ctx->swrContext,
+                            (SWR_DEFERRED_FUNC)(SWR_DEFERRED_SO_FUNC + 0),
+                            &soFunc->pfn);
    }
 
+   /* Restart index is only compiled in when enabled, don't let a stale one
+    * split the fetch shader cache. */
    struct swr_vertex_element_state *velems = ctx->velems;
+   unsigned cut_index = info->primitive_restart ? info->restart_index : 0;
    if (!velems->fsFunc
-       || (velems->fsState.cutIndex != info->restart_index)
+       || (velems->fsState.cutIndex != cut_index)
        || (velems->fsState.bEnableCutIndex != info->primitive_restart)) {
 
-      velems->fsState.cutIndex = info->restart_index;
+      velems->fsState.cutIndex = cut_index;
       velems->fsState.bEnableCutIndex = info->primitive_restart;
 
-      /* Create Fetch Shader */
-      HANDLE hJitMgr = swr_screen(ctx->pipe.screen)->hJitMgr;
-      velems->fsFunc = JitCompileFetch(hJitMgr, velems->fsState);
-
-      debug_printf("fetch shader %p\n", velems->fsFunc);
-      assert(velems->fsFunc && "Error: FetchShader = NULL");
+      /* Get Fetch Shader from the screen cache */
+      if (velems->fsFunc)
+         swr_release_jit_funcs(ctx, {velems->fsFunc});
+      velems->fsFunc =
+         swr_compile_fetch(swr_screen(ctx->pipe.screen), velems->fsState);
    }
 
-   SwrSetFetchFunc(ctx->swrContext, velems->fsFunc);
+   if (swr_compile_ready(swr_screen(pipe->screen), velems->fsFunc))
+      SwrSetFetchFunc(ctx->swrContext, (PFN_FETCH_FUNC)velems->fsFunc->pfn);
+   else
+      SwrSetDeferredFunc(
+         ctx->swrContext, SWR_DEFERRED_FETCH_FUNC, &velems->fsFunc->pfn);
+
+   /* The vertex reuse path restarts primitives itself, so its copy of the
+    * restart index has to follow the draws like the fetch shader's.  Only
+    * set it when it changes, the draws share the frontend state until then.
+    */
+   bool cut_enable = info->indexed && info->primitive_restart;
+   uint32_t cut = cut_enable ? info->restart_index : 0;
+   SWR_FRONTEND_STATE *feState = &ctx->derived.feState;
+   if (feState->bEnableCutIndex != cut_enable || feState->cutIndex != cut) {
+      feState->bEnableCutIndex = cut_enable;
+      feState->cutIndex = cut;
+      SwrSetFrontendState(ctx->swrContext, feState);
+   }
 
-   if (info->indexed)
+   if (info->indirect) {
+      const void *args = (const uint8_t *)swr_resource_data(info->indirect)
+         + info->indirect_offset;
+      /* Not covered by derived state, the buffer can change every draw. */
+      swr_resource_read(pipe, swr_resource(info->indirect));
+      if (info->indexed)
+         SwrDrawIndexedIndirect(ctx->swrContext,
+                                swr_convert_prim_topology(info->mode),
+                                (const SWR_DRAW_INDEXED_INDIRECT_ARGS *)args);
+      else
+         SwrDrawIndirect(ctx->swrContext,
+                         swr_convert_prim_topology(info->mode),
+                         (const SWR_DRAW_INDIRECT_ARGS *)args);
+   } else if (info->indexed)
       SwrDrawIndexedInstanced(ctx->swrContext,
                               swr_convert_prim_topology(info->mode),
                               info->count,
@@ -203,7 +263,7 @@ swr_finish(struct pipe_context *pipe)
    struct pipe_fence_handle *fence = nullptr;
 
    swr_flush(pipe, &fence, 0);
-   swr_fence_finish(pipe->screen, fence, 0);
+   swr_fence_finish(pipe->screen, fence, PIPE_TIMEOUT_INFINITE);
    swr_fence_reference(pipe->screen, &fence, NULL);
 }
 
@@ -21,6 +21,8 @@
  * IN THE SOFTWARE.
  ***************************************************************************/
 
+#include <chrono>
+
 #include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "os/os_time.h"
@@ -28,10 +30,7 @@
 #include "swr_context.h"
 #include "swr_screen.h"
 #include "swr_fence.h"
-
-#if defined(PIPE_CC_MSVC) // portable thread yield
-   #define sched_yield SwitchToThread
-#endif
+#include "gen_knobs.h"
 
 /*
  * Fence callback, called by back-end thread on completion of all rendering up
@@ -43,7 +42,9 @@ swr_sync_cb(UINT64 userData, UINT64 userData2, UINT64 userData3)
    struct swr_fence *fence = (struct swr_fence *)userData;
 
    /* Correct value is in SwrSync data, and not the fence write field. */
+   std::lock_guard<std::mutex> lock(fence->mutex);
    fence->read = userData2;
+   fence->cond.notify_all();
 }
 
 /*
@@ -66,12 +67,11 @@ struct pipe_fence_handle *
 swr_fence_create()
 {
    static int fence_id = 0;
-   struct swr_fence *fence = CALLOC_STRUCT(swr_fence);
-   if (!fence)
-      return NULL;
+   struct swr_fence *fence = new struct swr_fence();
 
    pipe_reference_init(&fence->reference, 1);
    fence->id = fence_id++;
+   fence->spin_ns = (uint64_t)KNOB_FENCE_SPIN_US * 1000;
 
    return (struct pipe_fence_handle *)fence;
 }
@@ -80,7 +80,11 @@ swr_fence_create()
 static void
 swr_fence_destroy(struct swr_fence *fence)
 {
-   FREE(fence);
+   /* A waiter that saw the fence signaled without sleeping may get here
+    * while the callback still holds the mutex. */
+   { std::lock_guard<std::mutex> lock(fence->mutex); }
+
+   delete fence;
 }
 
 /**
@@ -105,29 +109,105 @@ swr_fence_reference(struct pipe_screen *screen,
       swr_fence_destroy(old);
 }
 
-static INLINE boolean
-swr_is_fence_done(struct pipe_fence_handle *fence_handle)
+/*
+ * Spin for a short while before sleeping, a sleep and wakeup costs more
+ * than a short wait.  The spin time doubles when the fence signals while
+ * spinning and halves when it doesn't, up to KNOB_FENCE_SPIN_US.
+ */
+static boolean
+swr_fence_spin(struct swr_fence *fence, uint64_t value,
+               int64_t start, uint64_t timeout)
 {
-   struct swr_fence *fence = swr_fence(fence_handle);
-   return (fence->read == fence->write);
+   const uint64_t max_spin_ns = (uint64_t)KNOB_FENCE_SPIN_US * 1000;
+   if (!max_spin_ns)
+      return FALSE;
+
+   /* Concurrent waiters each adapt from the value they loaded, the last
+    * store wins */
+   const uint64_t cur_spin_ns = fence->spin_ns.load(std::memory_order_relaxed);
+   const uint64_t spin_ns = MIN2(cur_spin_ns, timeout);
+   while (fence->read < value) {
+      if ((uint64_t)(os_time_get_nano() - start) >= spin_ns) {
+         fence->spin_ns.store(MAX2(cur_spin_ns / 2, 1000),
+                              std::memory_order_relaxed);
+         return FALSE;
+      }
+      _mm_pause();
+   }
+
+   fence->spin_ns.store(MIN2(cur_spin_ns * 2, max_spin_ns),
+                        std::memory_order_relaxed);
+   return TRUE;
+}
+
+/*
+ * Sleep until the sync callback signals value, or timeout expires.
+ */
+static boolean
+swr_fence_sleep(struct swr_fence *fence, uint64_t value,
+                int64_t start, uint64_t timeout)
+{
+   std::unique_lock<std::mutex> lock(fence->mutex);
+   auto done = [fence, value] { return fence->read >= value; };
+
+   /* Anything past a few centuries can't expire, and would overflow */
+   if (timeout >= (UINT64_C(1) << 62)) {
+      fence->cond.wait(lock, done);
+      return TRUE;
+   }
+
+   uint64_t elapsed = os_time_get_nano() - start;
+   if (elapsed >= timeout)
+      return done();
+
+   return fence->cond.wait_for(
+      lock, std::chrono::nanoseconds(timeout - elapsed), done);
 }
 
 /*
  * Wait for the fence to finish.
+ * Returns FALSE if it hasn't within timeout nanoseconds.
  */
 boolean
 swr_fence_finish(struct pipe_screen *screen,
                  struct pipe_fence_handle *fence_handle,
                  uint64_t timeout)
 {
-   while (!swr_is_fence_done(fence_handle))
-      sched_yield();
+   struct swr_fence *fence = swr_fence(fence_handle);
+
+   if (!swr_fence_wait(fence_handle, fence->write, timeout))
+      return FALSE;
 
-   swr_fence(fence_handle)->pending = FALSE;
+   fence->pending = FALSE;
 
    return TRUE;
 }
 
+/*
+ * Wait for the fence to pass value, a write value it was submitted with.
+ * Returns FALSE if it hasn't within timeout nanoseconds.
+ */
+boolean
+swr_fence_wait(struct pipe_fence_handle *fence_handle,
+               uint64_t value,
+               uint64_t timeout)
+{
+   struct swr_fence *fence = swr_fence(fence_handle);
+
+   if (fence->read >= value)
+      return TRUE;
+
+   int64_t start = os_time_get_nano();
+   boolean done = swr_fence_spin(fence, value, start, timeout)
+      || swr_fence_sleep(fence, value, start, timeout);
+
+   fence->wait_count.fetch_add(1, std::memory_order_relaxed);
+   fence->wait_ns.fetch_add(os_time_get_nano() - start,
+                            std::memory_order_relaxed);
+
+   return done;
+}
+
 
 uint64_t
 swr_get_timestamp(struct pipe_screen *screen)
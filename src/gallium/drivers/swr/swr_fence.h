@@ -22,6 +22,10 @@
 #ifndef SWR_FENCE_H
 #define SWR_FENCE_H
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 #include "pipe/p_state.h"
 #include "util/u_inlines.h"
 
@@ -30,12 +34,24 @@ struct pipe_screen;
 struct swr_fence {
    struct pipe_reference reference;
 
-   uint64_t read;
+   volatile uint64_t read;
    uint64_t write;
 
    unsigned pending;
 
    unsigned id; /* Just for reference */
+
+   /* read is written under mutex by the sync callback, which wakes cond */
+   std::mutex mutex;
+   std::condition_variable cond;
+
+   /* Current spin time before sleeping, adapted per wait.  Several
+    * threads may wait on a fence, so it and the stats are atomic. */
+   std::atomic<uint64_t> spin_ns;
+
+   /* Waits that weren't already signaled, and wall time spent in them */
+   std::atomic<uint64_t> wait_count;
+   std::atomic<uint64_t> wait_ns;
 };
 
 
@@ -51,6 +67,13 @@ swr_is_fence_pending(struct pipe_fence_handle *fence_handle)
    return swr_fence(fence_handle)->pending;
 }
 
+static INLINE boolean
+swr_is_fence_done(struct pipe_fence_handle *fence_handle)
+{
+   struct swr_fence *fence = swr_fence(fence_handle);
+   return (fence->read == fence->write);
+}
+
 
 void swr_fence_init(struct pipe_screen *screen);
 
@@ -64,6 +87,10 @@ boolean swr_fence_finish(struct pipe_screen *screen,
                          struct pipe_fence_handle *fence_handle,
                          uint64_t timeout);
 
+boolean swr_fence_wait(struct pipe_fence_handle *fence,
+                       uint64_t value,
+                       uint64_t timeout);
+
 void
 swr_fence_submit(struct swr_context *ctx, struct pipe_fence_handle *fence);
 
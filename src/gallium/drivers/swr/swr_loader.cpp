@@ -38,15 +38,26 @@ swr_create_screen(struct sw_winsys *winsys)
    util_dl_library *pLibrary = nullptr;
 
    util_cpu_detect();
-   if (util_cpu_caps.has_avx2) {
-      fprintf(stderr, "AVX2\n");
-      pLibrary = util_dl_open("libswrAVX2.so");
-   } else if (util_cpu_caps.has_avx) {
-      fprintf(stderr, "AVX\n");
-      pLibrary = util_dl_open("libswrAVX.so");
-   } else {
-      fprintf(stderr, "no AVX/AVX2 support.  Aborting!\n");
-      exit(-1);
+   /* The AVX512 library is optional at build time, so fall back to AVX2 if
+    * it wasn't built. */
+   if (util_cpu_caps.has_avx512f && util_cpu_caps.has_avx512dq &&
+       util_cpu_caps.has_avx512bw && util_cpu_caps.has_avx512vl) {
+      pLibrary = util_dl_open("libswrAVX512.so");
+      if (pLibrary)
+         fprintf(stderr, "AVX512\n");
+   }
+
+   if (!pLibrary) {
+      if (util_cpu_caps.has_avx2) {
+         fprintf(stderr, "AVX2\n");
+         pLibrary = util_dl_open("libswrAVX2.so");
+      } else if (util_cpu_caps.has_avx) {
+         fprintf(stderr, "AVX\n");
+         pLibrary = util_dl_open("libswrAVX.so");
+      } else {
+         fprintf(stderr, "no AVX/AVX2 support.  Aborting!\n");
+         exit(-1);
+      }
    }
 
    if (!pLibrary) {
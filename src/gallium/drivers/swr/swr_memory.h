@@ -35,7 +35,7 @@ void StoreHotTile(
     SWR_FORMAT srcFormat,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
     UINT x, UINT y, uint32_t renderTargetArrayIndex,
-    BYTE *pSrcHotTile);
+    uint32_t numSamples, BYTE *pSrcHotTile);
 
 void StoreHotTileClear(
     SWR_SURFACE_STATE *pDstSurface,
@@ -63,13 +63,21 @@ swr_StoreHotTile(HANDLE hPrivateContext,
                  SWR_FORMAT srcFormat,
                  SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
                  UINT x, UINT y,
-                 uint32_t renderTargetArrayIndex, BYTE* pSrcHotTile)
+                 uint32_t renderTargetArrayIndex, uint32_t numSamples,
+                 BYTE* pSrcHotTile)
 {
    // Grab destination surface state from private context
    swr_draw_context *pDC = (swr_draw_context*)hPrivateContext;
    SWR_SURFACE_STATE *pDstSurface = &pDC->renderTargets[renderTargetIndex];
 
-   StoreHotTile(pDstSurface, srcFormat, renderTargetIndex, x, y, renderTargetArrayIndex, pSrcHotTile);
+   StoreHotTile(pDstSurface, srcFormat, renderTargetIndex, x, y,
+                renderTargetArrayIndex, numSamples, pSrcHotTile);
+
+   // Multisampled color is also resolved into its single sampled copy
+   SWR_SURFACE_STATE *pResolveSurface = &pDC->resolveTargets[renderTargetIndex];
+   if (pResolveSurface->pBaseAddress)
+      StoreHotTile(pResolveSurface, srcFormat, renderTargetIndex, x, y,
+                   renderTargetArrayIndex, numSamples, pSrcHotTile);
 }
 
 INLINE void
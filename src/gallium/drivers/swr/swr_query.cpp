@@ -29,6 +29,7 @@
 #include "swr_query.h"
 #include "swr_screen.h"
 #include "swr_state.h"
+#include "swr_compile.h"
 
 
 static struct swr_query *
@@ -42,7 +43,8 @@ swr_create_query(struct pipe_context *pipe, unsigned type, unsigned index)
 {
    struct swr_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES || type == SWR_QUERY_FETCH_CACHE_HITS
+          || type == SWR_QUERY_FETCH_CACHE_MISSES);
    assert(index < MAX_SO_STREAMS);
 
    pq = CALLOC_STRUCT(swr_query);
@@ -62,10 +64,9 @@ swr_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
    struct swr_query *pq = swr_query(q);
 
    if (pq->fence) {
-      if (!swr_is_fence_pending(pq->fence)) {
-         swr_fence_submit(swr_context(pipe), pq->fence);
-         swr_fence_finish(pipe->screen, pq->fence, 0);
-      }
+      /* Snapshots may still be written into the query */
+      if (swr_is_fence_pending(pq->fence))
+         swr_fence_finish(pipe->screen, pq->fence, PIPE_TIMEOUT_INFINITE);
       swr_fence_reference(pipe->screen, &pq->fence, NULL);
    }
 
@@ -73,100 +74,91 @@ swr_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 }
 
 
-// XXX Create a fence callback, rather than stalling SwrWaitForIdle
-static void
-swr_gather_stats(struct pipe_context *pipe, struct swr_query *pq)
+/*
+ * Queries answered from SwrCore counters, rather than on the API thread.
+ */
+static boolean
+swr_query_uses_stats(struct swr_query *pq)
 {
-   struct swr_context *ctx = swr_context(pipe);
-
-   assert(pq->result);
-   union pipe_query_result *result = pq->result;
-   boolean enable_stats = pq->enable_stats;
-   SWR_STATS swr_stats = {0};
-
-   if (pq->fence) {
-      if (!swr_is_fence_pending(pq->fence)) {
-         swr_fence_submit(ctx, pq->fence);
-         swr_fence_finish(pipe->screen, pq->fence, 0);
-      }
-      swr_fence_reference(pipe->screen, &pq->fence, NULL);
-   }
-
-   /*
-    * These queries don't need SWR Stats enabled in the core
-    * Set and return.
-    */
    switch (pq->type) {
    case PIPE_QUERY_TIMESTAMP:
    case PIPE_QUERY_TIME_ELAPSED:
-      result->u64 = swr_get_timestamp(pipe->screen);
-      return;
-      break;
    case PIPE_QUERY_TIMESTAMP_DISJOINT:
-      /* nothing to do here */
-      return;
-      break;
    case PIPE_QUERY_GPU_FINISHED:
-      result->b = TRUE; /* XXX TODO Add an api func to SWR to compare drawId
-                           vs LastRetiredId? */
-      return;
-      break;
+   case SWR_QUERY_FETCH_CACHE_HITS:
+   case SWR_QUERY_FETCH_CACHE_MISSES:
+      return FALSE;
    default:
-      /* Any query that needs SwrCore stats */
-      break;
+      return TRUE;
    }
+}
+
 
-   /*
-    * All other results are collected from SwrCore counters
-    */
+/*
+ * Current value of a driver specific query.  These count on the API thread,
+ * so they need no fence.
+ */
+static uint64_t
+swr_get_driver_query_value(struct pipe_screen *screen, unsigned type)
+{
+   struct swr_fetch_cache_stats stats;
+
+   swr_get_fetch_cache_stats(swr_screen(screen), &stats);
+   switch (type) {
+   case SWR_QUERY_FETCH_CACHE_HITS:
+      return stats.hits;
+   case SWR_QUERY_FETCH_CACHE_MISSES:
+      return stats.misses;
+   default:
+      assert(0 && "Unsupported query");
+      return 0;
+   }
+}
 
-   /* XXX, Should turn this into a fence callback and skip the stall */
-   SwrGetStats(ctx->swrContext, &swr_stats);
-   /* SwrGetStats returns immediately, wait for collection */
-   SwrWaitForIdle(ctx->swrContext);
 
+static void
+swr_convert_stats(struct swr_query *pq,
+                  const SWR_STATS *swr_stats,
+                  union pipe_query_result *result)
+{
    switch (pq->type) {
    case PIPE_QUERY_OCCLUSION_PREDICATE:
    case PIPE_QUERY_OCCLUSION_COUNTER:
-      result->u64 = swr_stats.DepthPassCount;
+      result->u64 = swr_stats->DepthPassCount;
       break;
    case PIPE_QUERY_PRIMITIVES_GENERATED:
-      result->u64 = swr_stats.IaPrimitives;
+      result->u64 = swr_stats->IaPrimitives;
       break;
    case PIPE_QUERY_PRIMITIVES_EMITTED:
-      result->u64 = swr_stats.SoNumPrimsWritten[pq->index];
+      result->u64 = swr_stats->SoNumPrimsWritten[pq->index];
       break;
    case PIPE_QUERY_SO_STATISTICS:
    case PIPE_QUERY_SO_OVERFLOW_PREDICATE: {
       struct pipe_query_data_so_statistics *so_stats = &result->so_statistics;
       so_stats->num_primitives_written =
-         swr_stats.SoNumPrimsWritten[pq->index];
+         swr_stats->SoNumPrimsWritten[pq->index];
       so_stats->primitives_storage_needed =
-         swr_stats.SoPrimStorageNeeded[pq->index];
+         swr_stats->SoPrimStorageNeeded[pq->index];
    } break;
    case PIPE_QUERY_PIPELINE_STATISTICS: {
       struct pipe_query_data_pipeline_statistics *p_stats =
          &result->pipeline_statistics;
-      p_stats->ia_vertices = swr_stats.IaVertices;
-      p_stats->ia_primitives = swr_stats.IaPrimitives;
-      p_stats->vs_invocations = swr_stats.VsInvocations;
-      p_stats->gs_invocations = swr_stats.GsInvocations;
-      p_stats->gs_primitives = swr_stats.GsPrimitives;
-      p_stats->c_invocations = swr_stats.CPrimitives;
-      p_stats->c_primitives = swr_stats.CPrimitives;
-      p_stats->ps_invocations = swr_stats.PsInvocations;
-      p_stats->hs_invocations = swr_stats.HsInvocations;
-      p_stats->ds_invocations = swr_stats.DsInvocations;
-      p_stats->cs_invocations = swr_stats.CsInvocations;
+      p_stats->ia_vertices = swr_stats->IaVertices;
+      p_stats->ia_primitives = swr_stats->IaPrimitives;
+      p_stats->vs_invocations = swr_stats->VsInvocations;
+      p_stats->gs_invocations = swr_stats->GsInvocations;
+      p_stats->gs_primitives = swr_stats->GsPrimitives;
+      p_stats->c_invocations = swr_stats->CPrimitives;
+      p_stats->c_primitives = swr_stats->CPrimitives;
+      p_stats->ps_invocations = swr_stats->PsInvocations;
+      p_stats->hs_invocations = swr_stats->HsInvocations;
+      p_stats->ds_invocations = swr_stats->DsInvocations;
+      p_stats->cs_invocations = swr_stats->CsInvocations;
    } break;
    default:
       assert(0 && "Unsupported query");
       break;
    }
-
-   /* Only change stat collection if there are no active queries */
-   if (ctx->active_queries == 0)
-      SwrEnableStats(ctx->swrContext, enable_stats);
 }
 
 
@@ -176,17 +168,18 @@ swr_get_query_result(struct pipe_context *pipe,
                      boolean wait,
                      union pipe_query_result *result)
 {
-   struct swr_context *ctx = swr_context(pipe);
    struct swr_query *pq = swr_query(q);
 
-   if (pq->fence) {
-      if (!swr_is_fence_pending(pq->fence)) {
-         swr_fence_submit(ctx, pq->fence);
-         if (!wait)
-            return FALSE;
-         swr_fence_finish(pipe->screen, pq->fence, 0);
-      }
-      swr_fence_reference(pipe->screen, &pq->fence, NULL);
+   /* Results are ready once the end snapshot's fence has signaled */
+   if (pq->fence && swr_is_fence_pending(pq->fence)) {
+      if (!wait && !swr_is_fence_done(pq->fence))
+         return FALSE;
+      swr_fence_finish(pipe->screen, pq->fence, PIPE_TIMEOUT_INFINITE);
+   }
+
+   if (swr_query_uses_stats(pq)) {
+      swr_convert_stats(pq, &pq->start_stats, &pq->start);
+      swr_convert_stats(pq, &pq->end_stats, &pq->end);
    }
 
    /* XXX: Need to handle counter rollover */
@@ -205,6 +198,8 @@ swr_get_query_result(struct pipe_context *pipe,
    case PIPE_QUERY_TIME_ELAPSED:
    case PIPE_QUERY_PRIMITIVES_GENERATED:
    case PIPE_QUERY_PRIMITIVES_EMITTED:
+   case SWR_QUERY_FETCH_CACHE_HITS:
+   case SWR_QUERY_FETCH_CACHE_MISSES:
       result->u64 = pq->end.u64 - pq->start.u64;
       break;
    /* Structures */
@@ -264,20 +259,31 @@ swr_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct swr_context *ctx = swr_context(pipe);
    struct swr_query *pq = swr_query(q);
 
+   /* A previous end snapshot may still be pending on a reused query */
+   if (pq->fence && swr_is_fence_pending(pq->fence))
+      swr_fence_finish(pipe->screen, pq->fence, PIPE_TIMEOUT_INFINITE);
+
    /* Initialize Results */
    memset(&pq->start, 0, sizeof(pq->start));
    memset(&pq->end, 0, sizeof(pq->end));
-
-   /* Gather start stats and enable SwrCore counters */
-   pq->result = &pq->start;
-   pq->enable_stats = TRUE;
-   swr_gather_stats(pipe, pq);
+   memset(&pq->start_stats, 0, sizeof(pq->start_stats));
+   memset(&pq->end_stats, 0, sizeof(pq->end_stats));
+
+   if (swr_query_uses_stats(pq)) {
+      /* Start stats are snapshot in order with the draws, no stall */
+      SwrGetStats(ctx->swrContext, &pq->start_stats);
+
+      /* Only change stat collection if there are no active queries */
+      if (ctx->active_queries == 0)
+         SwrEnableStats(ctx->swrContext, TRUE);
+   } else if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+      pq->start.u64 = swr_get_driver_query_value(pipe->screen, pq->type);
+   } else if (pq->type != PIPE_QUERY_TIMESTAMP) {
+      /* start timestamp stays 0 for TIMESTAMP query */
+      pq->start.u64 = swr_get_timestamp(pipe->screen);
+   }
    ctx->active_queries++;
 
-   /* override start timestamp to 0 for TIMESTAMP query */
-   if (pq->type == PIPE_QUERY_TIMESTAMP)
-      pq->start.u64 = 0;
-
    return true;
 }
 
@@ -291,10 +297,34 @@ swr_end_query(struct pipe_context *pipe, struct pipe_query *q)
           && "swr_end_query, there are no active queries!");
    ctx->active_queries--;
 
-   /* Gather end stats and disable SwrCore counters */
-   pq->result = &pq->end;
-   pq->enable_stats = FALSE;
-   swr_gather_stats(pipe, pq);
+   switch (pq->type) {
+   case PIPE_QUERY_TIMESTAMP:
+   case PIPE_QUERY_TIME_ELAPSED:
+      pq->end.u64 = swr_get_timestamp(pipe->screen);
+      return;
+   case PIPE_QUERY_TIMESTAMP_DISJOINT:
+      return;
+   case SWR_QUERY_FETCH_CACHE_HITS:
+   case SWR_QUERY_FETCH_CACHE_MISSES:
+      pq->end.u64 = swr_get_driver_query_value(pipe->screen, pq->type);
+      return;
+   case PIPE_QUERY_GPU_FINISHED:
+      /* TRUE once the fence below signals */
+      pq->end.b = TRUE;
+      break;
+   default:
+      SwrGetStats(ctx->swrContext, &pq->end_stats);
+
+      /* Only change stat collection if there are no active queries */
+      if (ctx->active_queries == 0)
+         SwrEnableStats(ctx->swrContext, FALSE);
+      break;
+   }
+
+   /* Fence callback signals the result, instead of waiting for idle */
+   if (!pq->fence)
+      pq->fence = swr_fence_create();
+   swr_fence_submit(ctx, pq->fence);
 }
 
 
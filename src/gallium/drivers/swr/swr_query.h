@@ -26,18 +26,25 @@
 
 
 #include <limits.h>
+#include "api.h"
+
+/* Driver specific queries, see swr_get_driver_query_info */
+#define SWR_QUERY_FETCH_CACHE_HITS   (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define SWR_QUERY_FETCH_CACHE_MISSES (PIPE_QUERY_DRIVER_SPECIFIC + 1)
 
 struct swr_query {
    unsigned type; /* PIPE_QUERY_* */
    unsigned index;
 
-   union pipe_query_result *result;
    union pipe_query_result start;
    union pipe_query_result end;
 
-   struct pipe_fence_handle *fence;
+   /* SwrCore counter snapshots, filled in by the backend when the
+    * SwrGetStats queued at begin/end executes.  Valid once fence is done. */
+   SWR_STATS start_stats;
+   SWR_STATS end_stats;
 
-   boolean enable_stats;
+   struct pipe_fence_handle *fence;
 };
 
 extern void swr_query_init(struct pipe_context *pipe);
@@ -47,8 +47,16 @@ struct swr_resource {
    SWR_SURFACE_STATE swr;
    SWR_SURFACE_STATE secondary; /* for faking depth/stencil merged formats */
 
+   /* The stencil bytes of the merged depth/stencil storage in swr match
+    * secondary over all of level 0, so maps needn't interleave them. */
+   bool stencil_interleaved;
+
    struct sw_displaytarget *display_target;
 
+   /* Single sampled copy of a multisampled color resource.  Kept resolved
+    * by every hot tile store, blits read from it. */
+   struct pipe_resource *resolve_target;
+
    unsigned row_stride[PIPE_MAX_TEXTURE_LEVELS];
    unsigned img_stride[PIPE_MAX_TEXTURE_LEVELS];
    unsigned mip_offsets[PIPE_MAX_TEXTURE_LEVELS];
@@ -88,6 +96,19 @@ swr_resource_is_texture(const struct pipe_resource *resource)
 }
 
 
+/*
+ * Byte offset of x_bytes, y within an image laid out in Y-major tiles:
+ * 4KB tiles of 128 bytes x 32 rows, made of eight 16 byte wide columns.
+ * Matches TilingTraits<SWR_TILE_MODE_YMAJOR> and gallivm's tiled sampling.
+ */
+static INLINE unsigned
+swr_tiled_offset(unsigned row_stride, unsigned x_bytes, unsigned y)
+{
+   return (y >> 5) * (row_stride << 5) + ((x_bytes >> 7) << 12)
+      + ((x_bytes & 0x70) << 5) + ((y & 0x1f) << 4) + (x_bytes & 0xf);
+}
+
+
 static INLINE void *
 swr_resource_data(struct pipe_resource *resource)
 {
@@ -130,6 +151,7 @@ static INLINE void
 swr_resource_write(struct pipe_context *pipe, struct swr_resource *resource)
 {
    resource->status |= SWR_RESOURCE_WRITE;
+   resource->stencil_interleaved = false;
    resource->bound_to_context = pipe;
 }
 
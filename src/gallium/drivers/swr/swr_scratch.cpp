@@ -22,63 +22,171 @@
  ***************************************************************************/
 
 #include "util/u_memory.h"
+#include "util/u_debug.h"
+#include "os/os_time.h"
 #include "swr_context.h"
 #include "swr_scratch.h"
+#include "swr_fence.h"
 #include "api.h"
 
 
+/*
+ * Fence value that passes once every draw queued so far has retired.
+ * Submitted at most once per epoch.
+ */
+static uint64_t
+swr_scratch_fence(struct swr_context *ctx)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+
+   if (scratch->fence_epoch != scratch->epoch) {
+      swr_fence_submit(ctx, scratch->fence);
+      scratch->fence_epoch = scratch->epoch;
+   }
+
+   return swr_fence(scratch->fence)->write;
+}
+
+static void
+swr_scratch_wait(struct swr_context *ctx, uint64_t value)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+
+   if (swr_fence(scratch->fence)->read >= value)
+      return;
+
+   int64_t start = os_time_get_nano();
+   swr_fence_wait(scratch->fence, value, PIPE_TIMEOUT_INFINITE);
+   scratch->stats.stalls++;
+   scratch->stats.stall_ns += os_time_get_nano() - start;
+}
+
+static void
+swr_scratch_retire(struct swr_context *ctx,
+                   struct swr_scratch_space *space,
+                   void *base)
+{
+   struct swr_scratch_retired *retired = CALLOC_STRUCT(swr_scratch_retired);
+
+   retired->base = base;
+   retired->epoch = ctx->scratch->epoch;
+   retired->next = space->retired;
+   space->retired = retired;
+}
+
+/*
+ * Called on the first copy into space in a new epoch: everything written
+ * into it before is now only read by queued draws, so segments and
+ * buffers left behind get the fence covering them.  Retired buffers whose
+ * fence passed are freed.
+ */
+static void
+swr_scratch_update_fences(struct swr_context *ctx,
+                          struct swr_scratch_space *space)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+   struct swr_fence *fence = swr_fence(scratch->fence);
+
+   if (space->closed_mask && space->closed_epoch != scratch->epoch) {
+      uint64_t value = swr_scratch_fence(ctx);
+      for (unsigned i = 0; i < SWR_SCRATCH_SEGMENTS; i++)
+         if (space->closed_mask & (1 << i))
+            space->segment_fence[i] = value;
+      space->closed_mask = 0;
+   }
+
+   struct swr_scratch_retired **link = &space->retired;
+   while (*link) {
+      struct swr_scratch_retired *retired = *link;
+      if (!retired->fence && retired->epoch != scratch->epoch)
+         retired->fence = swr_scratch_fence(ctx);
+
+      if (retired->fence && fence->read >= retired->fence) {
+         *link = retired->next;
+         align_free(retired->base);
+         FREE(retired);
+      } else {
+         link = &retired->next;
+      }
+   }
+}
+
+/*
+ * Replace the ring with one of size bytes.  The old one is retired, draws
+ * in flight may still read it.
+ */
+static void
+swr_scratch_grow(struct swr_context *ctx,
+                 struct swr_scratch_space *space,
+                 unsigned int size)
+{
+   if (space->base) {
+      swr_scratch_retire(ctx, space, space->base);
+      ctx->scratch->stats.grows++;
+   }
+
+   space->base = align_malloc(size, 16);
+   space->head = space->base;
+   space->current_size = size;
+   space->segment = 0;
+   space->closed_mask = 0;
+   memset(space->segment_fence, 0, sizeof(space->segment_fence));
+}
+
 void *
 swr_copy_to_scratch_space(struct swr_context *ctx,
                           struct swr_scratch_space *space,
                           const void *user_buffer,
                           unsigned int size)
 {
-   void *ptr;
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+   void *ptr = NULL;
    assert(space);
    assert(user_buffer);
    assert(size);
 
-   if (size >= 2048) { /* XXX TODO create KNOB_ for this */
-      /* Use per draw SwrAllocDrawContextMemory for larger copies */
-      ptr = SwrAllocDrawContextMemory(ctx->swrContext, size, 4);
-   } else {
-      /* Allocate enough so that MAX_DRAWS_IN_FLIGHT sets fit. */
-      unsigned int max_size_in_flight = size * KNOB_MAX_DRAWS_IN_FLIGHT;
+   swr_scratch_update_fences(ctx, space);
 
-      /* Need to grow space */
-      if (max_size_in_flight > space->current_size) {
-         /* Must idle the pipeline, this is infrequent */
-         SwrWaitForIdle(ctx->swrContext);
+   unsigned int aligned_size = align(size, 16);
 
-         space->current_size = max_size_in_flight;
+   /* Grow the ring until an allocation is at most half a segment */
+   unsigned int needed = aligned_size * 2 * SWR_SCRATCH_SEGMENTS;
+   if (needed > space->current_size && needed <= SWR_SCRATCH_MAX_SIZE)
+      swr_scratch_grow(ctx, space,
+                       MAX2(util_next_power_of_two(needed),
+                            SWR_SCRATCH_MIN_SIZE));
 
-         if (space->base) {
-            align_free(space->base);
-            space->base = NULL;
-         }
+   if (needed <= space->current_size) {
+      unsigned int segment_size = space->current_size / SWR_SCRATCH_SEGMENTS;
+      BYTE *segment_end = (BYTE *)space->base
+         + (space->segment + 1) * segment_size;
 
-         if (!space->base) {
-            space->base = (BYTE *)align_malloc(space->current_size, 4);
-            space->head = (void *)space->base;
-         }
-      }
+      if ((BYTE *)space->head + aligned_size <= segment_end) {
+         ptr = space->head;
+      } else {
+         /* Move to the next segment once the draws reading it retired.
+          * If it's still in use by this epoch, this draw's uploads
+          * outgrew the ring. */
+         unsigned int next = (space->segment + 1) % SWR_SCRATCH_SEGMENTS;
+         if (!(space->closed_mask & (1 << next))) {
+            swr_scratch_wait(ctx, space->segment_fence[next]);
 
-      /* Wrap */
-      if (((BYTE *)space->head + size)
-          >= ((BYTE *)space->base + space->current_size)) {
-         /*
-          * TODO XXX: Should add a fence on wrap.  Assumption is that
-          * current_space >> size, and there are at least MAX_DRAWS_IN_FLIGHT
-          * draws in scratch.  So fence would always be met on wrap.  A fence
-          * would ensure that first frame in buffer is done before wrapping.
-          * If fence ever needs to be waited on, can increase buffer size.
-          * So far in testing, this hasn't been necessary.
-          */
-         space->head = space->base;
+            space->closed_mask |= 1 << space->segment;
+            space->closed_epoch = scratch->epoch;
+            space->segment = next;
+            ptr = (BYTE *)space->base + next * segment_size;
+         }
       }
+   }
 
-      ptr = space->head;
-      space->head = (BYTE *)space->head + size;
+   if (ptr) {
+      space->head = (BYTE *)ptr + aligned_size;
+      scratch->stats.ring_bytes += size;
+   } else {
+      /* Dedicated buffer, retired right away like a full segment */
+      ptr = align_malloc(size, 16);
+      swr_scratch_retire(ctx, space, ptr);
+      scratch->stats.dedicated_bytes += size;
    }
 
    /* Copy user_buffer to scratch */
@@ -88,29 +196,64 @@ swr_copy_to_scratch_space(struct swr_context *ctx,
 }
 
 
+void
+swr_scratch_new_epoch(struct swr_context *ctx)
+{
+   ctx->scratch->epoch++;
+}
+
+void
+swr_get_scratch_stats(struct swr_context *ctx,
+                      struct swr_scratch_stats *stats)
+{
+   *stats = ctx->scratch->stats;
+}
+
+static void
+swr_destroy_scratch_space(struct swr_scratch_space *space)
+{
+   if (space->base)
+      align_free(space->base);
+
+   while (space->retired) {
+      struct swr_scratch_retired *retired = space->retired;
+      space->retired = retired->next;
+      align_free(retired->base);
+      FREE(retired);
+   }
+}
+
 void
 swr_init_scratch_buffers(struct swr_context *ctx)
 {
    struct swr_scratch_buffers *scratch;
 
    scratch = CALLOC_STRUCT(swr_scratch_buffers);
+   scratch->fence = swr_fence_create();
+   scratch->epoch = 1;
    ctx->scratch = scratch;
 }
 
+/* Context must be idle */
 void
 swr_destroy_scratch_buffers(struct swr_context *ctx)
 {
    struct swr_scratch_buffers *scratch = ctx->scratch;
 
    if (scratch) {
-      if (scratch->vs_constants.base)
-         align_free(scratch->vs_constants.base);
-      if (scratch->fs_constants.base)
-         align_free(scratch->fs_constants.base);
-      if (scratch->vertex_buffer.base)
-         align_free(scratch->vertex_buffer.base);
-      if (scratch->index_buffer.base)
-         align_free(scratch->index_buffer.base);
+      debug_printf("swr: scratch %llu bytes in rings, %llu bytes dedicated, "
+                   "%llu stalls (%llu us), %llu grows\n",
+                   (unsigned long long)scratch->stats.ring_bytes,
+                   (unsigned long long)scratch->stats.dedicated_bytes,
+                   (unsigned long long)scratch->stats.stalls,
+                   (unsigned long long)scratch->stats.stall_ns / 1000,
+                   (unsigned long long)scratch->stats.grows);
+
+      swr_destroy_scratch_space(&scratch->vs_constants);
+      swr_destroy_scratch_space(&scratch->fs_constants);
+      swr_destroy_scratch_space(&scratch->vertex_buffer);
+      swr_destroy_scratch_space(&scratch->index_buffer);
+      swr_fence_reference(NULL, &scratch->fence, NULL);
       FREE(scratch);
    }
 }
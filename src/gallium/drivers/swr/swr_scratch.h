@@ -24,12 +24,49 @@
 #ifndef SWR_SCRATCH_H
 #define SWR_SCRATCH_H
 
+/* Rings are split in segments, an allocation never straddles two. */
+#define SWR_SCRATCH_SEGMENTS 4
+
+/* Ring sizes, per scratch space.  Allocations larger than half a segment
+ * of the largest ring get a dedicated buffer. */
+#define SWR_SCRATCH_MIN_SIZE (64 * 1024)
+#define SWR_SCRATCH_MAX_SIZE (16 * 1024 * 1024)
+
+/*
+ * A buffer no longer handed out, freed once the fence passes the draws
+ * that may read it.  fence is 0 until those draws have all been queued.
+ */
+struct swr_scratch_retired {
+   void *base;
+   unsigned int epoch;
+   uint64_t fence;
+   struct swr_scratch_retired *next;
+};
+
 struct swr_scratch_space {
    void *head;
    unsigned int current_size;
-   /* TODO XXX: Add a fence for wrap condition. */
 
    void *base;
+
+   /* Segment head is in, and for every segment the scratch fence value
+    * that must pass before it is written again. */
+   unsigned int segment;
+   uint64_t segment_fence[SWR_SCRATCH_SEGMENTS];
+
+   /* Segments left during closed_epoch, whose fence isn't known yet */
+   unsigned int closed_mask;
+   unsigned int closed_epoch;
+
+   struct swr_scratch_retired *retired;
+};
+
+struct swr_scratch_stats {
+   uint64_t ring_bytes;      /* copied into rings */
+   uint64_t dedicated_bytes; /* copied into dedicated buffers */
+   uint64_t stalls;          /* waits for a segment to retire */
+   uint64_t stall_ns;
+   uint64_t grows;           /* rings replaced by larger ones */
 };
 
 struct swr_scratch_buffers {
@@ -37,6 +74,17 @@ struct swr_scratch_buffers {
    struct swr_scratch_space fs_constants;
    struct swr_scratch_space vertex_buffer;
    struct swr_scratch_space index_buffer;
+
+   /* Submitted behind the draws that read a segment before it's reused */
+   struct pipe_fence_handle *fence;
+
+   /* Bumped per state validation.  The first copy into a space in a new
+    * epoch starts replacing every pointer into it, so its earlier data is
+    * only read by draws that have already been queued. */
+   unsigned int epoch;
+   unsigned int fence_epoch;
+
+   struct swr_scratch_stats stats;
 };
 
 
@@ -44,6 +92,8 @@ struct swr_scratch_buffers {
  * swr_copy_to_scratch_space
  * Copies size bytes of user_buffer into the scratch ring buffer.
  * Used to store temporary data such as client arrays and constants.
+ * The copy stays valid until the next epoch's copy into the same space
+ * has been read by the draws queued after it.
  *
  * Inputs:
  *   space ptr to scratch pool (vs_constants, fs_constants)
@@ -57,6 +107,16 @@ void *swr_copy_to_scratch_space(struct swr_context *ctx,
                                 const void *user_buffer,
                                 unsigned int size);
 
+/*
+ * swr_scratch_new_epoch
+ * Starts the uploads for the next draw.  Every user buffer still needed
+ * must be copied again after this.
+ */
+void swr_scratch_new_epoch(struct swr_context *ctx);
+
+void swr_get_scratch_stats(struct swr_context *ctx,
+                           struct swr_scratch_stats *stats);
+
 void swr_init_scratch_buffers(struct swr_context *ctx);
 void swr_destroy_scratch_buffers(struct swr_context *ctx);
 
@@ -39,6 +39,8 @@ extern "C" {
 #include "swr_context.h"
 #include "swr_resource.h"
 #include "swr_fence.h"
+#include "swr_compile.h"
+#include "swr_query.h"
 #include "gen_knobs.h"
 
 #include "jit_api.h"
@@ -383,6 +385,33 @@ swr_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
    return 0.0;
 }
 
+
+static int
+swr_get_driver_query_info(struct pipe_screen *screen,
+                          unsigned index,
+                          struct pipe_driver_query_info *info)
+{
+#define QUERY(NAME, ENUM) \
+   {NAME, ENUM, {0}, PIPE_DRIVER_QUERY_TYPE_UINT64, \
+    PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE, 0, 0x0}
+
+   static const struct pipe_driver_query_info queries[] = {
+      /* screen wide fetch shader cache, see swr_compile_fetch */
+      QUERY("fetch-cache-hits", SWR_QUERY_FETCH_CACHE_HITS),
+      QUERY("fetch-cache-misses", SWR_QUERY_FETCH_CACHE_MISSES),
+   };
+#undef QUERY
+
+   if (!info)
+      return Elements(queries);
+
+   if (index >= Elements(queries))
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
 SWR_FORMAT
 mesa_to_swr_format(enum pipe_format format)
 {
@@ -460,6 +489,42 @@ swr_displaytarget_layout(struct swr_screen *screen, struct swr_resource *res)
    return TRUE;
 }
 
+/*
+ * Whether a texture is laid out in Y-major tiles.  Sampling, transfers and
+ * tile load/store all handle them, anything the winsys or another process
+ * sees stays linear.
+ */
+static boolean
+swr_texture_tiled(const struct pipe_resource *pt)
+{
+   const struct util_format_description *desc =
+      util_format_description(pt->format);
+
+   if (!KNOB_TILED_TEXTURES)
+      return FALSE;
+
+   if (pt->bind & (PIPE_BIND_DISPLAY_TARGET | PIPE_BIND_SCANOUT
+                   | PIPE_BIND_SHARED | PIPE_BIND_LINEAR))
+      return FALSE;
+
+   switch (pt->target) {
+   case PIPE_TEXTURE_2D:
+   case PIPE_TEXTURE_2D_ARRAY:
+   case PIPE_TEXTURE_RECT:
+   case PIPE_TEXTURE_CUBE:
+      break;
+   default:
+      return FALSE;
+   }
+
+   /* Pixels must not straddle the 16 byte columns of a tile */
+   return pt->nr_samples <= 1
+      && desc->colorspace != UTIL_FORMAT_COLORSPACE_ZS
+      && desc->block.width == 1 && desc->block.height == 1
+      && util_is_power_of_two(desc->block.bits)
+      && desc->block.bits >= 8 && desc->block.bits <= 128;
+}
+
 static boolean
 swr_texture_layout(struct swr_screen *screen,
                    struct swr_resource *res,
@@ -480,9 +545,10 @@ swr_texture_layout(struct swr_screen *screen,
    res->swr.height = pt->height0;
    res->swr.depth = pt->depth0;
    res->swr.type = swr_convert_target_type(pt->target);
-   res->swr.tileMode = SWR_TILE_NONE;
+   res->swr.tileMode =
+      swr_texture_tiled(pt) ? SWR_TILE_MODE_YMAJOR : SWR_TILE_NONE;
    res->swr.format = mesa_to_swr_format(fmt);
-   res->swr.numSamples = (1 << pt->nr_samples);
+   res->swr.numSamples = MAX2(pt->nr_samples, 1);
 
    SWR_FORMAT_INFO finfo = GetFormatInfo(res->swr.format);
 
@@ -504,6 +570,12 @@ swr_texture_layout(struct swr_screen *screen,
          alignedHeight = height;
       }
 
+      /* Rows of whole tiles, 128 bytes by 32 rows */
+      if (res->swr.tileMode == SWR_TILE_MODE_YMAJOR) {
+         alignedWidth = align(alignedWidth, 128 / finfo.Bpp);
+         alignedHeight = align(alignedHeight, 32);
+      }
+
       if (level == 0) {
          res->alignedWidth = alignedWidth;
          res->alignedHeight = alignedHeight;
@@ -536,22 +608,28 @@ swr_texture_layout(struct swr_screen *screen,
    res->swr.valign = res->alignedHeight;
    res->swr.pitch = res->row_stride[0];
 
+   /* The core addresses array slices through qpitch, level 0 slices are
+    * alignedHeight rows apart in linear and tiled layouts alike. */
+   res->swr.qpitch = res->alignedHeight;
+
+   /* Tile stores only take the optimized path into tiled surfaces that
+    * start on a page, levels are whole 4KB tiles so they all do then. */
    if (allocate) {
-      res->swr.pBaseAddress = (BYTE *)_aligned_malloc(total_size, 64);
+      res->swr.pBaseAddress = (BYTE *)_aligned_malloc(total_size, 4096);
 
       if (res->has_depth && res->has_stencil) {
+         res->secondary.format = R8_UINT;
          SWR_FORMAT_INFO finfo = GetFormatInfo(res->secondary.format);
          res->secondary.width = pt->width0;
          res->secondary.height = pt->height0;
          res->secondary.depth = pt->depth0;
          res->secondary.type = SURFACE_2D;
          res->secondary.tileMode = SWR_TILE_NONE;
-         res->secondary.format = R8_UINT;
-         res->secondary.numSamples = (1 << pt->nr_samples);
+         res->secondary.numSamples = MAX2(pt->nr_samples, 1);
          res->secondary.pitch = res->alignedWidth * finfo.Bpp;
 
          res->secondary.pBaseAddress = (BYTE *)_aligned_malloc(
-            res->alignedHeight * res->secondary.pitch, 64);
+            res->alignedHeight * res->secondary.pitch, 4096);
       }
    }
 
@@ -568,6 +646,9 @@ swr_can_create_resource(struct pipe_screen *screen,
    return swr_texture_layout(swr_screen(screen), &res, false);
 }
 
+static void swr_resource_destroy(struct pipe_screen *p_screen,
+                                 struct pipe_resource *pt);
+
 static struct pipe_resource *
 swr_resource_create(struct pipe_screen *_screen,
                     const struct pipe_resource *templat)
@@ -608,6 +689,22 @@ swr_resource_create(struct pipe_screen *_screen,
          goto fail;
    }
 
+   /* Multisampled color render targets get a single sampled copy that hot
+    * tile stores resolve into, see swr_StoreHotTile. */
+   if (templat->nr_samples > 1 && (templat->bind & PIPE_BIND_RENDER_TARGET)
+       && !util_format_is_depth_or_stencil(templat->format)
+       && !util_format_is_pure_integer(templat->format)) {
+      struct pipe_resource resolve = *templat;
+      resolve.nr_samples = 0;
+      resolve.bind &= ~(PIPE_BIND_DISPLAY_TARGET | PIPE_BIND_SCANOUT
+                        | PIPE_BIND_SHARED);
+      res->resolve_target = swr_resource_create(_screen, &resolve);
+      if (!res->resolve_target) {
+         swr_resource_destroy(_screen, &res->base);
+         return NULL;
+      }
+   }
+
    return &res->base;
 
 fail:
@@ -629,7 +726,7 @@ swr_resource_destroy(struct pipe_screen *p_screen, struct pipe_resource *pt)
       if (!swr_is_fence_pending(screen->flush_fence))
          swr_fence_submit(swr_context(pipe), screen->flush_fence);
 
-      swr_fence_finish(p_screen, screen->flush_fence, 0);
+      swr_fence_finish(p_screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
       swr_resource_unused(pipe, spr);
    }
 
@@ -646,6 +743,8 @@ swr_resource_destroy(struct pipe_screen *p_screen, struct pipe_resource *pt)
 
    _aligned_free(spr->secondary.pBaseAddress);
 
+   pipe_resource_reference(&spr->resolve_target, NULL);
+
    FREE(spr);
 }
 
@@ -664,7 +763,7 @@ swr_flush_frontbuffer(struct pipe_screen *p_screen,
    struct pipe_context *pipe = spr->bound_to_context;
 
    if (pipe) {
-      swr_fence_finish(p_screen, screen->flush_fence, 0);
+      swr_fence_finish(p_screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
       swr_resource_unused(pipe, spr);
       SwrEndFrame(swr_context(pipe)->swrContext);
    }
@@ -684,11 +783,26 @@ swr_destroy_screen(struct pipe_screen *p_screen)
 
    fprintf(stderr, "SWR destroy screen!\n");
 
-   swr_fence_finish(p_screen, screen->flush_fence, 0);
-   swr_fence_reference(p_screen, &screen->flush_fence, NULL);
+   if (screen->flush_fence) {
+      struct swr_fence *fence = swr_fence(screen->flush_fence);
+      swr_fence_finish(p_screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
 
+      /* Read the wait stats before dropping the last fence reference */
+      uint64_t wait_count = fence->wait_count;
+      uint64_t wait_ns = fence->wait_ns;
+      swr_fence_reference(p_screen, &screen->flush_fence, NULL);
+
+      debug_printf("swr: flush fence waited %llu times for %llu us\n",
+                   (unsigned long long)wait_count,
+                   (unsigned long long)wait_ns / 1000);
+   }
+
+   swr_compile_pool_destroy(screen);
    JitDestroyContext(screen->hJitMgr);
 
+   if (screen->hWorkerPool)
+      SwrDestroyWorkerPool(screen->hWorkerPool);
+
    if (winsys->destroy)
       winsys->destroy(winsys);
 
@@ -719,6 +833,7 @@ swr_create_screen(struct sw_winsys *winsys)
    screen->base.get_param = swr_get_param;
    screen->base.get_shader_param = swr_get_shader_param;
    screen->base.get_paramf = swr_get_paramf;
+   screen->base.get_driver_query_info = swr_get_driver_query_info;
 
    screen->base.resource_create = swr_resource_create;
    screen->base.resource_destroy = swr_resource_destroy;
@@ -726,6 +841,10 @@ swr_create_screen(struct sw_winsys *winsys)
    screen->base.flush_frontbuffer = swr_flush_frontbuffer;
 
    screen->hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
+   swr_compile_pool_init(screen);
+
+   if (KNOB_SHARED_WORKER_POOL)
+      screen->hWorkerPool = SwrCreateWorkerPool();
 
    swr_fence_init(&screen->base);
 
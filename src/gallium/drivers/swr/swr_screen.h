@@ -29,6 +29,7 @@
 #include "api.h"
 
 struct sw_winsys;
+struct swr_compile_pool;
 
 struct swr_screen {
    struct pipe_screen base;
@@ -38,6 +39,10 @@ struct swr_screen {
    struct sw_winsys *winsys;
 
    HANDLE hJitMgr;
+   struct swr_compile_pool *compile_pool;
+
+   /* Worker threads shared by all contexts, see KNOB_SHARED_WORKER_POOL */
+   HANDLE hWorkerPool;
 };
 
 static INLINE struct swr_screen *
@@ -25,11 +25,13 @@
 #include "state.h"
 #include "state_llvm.h"
 #include "builder.h"
+#include "rdtsc_core.h"
 
 #include "llvm-c/Core.h"
 #include "llvm/Support/CBindingWrapping.h"
 
 #include "tgsi/tgsi_strings.h"
+#include "tgsi/tgsi_parse.h"
 #include "gallivm/lp_bld_init.h"
 #include "gallivm/lp_bld_flow.h"
 #include "gallivm/lp_bld_struct.h"
@@ -37,14 +39,27 @@
 
 #include "swr_context.h"
 #include "swr_context_llvm.h"
+#include "swr_resource.h"
 #include "swr_state.h"
 #include "swr_screen.h"
+#include "swr_compile.h"
 
 bool operator==(const swr_jit_key &lhs, const swr_jit_key &rhs)
 {
    return !memcmp(&lhs, &rhs, sizeof(lhs));
 }
 
+static void
+swr_static_texture_state(struct lp_static_texture_state *state,
+                         const struct pipe_sampler_view *view)
+{
+   lp_sampler_static_texture_state(state, view);
+
+   if (view && view->texture)
+      state->tiled =
+         swr_resource(view->texture)->swr.tileMode != SWR_TILE_NONE;
+}
+
 void
 swr_generate_fs_key(struct swr_jit_key &key,
                     struct swr_context *ctx,
@@ -58,6 +73,8 @@ swr_generate_fs_key(struct swr_jit_key &key,
    memcpy(&key.vs_output_semantic_idx,
           &ctx->vs->info.base.output_semantic_index,
           sizeof(key.vs_output_semantic_idx));
+   key.vs_num_outputs = ctx->vs->info.base.num_outputs;
+   key.sprite_coord_enable = ctx->rasterizer->sprite_coord_enable;
 
    key.nr_samplers = swr_fs->info.base.file_max[TGSI_FILE_SAMPLER] + 1;
 
@@ -79,7 +96,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
          swr_fs->info.base.file_max[TGSI_FILE_SAMPLER_VIEW] + 1;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -88,7 +105,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
       key.nr_sampler_views = key.nr_samplers;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -105,9 +122,45 @@ struct BuilderSWR : public Builder {
 
    PFN_VERTEX_FUNC
    CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
-   PFN_PIXEL_KERNEL CompileFS(struct swr_context *ctx, swr_jit_key &key);
+   PFN_PIXEL_KERNEL CompileFS(const struct tgsi_token *tokens,
+                              const struct lp_tgsi_info &info,
+                              const swr_jit_key &key);
+
+   void *CompileCached(struct gallivm_state *gallivm,
+                       Function *pFunction,
+                       const JitCacheKey &cacheKey,
+                       bool cached);
 };
 
+/*
+ * With the on-disk JIT cache enabled, shaders are compiled by the
+ * JitManager's engine instead of gallivm's so their objects get cached.
+ * The IR is still built on a hit, but optimization and codegen are skipped.
+ */
+void *
+BuilderSWR::CompileCached(struct gallivm_state *gallivm,
+                          Function *pFunction,
+                          const JitCacheKey &cacheKey,
+                          bool cached)
+{
+   JM()->NameCachedFunction(cacheKey, pFunction);
+
+   if (!cached) {
+      /* same passes and attributes as gallivm_compile_module */
+#if HAVE_LLVM >= 0x0307
+      LLVMAddTargetDependentFunctionAttr(
+         wrap(pFunction), "no-frame-pointer-elim", "true");
+      LLVMAddTargetDependentFunctionAttr(
+         wrap(pFunction), "no-frame-pointer-elim-non-leaf", "true");
+#endif
+      LLVMInitializeFunctionPassManager(gallivm->passmgr);
+      LLVMRunFunctionPassManager(gallivm->passmgr, wrap(pFunction));
+      LLVMFinalizeFunctionPassManager(gallivm->passmgr);
+   }
+
+   return (void *)JM()->mpExec->getFunctionAddress(cacheKey.mFuncName);
+}
+
 PFN_VERTEX_FUNC
 BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 {
@@ -125,6 +178,11 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 
    //   tgsi_dump(swr_vs->pipe.tokens, 0);
 
+   JitCacheKey cacheKey("VS");
+   cacheKey.Add(swr_vs->pipe.tokens,
+                tgsi_num_tokens(swr_vs->pipe.tokens) * sizeof(struct tgsi_token));
+   bool cached = JM()->SetupCachedModule(cacheKey);
+
    struct gallivm_state *gallivm =
       gallivm_create("VS", wrap(&JM()->mContext));
    gallivm->module = wrap(JM()->mpCurrentModule);
@@ -221,12 +279,16 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
    RET_VOID();
 
    gallivm_verify_function(gallivm, wrap(pFunction));
-   gallivm_compile_module(gallivm);
 
    //   lp_debug_dump_value(func);
 
-   PFN_VERTEX_FUNC pFunc =
-      (PFN_VERTEX_FUNC)gallivm_jit_function(gallivm, wrap(pFunction));
+   PFN_VERTEX_FUNC pFunc;
+   if (JM()->mpCache) {
+      pFunc = (PFN_VERTEX_FUNC)CompileCached(gallivm, pFunction, cacheKey, cached);
+   } else {
+      gallivm_compile_module(gallivm);
+      pFunc = (PFN_VERTEX_FUNC)gallivm_jit_function(gallivm, wrap(pFunction));
+   }
 
    debug_printf("vert shader  %p\n", pFunc);
    assert(pFunc && "Error: VertShader = NULL");
@@ -243,23 +305,28 @@ swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 {
    BuilderSWR builder(
       reinterpret_cast<JitManager *>(swr_screen(ctx->screen)->hJitMgr));
-   return builder.CompileVS(ctx, swr_vs);
+
+   RDTSC_START(JITCompileShader);
+   PFN_VERTEX_FUNC func = builder.CompileVS(ctx, swr_vs);
+   RDTSC_STOP(JITCompileShader, 1, 0);
+
+   return func;
 }
 
 static unsigned
-locate_linkage(ubyte name, ubyte index, struct tgsi_shader_info *info)
+locate_linkage(ubyte name, ubyte index, const swr_jit_key &key)
 {
    for (int i = 0; i < PIPE_MAX_SHADER_OUTPUTS; i++) {
-      if ((info->output_semantic_name[i] == name)
-          && (info->output_semantic_index[i] == index)) {
+      if ((key.vs_output_semantic_name[i] == name)
+          && (key.vs_output_semantic_idx[i] == index)) {
          return i - 1; // position is not part of the linkage
       }
    }
 
    if (name == TGSI_SEMANTIC_COLOR) { // BCOLOR fallback
       for (int i = 0; i < PIPE_MAX_SHADER_OUTPUTS; i++) {
-         if ((info->output_semantic_name[i] == TGSI_SEMANTIC_BCOLOR)
-             && (info->output_semantic_index[i] == index)) {
+         if ((key.vs_output_semantic_name[i] == TGSI_SEMANTIC_BCOLOR)
+             && (key.vs_output_semantic_idx[i] == index)) {
             return i - 1; // position is not part of the linkage
          }
       }
@@ -268,12 +335,62 @@ locate_linkage(ubyte name, ubyte index, struct tgsi_shader_info *info)
    return 0xFFFFFFFF;
 }
 
+/*
+ * Constant interpolation and point sprite masks for the backend.  These
+ * only depend on the key, so they're derived here on the API thread rather
+ * than as a side effect of compiling, which may happen on another thread.
+ */
+void
+swr_update_fs_linkage(swr_fragment_shader *swr_fs, const swr_jit_key &key)
+{
+   swr_fs->constantMask = 0;
+   swr_fs->pointSpriteMask = 0;
+
+   for (int attrib = 0; attrib < PIPE_MAX_SHADER_INPUTS; attrib++) {
+      if (!swr_fs->info.base.input_usage_mask[attrib])
+         continue;
+
+      ubyte semantic_name = swr_fs->info.base.input_semantic_name[attrib];
+      ubyte semantic_idx = swr_fs->info.base.input_semantic_index[attrib];
+
+      if (semantic_name == TGSI_SEMANTIC_FACE
+          || semantic_name == TGSI_SEMANTIC_POSITION
+          || semantic_name == TGSI_SEMANTIC_PRIMID)
+         continue;
+
+      unsigned linkedAttrib = locate_linkage(semantic_name, semantic_idx, key);
+      if (linkedAttrib == 0xFFFFFFFF) {
+         if (!key.sprite_coord_enable)
+            continue;
+         linkedAttrib = key.vs_num_outputs - 1;
+         swr_fs->pointSpriteMask |= (1 << linkedAttrib);
+      }
+
+      if (swr_fs->info.base.input_interpolate[attrib]
+          == TGSI_INTERPOLATE_CONSTANT) {
+         swr_fs->constantMask |= 1 << linkedAttrib;
+
+         if ((semantic_name == TGSI_SEMANTIC_COLOR) && key.light_twoside) {
+            unsigned bcolorAttrib =
+               locate_linkage(TGSI_SEMANTIC_BCOLOR, semantic_idx, key);
+            if (bcolorAttrib != 0xFFFFFFFF)
+               swr_fs->constantMask |= 1 << bcolorAttrib;
+         }
+      }
+   }
+}
+
 PFN_PIXEL_KERNEL
-BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
+BuilderSWR::CompileFS(const struct tgsi_token *tokens,
+                      const struct lp_tgsi_info &info,
+                      const swr_jit_key &key)
 {
-   struct swr_fragment_shader *swr_fs = ctx->fs;
+   //   tgsi_dump(tokens, 0);
 
-   //   tgsi_dump(swr_fs->pipe.tokens, 0);
+   JitCacheKey cacheKey("FS");
+   cacheKey.Add(key);
+   cacheKey.Add(tokens, tgsi_num_tokens(tokens) * sizeof(struct tgsi_token));
+   bool cached = JM()->SetupCachedModule(cacheKey);
 
    struct gallivm_state *gallivm =
       gallivm_create("FS", wrap(&JM()->mContext));
@@ -327,13 +444,10 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
    Value *pPerspAttribs =
       LOAD(pPS, {0, SWR_PS_CONTEXT_pPerspAttribs}, "pPerspAttribs");
 
-   swr_fs->constantMask = 0;
-   swr_fs->pointSpriteMask = 0;
-
    for (int attrib = 0; attrib < PIPE_MAX_SHADER_INPUTS; attrib++) {
-      const unsigned mask = swr_fs->info.base.input_usage_mask[attrib];
-      const unsigned interpMode = swr_fs->info.base.input_interpolate[attrib];
-      const unsigned interpLoc = swr_fs->info.base.input_interpolate_loc[attrib];
+      const unsigned mask = info.base.input_usage_mask[attrib];
+      const unsigned interpMode = info.base.input_interpolate[attrib];
+      const unsigned interpLoc = info.base.input_interpolate_loc[attrib];
 
       if (!mask)
          continue;
@@ -377,8 +491,8 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 
       vw->setName("w");
 
-      ubyte semantic_name = swr_fs->info.base.input_semantic_name[attrib];
-      ubyte semantic_idx = swr_fs->info.base.input_semantic_index[attrib];
+      ubyte semantic_name = info.base.input_semantic_name[attrib];
+      ubyte semantic_idx = info.base.input_semantic_index[attrib];
 
       if (semantic_name == TGSI_SEMANTIC_FACE) {
          Value *ff =
@@ -408,12 +522,11 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
       }
 
       unsigned linkedAttrib =
-         locate_linkage(semantic_name, semantic_idx, &ctx->vs->info.base);
+         locate_linkage(semantic_name, semantic_idx, key);
       if (linkedAttrib == 0xFFFFFFFF) {
          // not found - check for point sprite
-         if (ctx->rasterizer->sprite_coord_enable) {
-            linkedAttrib = ctx->vs->info.base.num_outputs - 1;
-            swr_fs->pointSpriteMask |= (1 << linkedAttrib);
+         if (key.sprite_coord_enable) {
+            linkedAttrib = key.vs_num_outputs - 1;
          } else {
             fprintf(stderr,
                     "Missing %s[%d]\n",
@@ -423,10 +536,6 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
          }
       }
 
-      if (interpMode == TGSI_INTERPOLATE_CONSTANT) {
-         swr_fs->constantMask |= 1 << linkedAttrib;
-      }
-
       for (int channel = 0; channel < TGSI_NUM_CHANNELS; channel++) {
          if (mask & (1 << channel)) {
             Value *indexA = C(linkedAttrib * 12 + channel);
@@ -434,9 +543,9 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
             Value *indexC = C(linkedAttrib * 12 + channel + 8);
 
             if ((semantic_name == TGSI_SEMANTIC_COLOR)
-                && ctx->rasterizer->light_twoside) {
+                && key.light_twoside) {
                unsigned bcolorAttrib = locate_linkage(
-                  TGSI_SEMANTIC_BCOLOR, semantic_idx, &ctx->vs->info.base);
+                  TGSI_SEMANTIC_BCOLOR, semantic_idx, key);
 
                unsigned diff = 12 * (bcolorAttrib - linkedAttrib);
 
@@ -449,10 +558,6 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
                indexA = ADD(indexA, offset);
                indexB = ADD(indexB, offset);
                indexC = ADD(indexC, offset);
-
-               if (interpMode == TGSI_INTERPOLATE_CONSTANT) {
-                  swr_fs->constantMask |= 1 << bcolorAttrib;
-               }
             }
 
             Value *va = VBROADCAST(LOAD(GEP(pAttribs, indexA)));
@@ -485,16 +590,16 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 
    struct lp_build_mask_context mask;
 
-   if (swr_fs->info.base.uses_kill) {
+   if (info.base.uses_kill) {
       Value *mask_val = LOAD(pPS, {0, SWR_PS_CONTEXT_activeMask}, "activeMask");
       lp_build_mask_begin(
          &mask, gallivm, lp_type_float_vec(32, 32 * 8), wrap(mask_val));
    }
 
    lp_build_tgsi_soa(gallivm,
-                     swr_fs->pipe.tokens,
+                     tokens,
                      lp_type_float_vec(32, 32 * 8),
-                     swr_fs->info.base.uses_kill ? &mask : NULL, // mask
+                     info.base.uses_kill ? &mask : NULL, // mask
                      wrap(consts_ptr),
                      wrap(const_sizes_ptr),
                      &system_values,
@@ -503,14 +608,14 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
                      wrap(hPrivateData),
                      NULL, // thread data
                      sampler, // sampler
-                     &swr_fs->info.base,
+                     &info.base,
                      NULL); // geometry shader face
 
    IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
 
-   for (uint32_t attrib = 0; attrib < swr_fs->info.base.num_outputs;
+   for (uint32_t attrib = 0; attrib < info.base.num_outputs;
         attrib++) {
-      switch (swr_fs->info.base.output_semantic_name[attrib]) {
+      switch (info.base.output_semantic_name[attrib]) {
       case TGSI_SEMANTIC_POSITION: {
          // write z
          LLVMValueRef outZ =
@@ -525,7 +630,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 
             LLVMValueRef out =
                LLVMBuildLoad(gallivm->builder, outputs[attrib][channel], "");
-            if (swr_fs->info.base.properties[TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS]) {
+            if (info.base.properties[TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS]) {
                for (uint32_t rt = 0; rt < key.nr_cbufs; rt++) {
                   STORE(unwrap(out),
                         pPS,
@@ -536,7 +641,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
                      pPS,
                      {0,
                            SWR_PS_CONTEXT_shaded,
-                           swr_fs->info.base.output_semantic_index[attrib],
+                           info.base.output_semantic_index[attrib],
                            channel});
             }
          }
@@ -545,22 +650,22 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
       default: {
          fprintf(stderr,
                  "unknown output from FS %s[%d]\n",
-                 tgsi_semantic_names[swr_fs->info.base
+                 tgsi_semantic_names[info.base
                                         .output_semantic_name[attrib]],
-                 swr_fs->info.base.output_semantic_index[attrib]);
+                 info.base.output_semantic_index[attrib]);
          break;
       }
       }
    }
 
    LLVMValueRef mask_result = 0;
-   if (swr_fs->info.base.uses_kill) {
+   if (info.base.uses_kill) {
       mask_result = lp_build_mask_end(&mask);
    }
 
    IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
 
-   if (swr_fs->info.base.uses_kill) {
+   if (info.base.uses_kill) {
       STORE(unwrap(mask_result), pPS, {0, SWR_PS_CONTEXT_activeMask});
    }
 
@@ -568,10 +673,13 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 
    gallivm_verify_function(gallivm, wrap(pFunction));
 
-   gallivm_compile_module(gallivm);
-
-   PFN_PIXEL_KERNEL kernel =
-      (PFN_PIXEL_KERNEL)gallivm_jit_function(gallivm, wrap(pFunction));
+   PFN_PIXEL_KERNEL kernel;
+   if (JM()->mpCache) {
+      kernel = (PFN_PIXEL_KERNEL)CompileCached(gallivm, pFunction, cacheKey, cached);
+   } else {
+      gallivm_compile_module(gallivm);
+      kernel = (PFN_PIXEL_KERNEL)gallivm_jit_function(gallivm, wrap(pFunction));
+   }
    debug_printf("frag shader  %p\n", kernel);
    assert(kernel && "Error: FragShader = NULL");
 
@@ -582,10 +690,29 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
    return kernel;
 }
 
-PFN_PIXEL_KERNEL
+/*
+ * Queue the fragment shader variant for key on the screen's compile threads.
+ * The job gets its own copy of everything it needs from the shader, so the
+ * shader may be deleted before the compile finishes.
+ */
+struct swr_jit_func *
 swr_compile_fs(struct swr_context *ctx, swr_jit_key &key)
 {
-   BuilderSWR builder(
-      reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr));
-   return builder.CompileFS(ctx, key);
+   struct swr_fragment_shader *swr_fs = ctx->fs;
+   std::shared_ptr<const struct tgsi_token> tokens(
+      tgsi_dup_tokens(swr_fs->pipe.tokens),
+      [](const struct tgsi_token *t) { FREE((void *)t); });
+   struct lp_tgsi_info info = swr_fs->info;
+
+   return swr_compile_async(
+      swr_screen(ctx->pipe.screen),
+      [tokens, info, key](HANDLE hJitMgr) {
+         BuilderSWR builder(reinterpret_cast<JitManager *>(hJitMgr));
+
+         RDTSC_START(JITCompileShader);
+         void *func = (void *)builder.CompileFS(tokens.get(), info, key);
+         RDTSC_STOP(JITCompileShader, 1, 0);
+
+         return func;
+      });
 }
@@ -26,22 +26,28 @@
 class swr_vertex_shader;
 class swr_fragment_shader;
 class swr_jit_key;
+struct swr_jit_func;
 
 PFN_VERTEX_FUNC
 swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
 
-PFN_PIXEL_KERNEL
+struct swr_jit_func *
 swr_compile_fs(struct swr_context *ctx, swr_jit_key &key);
 
 void swr_generate_fs_key(struct swr_jit_key &key,
                          struct swr_context *ctx,
                          swr_fragment_shader *swr_fs);
 
+void swr_update_fs_linkage(swr_fragment_shader *swr_fs,
+                           const swr_jit_key &key);
+
 struct swr_jit_key {
    unsigned nr_cbufs;
    unsigned light_twoside;
    ubyte vs_output_semantic_name[PIPE_MAX_SHADER_OUTPUTS];
    ubyte vs_output_semantic_idx[PIPE_MAX_SHADER_OUTPUTS];
+   unsigned vs_num_outputs;
+   unsigned sprite_coord_enable;
    unsigned nr_samplers;
    unsigned nr_sampler_views;
    struct swr_sampler_static_state sampler[PIPE_MAX_SHADER_SAMPLER_VIEWS];
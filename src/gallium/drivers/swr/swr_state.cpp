@@ -367,6 +367,14 @@ static void
 swr_delete_vs_state(struct pipe_context *pipe, void *vs)
 {
    struct swr_vertex_shader *swr_vs = (swr_vertex_shader *)vs;
+
+   std::vector<struct swr_jit_func *> funcs;
+   for (unsigned i = 0; i < PIPE_PRIM_MAX; i++) {
+      if (swr_vs->soFunc[i])
+         funcs.push_back(swr_vs->soFunc[i]);
+   }
+   swr_release_jit_funcs(swr_context(pipe), std::move(funcs));
+
    FREE((void *)swr_vs->pipe.tokens);
    FREE(vs);
 }
@@ -403,6 +411,12 @@ static void
 swr_delete_fs_state(struct pipe_context *pipe, void *fs)
 {
    struct swr_fragment_shader *swr_fs = (swr_fragment_shader *)fs;
+
+   std::vector<struct swr_jit_func *> funcs;
+   for (auto &variant : swr_fs->map)
+      funcs.push_back(variant.second);
+   swr_release_jit_funcs(swr_context(pipe), std::move(funcs));
+
    FREE((void *)swr_fs->pipe.tokens);
    delete swr_fs;
 }
@@ -502,7 +516,11 @@ swr_bind_vertex_elements_state(struct pipe_context *pipe, void *velems)
 static void
 swr_delete_vertex_elements_state(struct pipe_context *pipe, void *velems)
 {
-   /* XXX Need to destroy fetch shader? */
+   struct swr_vertex_element_state *swr_velems =
+      (struct swr_vertex_element_state *)velems;
+
+   if (swr_velems->fsFunc)
+      swr_release_jit_funcs(swr_context(pipe), {swr_velems->fsFunc});
    FREE(velems);
 }
 
@@ -686,6 +704,9 @@ swr_update_derived(struct pipe_context *pipe,
    /* For example, user_buffer vertex and index buffers. */
    unsigned post_update_dirty_flags = 0;
 
+   /* Uploads below are for the draw following this validation */
+   swr_scratch_new_epoch(ctx);
+
    /* Render Targets */
    if (ctx->dirty & SWR_NEW_FRAMEBUFFER) {
       struct pipe_framebuffer_state *fb = &ctx->framebuffer;
@@ -748,10 +769,33 @@ swr_update_derived(struct pipe_context *pipe,
          }
       }
 
+      /* Multisampled color targets are resolved as their tiles are stored */
+      for (i = 0; i < SWR_NUM_RENDERTARGETS; i++) {
+         struct pipe_resource *resolve = NULL;
+         if (i < fb->nr_cbufs && fb->cbufs[i])
+            resolve = swr_resource(fb->cbufs[i]->texture)->resolve_target;
+
+         SWR_SURFACE_STATE *resolveTarget =
+            &pDC->resolveTargets[SWR_ATTACHMENT_COLOR0 + i];
+         if (resolve) {
+            *resolveTarget = swr_resource(resolve)->swr;
+            resolveTarget->lod = renderTargets[SWR_ATTACHMENT_COLOR0 + i].lod;
+            resolveTarget->arrayIndex =
+               renderTargets[SWR_ATTACHMENT_COLOR0 + i].arrayIndex;
+         } else if (resolveTarget->pBaseAddress)
+            *resolveTarget = {0};
+      }
+
       /* This fence ensures any attachment changes are resolved before the
        * next draw */
       if (need_fence)
          swr_fence_submit(ctx, screen->flush_fence);
+
+      /* Color hottile formats follow the attached surfaces */
+      SWR_FORMAT rtFormats[SWR_NUM_RENDERTARGETS];
+      for (i = 0; i < SWR_NUM_RENDERTARGETS; i++)
+         rtFormats[i] = renderTargets[SWR_ATTACHMENT_COLOR0 + i].format;
+      SwrSetRenderTargetFormats(ctx->swrContext, SWR_NUM_RENDERTARGETS, rtFormats);
    }
 
    /* Raster state */
@@ -968,6 +1012,8 @@ swr_update_derived(struct pipe_context *pipe,
 
       struct swr_vertex_element_state *velems = ctx->velems;
       if (velems && velems->fsState.indexType != index_type) {
+         if (velems->fsFunc)
+            swr_release_jit_funcs(ctx, {velems->fsFunc});
          velems->fsFunc = NULL;
          velems->fsState.indexType = index_type;
       }
@@ -976,23 +1022,31 @@ swr_update_derived(struct pipe_context *pipe,
    /* VertexShader */
    if (ctx->dirty & (SWR_NEW_VS | SWR_NEW_FRAMEBUFFER)) {
       SwrSetVertexFunc(ctx->swrContext, ctx->vs->func);
+
+      /* Don't leave the streamout function of a previous, maybe deleted,
+       * vertex shader set as deferred */
+      if (!ctx->vs->pipe.stream_output.num_outputs)
+         SwrSetSoFunc(ctx->swrContext, NULL, 0);
    }
 
    swr_jit_key key;
-   if (ctx->dirty & (SWR_NEW_FS | SWR_NEW_SAMPLER | SWR_NEW_SAMPLER_VIEW
-                     | SWR_NEW_RASTERIZER | SWR_NEW_FRAMEBUFFER)) {
+   if (ctx->dirty & (SWR_NEW_FS | SWR_NEW_VS | SWR_NEW_SAMPLER
+                     | SWR_NEW_SAMPLER_VIEW | SWR_NEW_RASTERIZER
+                     | SWR_NEW_FRAMEBUFFER)) {
       memset(&key, 0, sizeof(key));
       swr_generate_fs_key(key, ctx, ctx->fs);
+      swr_update_fs_linkage(ctx->fs, key);
       auto search = ctx->fs->map.find(key);
-      PFN_PIXEL_KERNEL func;
+      struct swr_jit_func *func;
       if (search != ctx->fs->map.end()) {
          func = search->second;
       } else {
          func = swr_compile_fs(ctx, key);
          ctx->fs->map.insert(std::make_pair(key, func));
       }
+      bool compiled = swr_compile_ready(screen, func);
       SWR_PS_STATE psState = {0};
-      psState.pfnPixelShader = func;
+      psState.pfnPixelShader = (PFN_PIXEL_KERNEL)func->pfn;
       psState.killsPixel = ctx->fs->info.base.uses_kill;
       psState.inputCoverage = SWR_INPUT_COVERAGE_NORMAL;
       psState.writesODepth = ctx->fs->info.base.writes_z;
@@ -1031,6 +1085,11 @@ swr_update_derived(struct pipe_context *pipe,
       psState.usesUAV = false; // XXX
       psState.forceEarlyZ = false;
       SwrSetPixelShaderState(ctx->swrContext, &psState);
+
+      /* Still compiling, draws are held by the core until it's done. */
+      if (!compiled)
+         SwrSetDeferredFunc(
+            ctx->swrContext, SWR_DEFERRED_PIXEL_SHADER, &func->pfn);
    }
 
    /* JIT sampler state */
@@ -1299,10 +1358,6 @@ swr_update_derived(struct pipe_context *pipe,
 
    SwrSetLinkage(ctx->swrContext, linkage, NULL);
 
-   // set up frontend state
-   SWR_FRONTEND_STATE feState = {0};
-   SwrSetFrontendState(ctx->swrContext, &feState);
-
    // set up backend state
    SWR_BACKEND_STATE backendState = {0};
    backendState.numAttributes = 1;
@@ -1314,7 +1369,7 @@ swr_update_derived(struct pipe_context *pipe,
 
    /* Ensure that any in-progress attachment change StoreTiles finish */
    if (swr_is_fence_pending(screen->flush_fence))
-      swr_fence_finish(pipe->screen, screen->flush_fence, 0);
+      swr_fence_finish(pipe->screen, screen->flush_fence, PIPE_TIMEOUT_INFINITE);
 
    /* Finally, update the in-use status of all resources involved in draw */
    swr_update_resource_status(pipe, p_draw_info);
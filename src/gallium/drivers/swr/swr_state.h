@@ -33,6 +33,7 @@
 #include "api.h"
 #include "swr_tex_sample.h"
 #include "swr_shader.h"
+#include "swr_compile.h"
 #include <unordered_map>
 
 /* skeleton */
@@ -42,7 +43,7 @@ struct swr_vertex_shader {
    unsigned linkageMask;
    PFN_VERTEX_FUNC func;
    SWR_STREAMOUT_STATE soState;
-   PFN_SO_FUNC soFunc[PIPE_PRIM_MAX];
+   struct swr_jit_func *soFunc[PIPE_PRIM_MAX];
 };
 
 struct swr_fragment_shader {
@@ -50,13 +51,13 @@ struct swr_fragment_shader {
    struct lp_tgsi_info info;
    uint32_t constantMask;
    uint32_t pointSpriteMask;
-   std::unordered_map<swr_jit_key, PFN_PIXEL_KERNEL> map;
+   std::unordered_map<swr_jit_key, struct swr_jit_func *> map;
 };
 
 /* Vertex element state */
 struct swr_vertex_element_state {
    FETCH_COMPILE_STATE fsState;
-   PFN_FETCH_FUNC fsFunc;
+   struct swr_jit_func *fsFunc;
    uint32_t stream_pitch[PIPE_MAX_ATTRIBS];
 };
 
@@ -74,6 +75,7 @@ struct swr_derived_state {
    SWR_RASTSTATE rastState;
    SWR_VIEWPORT vp;
    SWR_VIEWPORT_MATRIX vpm;
+   SWR_FRONTEND_STATE feState;
 };
 
 void swr_update_derived(struct pipe_context *,
@@ -0,0 +1,201 @@
+/****************************************************************************
+ * Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * BE dispatch overhead versus thread count.  Draws with a few trivial work
+ * items on every macrotile of a 1024x1024 target are queued to a DC ring,
+ * and N threads run WorkOnFifoBE on it the way the pool workers do.  The
+ * time per macrotile is then mostly claiming tiles and walking the draws.
+ * Also checks that each tile runs its work exactly once and in draw order.
+ *
+ * usage: swr_test_dispatch [num_draws [max_threads]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "context.h"
+#include "tilemgr.h"
+#include "threads.h"
+
+static const uint32_t tiles_x = 1024 / KNOB_MACROTILE_X_DIM;
+static const uint32_t tiles_y = 1024 / KNOB_MACROTILE_Y_DIM;
+static const uint32_t items_per_tile = 2;
+static const uint32_t ring_size = 8;
+
+/* Last work item run on each tile, items are numbered in queue order. */
+static uint64_t last_item[tiles_x * tiles_y];
+static volatile LONG num_errors;
+
+static void
+tile_work(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile,
+          void *pDesc)
+{
+   uint32_t x, y;
+   MacroTileMgr::getTileIndices(macroTile, x, y);
+
+   uint64_t item = ((SYNC_DESC *)pDesc)->userData;
+   uint64_t &last = last_item[y * tiles_x + x];
+   if (item != last + 1)
+      InterlockedIncrement(&num_errors);
+   last = item;
+}
+
+static void
+queue_draw(SWR_CONTEXT *pContext, uint64_t drawId)
+{
+   DRAW_CONTEXT *pDC = &pContext->dcRing[drawId % ring_size];
+
+   pDC->drawId = drawId;
+   pDC->doneFE = false;
+   pDC->threadsDoneBE = 0;
+   pDC->pArena->Reset();
+   pDC->pTileMgr->initialize();
+
+   BE_WORK work = {};
+   work.type = SYNC;
+   work.pfnWork = tile_work;
+   for (uint32_t i = 0; i < items_per_tile; i++) {
+      for (uint32_t y = 0; y < tiles_y; y++) {
+         for (uint32_t x = 0; x < tiles_x; x++) {
+            work.desc.sync.userData = (drawId - 1) * items_per_tile + i + 1;
+            pDC->pTileMgr->enqueue(x, y, &work);
+         }
+      }
+   }
+
+   _ReadWriteBarrier();
+   pDC->doneFE = true;
+   pContext->DrawEnqueued = drawId + 1;
+}
+
+static void
+worker(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t lastDraw)
+{
+   TileSet *pLockedTiles = new TileSet;
+   uint64_t curDrawBE = 1;
+
+   while (curDrawBE <= lastDraw) {
+      if (curDrawBE < pContext->DrawEnqueued)
+         WorkOnFifoBE(pContext, workerId, curDrawBE, *pLockedTiles, 0);
+      else
+         std::this_thread::yield();
+   }
+
+   delete pLockedTiles;
+}
+
+/* Returns the time per macrotile in ns. */
+static double
+run(SWR_CONTEXT *pContext, uint32_t num_threads, uint32_t num_draws)
+{
+   memset(last_item, 0, sizeof(last_item));
+   pContext->DrawEnqueued = 1;
+
+   auto start = std::chrono::steady_clock::now();
+
+   std::vector<std::thread> threads;
+   for (uint32_t i = 0; i < num_threads; i++)
+      threads.emplace_back(worker, pContext, i, (uint64_t)num_draws);
+
+   for (uint64_t drawId = 1; drawId <= num_draws; drawId++) {
+      /* Wait for every thread to move past the draw using the slot. */
+      DRAW_CONTEXT *pDC = &pContext->dcRing[drawId % ring_size];
+      while (drawId > ring_size && pDC->threadsDoneBE != num_threads)
+         std::this_thread::yield();
+
+      queue_draw(pContext, drawId);
+   }
+
+   for (auto &thread : threads)
+      thread.join();
+
+   std::chrono::duration<double, std::nano> time =
+      std::chrono::steady_clock::now() - start;
+
+   for (uint32_t i = 0; i < tiles_x * tiles_y; i++) {
+      if (last_item[i] != (uint64_t)num_draws * items_per_tile)
+         num_errors++;
+   }
+
+   return time.count() / ((double)num_draws * tiles_x * tiles_y);
+}
+
+int
+main(int argc, char *argv[])
+{
+   uint32_t num_draws = argc > 1 ? atoi(argv[1]) : 500;
+   uint32_t max_threads = argc > 2 ? atoi(argv[2]) : 16;
+
+   THREAD_POOL *pPool = new THREAD_POOL();
+   pPool->numNumaNodes = 1;
+
+   SWR_CONTEXT *pContext =
+      (SWR_CONTEXT *)_aligned_malloc(sizeof(SWR_CONTEXT), 64);
+   memset(pContext, 0, sizeof(SWR_CONTEXT));
+   pContext->pThreadPool = pPool;
+   pContext->maxDrawsInFlight = ring_size;
+   pContext->dcRing =
+      (DRAW_CONTEXT *)_aligned_malloc(sizeof(DRAW_CONTEXT) * ring_size, 64);
+   memset(pContext->dcRing, 0, sizeof(DRAW_CONTEXT) * ring_size);
+   for (uint32_t i = 0; i < ring_size; i++) {
+      DRAW_CONTEXT *pDC = &pContext->dcRing[i];
+      pDC->pContext = pContext;
+      pDC->pArena = new Arena();
+      pDC->pTileMgr = new MacroTileMgr(*pDC->pArena);
+   }
+
+   printf("%u draws of %ux%u macrotiles, %u items per tile\n",
+          num_draws, tiles_x, tiles_y, items_per_tile);
+   printf("threads  ns/macrotile\n");
+
+   for (uint32_t num_threads = 1; num_threads <= max_threads;
+        num_threads *= 2) {
+      /* best of 3 */
+      double best = 0.0;
+      for (uint32_t i = 0; i < 3; i++) {
+         double time = run(pContext, num_threads, num_draws);
+         if (i == 0 || time < best)
+            best = time;
+      }
+      printf("%7u  %12.1f\n", num_threads, best);
+   }
+
+   for (uint32_t i = 0; i < ring_size; i++) {
+      delete pContext->dcRing[i].pTileMgr;
+      delete pContext->dcRing[i].pArena;
+   }
+   _aligned_free(pContext->dcRing);
+   _aligned_free(pContext);
+   delete pPool;
+
+   if (num_errors)
+      printf("%d work items ran out of order\n", (int)num_errors);
+
+   return num_errors ? 1 : 0;
+}
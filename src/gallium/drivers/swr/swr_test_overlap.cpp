@@ -0,0 +1,191 @@
+/****************************************************************************
+ * Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Stress test for KNOB_OVERLAP_FE_BE.  The main thread bins draws the way
+ * the FE does, queuing work to random macrotiles, while worker threads
+ * already run WorkOnFifoBE on the draw.  Enough work is queued per draw that
+ * the tile FIFOs and the dirty tile list both chain several blocks.  Every
+ * work item has to run exactly once, and in queue order per tile.
+ *
+ * usage: swr_test_overlap [num_draws [num_threads]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include "context.h"
+#include "tilemgr.h"
+#include "threads.h"
+
+static const uint32_t tiles_x = 1024 / KNOB_MACROTILE_X_DIM;
+static const uint32_t tiles_y = 1024 / KNOB_MACROTILE_Y_DIM;
+static const uint32_t items_per_draw = 16 * 1024;
+static const uint32_t ring_size = 8;
+
+/* Work items queued to and run on each tile, in queue order. */
+static uint64_t queued_items[tiles_x * tiles_y];
+static uint64_t last_item[tiles_x * tiles_y];
+static volatile LONG num_errors;
+static volatile LONG num_overlapped; /* run before the FE was done */
+
+static void
+tile_work(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile,
+          void *pDesc)
+{
+   uint32_t x, y;
+   MacroTileMgr::getTileIndices(macroTile, x, y);
+
+   if (!pDC->doneFE)
+      InterlockedIncrement(&num_overlapped);
+
+   uint64_t item = ((SYNC_DESC *)pDesc)->userData;
+   uint64_t &last = last_item[y * tiles_x + x];
+   if (item != last + 1)
+      InterlockedIncrement(&num_errors);
+   last = item;
+}
+
+static void
+bin_draw(SWR_CONTEXT *pContext, uint64_t drawId, uint32_t &seed)
+{
+   DRAW_CONTEXT *pDC = &pContext->dcRing[drawId % ring_size];
+
+   pDC->drawId = drawId;
+   pDC->doneFE = false;
+   pDC->threadsDoneBE = 0;
+   pDC->pArena->Reset();
+   pDC->pTileMgr->initialize();
+
+   /* Workers may start on the draw as soon as it's enqueued. */
+   _ReadWriteBarrier();
+   pContext->DrawEnqueued = drawId + 1;
+
+   BE_WORK work = {};
+   work.type = SYNC;
+   work.pfnWork = tile_work;
+   for (uint32_t i = 0; i < items_per_draw; i++) {
+      /* Half the work goes to a few hot tiles, so their FIFOs chain. */
+      seed = seed * 1103515245 + 12345;
+      uint32_t tile = (seed >> 8) % (tiles_x * tiles_y);
+      if (seed & 1)
+         tile %= 16;
+
+      work.desc.sync.userData = ++queued_items[tile];
+      pDC->pTileMgr->enqueue(tile % tiles_x, tile / tiles_x, &work);
+
+      /* Let the workers in on a single CPU host */
+      if ((i % 256) == 0)
+         std::this_thread::yield();
+   }
+
+   std::atomic_thread_fence(std::memory_order_release);
+   pDC->doneFE = true;
+}
+
+static void
+worker(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t lastDraw)
+{
+   TileSet *pLockedTiles = new TileSet;
+   uint64_t curDrawBE = 1;
+
+   while (curDrawBE <= lastDraw) {
+      if (curDrawBE < pContext->DrawEnqueued)
+         WorkOnFifoBE(pContext, workerId, curDrawBE, *pLockedTiles, 0);
+
+      /* The FE may still be binning, give it the CPU */
+      std::this_thread::yield();
+   }
+
+   delete pLockedTiles;
+}
+
+int
+main(int argc, char *argv[])
+{
+   uint32_t num_draws = argc > 1 ? atoi(argv[1]) : 100;
+   uint32_t num_threads = argc > 2 ? atoi(argv[2]) : 4;
+   uint32_t seed = 1;
+
+   SET_KNOB(OVERLAP_FE_BE, true);
+
+   THREAD_POOL *pPool = new THREAD_POOL();
+   pPool->numNumaNodes = 1;
+
+   SWR_CONTEXT *pContext =
+      (SWR_CONTEXT *)_aligned_malloc(sizeof(SWR_CONTEXT), 64);
+   memset(pContext, 0, sizeof(SWR_CONTEXT));
+   pContext->pThreadPool = pPool;
+   pContext->maxDrawsInFlight = ring_size;
+   pContext->DrawEnqueued = 1;
+   pContext->dcRing =
+      (DRAW_CONTEXT *)_aligned_malloc(sizeof(DRAW_CONTEXT) * ring_size, 64);
+   memset(pContext->dcRing, 0, sizeof(DRAW_CONTEXT) * ring_size);
+   for (uint32_t i = 0; i < ring_size; i++) {
+      DRAW_CONTEXT *pDC = &pContext->dcRing[i];
+      pDC->pContext = pContext;
+      pDC->pArena = new Arena();
+      pDC->pTileMgr = new MacroTileMgr(*pDC->pArena);
+   }
+
+   std::vector<std::thread> threads;
+   for (uint32_t i = 0; i < num_threads; i++)
+      threads.emplace_back(worker, pContext, i, (uint64_t)num_draws);
+
+   for (uint64_t drawId = 1; drawId <= num_draws; drawId++) {
+      /* Wait for every thread to move past the draw using the slot. */
+      DRAW_CONTEXT *pDC = &pContext->dcRing[drawId % ring_size];
+      while (drawId > ring_size && pDC->threadsDoneBE != num_threads)
+         std::this_thread::yield();
+
+      bin_draw(pContext, drawId, seed);
+   }
+
+   for (auto &thread : threads)
+      thread.join();
+
+   for (uint32_t i = 0; i < tiles_x * tiles_y; i++) {
+      if (last_item[i] != queued_items[i])
+         num_errors++;
+   }
+
+   for (uint32_t i = 0; i < ring_size; i++) {
+      delete pContext->dcRing[i].pTileMgr;
+      delete pContext->dcRing[i].pArena;
+   }
+   _aligned_free(pContext->dcRing);
+   _aligned_free(pContext);
+   delete pPool;
+
+   printf("%u draws of %u work items, %u threads: "
+          "%d ran while binning, %d errors\n",
+          num_draws, items_per_draw, num_threads, (int)num_overlapped,
+          (int)num_errors);
+
+   /* Make sure the overlap was actually tested */
+   return (num_errors || !num_overlapped) ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+/****************************************************************************
+ * Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+
+/*
+ * Throughput of the two partial raster tile paths of RasterizeTriangle, the
+ * double edge equations and the 32 bit ones used for triangles no larger
+ * than a macrotile.  Random triangles up to max_size pixels are split into
+ * the raster tiles their bounding box touches, and every tile is rasterized
+ * with both paths.  The coverage masks have to match.  The 32 bit path is
+ * timed with the conversion of the start edges RasterizeTriangle does.
+ *
+ * usage: swr_test_raster [max_size]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+/* The rasterize functions are local to the rasterizer.  Defining all of
+ * it here keeps the linker from pulling rasterizer.o out of libswrtest.a. */
+#include "rasterizer.cpp"
+
+static const uint32_t num_tiles = 4096;
+static const uint32_t num_edges = 3;
+
+struct raster_tile {
+   EDGE edges[num_edges];
+   double start_edges[num_edges];
+};
+
+/* EDGE holds SIMD vectors, keep the tiles aligned */
+static raster_tile *tiles;
+static uint32_t num_setup_tiles;
+
+static void
+setup_triangle(const int32_t x[3], const int32_t y[3])
+{
+   int32_t a[3], b[3];
+   for (uint32_t i = 0; i < 3; i++) {
+      uint32_t j = (i + 1) % 3;
+      a[i] = y[i] - y[j];
+      b[i] = x[j] - x[i];
+   }
+
+   /* Covered samples are on the negative side of all edges. */
+   int64_t det = (int64_t)a[0] * b[2] - (int64_t)a[2] * b[0];
+   if (det == 0)
+      return;
+   if (det > 0) {
+      for (uint32_t i = 0; i < 3; i++) {
+         a[i] = -a[i];
+         b[i] = -b[i];
+      }
+   }
+
+   const int32_t shift_x = FIXED_POINT_SHIFT + KNOB_TILE_X_DIM_SHIFT;
+   const int32_t shift_y = FIXED_POINT_SHIFT + KNOB_TILE_Y_DIM_SHIFT;
+   int32_t min_x = std::min(x[0], std::min(x[1], x[2])) >> shift_x;
+   int32_t max_x = std::max(x[0], std::max(x[1], x[2])) >> shift_x;
+   int32_t min_y = std::min(y[0], std::min(y[1], y[2])) >> shift_y;
+   int32_t max_y = std::max(y[0], std::max(y[1], y[2])) >> shift_y;
+
+   for (int32_t ty = min_y; ty <= max_y; ty++) {
+      for (int32_t tx = min_x; tx <= max_x && num_setup_tiles < num_tiles;
+           tx++) {
+         /* UL sample of the raster tile, at the pixel center */
+         int32_t px = tx * KNOB_TILE_X_DIM * FIXED_POINT_SCALE + FIXED_POINT_SCALE / 2;
+         int32_t py = ty * KNOB_TILE_Y_DIM * FIXED_POINT_SCALE + FIXED_POINT_SCALE / 2;
+
+         raster_tile &tile = tiles[num_setup_tiles++];
+         for (uint32_t i = 0; i < 3; i++) {
+            ComputeEdgeData(a[i], b[i], tile.edges[i]);
+            tile.start_edges[i] = (double)((int64_t)a[i] * (px - x[i]) +
+                                           (int64_t)b[i] * (py - y[i]));
+         }
+      }
+   }
+}
+
+static uint64_t
+rasterize_double(const raster_tile &tile)
+{
+   double start_edges[num_edges];
+   for (uint32_t e = 0; e < num_edges; e++)
+      start_edges[e] = tile.start_edges[e];
+
+   return rasterizePartialTile<num_edges>(nullptr, start_edges,
+                                          (EDGE *)tile.edges);
+}
+
+static uint64_t
+rasterize_int(const raster_tile &tile)
+{
+   int32_t start_edges[num_edges];
+   for (uint32_t e = 0; e < num_edges; e++)
+      start_edges[e] = (int32_t)tile.start_edges[e];
+
+   return rasterizePartialTileInt<num_edges>(nullptr, start_edges,
+                                             tile.edges);
+}
+
+/* Returns the best time per raster tile in ns. */
+template<uint64_t (*rasterize)(const raster_tile &)>
+static double
+time_path(uint64_t &checksum)
+{
+   double best = 0.0;
+
+   for (uint32_t run = 0; run < 21; run++) {
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < 100; i++) {
+         for (uint32_t t = 0; t < num_tiles; t++)
+            checksum += rasterize(tiles[t]);
+      }
+      std::chrono::duration<double, std::nano> time =
+         std::chrono::steady_clock::now() - start;
+
+      double per_tile = time.count() / (100.0 * num_tiles);
+      if (run == 0 || per_tile < best)
+         best = per_tile;
+   }
+
+   return best;
+}
+
+int
+main(int argc, char *argv[])
+{
+   int32_t max_size = argc > 1 ? atoi(argv[1]) : 64;
+   uint32_t seed = 1;
+
+   if (max_size <= 0 || max_size > KNOB_MACROTILE_X_DIM ||
+       max_size > KNOB_MACROTILE_Y_DIM) {
+      fprintf(stderr, "max_size must be 1 to a macrotile\n");
+      return 1;
+   }
+
+   tiles = (raster_tile *)_aligned_malloc(sizeof(raster_tile) * num_tiles, 64);
+   while (num_setup_tiles < num_tiles) {
+      int32_t x[3], y[3];
+      for (uint32_t i = 0; i < 3; i++) {
+         seed = seed * 1103515245 + 12345;
+         x[i] = (seed >> 8) % (max_size * FIXED_POINT_SCALE + 1);
+         seed = seed * 1103515245 + 12345;
+         y[i] = (seed >> 8) % (max_size * FIXED_POINT_SCALE + 1);
+      }
+      setup_triangle(x, y);
+   }
+
+   uint32_t mismatches = 0;
+   for (uint32_t t = 0; t < num_tiles; t++) {
+      if (rasterize_double(tiles[t]) != rasterize_int(tiles[t]))
+         mismatches++;
+   }
+
+   uint64_t checksum = 0;
+   double double_time = time_path<rasterize_double>(checksum);
+   double int_time = time_path<rasterize_int>(checksum);
+
+   printf("triangles up to %dx%d pixels, %u raster tiles\n",
+          max_size, max_size, num_tiles);
+   printf("double  %6.2f ns/tile\n", double_time);
+   printf("int32   %6.2f ns/tile (%+.0f%%)\n", int_time,
+          (int_time / double_time - 1.0) * 100.0);
+
+   _aligned_free(tiles);
+
+   if (mismatches)
+      printf("%u coverage masks differ\n", mismatches);
+
+   /* keep the timed loops */
+   return (mismatches || checksum == 1) ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/****************************************************************************
+ * Copyright (C) 2016 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Checks that a steady stream of draws shares its state blocks.  The loop
+ * sets the state the gallium driver sets for every draw, the fetch shader,
+ * deferred while it compiles, and the frontend state, then draws.  Once the
+ * first draw of each loop has unshared what it changed, no draw may copy a
+ * state block.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "api.h"
+
+static const unsigned num_draws = 1000;
+
+static void SWR_API
+load_tile(HANDLE hPrivateContext, SWR_FORMAT dstFormat,
+          SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+          uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+          BYTE *pDstHotTile)
+{
+}
+
+static void SWR_API
+store_tile(HANDLE hPrivateContext, SWR_FORMAT srcFormat,
+           SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+           uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+           uint32_t numSamples, BYTE *pSrcHotTile)
+{
+}
+
+static void SWR_API
+clear_tile(HANDLE hPrivateContext, SWR_RENDERTARGET_ATTACHMENT rtIndex,
+           uint32_t x, uint32_t y, const float *pClearColor)
+{
+}
+
+static void __cdecl
+fetch_func(SWR_FETCH_CONTEXT &fetchInfo, simdvertex &out)
+{
+   memset(&out, 0, sizeof(out));
+}
+
+static void __cdecl
+vertex_func(HANDLE hPrivateData, SWR_VS_CONTEXT *pVsContext)
+{
+}
+
+static uint64_t
+state_block_copies(HANDLE hContext)
+{
+   SWR_DRAW_RING_STATS stats;
+   SwrGetDrawRingStats(hContext, &stats);
+   return stats.numStateBlockCopies;
+}
+
+/*
+ * Draws count triangles, setting the per draw state before each.  Returns
+ * the state blocks copied after the first draw.
+ */
+static uint64_t
+draw_loop(HANDLE hContext, void *volatile *ppFetchFunc, bool deferred,
+          unsigned count)
+{
+   SWR_FRONTEND_STATE feState = {0};
+   uint64_t copies = 0;
+
+   for (unsigned i = 0; i < count; i++) {
+      if (i == 1)
+         copies = state_block_copies(hContext);
+
+      if (deferred)
+         SwrSetDeferredFunc(hContext, SWR_DEFERRED_FETCH_FUNC, ppFetchFunc);
+      else
+         SwrSetFetchFunc(hContext, (PFN_FETCH_FUNC)*ppFetchFunc);
+      SwrSetFrontendState(hContext, &feState);
+
+      SwrDraw(hContext, TOP_TRIANGLE_LIST, 0, 3);
+   }
+
+   return state_block_copies(hContext) - copies;
+}
+
+int
+main(int argc, char *argv[])
+{
+   SWR_CREATECONTEXT_INFO createInfo = {};
+   createInfo.driver = GL;
+   createInfo.privateStateSize = 64;
+   createInfo.maxSubContexts = 1;
+   createInfo.pfnLoadTile = load_tile;
+   createInfo.pfnStoreTile = store_tile;
+   createInfo.pfnClearTile = clear_tile;
+
+   HANDLE hContext = SwrCreateContext(&createInfo);
+   SwrSetVertexFunc(hContext, vertex_func);
+
+   /* Already compiled, as single threaded draws need it to be, but set the
+    * way the driver sets it while compiling. */
+   static void *volatile pfnFetch = (void *)fetch_func;
+   uint64_t deferred_copies = draw_loop(hContext, &pfnFetch, true, num_draws);
+
+   uint64_t copies = draw_loop(hContext, &pfnFetch, false, num_draws);
+   SwrWaitForIdle(hContext);
+
+   printf("%u draws, deferred fetch shader: %llu state block copies\n",
+          num_draws, (unsigned long long)deferred_copies);
+   printf("%u draws: %llu state block copies\n",
+          num_draws, (unsigned long long)copies);
+
+   SwrDestroyContext(hContext);
+
+   return (deferred_copies || copies) ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/* Measure the draw call submission rate.  Every frame issues many draws
+ * of a tiny triangle, so the time goes to handing state and work from the
+ * API to the driver rather than to rasterization.
+ *
+ * Usage: draw-rate [-f frames] [-n draws_per_frame] [-v]
+ *
+ *   -v  bind a different vertex buffer for every draw, so the vertex
+ *       input state changes between draws
+ *
+ * Prints the rate at which draws are submitted, and the rate including
+ * waiting for them to finish.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graw_util.h"
+#include "os/os_time.h"
+
+static const int WIDTH = 256;
+static const int HEIGHT = 256;
+
+static int num_frames = 20;
+static int num_draws = 10000;
+static boolean change_vbuf = FALSE;
+
+static struct graw_info info;
+
+static struct pipe_vertex_buffer vbuf[2];
+
+struct vertex {
+   float position[4];
+   float color[4];
+};
+
+/* covers a few pixels in the middle of the window */
+static struct vertex vertices[3] =
+{
+   { {  0.00f, -0.02f, 0.0f, 1.0f },
+     {  1.0f,   0.0f,  0.0f, 1.0f } },
+
+   { { -0.02f,  0.02f, 0.0f, 1.0f },
+     {  0.0f,   1.0f,  0.0f, 1.0f } },
+
+   { {  0.02f,  0.02f, 0.0f, 1.0f },
+     {  0.0f,   0.0f,  1.0f, 1.0f } },
+};
+
+
+static void set_vertices( void )
+{
+   struct pipe_vertex_element ve[2];
+   void *handle;
+   int i;
+
+   memset(ve, 0, sizeof ve);
+
+   ve[0].src_offset = Offset(struct vertex, position);
+   ve[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve[1].src_offset = Offset(struct vertex, color);
+   ve[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   handle = info.ctx->create_vertex_elements_state(info.ctx, 2, ve);
+   info.ctx->bind_vertex_elements_state(info.ctx, handle);
+
+   memset(vbuf, 0, sizeof vbuf);
+
+   for (i = 0; i < 2; i++) {
+      vbuf[i].stride = sizeof( struct vertex );
+      vbuf[i].buffer_offset = 0;
+      vbuf[i].buffer = pipe_buffer_create_with_data(info.ctx,
+                                                    PIPE_BIND_VERTEX_BUFFER,
+                                                    PIPE_USAGE_DEFAULT,
+                                                    sizeof(vertices),
+                                                    vertices);
+   }
+
+   info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vbuf[0]);
+}
+
+static void set_vertex_shader( void )
+{
+   void *handle;
+   const char *text =
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL IN[1]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], COLOR\n"
+      "  0: MOV OUT[1], IN[1]\n"
+      "  1: MOV OUT[0], IN[0]\n"
+      "  2: END\n";
+
+   handle = graw_parse_vertex_shader(info.ctx, text);
+   info.ctx->bind_vs_state(info.ctx, handle);
+}
+
+static void set_fragment_shader( void )
+{
+   void *handle;
+   const char *text =
+      "FRAG\n"
+      "DCL IN[0], COLOR, LINEAR\n"
+      "DCL OUT[0], COLOR\n"
+      "  0: MOV OUT[0], IN[0]\n"
+      "  1: END\n";
+
+   handle = graw_parse_fragment_shader(info.ctx, text);
+   info.ctx->bind_fs_state(info.ctx, handle);
+}
+
+
+static void draw( void )
+{
+   union pipe_color_union clear_color = { {.5,.5,.5,1} };
+   struct pipe_fence_handle *fence = NULL;
+   int64_t start, submitted = 0, end;
+   double submit_secs, total_secs, draws;
+   int i, j;
+
+   /* warm up, compiles the shaders */
+   util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, 0, 3);
+   info.ctx->flush(info.ctx, &fence, 0);
+   info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+   info.screen->fence_reference(info.screen, &fence, NULL);
+
+   start = os_time_get_nano();
+   for (i = 0; i < num_frames; i++) {
+      int64_t frame_start = os_time_get_nano();
+
+      info.ctx->clear(info.ctx, PIPE_CLEAR_COLOR, &clear_color, 0, 0);
+      for (j = 0; j < num_draws; j++) {
+         if (change_vbuf)
+            info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vbuf[j & 1]);
+         util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, 0, 3);
+      }
+      submitted += os_time_get_nano() - frame_start;
+
+      info.ctx->flush(info.ctx, &fence, 0);
+      info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+      info.screen->fence_reference(info.screen, &fence, NULL);
+   }
+   end = os_time_get_nano();
+
+   draws = (double)num_draws * num_frames;
+   submit_secs = submitted / 1e9;
+   total_secs = (end - start) / 1e9;
+   printf("%d frames of %d draws%s: submit %.2f us/draw (%.0f Kdraws/s), "
+          "total %.2f us/draw (%.0f Kdraws/s)\n",
+          num_frames, num_draws, change_vbuf ? ", vertex buffer per draw" : "",
+          submit_secs * 1e6 / draws, draws / submit_secs / 1e3,
+          total_secs * 1e6 / draws, draws / total_secs / 1e3);
+
+   graw_util_flush_front(&info);
+   exit(0);
+}
+
+
+static void init( void )
+{
+   if (!graw_util_create_window(&info, WIDTH, HEIGHT, 1, FALSE))
+      exit(1);
+
+   graw_util_default_state(&info, FALSE);
+
+   graw_util_viewport(&info, 0, 0, WIDTH, HEIGHT, 0, 1);
+
+   set_vertices();
+   set_vertex_shader();
+   set_fragment_shader();
+}
+
+
+static void args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (graw_parse_args(&i, argc, argv)) {
+         continue;
+      }
+      if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+         num_frames = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+         num_draws = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else if (strcmp(argv[i], "-v") == 0) {
+         change_vbuf = TRUE;
+         i++;
+      }
+      else {
+         printf("Invalid arg %s\n", argv[i]);
+         exit(1);
+      }
+   }
+}
+
+int main( int argc, char *argv[] )
+{
+   args(argc, argv);
+   init();
+
+   graw_set_display_func( draw );
+   graw_main_loop();
+   return 0;
+}
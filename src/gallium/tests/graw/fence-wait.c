@@ -0,0 +1,218 @@
+/* Measure the CPU time the application thread spends waiting on fences.
+ * Every frame draws a number of window sized quads, flushes and waits on
+ * the flush fence, timing the wait in wall clock and in thread CPU time.
+ * A driver that sleeps on the fence uses little CPU while waiting, one
+ * that spins uses about as much CPU as wall time.
+ *
+ * Usage: fence-wait [-f frames] [-n quads_per_frame]
+ *
+ * With swr, KNOB_FENCE_SPIN_US sets how long to spin before sleeping.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graw_util.h"
+#include "os/os_time.h"
+
+#if defined(PIPE_OS_UNIX)
+#include <time.h>
+#endif
+
+static const int WIDTH = 1024;
+static const int HEIGHT = 1024;
+
+static int num_frames = 100;
+static int num_quads = 20;
+
+static struct graw_info info;
+
+struct vertex {
+   float position[4];
+   float color[4];
+};
+
+static struct vertex vertices[4] =
+{
+   { { -1.0f, -1.0f, 0.0f, 1.0f },
+     {  1.0f,  0.0f, 0.0f, 1.0f } },
+
+   { {  1.0f, -1.0f, 0.0f, 1.0f },
+     {  0.0f,  1.0f, 0.0f, 1.0f } },
+
+   { {  1.0f,  1.0f, 0.0f, 1.0f },
+     {  0.0f,  0.0f, 1.0f, 1.0f } },
+
+   { { -1.0f,  1.0f, 0.0f, 1.0f },
+     {  1.0f,  1.0f, 1.0f, 1.0f } },
+};
+
+
+/* CPU time of the calling thread in nanoseconds, or wall time where it
+ * isn't available */
+static int64_t thread_cpu_time_nano( void )
+{
+#if defined(PIPE_OS_UNIX)
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+   return os_time_get_nano();
+#endif
+}
+
+
+static void set_vertices( void )
+{
+   struct pipe_vertex_element ve[2];
+   struct pipe_vertex_buffer vbuf;
+   void *handle;
+
+   memset(ve, 0, sizeof ve);
+
+   ve[0].src_offset = Offset(struct vertex, position);
+   ve[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve[1].src_offset = Offset(struct vertex, color);
+   ve[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   handle = info.ctx->create_vertex_elements_state(info.ctx, 2, ve);
+   info.ctx->bind_vertex_elements_state(info.ctx, handle);
+
+   memset(&vbuf, 0, sizeof vbuf);
+
+   vbuf.stride = sizeof( struct vertex );
+   vbuf.buffer_offset = 0;
+   vbuf.buffer = pipe_buffer_create_with_data(info.ctx,
+                                              PIPE_BIND_VERTEX_BUFFER,
+                                              PIPE_USAGE_DEFAULT,
+                                              sizeof(vertices),
+                                              vertices);
+
+   info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vbuf);
+}
+
+static void set_vertex_shader( void )
+{
+   void *handle;
+   const char *text =
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL IN[1]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], COLOR\n"
+      "  0: MOV OUT[1], IN[1]\n"
+      "  1: MOV OUT[0], IN[0]\n"
+      "  2: END\n";
+
+   handle = graw_parse_vertex_shader(info.ctx, text);
+   info.ctx->bind_vs_state(info.ctx, handle);
+}
+
+static void set_fragment_shader( void )
+{
+   void *handle;
+   const char *text =
+      "FRAG\n"
+      "DCL IN[0], COLOR, LINEAR\n"
+      "DCL OUT[0], COLOR\n"
+      "  0: MOV OUT[0], IN[0]\n"
+      "  1: END\n";
+
+   handle = graw_parse_fragment_shader(info.ctx, text);
+   info.ctx->bind_fs_state(info.ctx, handle);
+}
+
+
+static void draw( void )
+{
+   union pipe_color_union clear_color = { {.5,.5,.5,1} };
+   struct pipe_fence_handle *fence = NULL;
+   int64_t start, end, wait_wall = 0, wait_cpu = 0;
+   double frame_ms;
+   int i, j;
+
+   /* warm up, compiles the shaders */
+   util_draw_arrays(info.ctx, PIPE_PRIM_QUADS, 0, 4);
+   info.ctx->flush(info.ctx, &fence, 0);
+   info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+   info.screen->fence_reference(info.screen, &fence, NULL);
+
+   start = os_time_get_nano();
+   for (i = 0; i < num_frames; i++) {
+      int64_t wall, cpu;
+
+      info.ctx->clear(info.ctx, PIPE_CLEAR_COLOR, &clear_color, 0, 0);
+      for (j = 0; j < num_quads; j++)
+         util_draw_arrays(info.ctx, PIPE_PRIM_QUADS, 0, 4);
+      info.ctx->flush(info.ctx, &fence, 0);
+
+      wall = os_time_get_nano();
+      cpu = thread_cpu_time_nano();
+      info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+      wait_cpu += thread_cpu_time_nano() - cpu;
+      wait_wall += os_time_get_nano() - wall;
+
+      info.screen->fence_reference(info.screen, &fence, NULL);
+   }
+   end = os_time_get_nano();
+
+   frame_ms = (end - start) / 1e6 / num_frames;
+   printf("%d frames of %d quads: %.2f ms/frame, waiting %.3f ms/frame, "
+          "%.3f ms CPU/frame while waiting\n",
+          num_frames, num_quads, frame_ms,
+          wait_wall / 1e6 / num_frames,
+          wait_cpu / 1e6 / num_frames);
+
+   graw_util_flush_front(&info);
+   exit(0);
+}
+
+
+static void init( void )
+{
+   if (!graw_util_create_window(&info, WIDTH, HEIGHT, 1, FALSE))
+      exit(1);
+
+   graw_util_default_state(&info, FALSE);
+
+   graw_util_viewport(&info, 0, 0, WIDTH, HEIGHT, 0, 1);
+
+   set_vertices();
+   set_vertex_shader();
+   set_fragment_shader();
+}
+
+
+static void args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (graw_parse_args(&i, argc, argv)) {
+         continue;
+      }
+      if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+         num_frames = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+         num_quads = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else {
+         printf("Invalid arg %s\n", argv[i]);
+         exit(1);
+      }
+   }
+}
+
+int main( int argc, char *argv[] )
+{
+   args(argc, argv);
+   init();
+
+   graw_set_display_func( draw );
+   graw_main_loop();
+   return 0;
+}
@@ -313,6 +313,7 @@ graw_util_create_simple_sampler_view(const struct graw_info *info,
    struct pipe_sampler_view *sv;
 
    memset(&sv_temp, 0, sizeof(sv_temp));
+   sv_temp.target = texture->target;
    sv_temp.format = texture->format;
    sv_temp.texture = texture;
    sv_temp.swizzle_r = PIPE_SWIZZLE_RED;
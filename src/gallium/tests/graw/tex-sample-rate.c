@@ -0,0 +1,226 @@
+/* Measure textured fill throughput.  A screen sized quad samples a
+ * texture with bilinear filtering and its texture coordinates rotated by
+ * 90 degrees, so neighbouring pixels of a span read down a texture column,
+ * which is the worst case for a linear texture layout.
+ *
+ * Usage: tex-sample-rate [-f frames] [-s texture_size]
+ *
+ * Run it with the driver's layout options switched to compare linear and
+ * tiled textures, e.g. KNOB_TILED_TEXTURES=0/1 with swr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graw_util.h"
+#include "os/os_time.h"
+
+static const int WIDTH = 1024;
+static const int HEIGHT = 1024;
+
+static int num_frames = 100;
+static int tex_size = 4096;
+
+static struct graw_info info;
+
+static struct pipe_resource *texture = NULL;
+static struct pipe_sampler_view *sv = NULL;
+static void *sampler = NULL;
+
+struct vertex {
+   float position[4];
+   float texcoord[4];
+};
+
+/* s follows window y and t follows window x */
+static struct vertex vertices[] =
+{
+   { { -1.0, -1.0, 0.0, 1.0 },
+     {  0.0,  0.0, 0.0, 1.0 } },
+
+   { {  1.0, -1.0, 0.0, 1.0 },
+     {  0.0,  1.0, 0.0, 1.0 } },
+
+   { {  1.0,  1.0, 0.0, 1.0 },
+     {  1.0,  1.0, 0.0, 1.0 } },
+
+   { { -1.0,  1.0, 0.0, 1.0 },
+     {  1.0,  0.0, 0.0, 1.0 } },
+};
+
+
+static void set_vertices( void )
+{
+   struct pipe_vertex_element ve[2];
+   struct pipe_vertex_buffer vbuf;
+   void *handle;
+
+   memset(ve, 0, sizeof ve);
+
+   ve[0].src_offset = Offset(struct vertex, position);
+   ve[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve[1].src_offset = Offset(struct vertex, texcoord);
+   ve[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   handle = info.ctx->create_vertex_elements_state(info.ctx, 2, ve);
+   info.ctx->bind_vertex_elements_state(info.ctx, handle);
+
+   memset(&vbuf, 0, sizeof vbuf);
+
+   vbuf.stride = sizeof( struct vertex );
+   vbuf.buffer_offset = 0;
+   vbuf.buffer = pipe_buffer_create_with_data(info.ctx,
+                                              PIPE_BIND_VERTEX_BUFFER,
+                                              PIPE_USAGE_DEFAULT,
+                                              sizeof(vertices),
+                                              vertices);
+
+   info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vbuf);
+}
+
+static void set_vertex_shader( void )
+{
+   void *handle;
+   const char *text =
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL IN[1]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], GENERIC[0]\n"
+      "  0: MOV OUT[1], IN[1]\n"
+      "  1: MOV OUT[0], IN[0]\n"
+      "  2: END\n";
+
+   handle = graw_parse_vertex_shader(info.ctx, text);
+   info.ctx->bind_vs_state(info.ctx, handle);
+}
+
+static void set_fragment_shader( void )
+{
+   void *handle;
+   const char *text =
+      "FRAG\n"
+      "DCL IN[0], GENERIC[0], PERSPECTIVE\n"
+      "DCL OUT[0], COLOR\n"
+      "DCL SAMP[0]\n"
+      "  0: TEX OUT[0], IN[0], SAMP[0], 2D\n"
+      "  1: END\n";
+
+   handle = graw_parse_fragment_shader(info.ctx, text);
+   info.ctx->bind_fs_state(info.ctx, handle);
+}
+
+
+static void init_tex( void )
+{
+   uint32_t *tex2d = MALLOC(tex_size * tex_size * sizeof(uint32_t));
+   int s, t;
+
+   for (t = 0; t < tex_size; t++)
+      for (s = 0; s < tex_size; s++)
+         tex2d[t * tex_size + s] = 0xff000000 | ((s & 0xff) << 8) | (t & 0xff);
+
+   texture = graw_util_create_tex2d(&info, tex_size, tex_size,
+                                    PIPE_FORMAT_B8G8R8A8_UNORM, tex2d);
+   FREE(tex2d);
+   if (!texture)
+      exit(1);
+
+   sv = graw_util_create_simple_sampler_view(&info, texture);
+   info.ctx->set_sampler_views(info.ctx, PIPE_SHADER_FRAGMENT, 0, 1, &sv);
+
+   sampler = graw_util_create_simple_sampler(&info,
+                                             PIPE_TEX_WRAP_REPEAT,
+                                             PIPE_TEX_FILTER_LINEAR);
+   info.ctx->bind_sampler_states(info.ctx, PIPE_SHADER_FRAGMENT,
+                                 0, 1, &sampler);
+}
+
+
+static void draw( void )
+{
+   union pipe_color_union clear_color = { {.5,.5,.5,1} };
+   struct pipe_fence_handle *fence = NULL;
+   int64_t start, end;
+   double secs;
+   int i;
+
+   /* warm up, compiles the shaders and faults in the texture */
+   util_draw_arrays(info.ctx, PIPE_PRIM_QUADS, 0, 4);
+   info.ctx->flush(info.ctx, &fence, 0);
+   info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+   info.screen->fence_reference(info.screen, &fence, NULL);
+
+   start = os_time_get_nano();
+   for (i = 0; i < num_frames; i++) {
+      info.ctx->clear(info.ctx, PIPE_CLEAR_COLOR, &clear_color, 0, 0);
+      util_draw_arrays(info.ctx, PIPE_PRIM_QUADS, 0, 4);
+   }
+   info.ctx->flush(info.ctx, &fence, 0);
+   info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+   info.screen->fence_reference(info.screen, &fence, NULL);
+   end = os_time_get_nano();
+
+   secs = (end - start) / 1e9;
+   printf("%dx%d texture, %d frames of %dx%d: %.1f ms/frame, "
+          "%.1f Mpixel/s, %.1f Mtexel/s\n",
+          tex_size, tex_size, num_frames, WIDTH, HEIGHT,
+          secs * 1e3 / num_frames,
+          (double)WIDTH * HEIGHT * num_frames / secs / 1e6,
+          4.0 * WIDTH * HEIGHT * num_frames / secs / 1e6);
+
+   graw_util_flush_front(&info);
+   exit(0);
+}
+
+
+static void init( void )
+{
+   if (!graw_util_create_window(&info, WIDTH, HEIGHT, 1, FALSE))
+      exit(1);
+
+   graw_util_default_state(&info, FALSE);
+
+   graw_util_viewport(&info, 0, 0, WIDTH, HEIGHT, 0, 1);
+
+   init_tex();
+
+   set_vertices();
+   set_vertex_shader();
+   set_fragment_shader();
+}
+
+
+static void args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc;) {
+      if (graw_parse_args(&i, argc, argv)) {
+         continue;
+      }
+      if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+         num_frames = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+         tex_size = atoi(argv[i + 1]);
+         i += 2;
+      }
+      else {
+         printf("Invalid arg %s\n", argv[i]);
+         exit(1);
+      }
+   }
+}
+
+int main( int argc, char *argv[] )
+{
+   args(argc, argv);
+   init();
+
+   graw_set_display_func( draw );
+   graw_main_loop();
+   return 0;
+}